@@ -0,0 +1,25 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+// Rounds num up to a whole number of denom-sized steps.
+template <typename T, typename U>
+constexpr T DivRoundUp(T num, U denom)
+{
+    return (num + denom - 1) / denom;
+}
+
+// Rounds value up to a multiple of alignment, which must be a power of two.
+template <typename T, typename U>
+constexpr T AlignUp(T value, U alignment)
+{
+    return (value + alignment - 1) & ~static_cast<T>(alignment - 1);
+}
@@ -0,0 +1,2414 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Benchmarks.h"
+
+#include "BundledAssets.h"
+#include "ClusterLod.h"
+#include "CullDataGenerator.h"
+#include "CullViews.h"
+#include "DispatchRuns.h"
+#include "DrawPackets.h"
+#include "GeometryHeap.h"
+#include "HeapCounter.h"
+#include "InstanceCuller.h"
+#include "LinearArena.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "MeshletCuller.h"
+#include "MeshletGenerator.h"
+#include "Model.h"
+#include "ModelWriter.h"
+#include "OcclusionCuller.h"
+#include "ParallelRecording.h"
+#include "SceneGeometry.h"
+#include "SoftwareRasterizer.h"
+#include "TemporalOcclusionCuller.h"
+#include "ThreadPool.h"
+#include "UploadBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+    const uint32_t c_iterationCount = 10;
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    void Log(const char* format, ...)
+    {
+        char buffer[512];
+
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        OutputDebugStringA(buffer);
+        fputs(buffer, stdout);
+    }
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::vector<std::wstring> GetAssetPaths(const std::wstring& assetDirectory)
+    {
+        std::vector<std::wstring> paths;
+        for (auto filename : c_assetFilenames)
+        {
+            paths.push_back(assetDirectory + filename);
+        }
+        return paths;
+    }
+
+    // Best-of-N wall time to load every bundled asset, serially and across pools of increasing size.
+    void BenchmarkModelLoading(const std::wstring& assetDirectory)
+    {
+        const auto paths = GetAssetPaths(assetDirectory);
+
+        Log("\nModel loading (%u files, best of %u, warm file cache)\n", static_cast<uint32_t>(paths.size()), c_iterationCount);
+        Log("%-10s %12s %12s\n", "threads", "copy (ms)", "mapped (ms)");
+
+        const ModelLoadMode modes[] = { ModelLoadMode::Copy, ModelLoadMode::MemoryMapped };
+
+        // Serial baseline on the calling thread.
+        {
+            double best[2] = { 1e30, 1e30 };
+
+            for (uint32_t m = 0; m < 2; ++m)
+            {
+                for (uint32_t n = 0; n < c_iterationCount; ++n)
+                {
+                    auto start = Clock::now();
+                    for (auto& path : paths)
+                    {
+                        Model model;
+                        if (FAILED(model.LoadFromFile(path.c_str(), modes[m])))
+                        {
+                            Log("Failed to load %ls\n", path.c_str());
+                            return;
+                        }
+                    }
+                    best[m] = min(best[m], ElapsedMs(start));
+                }
+            }
+
+            Log("%-10s %12.3f %12.3f\n", "serial", best[0], best[1]);
+        }
+
+        // The calling thread participates in ParallelFor, so a pool of N workers runs N + 1 threads.
+        const uint32_t maxThreads = max(2u, std::thread::hardware_concurrency());
+        for (uint32_t threadCount = 2; threadCount <= maxThreads; threadCount *= 2)
+        {
+            ThreadPool pool(threadCount - 1);
+            double best[2] = { 1e30, 1e30 };
+
+            for (uint32_t m = 0; m < 2; ++m)
+            {
+                for (uint32_t n = 0; n < c_iterationCount; ++n)
+                {
+                    std::vector<std::unique_ptr<Model>> models;
+
+                    auto start = Clock::now();
+                    if (FAILED(LoadModels(paths, models, modes[m], pool)))
+                    {
+                        Log("Failed to load assets from %ls\n", assetDirectory.c_str());
+                        return;
+                    }
+                    best[m] = min(best[m], ElapsedMs(start));
+                }
+            }
+
+            Log("%-10u %12.3f %12.3f\n", threadCount, best[0], best[1]);
+        }
+    }
+
+    size_t GetFileSize(const std::wstring& path)
+    {
+        MappedFile file;
+        return SUCCEEDED(file.Open(path.c_str())) ? file.size() : 0;
+    }
+
+    // Stores the best-of-N time to load the file in best; logs and returns false if a load fails.
+    bool BestLoadTimeMs(const std::wstring& path, ModelLoadMode mode, double& best)
+    {
+        best = 1e30;
+
+        for (uint32_t n = 0; n < c_iterationCount; ++n)
+        {
+            Model model;
+
+            auto start = Clock::now();
+            if (FAILED(model.LoadFromFile(path.c_str(), mode)))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return false;
+            }
+            best = min(best, ElapsedMs(start));
+        }
+
+        return true;
+    }
+
+    // Writes a copy of an asset to the working directory; the caller removes it.
+    bool WriteAssetCopy(const std::wstring& sourcePath, const std::wstring& copyPath, const ModelWriteOptions& options)
+    {
+        Model model;
+        if (FAILED(model.LoadFromFile(sourcePath.c_str())) || FAILED(WriteModelFile(copyPath.c_str(), model, options)))
+        {
+            Log("Failed to rewrite %ls\n", sourcePath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Size and best-of-N load time of each asset as shipped (v0) and re-encoded with block compression (v1).
+    // The v1 copies are written to the working directory and removed afterwards.
+    void BenchmarkCompressedLoading(const std::wstring& assetDirectory)
+    {
+        Log("\nCompressed models (best of %u, warm file cache)\n", c_iterationCount);
+        Log("%-16s %10s %10s %7s %10s %10s\n", "file", "v0 (KB)", "v1 (KB)", "ratio", "v0 (ms)", "v1 (ms)");
+
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring sourcePath = assetDirectory + filename;
+            const std::wstring compressedPath = std::wstring(filename) + L".v1";
+
+            ModelWriteOptions options;
+            options.WriteBounds = false;
+
+            if (!WriteAssetCopy(sourcePath, compressedPath, options))
+            {
+                return;
+            }
+
+            double best[2];
+            const bool loaded = BestLoadTimeMs(sourcePath, ModelLoadMode::MemoryMapped, best[0]) && BestLoadTimeMs(compressedPath, ModelLoadMode::MemoryMapped, best[1]);
+            if (!loaded)
+            {
+                _wremove(compressedPath.c_str());
+                return;
+            }
+
+            const size_t sizes[] = { GetFileSize(sourcePath), GetFileSize(compressedPath) };
+            Log("%-16ls %10.1f %10.1f %7.2f %10.3f %10.3f\n", filename, sizes[0] / 1024.0, sizes[1] / 1024.0,
+                double(sizes[0]) / max(sizes[1], size_t(1)), best[0], best[1]);
+
+            _wremove(compressedPath.c_str());
+        }
+    }
+
+    // Load time with bounds scanned from the vertices versus read from an exported bounds section.
+    void BenchmarkPrecomputedBounds(const std::wstring& assetDirectory)
+    {
+        Log("\nPrecomputed bounds (best of %u, memory-mapped, warm file cache)\n", c_iterationCount);
+        Log("%-16s %10s %12s\n", "file", "scan (ms)", "stored (ms)");
+
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring sourcePath = assetDirectory + filename;
+            const std::wstring boundsPath = std::wstring(filename) + L".bounds";
+
+            ModelWriteOptions options;
+            options.Compress = false;
+
+            if (!WriteAssetCopy(sourcePath, boundsPath, options))
+            {
+                return;
+            }
+
+            double best[2];
+            const bool loaded = BestLoadTimeMs(sourcePath, ModelLoadMode::MemoryMapped, best[0]) && BestLoadTimeMs(boundsPath, ModelLoadMode::MemoryMapped, best[1]);
+
+            _wremove(boundsPath.c_str());
+            if (!loaded)
+            {
+                return;
+            }
+
+            Log("%-16ls %10.3f %12.3f\n", filename, best[0], best[1]);
+        }
+    }
+
+    void LogMeshletStats(const char* label, double ms, const MeshletStats& stats)
+    {
+        Log("%-12s %10.3f %9u %9.3f %9.3f %10.3f %9.1f %10.4f\n", label, ms, stats.MeshletCount,
+            stats.AverageVertFill, stats.AveragePrimFill, stats.VertsPerTriangle, stats.MeanConeAngle, stats.MeanRadius);
+    }
+
+    // Meshlet quality of the baked clustering against each generator strategy on the densest asset.
+    // Lower verts/tri means fewer vertex shader invocations; tighter cones and spheres cull better.
+    void BenchmarkMeshletGeneration(const std::wstring& assetDirectory)
+    {
+        const std::wstring path = assetDirectory + c_assetFilenames[0];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            Log("Failed to load %ls\n", path.c_str());
+            return;
+        }
+
+        Log("\nMeshlet generation (%ls, best of %u)\n", c_assetFilenames[0], c_iterationCount);
+        Log("%-12s %10s %9s %9s %9s %10s %9s %10s\n", "strategy", "build (ms)", "meshlets", "vert fill", "prim fill", "verts/tri", "cone (deg)", "radius");
+
+        // The bundled assets each hold a single mesh.
+        Mesh& mesh = *model.begin();
+        LogMeshletStats("baked", 0.0, ComputeMeshletStats(mesh));
+
+        const struct { const char* Label; MeshletStrategy Strategy; } strategies[] =
+        {
+            { "index order", MeshletStrategy::IndexOrder },
+            { "locality",    MeshletStrategy::Locality },
+        };
+
+        for (auto& strategy : strategies)
+        {
+            MeshletGeneratorOptions options;
+            options.Strategy = strategy.Strategy;
+
+            MeshletData data;
+            double best = 1e30;
+
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                if (FAILED(GenerateMeshlets(mesh, data, options)))
+                {
+                    Log("Failed to generate meshlets for %ls\n", path.c_str());
+                    return;
+                }
+                best = min(best, ElapsedMs(start));
+            }
+
+            // Stats read the meshlets through the mesh, so measure on a copy to leave the baked set intact.
+            Mesh generated = mesh;
+            data.AttachTo(generated);
+            LogMeshletStats(strategy.Label, best, ComputeMeshletStats(generated, options));
+        }
+    }
+
+    // Time to regenerate each asset's culling data, and how it compares with the exported data.
+    void BenchmarkCullDataGeneration(const std::wstring& assetDirectory)
+    {
+        Log("\nCull data generation (best of %u)\n", c_iterationCount);
+        Log("%-16s %9s %10s %16s %16s\n", "file", "meshlets", "time (ms)", "degenerate b/g", "radius b/g");
+
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            Model model;
+            if (FAILED(model.LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+
+            const Mesh& mesh = *model.begin();
+            std::vector<CullData> cullData;
+            double best = 1e30;
+
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                if (FAILED(GenerateCullData(mesh, cullData)))
+                {
+                    Log("Failed to generate cull data for %ls\n", path.c_str());
+                    return;
+                }
+                best = min(best, ElapsedMs(start));
+            }
+
+            uint32_t degenerate[2] = {};
+            double radius[2] = {};
+
+            for (uint32_t i = 0; i < cullData.size(); ++i)
+            {
+                const CullData* pair[] = { &mesh.CullingData[i], &cullData[i] };
+                for (uint32_t k = 0; k < 2; ++k)
+                {
+                    degenerate[k] += pair[k]->NormalCone[3] == 0xFF;
+                    radius[k] += pair[k]->BoundingSphere.w;
+                }
+            }
+
+            Log("%-16ls %9u %10.3f %7u / %-6u %7.3f / %7.3f\n", filename, static_cast<uint32_t>(cullData.size()), best,
+                degenerate[0], degenerate[1], radius[0] / max(cullData.size(), size_t(1)), radius[1] / max(cullData.size(), size_t(1)));
+        }
+    }
+
+    struct CullConfig
+    {
+        const char*    Name;
+        CullPath       Path;
+        CullDataLayout Layout;
+    };
+
+    const CullConfig c_cullConfigs[] =
+    {
+        { "scalar",  CullPath::Scalar, CullDataLayout::ArrayOfStructs },
+        { "sse",     CullPath::SSE,    CullDataLayout::ArrayOfStructs },
+        { "sse-soa", CullPath::SSE,    CullDataLayout::StructOfArrays },
+        { "avx",     CullPath::AVX,    CullDataLayout::ArrayOfStructs },
+        { "avx-soa", CullPath::AVX,    CullDataLayout::StructOfArrays },
+    };
+
+    // Reports how much of each Dragon LOD the views keep, then measures the throughput of every
+    // SIMD path and cull data layout on the densest one. MeshletCullerTests.cpp checks that they
+    // all agree with the scalar reference.
+    void BenchmarkMeshletCulling(const std::wstring& assetDirectory)
+    {
+        Log("\nMeshlet culling (%u views per model)\n", c_cullViewCount);
+        Log("%-16s %9s %9s\n", "file", "meshlets", "visible");
+
+        for (uint32_t f = 0; f < 5; ++f)
+        {
+            const std::wstring path = assetDirectory + c_assetFilenames[f];
+
+            Model model;
+            if (FAILED(model.LoadFromFile(path.c_str(), ModelLoadMode::Copy, ModelLoadFlags_CullDataSoA)))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+
+            const Mesh& mesh = *model.begin();
+            uint64_t visibleCount = 0;
+
+            for (uint32_t v = 0; v < c_cullViewCount; ++v)
+            {
+                MeshletCullParams params;
+                MakeCullParams(model, v, params);
+
+                VisibleMeshlets visible;
+                CullMeshlets(mesh, params, visible, CullPath::Scalar);
+                visibleCount += visible.Indices.size();
+            }
+
+            Log("%-16ls %9u %8.1f%%\n", c_assetFilenames[f], static_cast<uint32_t>(mesh.Meshlets.size()),
+                100.0 * visibleCount / (double(mesh.Meshlets.size()) * c_cullViewCount));
+        }
+
+        const std::wstring path = assetDirectory + c_assetFilenames[0];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str(), ModelLoadMode::Copy, ModelLoadFlags_CullDataSoA)))
+            return;
+
+        const Mesh& mesh = *model.begin();
+
+        std::vector<MeshletCullParams> views(c_cullViewCount);
+        for (uint32_t v = 0; v < c_cullViewCount; ++v)
+        {
+            MakeCullParams(model, v, views[v]);
+        }
+
+        Log("\n%ls, best of %u\n", c_assetFilenames[0], c_iterationCount);
+        Log("%-10s %12s %10s\n", "path", "ns/meshlet", "speedup");
+
+        double scalarNs = 0.0;
+        VisibleMeshlets visible;
+
+        for (uint32_t c = 0; c < _countof(c_cullConfigs); ++c)
+        {
+            const CullConfig& config = c_cullConfigs[c];
+
+            if (!IsCullPathSupported(config.Path))
+            {
+                Log("%-10s %12s\n", config.Name, "unsupported");
+                continue;
+            }
+
+            double best = 1e30;
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                for (auto& params : views)
+                {
+                    CullMeshlets(mesh, params, visible, config.Path, config.Layout);
+                }
+                best = min(best, ElapsedMs(start));
+            }
+
+            const double ns = best * 1e6 / (double(mesh.Meshlets.size()) * c_cullViewCount);
+            if (c == 0)
+            {
+                scalarNs = ns;
+            }
+
+            Log("%-10s %12.3f %9.2fx\n", config.Name, ns, scalarNs / ns);
+        }
+    }
+    // Reports how much of each asset the flat scan and the tree keep, then compares the cost of the
+    // two on Dragon_LOD1 for whole-model views and for close-ups. MeshletCullerTests.cpp checks that
+    // the tree's results are subsets of the flat scan's.
+    void BenchmarkMeshletTree(const std::wstring& assetDirectory)
+    {
+        const float c_closeUpFieldOfView = XM_PIDIV4 / 8.0f;
+
+        Log("\nMeshlet tree culling (%u views per model, whole and close-up)\n", c_cullViewCount);
+        Log("%-16s %9s %7s %9s %9s\n", "file", "meshlets", "nodes", "flat", "tree");
+
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            Model model;
+            if (FAILED(model.LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+
+            uint32_t meshletCount = 0;
+            uint32_t nodeCount = 0;
+            uint64_t visibleCount[2] = {};
+
+            for (auto& mesh : model)
+            {
+                meshletCount += static_cast<uint32_t>(mesh.Meshlets.size());
+                nodeCount += static_cast<uint32_t>(mesh.GetMeshletTree().Nodes.size());
+
+                for (uint32_t v = 0; v < 2 * c_cullViewCount; ++v)
+                {
+                    MeshletCullParams params;
+                    MakeCullParams(model, v % c_cullViewCount, params, v < c_cullViewCount ? XM_PIDIV4 : c_closeUpFieldOfView);
+
+                    VisibleMeshlets flat, tree;
+                    CullMeshlets(mesh, params, flat);
+                    CullMeshletTree(mesh, params, tree);
+
+                    visibleCount[0] += flat.Indices.size();
+                    visibleCount[1] += tree.Indices.size();
+                }
+            }
+
+            const double tested = double(max(meshletCount, 1u)) * 2 * c_cullViewCount;
+            Log("%-16ls %9u %7u %8.1f%% %8.1f%%\n", filename, meshletCount, nodeCount,
+                100.0 * visibleCount[0] / tested, 100.0 * visibleCount[1] / tested);
+        }
+
+        const std::wstring path = assetDirectory + c_assetFilenames[0];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str(), ModelLoadMode::Copy, ModelLoadFlags_CullDataSoA | ModelLoadFlags_MeshletTree)))
+            return;
+
+        const Mesh& mesh = *model.begin();
+
+        Log("\n%ls, best of %u\n", c_assetFilenames[0], c_iterationCount);
+        Log("%-10s %9s %12s %12s %9s\n", "views", "visible", "flat ns", "tree ns", "speedup");
+
+        const char* viewNames[] = { "whole", "close-up" };
+        const float fieldsOfView[] = { XM_PIDIV4, c_closeUpFieldOfView };
+
+        for (uint32_t set = 0; set < 2; ++set)
+        {
+            std::vector<MeshletCullParams> views(c_cullViewCount);
+            for (uint32_t v = 0; v < c_cullViewCount; ++v)
+            {
+                MakeCullParams(model, v, views[v], fieldsOfView[set]);
+            }
+
+            VisibleMeshlets visible;
+            double best[2] = { 1e30, 1e30 };
+            uint64_t visibleCount = 0;
+
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                for (auto& params : views)
+                {
+                    CullMeshlets(mesh, params, visible);
+                }
+                best[0] = min(best[0], ElapsedMs(start));
+
+                visibleCount = 0;
+                start = Clock::now();
+                for (auto& params : views)
+                {
+                    CullMeshletTree(mesh, params, visible);
+                    visibleCount += visible.Indices.size();
+                }
+                best[1] = min(best[1], ElapsedMs(start));
+            }
+
+            // Per view rather than per meshlet: the tree's cost isn't proportional to the meshlet count.
+            Log("%-10s %8.1f%% %12.1f %12.1f %8.2fx\n", viewNames[set],
+                100.0 * visibleCount / (double(mesh.Meshlets.size()) * c_cullViewCount),
+                best[0] * 1e6 / c_cullViewCount, best[1] * 1e6 / c_cullViewCount, best[0] / best[1]);
+        }
+    }
+    // Counts the edges used by exactly one of the selected meshlets' triangles.
+    uint32_t CountOpenEdges(const ClusterLodData& lod, const VisibleMeshlets& selected, uint32_t indexSize, uint32_t& triangleCount)
+    {
+        std::vector<uint64_t> edges;
+        triangleCount = 0;
+
+        for (uint32_t m : selected.Indices)
+        {
+            const Meshlet& meshlet = lod.Meshlets.Meshlets[m];
+            triangleCount += meshlet.PrimCount;
+
+            for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+            {
+                const PackedTriangle& tri = lod.Meshlets.PrimitiveIndices[meshlet.PrimOffset + p];
+                const uint32_t local[3] = { tri.i0, tri.i1, tri.i2 };
+
+                uint32_t v[3] = {};
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    std::memcpy(&v[k], &lod.Meshlets.UniqueVertexIndices[size_t(meshlet.VertOffset + local[k]) * indexSize], indexSize);
+                }
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t a = min(v[k], v[(k + 1) % 3]);
+                    const uint32_t b = max(v[k], v[(k + 1) % 3]);
+                    edges.push_back((uint64_t(a) << 32) | b);
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        uint32_t openCount = 0;
+        for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+        {
+            for (end = begin + 1; end < edges.size() && edges[end] == edges[begin]; ++end)
+            {
+            }
+            openCount += end - begin == 1;
+        }
+        return openCount;
+    }
+
+    // Builds the cluster hierarchy of Dragon_LOD1, then selects cuts from a range of distances. A cut
+    // with open edges the source mesh doesn't have would show cracks; the baked LOD files give a sense
+    // of the triangle counts a hand-made chain uses instead.
+    void BenchmarkClusterLod(const std::wstring& assetDirectory)
+    {
+        const std::wstring path = assetDirectory + c_assetFilenames[0];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            Log("Failed to load %ls\n", path.c_str());
+            return;
+        }
+
+        const Mesh& mesh = *model.begin();
+
+        ClusterLodData lod;
+        auto start = Clock::now();
+        if (FAILED(BuildClusterLod(mesh, lod)))
+        {
+            Log("Failed to build the cluster LOD of %ls\n", path.c_str());
+            return;
+        }
+        const double buildMs = ElapsedMs(start);
+
+        Log("\nCluster LOD, %ls: %u meshlets over %u levels in %.1f ms\n", c_assetFilenames[0],
+            static_cast<uint32_t>(lod.Lods.size()), static_cast<uint32_t>(lod.LevelTriangles.size()), buildMs);
+        Log("%-6s %10s %12s\n", "level", "triangles", "error");
+
+        for (uint32_t l = 0; l < lod.LevelTriangles.size(); ++l)
+        {
+            Log("%-6u %10u %12.6f\n", l, lod.LevelTriangles[l], lod.LevelErrors[l]);
+        }
+
+        Log("baked:");
+        for (uint32_t f = 0; f < 5; ++f)
+        {
+            Model baked;
+            if (SUCCEEDED(baked.LoadFromFile((assetDirectory + c_assetFilenames[f]).c_str())))
+            {
+                Log(" %u", baked.begin()->IndexCount / 3);
+            }
+        }
+        Log("\n");
+
+        // A 1080p view with a 45 degree vertical field of view and a one pixel error budget.
+        const BoundingSphere& bounds = model.GetBoundingSphere();
+
+        ClusterLodView view;
+        XMStoreFloat4x4(&view.World, XMMatrixIdentity());
+        view.Scale = 1.0f;
+        view.ProjectionScale = 1080.0f / (2.0f * tanf(XM_PIDIV4 / 2.0f));
+        view.ErrorThreshold = 1.0f;
+
+        VisibleMeshlets all;
+        all.Indices.resize(lod.Meshlets.MeshletSubsets[0].Count);
+        for (uint32_t m = 0; m < all.Indices.size(); ++m)
+        {
+            all.Indices[m] = m;
+        }
+
+        VisibleMeshlets level0;
+        for (uint32_t m : all.Indices)
+        {
+            if (lod.Lods[m].Level == 0)
+                level0.Indices.push_back(m);
+        }
+
+        uint32_t sourceTriangles = 0;
+        const uint32_t sourceOpenEdges = CountOpenEdges(lod, level0, mesh.IndexSize, sourceTriangles);
+
+        Log("%-10s %9s %10s %11s %9s\n", "radii", "meshlets", "triangles", "open edges", "select us");
+
+        const float distances[] = { 1.5f, 3.0f, 6.0f, 12.0f, 24.0f, 48.0f, 96.0f };
+        for (float distance : distances)
+        {
+            XMStoreFloat3(&view.ViewPosition, XMVectorAdd(XMLoadFloat3(&bounds.Center), XMVectorSet(0, 0, bounds.Radius * distance, 0)));
+
+            VisibleMeshlets selected;
+            double best = 1e30;
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                start = Clock::now();
+                SelectClusterLod(lod, view, selected);
+                best = min(best, ElapsedMs(start));
+            }
+
+            uint32_t triangleCount = 0;
+            const uint32_t openEdges = CountOpenEdges(lod, selected, mesh.IndexSize, triangleCount);
+
+            Log("%-10.1f %9u %10u %5u (%3s) %9.1f\n", distance, static_cast<uint32_t>(selected.Indices.size()), triangleCount,
+                openEdges, openEdges == sourceOpenEdges ? "ok" : "bad", best * 1e3);
+        }
+    }
+    // Simplifies each asset to a half and an eighth of its triangles, with and without the normal cost,
+    // on the default pool; times include regenerating the meshlets. The halved Dragon_LOD1 is then
+    // written as an MSHL file and compared in size with the baked Dragon_LOD2; MeshSimplifierTests
+    // checks that it reloads unchanged.
+    void BenchmarkSimplification(const std::wstring& assetDirectory)
+    {
+        const uint32_t c_simplifyIterations = 3;
+        const wchar_t* filenames[] = { c_assetFilenames[0], L"ToyRobot.bin", L"Camera.bin" };
+
+        Log("\nMesh simplification (best of %u)\n", c_simplifyIterations);
+        Log("%-16s %8s %7s %8s %10s %10s %10s %10s\n", "file", "subsets", "target", "normals", "triangles", "error", "ms", "Mtri/s");
+
+        for (auto filename : filenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            Model model;
+            if (FAILED(model.LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+
+            const Mesh& mesh = *model.begin();
+            const uint32_t triangleCount = mesh.IndexCount / 3;
+
+            for (uint32_t divisor : { 2u, 8u })
+            {
+                for (uint32_t withNormals = 0; withNormals < 2; ++withNormals)
+                {
+                    SimplifyOptions options;
+                    options.TargetTriangleCount = triangleCount / divisor;
+                    options.NormalWeight = withNormals ? model.GetBoundingSphere().Radius * 0.01f : 0.0f;
+
+                    SimplifiedMesh simplified;
+                    double best = 1e30;
+
+                    for (uint32_t n = 0; n < c_simplifyIterations; ++n)
+                    {
+                        auto start = Clock::now();
+                        SimplifyMesh(mesh, simplified, options);
+                        best = min(best, ElapsedMs(start));
+                    }
+
+                    const float error = simplified.SubsetErrors.empty() ? 0.0f : *std::max_element(simplified.SubsetErrors.begin(), simplified.SubsetErrors.end());
+
+                    Log("%-16ls %8u %6s%u %8s %10u %10.4f %10.1f %10.2f\n", filename, static_cast<uint32_t>(mesh.IndexSubsets.size()), "1/", divisor,
+                        withNormals ? "yes" : "no", static_cast<uint32_t>(simplified.Indices.size() / mesh.IndexSize / 3), error,
+                        best, triangleCount / (best * 1e3));
+                }
+            }
+        }
+
+        // Write-back through the MSHL path.
+        const std::wstring sourcePath = assetDirectory + c_assetFilenames[0];
+        const std::wstring lodPath = std::wstring(c_assetFilenames[0]) + L".lod";
+
+        Model source;
+        Model baked;
+        if (FAILED(source.LoadFromFile(sourcePath.c_str())) || FAILED(baked.LoadFromFile((assetDirectory + c_assetFilenames[1]).c_str())))
+            return;
+
+        const Mesh& sourceMesh = *source.begin();
+
+        SimplifyOptions options;
+        options.TargetTriangleCount = sourceMesh.IndexCount / 3 / 2;
+
+        SimplifiedMesh simplified;
+        Mesh lod = sourceMesh;
+        if (FAILED(SimplifyMesh(sourceMesh, simplified, options)))
+        {
+            Log("Failed to simplify %ls\n", sourcePath.c_str());
+            return;
+        }
+        simplified.AttachTo(lod);
+
+        if (FAILED(WriteModelFile(lodPath.c_str(), &lod, 1)))
+        {
+            Log("Failed to write %ls\n", lodPath.c_str());
+            return;
+        }
+
+        const Mesh& bakedMesh = *baked.begin();
+
+        Log("\n%-24s %10s %10s %9s %10s\n", "", "triangles", "vertices", "meshlets", "size (KB)");
+        Log("%-24s %10u %10u %9u %10.1f\n", "simplified", lod.IndexCount / 3, lod.VertexCount, static_cast<uint32_t>(lod.Meshlets.size()), GetFileSize(lodPath) / 1024.0);
+        Log("%-24ls %10u %10u %9u %10.1f\n", c_assetFilenames[1], bakedMesh.IndexCount / 3, bakedMesh.VertexCount, static_cast<uint32_t>(bakedMesh.Meshlets.size()),
+            GetFileSize(assetDirectory + c_assetFilenames[1]) / 1024.0);
+
+        _wremove(lodPath.c_str());
+    }
+    // View number 'view' of an orbit at twice the model's radius, at the given resolution.
+    void MakeRasterConstants(const Model& model, uint32_t view, uint32_t viewCount, uint32_t width, uint32_t height, RasterConstants& constants)
+    {
+        const BoundingSphere& bounds = model.GetBoundingSphere();
+        const float yaw = XM_2PI * view / viewCount;
+
+        const XMVECTOR center = XMLoadFloat3(&bounds.Center);
+        const XMVECTOR eye = XMVectorAdd(center, XMVectorScale(XMVectorSet(cosf(yaw), 0.3f, sinf(yaw), 0), 2.0f * bounds.Radius));
+
+        const XMMATRIX viewMatrix = XMMatrixLookAtRH(eye, center, XMVectorSet(0, 1, 0, 0));
+        const XMMATRIX proj = XMMatrixPerspectiveFovRH(XM_PI / 3.0f, float(width) / height, bounds.Radius * 0.01f, bounds.Radius * 10.0f);
+
+        XMStoreFloat4x4(&constants.World, XMMatrixIdentity());
+        XMStoreFloat4x4(&constants.WorldView, viewMatrix);
+        XMStoreFloat4x4(&constants.WorldViewProj, viewMatrix * proj);
+        constants.DrawMeshlets = true;
+    }
+
+    // Renders an orbit of each model on the CPU with one worker and with the default pool, and reports
+    // the frame time split into draws and resolve.
+    void BenchmarkSoftwareRasterizer(const std::wstring& assetDirectory)
+    {
+        const uint32_t c_width = 1280;
+        const uint32_t c_height = 720;
+        const uint32_t c_viewCount = 8;
+        const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+        const wchar_t* filenames[] = { c_assetFilenames[0], c_assetFilenames[2], L"ToyRobot.bin" };
+
+        Log("\nSoftware rasterizer (%ux%u, %u views, best of %u)\n", c_width, c_height, c_viewCount, c_iterationCount);
+        Log("%-16s %8s %10s %9s %9s %10s %10s %10s\n", "file", "threads", "triangles", "raster", "covered", "draw ms", "resolve ms", "Mtri/s");
+
+        ThreadPool singleWorker(1);
+
+        for (auto filename : filenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            Model model;
+            if (FAILED(model.LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+
+            std::vector<RasterConstants> views(c_viewCount);
+            for (uint32_t v = 0; v < c_viewCount; ++v)
+            {
+                MakeRasterConstants(model, v, c_viewCount, c_width, c_height, views[v]);
+            }
+
+            ThreadPool* pools[] = { &singleWorker, &ThreadPool::GetDefault() };
+
+            for (uint32_t p = 0; p < _countof(pools); ++p)
+            {
+                SoftwareRasterizer rasterizer(*pools[p]);
+
+                double best[2] = { 1e30, 1e30 };
+                RasterStats stats = {};
+                uint64_t covered = 0;
+
+                for (uint32_t n = 0; n < c_iterationCount; ++n)
+                {
+                    double elapsed[2] = {};
+                    stats = RasterStats();
+                    covered = 0;
+
+                    for (uint32_t v = 0; v < c_viewCount; ++v)
+                    {
+                        auto start = Clock::now();
+                        rasterizer.Clear(c_width, c_height, clearColor);
+                        for (auto& mesh : model)
+                        {
+                            rasterizer.Draw(mesh, views[v]);
+                        }
+                        elapsed[0] += ElapsedMs(start);
+
+                        start = Clock::now();
+                        rasterizer.Resolve();
+                        elapsed[1] += ElapsedMs(start);
+
+                        stats.TriangleCount += rasterizer.GetStats().TriangleCount;
+                        stats.RasterTriangleCount += rasterizer.GetStats().RasterTriangleCount;
+
+                        const std::vector<float>& depth = rasterizer.GetDepthBuffer();
+                        covered += std::count_if(depth.begin(), depth.end(), [](float d) { return d < 1.0f; });
+                    }
+
+                    best[0] = min(best[0], elapsed[0] / c_viewCount);
+                    best[1] = min(best[1], elapsed[1] / c_viewCount);
+                }
+
+                Log("%-16ls %8u %10u %8.1f%% %8.1f%% %10.2f %10.2f %10.2f\n", filename, pools[p]->GetThreadCount() + 1, stats.TriangleCount / c_viewCount,
+                    100.0 * stats.RasterTriangleCount / max(stats.TriangleCount, 1u), 100.0 * covered / (double(c_width) * c_height * c_viewCount),
+                    best[0], best[1], stats.TriangleCount / c_viewCount / ((best[0] + best[1]) * 1e3));
+            }
+        }
+    }
+    const float c_occlusionSceneSpacing = 1.5f;     // Model radii between neighbouring instances
+
+    // A field of Dragon_LOD3 instances seen along its rows from eye height, so that the nearer
+    // dragons hide much of the ones behind them.
+    struct OcclusionScene
+    {
+        static const uint32_t Columns = 5;
+        static const uint32_t Rows = 5;
+        static const uint32_t ViewCount = 4;
+
+        std::vector<XMFLOAT4X4> Worlds;     // Nearest row first
+        XMFLOAT4X4              Views[ViewCount];
+        XMFLOAT4X4              Projection;
+        XMFLOAT3                Eyes[ViewCount];
+    };
+
+    // The occlusion scene's camera, turned by yaw about the field and raised by height model radii.
+    void MakeOcclusionView(const Model& model, float yaw, float height, XMFLOAT4X4& view, XMFLOAT3& eye)
+    {
+        const BoundingSphere& bounds = model.GetBoundingSphere();
+        const float spacing = bounds.Radius * c_occlusionSceneSpacing;
+
+        const XMVECTOR position = XMVectorSet(sinf(yaw) * spacing * 2.0f, bounds.Radius * height, spacing * 1.5f, 0);
+        const XMVECTOR target = XMVectorSet(0, 0, -spacing * OcclusionScene::Rows * 0.5f, 0);
+
+        XMStoreFloat4x4(&view, XMMatrixLookAtRH(position, target, XMVectorSet(0, 1, 0, 0)));
+        XMStoreFloat3(&eye, position);
+    }
+
+    void MakeOcclusionScene(const Model& model, uint32_t width, uint32_t height, OcclusionScene& scene)
+    {
+        const BoundingSphere& bounds = model.GetBoundingSphere();
+        const float spacing = bounds.Radius * c_occlusionSceneSpacing;
+
+        for (uint32_t r = 0; r < OcclusionScene::Rows; ++r)
+        {
+            for (uint32_t c = 0; c < OcclusionScene::Columns; ++c)
+            {
+                const float x = (c - (OcclusionScene::Columns - 1) * 0.5f) * spacing;
+                const float z = -(r * spacing);
+
+                XMFLOAT4X4 world;
+                XMStoreFloat4x4(&world, XMMatrixRotationY(XM_PIDIV2 * (r + c)) * XMMatrixTranslation(x - bounds.Center.x, -bounds.Center.y, z - bounds.Center.z));
+                scene.Worlds.push_back(world);
+            }
+        }
+
+        for (uint32_t v = 0; v < OcclusionScene::ViewCount; ++v)
+        {
+            MakeOcclusionView(model, 0.25f * (v - (OcclusionScene::ViewCount - 1) * 0.5f), 0.1f * v, scene.Views[v], scene.Eyes[v]);
+        }
+
+        XMStoreFloat4x4(&scene.Projection, XMMatrixPerspectiveFovRH(XM_PI / 3.0f, float(width) / height, bounds.Radius * 0.01f, bounds.Radius * 50.0f));
+    }
+
+    // Draws the listed meshlets of each of the scene's instances at the rasterizer's size and returns the image.
+    void RenderOcclusionScene(SoftwareRasterizer& rasterizer, uint32_t width, uint32_t height, const Mesh& mesh, const OcclusionScene& scene,
+        FXMMATRIX view, const std::vector<VisibleMeshlets>& visible, std::vector<uint32_t>& image)
+    {
+        const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+        const XMMATRIX viewProj = view * XMLoadFloat4x4(&scene.Projection);
+
+        rasterizer.Clear(width, height, clearColor);
+        for (uint32_t i = 0; i < scene.Worlds.size(); ++i)
+        {
+            const XMMATRIX world = XMLoadFloat4x4(&scene.Worlds[i]);
+
+            RasterConstants constants;
+            XMStoreFloat4x4(&constants.World, world);
+            XMStoreFloat4x4(&constants.WorldView, world * view);
+            XMStoreFloat4x4(&constants.WorldViewProj, world * viewProj);
+            constants.DrawMeshlets = true;
+
+            rasterizer.Draw(mesh, constants, &visible[i]);
+        }
+        rasterizer.Resolve();
+        image = rasterizer.GetColorBuffer();
+    }
+
+    double PercentDiffering(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+    {
+        uint32_t differing = 0;
+        for (size_t p = 0; p < a.size(); ++p)
+        {
+            differing += a[p] != b[p];
+        }
+        return 100.0 * differing / max(double(a.size()), 1.0);
+    }
+
+    // Culls the scene's meshlets against the frustum, then against occluders built from the nearest
+    // instances, with full and simplified occluder meshes. Reports the cost of the occlusion stage at
+    // the default 256x128 on one thread, and checks it by rendering both meshlet sets at 1280x720 with
+    // the software rasterizer: simplified occluders only shrink, so no budget should change pixels.
+    void BenchmarkOcclusionCulling(const std::wstring& assetDirectory)
+    {
+        const uint32_t c_occluderInstances = 10;
+        const uint32_t c_width = 1280;
+        const uint32_t c_height = 720;
+
+        const std::wstring path = assetDirectory + c_assetFilenames[2];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            Log("Failed to load %ls\n", path.c_str());
+            return;
+        }
+
+        const Mesh& mesh = *model.begin();
+
+        OcclusionScene scene;
+        MakeOcclusionScene(model, c_width, c_height, scene);
+
+        const uint32_t instanceCount = static_cast<uint32_t>(scene.Worlds.size());
+        const uint32_t budgets[] = { mesh.IndexCount / 3, 1024, 256 };
+
+        Log("\nOcclusion culling (%ls x %u, %u occluders, 256x128, best of %u)\n", c_assetFilenames[2], instanceCount, c_occluderInstances, c_iterationCount);
+        Log("%-6s %10s %10s %10s %10s %10s %10s %10s %12s\n", "view", "budget", "occl tris", "raster ms", "test ms", "meshes", "frustum", "occlusion", "pixels diff");
+
+        OcclusionCuller culler;
+        SoftwareRasterizer rasterizer;
+
+        for (uint32_t budget : budgets)
+        {
+            OccluderMesh occluder;
+            if (FAILED(BuildOccluderMesh(mesh, budget, occluder)))
+            {
+                Log("Failed to build an occluder from %ls\n", path.c_str());
+                return;
+            }
+
+            for (uint32_t v = 0; v < OcclusionScene::ViewCount; ++v)
+            {
+                const XMMATRIX view = XMLoadFloat4x4(&scene.Views[v]);
+                const XMMATRIX viewProj = view * XMLoadFloat4x4(&scene.Projection);
+
+                std::vector<MeshletCullParams> params(instanceCount);
+                std::vector<VisibleMeshlets> frustumVisible(instanceCount);
+                std::vector<VisibleMeshlets> visible(instanceCount);
+                std::vector<bool> meshVisible(instanceCount);
+                uint64_t frustumCount = 0;
+
+                for (uint32_t i = 0; i < instanceCount; ++i)
+                {
+                    params[i].World = scene.Worlds[i];
+                    params[i].Scale = 1.0f;
+                    ComputeFrustumPlanes(viewProj, params[i].Planes);
+                    params[i].ViewPosition = scene.Eyes[v];
+
+                    CullMeshlets(mesh, params[i], frustumVisible[i]);
+                    frustumCount += frustumVisible[i].Indices.size();
+                }
+
+                double best[2] = { 1e30, 1e30 };
+                for (uint32_t n = 0; n < c_iterationCount; ++n)
+                {
+                    auto start = Clock::now();
+                    culler.Clear(viewProj);
+                    for (uint32_t i = 0; i < c_occluderInstances; ++i)
+                    {
+                        culler.RenderOccluder(occluder, XMLoadFloat4x4(&scene.Worlds[i]));
+                    }
+                    best[0] = min(best[0], ElapsedMs(start));
+
+                    start = Clock::now();
+                    for (uint32_t i = 0; i < instanceCount; ++i)
+                    {
+                        visible[i] = frustumVisible[i];
+                        meshVisible[i] = culler.IsMeshVisible(mesh, params[i]);
+                        if (meshVisible[i])
+                        {
+                            culler.CullOccludedMeshlets(mesh, params[i], visible[i]);
+                        }
+                        else
+                        {
+                            visible[i].Indices.clear();
+                            for (auto& subset : visible[i].Subsets)
+                            {
+                                subset.Offset = 0;
+                                subset.Count = 0;
+                            }
+                        }
+                    }
+                    best[1] = min(best[1], ElapsedMs(start));
+                }
+
+                uint64_t occlusionCount = 0;
+                uint32_t meshCount = 0;
+                for (uint32_t i = 0; i < instanceCount; ++i)
+                {
+                    occlusionCount += visible[i].Indices.size();
+                    meshCount += meshVisible[i];
+                }
+
+                // Render both sets and count the pixels the occlusion stage lost.
+                std::vector<uint32_t> images[2];
+                RenderOcclusionScene(rasterizer, c_width, c_height, mesh, scene, view, frustumVisible, images[0]);
+                RenderOcclusionScene(rasterizer, c_width, c_height, mesh, scene, view, visible, images[1]);
+
+                Log("%-6u %10u %10u %10.3f %10.3f %7u/%-2u %10u %9.1f%% %11.3f%%\n", v, budget, culler.GetStats().OccluderTriangleCount, best[0], best[1],
+                    meshCount, instanceCount, static_cast<uint32_t>(frustumCount), 100.0 * occlusionCount / max(double(frustumCount), 1.0), PercentDiffering(images[0], images[1]));
+            }
+        }
+    }
+    // Flies two camera paths over the occlusion scene, a nearly still one and a slow pan, and culls
+    // each frame with simplified occluders and with the two-phase temporal culler at a few occluder
+    // budgets. Reports the culling cost per frame, the triangles rasterized as occluders, how much of
+    // what two-phase draws comes from last frame's set, and on the last frame how many pixels either
+    // loses against frustum culling alone.
+    void BenchmarkTemporalOcclusion(const std::wstring& assetDirectory)
+    {
+        const uint32_t c_frameCount = 32;
+        const uint32_t c_occluderInstances = 10;
+        const uint32_t c_occluderTriangles = 256;
+        const uint32_t c_width = 1280;
+        const uint32_t c_height = 720;
+        const uint32_t c_budgets[] = { 0, 4096, 16384, 65536 };   // 0 culls with simplified occluders
+
+        struct CameraPath
+        {
+            const char* Name;
+            float       Yaw;        // Total turn over the path
+        };
+
+        const CameraPath paths[] = { { "still", 0.01f }, { "pan", 0.5f } };
+
+        const std::wstring path = assetDirectory + c_assetFilenames[2];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            Log("Failed to load %ls\n", path.c_str());
+            return;
+        }
+
+        const Mesh& mesh = *model.begin();
+
+        OccluderMesh occluder;
+        if (FAILED(BuildOccluderMesh(mesh, c_occluderTriangles, occluder)))
+        {
+            Log("Failed to build an occluder from %ls\n", path.c_str());
+            return;
+        }
+
+        OcclusionScene scene;
+        MakeOcclusionScene(model, c_width, c_height, scene);
+
+        const uint32_t instanceCount = static_cast<uint32_t>(scene.Worlds.size());
+
+        Log("\nTemporal occlusion culling (%ls x %u, %u frames, 256x128)\n", c_assetFilenames[2], instanceCount, c_frameCount);
+        Log("%-6s %-10s %10s %10s %10s %10s %10s %10s %12s\n", "path", "mode", "ms/frame", "occluders", "frustum", "drawn", "reused", "revealed", "pixels diff");
+
+        SoftwareRasterizer rasterizer;
+
+        for (auto& cameraPath : paths)
+        {
+            for (uint32_t budget : c_budgets)
+            {
+                const bool temporal = budget != 0;
+
+                OcclusionCuller culler;
+                TemporalOcclusionCuller temporalCuller(256, 128, budget);
+
+                std::vector<MeshletCullParams> params(instanceCount);
+                std::vector<VisibleMeshlets> frustumVisible(instanceCount);
+                std::vector<VisibleMeshlets> drawn(instanceCount);
+                std::vector<VisibleMeshlets> previous(instanceCount);
+                std::vector<VisibleMeshlets> revealed(instanceCount);
+
+                double elapsed = 0.0;
+                uint64_t frustumCount = 0;
+                uint64_t drawnCount = 0;
+                uint64_t previousCount = 0;
+                uint64_t revealedCount = 0;
+                uint64_t occluderCount = temporal ? 0 : uint64_t(c_occluderInstances) * occluder.Indices.size() / 3 * c_frameCount;
+                XMMATRIX view = XMMatrixIdentity();
+
+                for (uint32_t f = 0; f < c_frameCount; ++f)
+                {
+                    XMFLOAT4X4 viewMatrix;
+                    XMFLOAT3 eye;
+                    MakeOcclusionView(model, cameraPath.Yaw * (float(f) / c_frameCount - 0.5f), 0.1f, viewMatrix, eye);
+
+                    view = XMLoadFloat4x4(&viewMatrix);
+                    const XMMATRIX viewProj = view * XMLoadFloat4x4(&scene.Projection);
+
+                    for (uint32_t i = 0; i < instanceCount; ++i)
+                    {
+                        params[i].World = scene.Worlds[i];
+                        params[i].Scale = 1.0f;
+                        ComputeFrustumPlanes(viewProj, params[i].Planes);
+                        params[i].ViewPosition = eye;
+                    }
+
+                    auto start = Clock::now();
+                    if (temporal)
+                    {
+                        temporalCuller.BeginFrame(viewProj);
+                        for (uint32_t i = 0; i < instanceCount; ++i)
+                        {
+                            temporalCuller.CullPhaseOne(i, mesh, params[i], previous[i]);
+                        }
+                        for (uint32_t i = 0; i < instanceCount; ++i)
+                        {
+                            temporalCuller.CullPhaseTwo(i, mesh, params[i], revealed[i]);
+                        }
+                    }
+                    else
+                    {
+                        culler.Clear(viewProj);
+                        for (uint32_t i = 0; i < c_occluderInstances; ++i)
+                        {
+                            culler.RenderOccluder(occluder, XMLoadFloat4x4(&scene.Worlds[i]));
+                        }
+                        for (uint32_t i = 0; i < instanceCount; ++i)
+                        {
+                            CullMeshlets(mesh, params[i], drawn[i]);
+                            culler.CullOccludedMeshlets(mesh, params[i], drawn[i]);
+                        }
+                    }
+                    elapsed += ElapsedMs(start);
+
+                    for (uint32_t i = 0; i < instanceCount; ++i)
+                    {
+                        CullMeshlets(mesh, params[i], frustumVisible[i]);
+                        frustumCount += frustumVisible[i].Indices.size();
+
+                        if (temporal)
+                        {
+                            MergeVisibleMeshlets(previous[i], revealed[i], drawn[i]);
+                        }
+                        drawnCount += drawn[i].Indices.size();
+                    }
+
+                    if (temporal)
+                    {
+                        previousCount += temporalCuller.GetStats().PreviousCount;
+                        revealedCount += temporalCuller.GetStats().RevealedCount;
+                        occluderCount += temporalCuller.GetStats().OccluderTriangleCount;
+                    }
+                }
+
+                std::vector<uint32_t> images[2];
+                RenderOcclusionScene(rasterizer, c_width, c_height, mesh, scene, view, frustumVisible, images[0]);
+                RenderOcclusionScene(rasterizer, c_width, c_height, mesh, scene, view, drawn, images[1]);
+
+                char reused[16] = "-";
+                char revealedPerFrame[16] = "-";
+                if (temporal)
+                {
+                    snprintf(reused, sizeof(reused), "%.1f%%", 100.0 * previousCount / max(double(drawnCount), 1.0));
+                    snprintf(revealedPerFrame, sizeof(revealedPerFrame), "%.1f", double(revealedCount) / c_frameCount);
+                }
+
+                Log("%-6s %-10s %10.3f %10u %10u %10u %10s %10s %11.3f%%\n", cameraPath.Name, temporal ? "two-phase" : "occluders", elapsed / c_frameCount,
+                    static_cast<uint32_t>(occluderCount / c_frameCount), static_cast<uint32_t>(frustumCount / c_frameCount), static_cast<uint32_t>(drawnCount / c_frameCount), reused, revealedPerFrame,
+                    PercentDiffering(images[0], images[1]));
+            }
+        }
+    }
+
+    const uint32_t c_instanceGridSizes[] = { 100, 320 };
+    const uint32_t c_instanceViewCount = 8;
+    const uint32_t c_instanceSlotSize = 256;   // FrameResource::SceneConstantBuffer
+
+    // The old FrameResource::UpdateConstantBuffers: every instance's MVP, multiplied and copied one by one.
+    void XM_CALLCONV UpdateEveryInstance(const std::vector<XMFLOAT4X4>& worlds, FXMMATRIX view, CXMMATRIX projection, uint8_t* constants)
+    {
+        XMFLOAT4X4 mvp;
+        for (uint32_t i = 0; i < worlds.size(); ++i)
+        {
+            XMStoreFloat4x4(&mvp, XMMatrixTranspose(XMLoadFloat4x4(&worlds[i]) * view * projection));
+            memcpy(constants + size_t(i) * c_instanceSlotSize, &mvp, sizeof(mvp));
+        }
+    }
+
+    // FrameResource's city grid, scaled up and seen from its middle in every direction.
+    struct InstanceScene
+    {
+        std::vector<XMFLOAT4X4> Worlds;
+        std::vector<XMFLOAT4X4> Views;
+        XMFLOAT4X4              Projection;
+        BoundingSphere          Bounds;
+    };
+
+    void MakeInstanceScene(uint32_t gridSize, InstanceScene& scene)
+    {
+        const float c_spacing = 8.0f;
+        const uint32_t count = gridSize * gridSize;
+
+        scene.Bounds = BoundingSphere(XMFLOAT3(0.0f, 1.0f, 0.0f), 4.0f);
+
+        scene.Worlds.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            XMStoreFloat4x4(&scene.Worlds[i], XMMatrixTranslation((i % gridSize) * c_spacing, 0.0f, (i / gridSize) * -c_spacing));
+        }
+
+        const float extent = gridSize * c_spacing;
+        XMStoreFloat4x4(&scene.Projection, XMMatrixPerspectiveFovRH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, extent));
+
+        scene.Views.resize(c_instanceViewCount);
+        for (uint32_t v = 0; v < c_instanceViewCount; ++v)
+        {
+            const float yaw = XM_2PI * v / c_instanceViewCount;
+            const XMVECTOR eye = XMVectorSet(extent * 0.5f, 20.0f, -extent * 0.5f, 1.0f);
+            XMStoreFloat4x4(&scene.Views[v], XMMatrixLookToRH(eye, XMVectorSet(sinf(yaw), -0.2f, cosf(yaw), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+        }
+    }
+
+    // Compares the constant update of FrameResource's city grid, scaled up, before and after batching:
+    // the per-instance loop against InstanceCuller with and without frustum culling. InstanceCullerTests
+    // checks the culled results against a scalar sphere test and the per-instance matrices.
+    void BenchmarkInstanceCulling()
+    {
+        Log("\nInstance culling (%u views, best of %u)\n", c_instanceViewCount, c_iterationCount);
+        Log("%-8s %-14s %10s %14s %9s\n", "grid", "mode", "us/frame", "ns/instance", "drawn");
+
+        for (uint32_t gridSize : c_instanceGridSizes)
+        {
+            const uint32_t count = gridSize * gridSize;
+
+            InstanceScene scene;
+            MakeInstanceScene(gridSize, scene);
+
+            const auto& worlds = scene.Worlds;
+            const auto& views = scene.Views;
+            const BoundingSphere& bounds = scene.Bounds;
+            const XMMATRIX projection = XMLoadFloat4x4(&scene.Projection);
+
+            InstanceCuller culler;
+            culler.SetInstances(worlds.data(), count, bounds);
+
+            // Upload heaps are at least 64KB aligned; 256 bytes is enough for the streaming stores.
+            std::vector<uint8_t> storage(size_t(count) * c_instanceSlotSize + c_instanceSlotSize);
+            uint8_t* constants = storage.data() + (c_instanceSlotSize - reinterpret_cast<uintptr_t>(storage.data()) % c_instanceSlotSize) % c_instanceSlotSize;
+
+            std::vector<uint32_t> visible;
+            uint64_t drawnCount = 0;
+
+            for (auto& view : views)
+            {
+                const XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+                culler.Cull(viewMatrix * projection, constants, c_instanceSlotSize, visible);
+                drawnCount += visible.size();
+            }
+
+            const char* c_modes[] = { "per-instance", "batched", "batched+cull" };
+            for (uint32_t m = 0; m < _countof(c_modes); ++m)
+            {
+                double best = 1e30;
+                for (uint32_t n = 0; n < c_iterationCount; ++n)
+                {
+                    auto start = Clock::now();
+                    for (auto& view : views)
+                    {
+                        const XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+                        if (m == 0)
+                        {
+                            UpdateEveryInstance(worlds, viewMatrix, projection, constants);
+                        }
+                        else
+                        {
+                            culler.Cull(viewMatrix * projection, constants, c_instanceSlotSize, visible, m == 2);
+                        }
+                    }
+                    best = min(best, ElapsedMs(start));
+                }
+
+                const double us = best * 1e3 / c_instanceViewCount;
+                const double drawn = m == 2 ? double(drawnCount) / c_instanceViewCount : double(count);
+
+                char grid[16];
+                snprintf(grid, sizeof(grid), "%ux%u", gridSize, gridSize);
+                Log("%-8s %-14s %10.1f %14.2f %9.0f\n", grid, c_modes[m], us, us * 1e3 / count, drawn);
+            }
+        }
+    }
+
+    // Sums a tree of tasks: leafCount leaves each sum a slice of values, and every inner node adds
+    // its two children once both have finished.
+    double SumTaskTree(ThreadPool& pool, const std::vector<float>& values, uint32_t leafCount)
+    {
+        std::vector<double> sums(2 * leafCount);
+        std::vector<ThreadPool::TaskHandle> tasks(2 * leafCount);
+
+        const size_t sliceSize = values.size() / leafCount;
+        for (uint32_t i = 0; i < leafCount; ++i)
+        {
+            tasks[leafCount + i] = pool.Schedule([&, i]()
+            {
+                double sum = 0.0;
+                for (size_t k = i * sliceSize; k < (i + 1) * sliceSize; ++k)
+                {
+                    sum += sqrt(values[k]);
+                }
+                sums[leafCount + i] = sum;
+            });
+        }
+
+        for (uint32_t i = leafCount - 1; i > 0; --i)
+        {
+            tasks[i] = pool.Schedule([&sums, i]() { sums[i] = sums[2 * i] + sums[2 * i + 1]; }, { tasks[2 * i], tasks[2 * i + 1] });
+        }
+
+        pool.Wait(tasks[1]);
+        return sums[1];
+    }
+
+    // Scaling of the thread pool with its worker count on three workloads: regenerating
+    // Dragon_LOD1's cull data (ParallelFor), culling the 320x320 city grid (two ParallelFors per
+    // frame) and summing a tree of 8191 dependent tasks. The calling thread helps in all three, so
+    // a pool of N workers runs up to N + 1 threads.
+    void BenchmarkJobSystem(const std::wstring& assetDirectory)
+    {
+        const uint32_t c_leafCount = 4096;
+
+        const std::wstring path = assetDirectory + c_assetFilenames[0];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            Log("Failed to load %ls\n", path.c_str());
+            return;
+        }
+
+        const Mesh& mesh = *model.begin();
+        std::vector<CullData> cullData;
+
+        InstanceScene scene;
+        MakeInstanceScene(c_instanceGridSizes[_countof(c_instanceGridSizes) - 1], scene);
+
+        const uint32_t instanceCount = static_cast<uint32_t>(scene.Worlds.size());
+        InstanceCuller culler;
+        culler.SetInstances(scene.Worlds.data(), instanceCount, scene.Bounds);
+
+        std::vector<uint8_t> storage(size_t(instanceCount) * c_instanceSlotSize + c_instanceSlotSize);
+        uint8_t* constants = storage.data() + (c_instanceSlotSize - reinterpret_cast<uintptr_t>(storage.data()) % c_instanceSlotSize) % c_instanceSlotSize;
+        std::vector<uint32_t> visible;
+
+        std::vector<float> values(c_leafCount * 512);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = float(i % 1000);
+        }
+
+        Log("\nJob system scaling (best of %u)\n", c_iterationCount);
+        Log("%-8s %14s %8s %14s %8s %14s %8s\n", "workers", "cull data ms", "speedup", "instances ms", "speedup", "task tree ms", "speedup");
+
+        double baseline[3] = {};
+
+        const uint32_t maxWorkers = max(1u, std::thread::hardware_concurrency());
+        for (uint32_t workerCount = 1; workerCount <= maxWorkers; workerCount *= 2)
+        {
+            ThreadPool pool(workerCount);
+            double best[3] = { 1e30, 1e30, 1e30 };
+
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                if (FAILED(GenerateCullData(mesh, cullData, pool)))
+                {
+                    Log("Failed to generate cull data for %ls\n", path.c_str());
+                    return;
+                }
+                best[0] = min(best[0], ElapsedMs(start));
+
+                start = Clock::now();
+                for (auto& view : scene.Views)
+                {
+                    culler.Cull(XMLoadFloat4x4(&view) * XMLoadFloat4x4(&scene.Projection), constants, c_instanceSlotSize, visible, true, pool);
+                }
+                best[1] = min(best[1], ElapsedMs(start));
+
+                start = Clock::now();
+                SumTaskTree(pool, values, c_leafCount);
+                best[2] = min(best[2], ElapsedMs(start));
+            }
+
+            if (workerCount == 1)
+            {
+                std::copy(best, best + 3, baseline);
+            }
+
+            Log("%-8u %14.3f %7.2fx %14.3f %7.2fx %14.3f %7.2fx\n", workerCount, best[0], baseline[0] / best[0], best[1], baseline[1] / best[1],
+                best[2], baseline[2] / best[2]);
+        }
+    }
+
+    // Records a frame's meshlet ranges the way DX12Practice::RecordChunk does, with the command lists
+    // taken out: the packets of every chunk come from one allocation in the frame's arena, where the
+    // app takes them from the upload ring, and each chunk builds its meshes' packets.
+    class FramePacketRecorder : public ChunkRecordingTarget
+    {
+    public:
+        FramePacketRecorder(const FrameMeshletRanges& ranges, LinearArena& arena) :
+            m_ranges(ranges), m_arena(arena), m_packets(nullptr), m_packetCount(0)
+        {
+        }
+
+        uint32_t GetMaxChunkCount() override { return ThreadPool::GetDefault().GetThreadCount() + 1; }
+
+        HRESULT BeginChunks(const RecordingChunk* chunks, uint32_t chunkCount) override
+        {
+            uint32_t packetCount = 0;
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                const uint32_t first = m_ranges.RangeBases[chunks[c].FirstItem];
+                m_packetBases[c] = packetCount;
+                packetCount += GetMaxDrawPacketCount(m_ranges.Ranges + first, m_ranges.RangeBases[chunks[c].FirstItem + chunks[c].ItemCount] - first);
+            }
+            m_packets = m_arena.Allocate<DrawPacket>(packetCount);
+            return S_OK;
+        }
+
+        HRESULT RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk) override
+        {
+            DrawPacket* packets = m_packets + m_packetBases[chunkIndex];
+            uint32_t packetCount = 0;
+            for (uint32_t m = chunk.FirstItem; m < chunk.FirstItem + chunk.ItemCount; ++m)
+            {
+                const uint32_t first = m_ranges.RangeBases[m];
+                packetCount += BuildDrawPackets(m_ranges.Ranges + first, m_ranges.RangeBases[m + 1] - first, packets + packetCount);
+            }
+            m_chunkPacketCounts[chunkIndex] = packetCount;
+            return S_OK;
+        }
+
+        HRESULT SubmitChunks(uint32_t chunkCount) override
+        {
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                m_packetCount += m_chunkPacketCounts[c];
+            }
+            return S_OK;
+        }
+
+        uint64_t GetPacketCount() const { return m_packetCount; }
+
+    private:
+        const FrameMeshletRanges& m_ranges;
+        LinearArena& m_arena;
+        DrawPacket* m_packets;
+        uint32_t m_packetBases[c_maxRecordingChunks] = {};
+        uint32_t m_chunkPacketCounts[c_maxRecordingChunks] = {};
+        uint64_t m_packetCount;
+    };
+
+    // Heap allocations per frame of the per-frame CPU work, on every thread: occlusion culling the
+    // occlusion scene, culling the 100x100 city grid, then what DX12Practice does with the culled
+    // meshlets in one of three frame arenas: building the dispatch runs, gathering the meshlet ranges
+    // and recording them in chunks. The warm-up frames let every buffer grow to its largest view, and the pool's
+    // queues and ParallelFor states to the most that lagging workers leave in flight; from then on
+    // each stage should allocate nothing. Needs a build with COUNT_HEAP_ALLOCATIONS defined.
+    void BenchmarkFrameAllocations(const std::wstring& assetDirectory)
+    {
+        if (!HeapCounter::c_enabled)
+        {
+            Log("\nFrame allocations not counted; define COUNT_HEAP_ALLOCATIONS to count them\n");
+            return;
+        }
+
+        const uint32_t c_frameCount = 384;
+        const uint32_t c_warmUpFrames = 128;
+        const uint32_t c_occluderInstances = 10;
+        const uint32_t c_occluderTriangles = 1024;
+        const uint32_t c_frameArenaCount = 3;       // DX12Practice::FrameCount
+        const uint64_t c_minChunkCost = 64;         // DX12Practice::c_minRecordingChunkCost
+
+        const std::wstring path = assetDirectory + c_assetFilenames[2];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            Log("Failed to load %ls\n", path.c_str());
+            return;
+        }
+
+        const Mesh& mesh = *model.begin();
+
+        OcclusionScene occlusionScene;
+        MakeOcclusionScene(model, 256, 128, occlusionScene);
+
+        OccluderMesh occluder;
+        if (FAILED(BuildOccluderMesh(mesh, c_occluderTriangles, occluder)))
+        {
+            Log("Failed to build an occluder from %ls\n", path.c_str());
+            return;
+        }
+
+        InstanceScene instanceScene;
+        MakeInstanceScene(c_instanceGridSizes[0], instanceScene);
+
+        const uint32_t meshInstanceCount = static_cast<uint32_t>(occlusionScene.Worlds.size());
+        const uint32_t cityCount = static_cast<uint32_t>(instanceScene.Worlds.size());
+
+        InstanceCuller instanceCuller;
+        instanceCuller.SetInstances(instanceScene.Worlds.data(), cityCount, instanceScene.Bounds);
+
+        std::vector<uint8_t> storage(size_t(cityCount) * c_instanceSlotSize + c_instanceSlotSize);
+        uint8_t* constants = storage.data() + (c_instanceSlotSize - reinterpret_cast<uintptr_t>(storage.data()) % c_instanceSlotSize) % c_instanceSlotSize;
+
+        ThreadPool& pool = ThreadPool::GetDefault();
+        OcclusionCuller occlusionCuller;
+        LinearArena frameArenas[c_frameArenaCount];
+        std::vector<MeshletCullParams> params(meshInstanceCount);
+        std::vector<VisibleMeshlets> visible(meshInstanceCount);
+        std::vector<uint32_t> visibleCities;
+        const std::vector<const Mesh*> meshes(meshInstanceCount, &mesh);
+
+        uint64_t allocations[2][5] = {};    // Warm-up and steady frames, per stage
+        uint64_t runCount = 0;
+        uint64_t packetCount = 0;
+        uint32_t recordErrors = 0;
+
+        for (uint32_t f = 0; f < c_frameCount; ++f)
+        {
+            const uint32_t v = f % OcclusionScene::ViewCount;
+            const XMMATRIX meshViewProj = XMLoadFloat4x4(&occlusionScene.Views[v]) * XMLoadFloat4x4(&occlusionScene.Projection);
+            const XMMATRIX cityViewProj = XMLoadFloat4x4(&instanceScene.Views[f % c_instanceViewCount]) * XMLoadFloat4x4(&instanceScene.Projection);
+            uint64_t* counts = allocations[f >= c_warmUpFrames];
+
+            uint64_t start = HeapCounter::GetAllocationCount();
+            occlusionCuller.Clear(meshViewProj);
+            for (uint32_t i = 0; i < c_occluderInstances; ++i)
+            {
+                occlusionCuller.RenderOccluder(occluder, XMLoadFloat4x4(&occlusionScene.Worlds[i]));
+            }
+            for (uint32_t i = 0; i < meshInstanceCount; ++i)
+            {
+                params[i].World = occlusionScene.Worlds[i];
+                params[i].Scale = 1.0f;
+                ComputeFrustumPlanes(meshViewProj, params[i].Planes);
+                params[i].ViewPosition = occlusionScene.Eyes[v];
+
+                CullMeshlets(mesh, params[i], visible[i]);
+                occlusionCuller.CullOccludedMeshlets(mesh, params[i], visible[i]);
+            }
+            counts[0] += HeapCounter::GetAllocationCount() - start;
+
+            start = HeapCounter::GetAllocationCount();
+            instanceCuller.Cull(cityViewProj, constants, c_instanceSlotSize, visibleCities, true, pool);
+            counts[1] += HeapCounter::GetAllocationCount() - start;
+
+            start = HeapCounter::GetAllocationCount();
+            LinearArena& arena = frameArenas[f % c_frameArenaCount];
+            arena.Reset();
+            DispatchRuns runs;
+            BuildDispatchRuns(visible.data(), meshInstanceCount, arena, pool, runs);
+            counts[2] += HeapCounter::GetAllocationCount() - start;
+
+            start = HeapCounter::GetAllocationCount();
+            FrameMeshletRanges ranges;
+            GatherMeshletRanges(meshes.data(), meshInstanceCount, &runs, arena, ranges);
+            counts[3] += HeapCounter::GetAllocationCount() - start;
+
+            start = HeapCounter::GetAllocationCount();
+            FramePacketRecorder recorder(ranges, arena);
+            recordErrors += FAILED(RecordInChunks(recorder, ranges.RecordCosts, meshInstanceCount, c_minChunkCost, pool));
+            counts[4] += HeapCounter::GetAllocationCount() - start;
+
+            runCount += ranges.RangeBases[meshInstanceCount];
+            packetCount += recorder.GetPacketCount();
+        }
+
+        const uint32_t steadyFrames = c_frameCount - c_warmUpFrames;
+
+        Log("\nFrame allocations (%u frames after %u warm-up, %u workers)\n", steadyFrames, c_warmUpFrames, pool.GetThreadCount());
+        Log("%-16s %14s %14s\n", "stage", "warm-up/frame", "steady/frame");
+
+        const char* stages[] = { "meshlet culling", "instance cull", "dispatch runs", "meshlet ranges", "record chunks" };
+        for (uint32_t s = 0; s < _countof(stages); ++s)
+        {
+            Log("%-16s %14.1f %14.2f\n", stages[s], double(allocations[0][s]) / c_warmUpFrames, double(allocations[1][s]) / steadyFrames);
+        }
+
+        Log("%u dispatch runs and %u draw packets per frame, arena of %u KB, %u recording errors\n", static_cast<uint32_t>(runCount / c_frameCount),
+            static_cast<uint32_t>(packetCount / c_frameCount), static_cast<uint32_t>(frameArenas[0].GetCapacity() / 1024), recordErrors);
+    }
+
+    // Drives a RingAllocator the way DX12Practice drives its UploadRing, against a fake fence which
+    // trails the submissions by up to two frames: a 256-byte constant buffer per frame and mesh
+    // uploads of up to an eighth of the ring. When an allocation doesn't fit, unsubmitted ranges are
+    // submitted, as Model::UploadGpuResources does, or the fake GPU is stepped to the oldest pending
+    // fence, as UploadRing::Allocate waits for it. UploadRingTests.cpp checks the same frames for
+    // overlapping ranges. The second ring's capacity isn't a power of two.
+    void BenchmarkUploadRing()
+    {
+        const uint64_t c_capacities[] = { 1024 * 1024, 768 * 1024 };
+        const uint32_t c_frameCount = 20000;
+        const uint32_t c_maxFrameLag = 2;
+
+        Log("\nUpload ring (%u frames, fake fence up to %u frames behind)\n", c_frameCount, c_maxFrameLag);
+        Log("%10s %12s %10s %14s %8s %10s %10s\n", "ring KB", "allocations", "MB", "early submits", "stalls", "peak KB", "us/frame");
+
+        for (uint64_t capacity : c_capacities)
+        {
+            RingAllocator ring(capacity);
+            std::mt19937 random(1);
+
+            uint64_t submitted = 0;
+            uint64_t completed = 0;
+            uint64_t allocationCount = 0;
+            uint64_t allocatedBytes = 0;
+            uint64_t earlySubmits = 0;
+            uint64_t stalls = 0;
+            uint64_t peakUsed = 0;
+
+            auto retire = [&](uint64_t fenceValue)
+            {
+                completed = max(completed, fenceValue);
+                ring.Retire(completed);
+            };
+
+            auto submit = [&]()
+            {
+                ring.Submit(++submitted);
+            };
+
+            auto start = Clock::now();
+
+            for (uint32_t f = 0; f < c_frameCount; ++f)
+            {
+                retire(submitted - min<uint64_t>(submitted, random() % (c_maxFrameLag + 1)));
+
+                // The constants come last, after the uploads of the frame were submitted.
+                const uint32_t uploadCount = random() % 4 == 0 ? random() % 16 : 0;
+                for (uint32_t u = 0; u <= uploadCount; ++u)
+                {
+                    const bool constants = u == uploadCount;
+                    const uint64_t size = constants ? 256 : 1 + random() % (capacity / 8);
+                    const uint64_t alignment = constants ? 256 : 16;
+
+                    uint64_t offset = 0;
+                    while (!ring.Allocate(size, alignment, offset))
+                    {
+                        if (ring.GetOldestPendingFence() == 0)
+                        {
+                            submit();
+                            earlySubmits++;
+                        }
+                        else
+                        {
+                            retire(ring.GetOldestPendingFence());
+                            stalls++;
+                        }
+                    }
+
+                    allocationCount++;
+                    allocatedBytes += size;
+                    peakUsed = max(peakUsed, ring.GetUsedSize());
+
+                    if (!constants && u + 1 == uploadCount)
+                    {
+                        submit();
+                    }
+                }
+
+                submit();
+            }
+
+            const double elapsedMs = ElapsedMs(start);
+
+            Log("%10u %12u %10.1f %14u %8u %10u %10.3f\n", static_cast<uint32_t>(capacity / 1024), static_cast<uint32_t>(allocationCount), allocatedBytes / (1024.0 * 1024.0),
+                static_cast<uint32_t>(earlySubmits), static_cast<uint32_t>(stalls), static_cast<uint32_t>(peakUsed / 1024), elapsedMs * 1000.0 / c_frameCount);
+        }
+    }
+
+    // Stand-in for the GPU behind an UploadBatch: staging is a RingAllocator over CPU memory which
+    // a wait retires, and the copies and barriers are only counted. UploadBatchTests.cpp checks what
+    // lands in the destinations.
+    class CountingUploadQueue : public UploadQueue
+    {
+    public:
+        explicit CountingUploadQueue(uint64_t stagingCapacity)
+            : m_staging(stagingCapacity)
+            , m_ring(stagingCapacity)
+            , m_submitted(0)
+            , m_completed(0)
+            , SubmitCount(0)
+            , WaitCount(0)
+            , BarrierCallCount(0)
+        { }
+
+        uint64_t GetStagingCapacity() override { return m_ring.GetCapacity(); }
+
+        HRESULT AllocateStaging(uint64_t size, uint64_t alignment, UploadAllocation& allocation) override
+        {
+            uint64_t offset = 0;
+            while (!m_ring.Allocate(size, alignment, offset))
+            {
+                if (m_ring.GetOldestPendingFence() == 0)
+                {
+                    return E_PENDING;
+                }
+                Wait(m_ring.GetOldestPendingFence());
+            }
+
+            allocation.CpuAddress = m_staging.data() + offset;
+            allocation.GpuAddress = offset;
+            allocation.Resource = nullptr;
+            allocation.Offset = offset;
+            return S_OK;
+        }
+
+        HRESULT Begin() override { return S_OK; }
+        void CopyBufferRegion(ID3D12Resource*, uint64_t, const UploadAllocation&, uint64_t) override { }
+        void ResourceBarrier(uint32_t, const D3D12_RESOURCE_BARRIER*) override { BarrierCallCount++; }
+
+        HRESULT Execute(UploadToken& token) override
+        {
+            token = ++m_submitted;
+            m_ring.Submit(token);
+            SubmitCount++;
+            return S_OK;
+        }
+
+        void Abandon() override { }
+
+        bool IsComplete(UploadToken token) override { return m_completed >= token; }
+
+        HRESULT Wait(UploadToken token) override
+        {
+            if (m_completed < token)
+            {
+                WaitCount++;
+                m_completed = token;
+                m_ring.Retire(m_completed);
+            }
+            return S_OK;
+        }
+
+        uint32_t SubmitCount;
+        uint32_t WaitCount;
+        uint32_t BarrierCallCount;
+
+    private:
+        std::vector<uint8_t> m_staging;
+        RingAllocator        m_ring;
+        uint64_t             m_submitted;
+        uint64_t             m_completed;
+    };
+
+    struct StagedBuffer
+    {
+        ID3D12Resource* Dest;
+        const void*     Data;
+        uint64_t        Size;
+    };
+
+    // The buffers Model::UploadGpuResources stages for a mesh, with made-up destinations.
+    HRESULT StageMesh(UploadBatch& batch, const Mesh& mesh, std::vector<StagedBuffer>& staged, std::vector<MeshInfo>& infos)
+    {
+        MeshInfo& info = infos[staged.size() % infos.size()];
+        info.IndexSize = mesh.IndexSize;
+        info.MeshletCount = static_cast<uint32_t>(mesh.Meshlets.size());
+        info.LastMeshletVertCount = mesh.Meshlets.back().VertCount;
+        info.LastMeshletPrimCount = mesh.Meshlets.back().PrimCount;
+
+        std::vector<StagedBuffer> buffers;
+        for (auto& stream : mesh.Vertices)
+        {
+            buffers.push_back(StagedBuffer{ nullptr, stream.data(), stream.size() });
+        }
+        buffers.push_back(StagedBuffer{ nullptr, mesh.Indices.data(), mesh.Indices.size() });
+        buffers.push_back(StagedBuffer{ nullptr, mesh.Meshlets.data(), mesh.Meshlets.size() * sizeof(mesh.Meshlets[0]) });
+        buffers.push_back(StagedBuffer{ nullptr, mesh.CullingData.data(), mesh.CullingData.size() * sizeof(mesh.CullingData[0]) });
+        buffers.push_back(StagedBuffer{ nullptr, mesh.UniqueVertexIndices.data(), mesh.UniqueVertexIndices.size() });
+        buffers.push_back(StagedBuffer{ nullptr, mesh.PrimitiveIndices.data(), mesh.PrimitiveIndices.size() * sizeof(mesh.PrimitiveIndices[0]) });
+        buffers.push_back(StagedBuffer{ nullptr, &info, sizeof(MeshInfo) });
+
+        for (auto& buffer : buffers)
+        {
+            buffer.Dest = reinterpret_cast<ID3D12Resource*>(staged.size() + 1);
+            staged.push_back(buffer);
+
+            HRESULT hr = batch.Stage(buffer.Dest, buffer.Data, buffer.Size, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        return S_OK;
+    }
+
+    // Uploads the meshes of every asset through a counting stand-in queue, the old way (a submit and
+    // a wait per mesh), per mesh without waiting, and as a single batch across every model with one
+    // wait at the end, and with staging large and small enough to overflow.
+    void BenchmarkBatchedUpload(const std::wstring& assetDirectory)
+    {
+        enum Mode { PerMeshWait, PerMesh, Batched, ModeCount };
+        const char* modeNames[] = { "per mesh+wait", "per mesh", "one batch" };
+        const uint64_t stagingSizes[] = { 32 * 1024 * 1024, 4 * 1024 * 1024 };
+
+        std::vector<std::unique_ptr<Model>> models;
+        uint32_t meshCount = 0;
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            models.push_back(std::make_unique<Model>());
+            if (FAILED(models.back()->LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+            meshCount += models.back()->GetMeshCount();
+        }
+
+        Log("\nBatched upload (%u models, %u meshes, counting queue, best of %u)\n", static_cast<uint32_t>(models.size()), meshCount, c_iterationCount);
+        Log("%-14s %10s %8s %8s %10s %10s %10s\n", "mode", "staging MB", "buffers", "submits", "waits", "barriers", "ms");
+
+        for (uint64_t stagingSize : stagingSizes)
+        {
+            for (uint32_t mode = 0; mode < ModeCount; ++mode)
+            {
+                double best = 1e30;
+                uint32_t counts[3] = {};
+                size_t bufferCount = 0;
+
+                for (uint32_t n = 0; n < c_iterationCount; ++n)
+                {
+                    CountingUploadQueue queue(stagingSize);
+                    UploadBatch batch(queue);
+                    std::vector<StagedBuffer> staged;
+                    std::vector<MeshInfo> infos(meshCount * 16);
+
+                    auto start = Clock::now();
+
+                    UploadToken token = 0;
+                    for (auto& model : models)
+                    {
+                        for (auto& mesh : *model)
+                        {
+                            StageMesh(batch, mesh, staged, infos);
+
+                            if (mode == PerMeshWait)
+                            {
+                                batch.SubmitAndWait();
+                            }
+                            else if (mode == PerMesh)
+                            {
+                                batch.Submit(token);
+                            }
+                        }
+                    }
+
+                    batch.Submit(token);
+                    batch.Wait(token);
+
+                    best = min(best, ElapsedMs(start));
+
+                    counts[0] = queue.SubmitCount;
+                    counts[1] = queue.WaitCount;
+                    counts[2] = queue.BarrierCallCount;
+                    bufferCount = staged.size();
+                }
+
+                Log("%-14s %10u %8u %8u %10u %10u %10.3f\n", modeNames[mode], static_cast<uint32_t>(stagingSize >> 20), static_cast<uint32_t>(bufferCount),
+                    counts[0], counts[1], counts[2], best);
+            }
+        }
+    }
+
+    struct GeometryRequest
+    {
+        uint64_t Size;
+        uint64_t Alignment;
+    };
+
+    // The buffers Model::UploadGpuResources allocates for a mesh.
+    void GetMeshGeometry(const Mesh& mesh, std::vector<GeometryRequest>& requests)
+    {
+        for (auto& stream : mesh.Vertices)
+        {
+            requests.push_back(GeometryRequest{ stream.size(), 16 });
+        }
+        requests.push_back(GeometryRequest{ mesh.Indices.size(), 16 });
+        requests.push_back(GeometryRequest{ mesh.Meshlets.size() * sizeof(mesh.Meshlets[0]), 16 });
+        requests.push_back(GeometryRequest{ mesh.CullingData.size() * sizeof(mesh.CullingData[0]), 16 });
+        requests.push_back(GeometryRequest{ mesh.UniqueVertexIndices.size(), 16 });
+        requests.push_back(GeometryRequest{ mesh.PrimitiveIndices.size() * sizeof(mesh.PrimitiveIndices[0]), 16 });
+        requests.push_back(GeometryRequest{ sizeof(MeshInfo), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT });
+    }
+
+    // A range of a GeometryPageTable, with the size it was allocated with.
+    struct GeometryRange
+    {
+        uint32_t Page;
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    GeometryRange AllocateGeometry(GeometryPageTable& pages, const GeometryRequest& request)
+    {
+        GeometryRange range = { 0, 0, request.Size };
+        bool addedPage;
+        pages.Allocate(request.Size, request.Alignment, range.Page, range.Offset, addedPage);
+        return range;
+    }
+
+    // Reports what the bundled assets' GPU buffers cost as a committed resource each, every one
+    // rounded up to 64 KB, against sub-allocating them from pages of a few sizes. Then times
+    // unloading and reloading random models many times.
+    void BenchmarkGeometryHeap(const std::wstring& assetDirectory)
+    {
+        const uint64_t pageSizes[] = { 4 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+        const uint32_t churnRounds = 4096;
+
+        std::vector<std::vector<GeometryRequest>> requests;  // Per model
+        uint64_t payload = 0;
+        uint64_t committedReserved = 0;
+        size_t bufferCount = 0;
+
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            Model model;
+            if (FAILED(model.LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+
+            requests.emplace_back();
+            for (auto& mesh : model)
+            {
+                GetMeshGeometry(mesh, requests.back());
+            }
+
+            for (auto& request : requests.back())
+            {
+                payload += request.Size;
+                committedReserved += (request.Size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+            }
+            bufferCount += requests.back().size();
+        }
+
+        const double mb = 1024.0 * 1024.0;
+        Log("\nGeometry heap (%u models, %u buffers, %.2f MB of data)\n", static_cast<uint32_t>(requests.size()), static_cast<uint32_t>(bufferCount), payload / mb);
+        Log("%-18s %10s %12s %12s %10s %12s\n", "layout", "resources", "reserved MB", "wasted KB", "wasted %", "reusable KB");
+        Log("%-18s %10u %12.2f %12.1f %10.1f %12.1f\n", "committed (64 KB)", static_cast<uint32_t>(bufferCount), committedReserved / mb,
+            (committedReserved - payload) / 1024.0, 100.0 * (committedReserved - payload) / committedReserved, 0.0);
+
+        for (uint64_t pageSize : pageSizes)
+        {
+            GeometryPageTable pages(pageSize);
+            for (auto& model : requests)
+            {
+                for (auto& request : model)
+                {
+                    AllocateGeometry(pages, request);
+                }
+            }
+
+            // Rounding and alignment padding are lost; the free rest of the pages is there for later loads.
+            const uint64_t reserved = pages.GetReservedSize();
+            const uint64_t used = pages.GetUsedSize();
+            char name[32];
+            snprintf(name, sizeof(name), "heap (%u MB pages)", static_cast<uint32_t>(pageSize >> 20));
+            Log("%-18s %10u %12.2f %12.1f %10.1f %12.1f\n", name, pages.GetPageCount(), reserved / mb,
+                (used - payload) / 1024.0, 100.0 * (used - payload) / reserved, (reserved - used) / 1024.0);
+        }
+
+        // Unload and reload random models, as a scene streaming its content in and out would.
+        GeometryPageTable pages(pageSizes[1]);
+        std::vector<std::vector<GeometryRange>> live(requests.size());
+        std::mt19937 rng(7);
+        uint32_t maxFreeRanges = 0;
+        uint32_t operations = 0;
+
+        auto start = Clock::now();
+
+        for (uint32_t round = 0; round < churnRounds; ++round)
+        {
+            const size_t model = rng() % requests.size();
+            for (auto& range : live[model])
+            {
+                pages.Free(range.Page, range.Offset, range.Size);
+                operations++;
+            }
+            live[model].clear();
+
+            // Most unloads are followed by a reload; the rest leave the model out for a while, so the
+            // set of live models, and the holes between them, keeps changing.
+            if (rng() % 4 != 0)
+            {
+                for (auto& request : requests[model])
+                {
+                    live[model].push_back(AllocateGeometry(pages, request));
+                    operations++;
+                }
+            }
+
+            uint32_t freeRanges = 0;
+            for (uint32_t p = 0; p < pages.GetPageCount(); ++p)
+            {
+                freeRanges += pages.GetPage(p).GetFreeRangeCount();
+            }
+            maxFreeRanges = max(maxFreeRanges, freeRanges);
+        }
+
+        const double churnMs = ElapsedMs(start);
+        Log("churn: %u rounds, %u allocs+frees in %.3f ms (%.1f ns each), %u pages, peak %u free ranges\n", churnRounds, operations, churnMs,
+            churnMs * 1e6 / max(operations, 1u), pages.GetPageCount(), maxFreeRanges);
+    }
+
+    // Times laying out and packing every mesh of every asset into shared streams, and counts the root
+    // parameter changes of a frame drawing each mesh once from its own buffers and from the packed ones.
+    void BenchmarkSceneGeometry(const std::wstring& assetDirectory)
+    {
+        std::vector<std::unique_ptr<Model>> models;
+        uint32_t meshCount = 0;
+        for (auto filename : c_assetFilenames)
+        {
+            const std::wstring path = assetDirectory + filename;
+
+            models.push_back(std::make_unique<Model>());
+            if (FAILED(models.back()->LoadFromFile(path.c_str())))
+            {
+                Log("Failed to load %ls\n", path.c_str());
+                return;
+            }
+            meshCount += models.back()->GetMeshCount();
+        }
+
+        SceneGeometryLayout layout;
+
+        double layoutMs = 1e30;
+        for (uint32_t n = 0; n < c_iterationCount; ++n)
+        {
+            auto start = Clock::now();
+
+            layout.Reset();
+            for (auto& model : models)
+            {
+                for (auto& mesh : *model)
+                {
+                    uint32_t meshIndex;
+                    AddSceneMesh(layout, mesh, meshIndex);
+                }
+            }
+
+            layoutMs = min(layoutMs, ElapsedMs(start));
+        }
+
+        std::vector<uint8_t> streams[SceneStream::Count];
+        uint8_t* streamData[SceneStream::Count];
+        for (uint32_t s = 0; s < SceneStream::Count; ++s)
+        {
+            streams[s].resize(layout.GetStreamSize(static_cast<SceneStream::EType>(s)));
+            streamData[s] = streams[s].data();
+        }
+
+        double packMs = 1e30;
+        for (uint32_t n = 0; n < c_iterationCount; ++n)
+        {
+            auto start = Clock::now();
+            PackSceneGeometry(layout, streamData);
+            packMs = min(packMs, ElapsedMs(start));
+        }
+
+        // Per mesh: the index root constant, plus four SRVs unless the scene is packed, which binds them once.
+        const uint32_t unpackedCalls = meshCount * 5;
+        const uint32_t packedCalls = SceneStream::Count + meshCount;
+
+        Log("\nScene geometry packing (%u models, %u meshes, best of %u)\n", static_cast<uint32_t>(models.size()), meshCount, c_iterationCount);
+        Log("streams: vertices %.2f MB, meshlets %.2f MB, unique indices %.2f MB, primitives %.2f MB, table %u bytes\n",
+            streams[SceneStream::Vertices].size() / (1024.0 * 1024.0), streams[SceneStream::Meshlets].size() / (1024.0 * 1024.0),
+            streams[SceneStream::UniqueVertexIndices].size() / (1024.0 * 1024.0), streams[SceneStream::PrimitiveIndices].size() / (1024.0 * 1024.0),
+            static_cast<uint32_t>(layout.GetTable().size() * sizeof(MeshGeometryOffsets)));
+        Log("layout %.3f ms, pack %.3f ms, root parameter sets per frame %u -> %u\n", layoutMs, packMs, unpackedCalls, packedCalls);
+    }
+
+    // Ranges of meshCount meshes of subsetsPerMesh consecutive subsets each; with visibleChance below
+    // one, only runs of visible meshlets are kept, as culling leaves them.
+    std::vector<MeshletRange> MakeMeshletRanges(std::mt19937& rng, uint32_t meshCount, uint32_t subsetsPerMesh, float visibleChance)
+    {
+        std::uniform_int_distribution<uint32_t> subsetSize(1, 256);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        std::vector<MeshletRange> ranges;
+        for (uint32_t m = 0; m < meshCount; ++m)
+        {
+            uint32_t offset = 0;
+            for (uint32_t s = 0; s < subsetsPerMesh; ++s)
+            {
+                const uint32_t count = subsetSize(rng);
+                if (visibleChance >= 1.0f)
+                {
+                    ranges.push_back(MeshletRange{ m, offset, count });
+                }
+                else
+                {
+                    // Runs of visible meshlets within the subset.
+                    for (uint32_t i = 0; i < count; )
+                    {
+                        uint32_t end = i;
+                        while (end < count && unit(rng) < visibleChance)
+                        {
+                            ++end;
+                        }
+                        if (end > i)
+                        {
+                            ranges.push_back(MeshletRange{ m, offset + i, end - i });
+                        }
+                        i = end + 1;
+                    }
+                }
+                offset += count;
+            }
+        }
+        return ranges;
+    }
+
+    // Times the draw packet builder over 100k meshlet subsets, whole and after culling.
+    void BenchmarkDrawPackets()
+    {
+        const uint32_t meshCount = 1000;
+        const uint32_t subsetsPerMesh = 100;
+        std::mt19937 rng(11);
+
+        Log("\nDraw packets (%u meshes x %u subsets, best of %u)\n", meshCount, subsetsPerMesh, c_iterationCount);
+        Log("%-14s %10s %10s %10s %12s\n", "ranges", "count", "packets", "ms", "ns/range");
+
+        const struct { const char* Name; float VisibleChance; } scenarios[] = { { "all subsets", 1.0f }, { "culled runs", 0.98f }, { "sparse runs", 0.5f } };
+        for (auto& scenario : scenarios)
+        {
+            const std::vector<MeshletRange> ranges = MakeMeshletRanges(rng, meshCount, subsetsPerMesh, scenario.VisibleChance);
+            std::vector<DrawPacket> packets(GetMaxDrawPacketCount(ranges.data(), static_cast<uint32_t>(ranges.size())));
+
+            double best = 1e30;
+            uint32_t packetCount = 0;
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                packetCount = BuildDrawPackets(ranges.data(), static_cast<uint32_t>(ranges.size()), packets.data());
+                best = min(best, ElapsedMs(start));
+            }
+
+            Log("%-14s %10u %10u %10.3f %12.2f\n", scenario.Name, static_cast<uint32_t>(ranges.size()), packetCount, best, best * 1e6 / max(ranges.size(), size_t(1)));
+        }
+    }
+
+    // Records meshes the way DX12Practice does with the GPU taken out: each chunk writes its meshes'
+    // root parameter changes and ExecuteIndirect calls into its own command stream, and its packets into
+    // its part of a shared buffer. Every command costs commandWork steps of busy work, standing in for
+    // the driver's encoding; submission joins the streams in chunk order.
+    class RecordingStandIn : public ChunkRecordingTarget
+    {
+    public:
+        RecordingStandIn(const std::vector<MeshletRange>& ranges, const std::vector<uint32_t>& rangeBases, uint32_t maxChunks, uint32_t commandWork) :
+            m_ranges(ranges), m_rangeBases(rangeBases), m_maxChunks(maxChunks), m_commandWork(commandWork)
+        {
+            for (auto& stream : m_streams)
+            {
+                stream.reserve(ranges.size() * 8 + 64);
+            }
+            m_packets.resize(GetMaxDrawPacketCount(ranges.data(), static_cast<uint32_t>(ranges.size())));
+            m_submitted.reserve(ranges.size() * 8 + 64);
+        }
+
+        uint32_t GetMaxChunkCount() override { return m_maxChunks; }
+
+        HRESULT BeginChunks(const RecordingChunk* chunks, uint32_t chunkCount) override
+        {
+            uint32_t packetCount = 0;
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                const uint32_t first = m_rangeBases[chunks[c].FirstItem];
+                m_packetBases[c] = packetCount;
+                packetCount += GetMaxDrawPacketCount(m_ranges.data() + first, m_rangeBases[chunks[c].FirstItem + chunks[c].ItemCount] - first);
+            }
+            return packetCount <= m_packets.size() ? S_OK : E_OUTOFMEMORY;
+        }
+
+        HRESULT RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk) override
+        {
+            std::vector<uint32_t>& stream = m_streams[chunkIndex];
+            stream.clear();
+
+            DrawPacket* packets = m_packets.data() + m_packetBases[chunkIndex];
+            uint32_t packetCount = 0;
+            for (uint32_t m = chunk.FirstItem; m < chunk.FirstItem + chunk.ItemCount; ++m)
+            {
+                const uint32_t first = m_rangeBases[m];
+                const uint32_t meshPacketCount = BuildDrawPackets(m_ranges.data() + first, m_rangeBases[m + 1] - first, packets + packetCount);
+                if (meshPacketCount == 0)
+                {
+                    continue;
+                }
+
+                for (uint32_t p = 2; p <= 5; ++p)
+                {
+                    Emit(stream, p, m);
+                }
+                Emit(stream, meshPacketCount, m);
+
+                // The stream names the packets by content, so a change of layout goes unnoticed.
+                for (uint32_t i = 0; i < meshPacketCount; ++i)
+                {
+                    const DrawPacket& packet = packets[packetCount + i];
+                    stream.push_back(packet.MeshletOffset);
+                    stream.push_back(packet.ThreadGroupCountX);
+                }
+                packetCount += meshPacketCount;
+            }
+            return S_OK;
+        }
+
+        HRESULT SubmitChunks(uint32_t chunkCount) override
+        {
+            m_submitted.clear();
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                m_submitted.insert(m_submitted.end(), m_streams[c].begin(), m_streams[c].end());
+            }
+            m_submittedChunkCount = chunkCount;
+            return S_OK;
+        }
+
+        const std::vector<uint32_t>& GetSubmitted() const { return m_submitted; }
+        uint32_t GetSubmittedChunkCount() const { return m_submittedChunkCount; }
+
+    private:
+        void Emit(std::vector<uint32_t>& stream, uint32_t command, uint32_t argument)
+        {
+            uint32_t hash = command * 0x9e3779b9u ^ argument;
+            for (uint32_t i = 0; i < m_commandWork; ++i)
+            {
+                hash = (hash ^ (hash >> 15)) * 0x2c1b3c6du;
+            }
+            stream.push_back(command);
+            stream.push_back(argument);
+            stream.push_back(hash);
+        }
+
+        const std::vector<MeshletRange>& m_ranges;
+        const std::vector<uint32_t>& m_rangeBases;
+        uint32_t m_maxChunks;
+        uint32_t m_commandWork;
+
+        std::vector<uint32_t> m_streams[c_maxRecordingChunks];
+        uint32_t m_packetBases[c_maxRecordingChunks] = {};
+        std::vector<DrawPacket> m_packets;
+        std::vector<uint32_t> m_submitted;
+        uint32_t m_submittedChunkCount = 0;
+    };
+
+    // Times 1000 meshes x 100 subsets recorded in 1 to 8 chunks with as many threads.
+    void BenchmarkParallelRecording()
+    {
+        const uint32_t meshCount = 1000;
+        const uint32_t subsetsPerMesh = 100;
+        const uint64_t minChunkCost = 64;
+        const uint32_t commandWork = 64;
+        std::mt19937 rng(25);
+
+        // Meshes as GatherMeshletRanges lays them out, with its costs.
+        const std::vector<MeshletRange> ranges = MakeMeshletRanges(rng, meshCount, subsetsPerMesh, 0.98f);
+        std::vector<uint32_t> rangeBases(meshCount + 1, 0);
+        for (auto& range : ranges)
+        {
+            rangeBases[range.MeshIndex + 1]++;
+        }
+        std::vector<uint32_t> costs(meshCount);
+        for (uint32_t m = 0; m < meshCount; ++m)
+        {
+            costs[m] = 1 + rangeBases[m + 1];
+            rangeBases[m + 1] += rangeBases[m];
+        }
+
+        Log("\nParallel recording (%u meshes x %u subsets, %u hardware threads, best of %u)\n", meshCount, subsetsPerMesh,
+            std::thread::hardware_concurrency(), c_iterationCount);
+        Log("%-8s %10s %10s %8s\n", "chunks", "words", "ms", "speedup");
+
+        double baseline = 0.0;
+        for (uint32_t chunkCount = 1; chunkCount <= 8; chunkCount *= 2)
+        {
+            ThreadPool pool(chunkCount);
+            RecordingStandIn target(ranges, rangeBases, chunkCount, commandWork);
+
+            double best = 1e30;
+            for (uint32_t n = 0; n < c_iterationCount; ++n)
+            {
+                auto start = Clock::now();
+                RecordInChunks(target, costs.data(), meshCount, minChunkCost, pool);
+                best = min(best, ElapsedMs(start));
+            }
+
+            if (chunkCount == 1)
+            {
+                baseline = best;
+            }
+
+            Log("%-8u %10u %10.3f %8.2f\n", target.GetSubmittedChunkCount(), static_cast<uint32_t>(target.GetSubmitted().size()), best, baseline / best);
+        }
+    }
+}
+
+int Benchmarks::Run(const std::wstring& assetDirectory)
+{
+    BenchmarkModelLoading(assetDirectory);
+    BenchmarkCompressedLoading(assetDirectory);
+    BenchmarkPrecomputedBounds(assetDirectory);
+    BenchmarkMeshletGeneration(assetDirectory);
+    BenchmarkCullDataGeneration(assetDirectory);
+    BenchmarkMeshletCulling(assetDirectory);
+    BenchmarkMeshletTree(assetDirectory);
+    BenchmarkClusterLod(assetDirectory);
+    BenchmarkSimplification(assetDirectory);
+    BenchmarkSoftwareRasterizer(assetDirectory);
+    BenchmarkOcclusionCulling(assetDirectory);
+    BenchmarkTemporalOcclusion(assetDirectory);
+    BenchmarkInstanceCulling();
+    BenchmarkJobSystem(assetDirectory);
+    BenchmarkFrameAllocations(assetDirectory);
+    BenchmarkUploadRing();
+    BenchmarkBatchedUpload(assetDirectory);
+    BenchmarkGeometryHeap(assetDirectory);
+    BenchmarkSceneGeometry(assetDirectory);
+    BenchmarkDrawPackets();
+    BenchmarkParallelRecording();
+
+    return 0;
+}
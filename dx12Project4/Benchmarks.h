@@ -0,0 +1,22 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <string>
+
+// CPU-only measurements over the bundled assets. Launch the sample with
+// "-benchmark [assetDirectory]" to run them instead of opening a window; results
+// are written to stdout and the debugger output window. The checks of what the measured
+// code computes are in the DX12PracticeTests target (see Tests.h).
+namespace Benchmarks
+{
+    int Run(const std::wstring& assetDirectory);
+}
@@ -0,0 +1,28 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+// The models the benchmarks and tests load, relative to the asset directory. The five Dragon LODs
+// come first, densest first.
+const uint32_t c_assetCount = 7;
+
+const wchar_t* const c_assetFilenames[c_assetCount] =
+{
+    L"Dragon_LOD1.bin",
+    L"Dragon_LOD2.bin",
+    L"Dragon_LOD3.bin",
+    L"Dragon_LOD4.bin",
+    L"Dragon_LOD5.bin",
+    L"ToyRobot.bin",
+    L"Camera.bin",
+};
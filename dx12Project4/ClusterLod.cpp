@@ -0,0 +1,564 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "ClusterLod.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+    // A meshlet of the level being grouped, with its triangles decoded.
+    struct Cluster
+    {
+        uint32_t              Meshlet;      // Index into ClusterLodData::Meshlets.Meshlets
+        std::vector<uint32_t> Triangles;    // Mesh vertex indices, three per triangle
+    };
+
+    struct Group
+    {
+        std::vector<uint32_t> Members;      // Indices into the level's clusters
+        ClusterLodBounds      Bounds;
+        bool                  Simplified;
+        MeshletData           Meshlets;
+        HRESULT               Result;
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    uint32_t ReadIndex(const uint8_t* data, uint32_t indexSize, uint32_t i)
+    {
+        if (indexSize == 4)
+        {
+            uint32_t index;
+            std::memcpy(&index, data + size_t(i) * 4, sizeof(index));
+            return index;
+        }
+        else
+        {
+            uint16_t index;
+            std::memcpy(&index, data + size_t(i) * 2, sizeof(index));
+            return index;
+        }
+    }
+
+    // Decodes a meshlet back into a triangle list of mesh vertex indices.
+    void DecodeMeshlet(const MeshletData& data, uint32_t meshletIndex, uint32_t indexSize, std::vector<uint32_t>& triangles)
+    {
+        const Meshlet& meshlet = data.Meshlets[meshletIndex];
+
+        triangles.resize(meshlet.PrimCount * 3);
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            const PackedTriangle& tri = data.PrimitiveIndices[meshlet.PrimOffset + p];
+            triangles[p * 3 + 0] = ReadIndex(data.UniqueVertexIndices.data(), indexSize, meshlet.VertOffset + tri.i0);
+            triangles[p * 3 + 1] = ReadIndex(data.UniqueVertexIndices.data(), indexSize, meshlet.VertOffset + tri.i1);
+            triangles[p * 3 + 2] = ReadIndex(data.UniqueVertexIndices.data(), indexSize, meshlet.VertOffset + tri.i2);
+        }
+    }
+
+    // Splits a triangle list into meshlets by running the generator over a copy of the mesh whose
+    // index buffer holds just those triangles.
+    HRESULT BuildMeshlets(const Mesh& base, const std::vector<uint32_t>& triangles, const MeshletGeneratorOptions& options, ThreadPool& pool, MeshletData& meshlets)
+    {
+        const uint32_t indexCount = static_cast<uint32_t>(triangles.size());
+
+        std::vector<uint8_t> indices(size_t(indexCount) * base.IndexSize);
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            if (base.IndexSize == 4)
+            {
+                std::memcpy(&indices[size_t(i) * 4], &triangles[i], sizeof(uint32_t));
+            }
+            else
+            {
+                const uint16_t index16 = static_cast<uint16_t>(triangles[i]);
+                std::memcpy(&indices[size_t(i) * 2], &index16, sizeof(index16));
+            }
+        }
+
+        Subset subset = { 0, indexCount };
+
+        Mesh view = base;
+        view.Indices = MakeSpan(indices.data(), static_cast<uint32_t>(indices.size()));
+        view.IndexCount = indexCount;
+        view.IndexSubsets = MakeSpan(&subset, 1);
+
+        return GenerateMeshlets(view, meshlets, options, pool);
+    }
+
+    // Appends src's meshlets to dst, rebasing their offsets. Returns the index of the first.
+    uint32_t AppendMeshlets(MeshletData& dst, const MeshletData& src, uint32_t indexSize)
+    {
+        const uint32_t first = static_cast<uint32_t>(dst.Meshlets.size());
+        const uint32_t vertBase = static_cast<uint32_t>(dst.UniqueVertexIndices.size() / indexSize);
+        const uint32_t primBase = static_cast<uint32_t>(dst.PrimitiveIndices.size());
+
+        for (Meshlet m : src.Meshlets)
+        {
+            m.VertOffset += vertBase;
+            m.PrimOffset += primBase;
+            dst.Meshlets.push_back(m);
+        }
+
+        dst.UniqueVertexIndices.insert(dst.UniqueVertexIndices.end(), src.UniqueVertexIndices.begin(), src.UniqueVertexIndices.end());
+        dst.PrimitiveIndices.insert(dst.PrimitiveIndices.end(), src.PrimitiveIndices.begin(), src.PrimitiveIndices.end());
+        dst.CullingData.insert(dst.CullingData.end(), src.CullingData.begin(), src.CullingData.end());
+
+        return first;
+    }
+
+    uint32_t SpreadBits(uint32_t v)
+    {
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    // Gathers clusters into groups of up to groupSize, each grown from a seed by repeatedly adding the
+    // neighbour sharing the most edges with the group. Seeds are taken in Morton order of the cluster
+    // centres so that groups stay compact and few are left stranded.
+    void PartitionClusters(const std::vector<Cluster>& clusters, const std::vector<ClusterLod>& lods, uint32_t groupSize, std::vector<Group>& groups)
+    {
+        const uint32_t count = static_cast<uint32_t>(clusters.size());
+
+        std::vector<std::pair<uint64_t, uint32_t>> edges;
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            const std::vector<uint32_t>& tris = clusters[c].Triangles;
+            for (size_t i = 0; i < tris.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    edges.emplace_back(EdgeKey(tris[i + k], tris[i + (k + 1) % 3]), c);
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<std::unordered_map<uint32_t, uint32_t>> shared(count);
+        for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+        {
+            for (end = begin + 1; end < edges.size() && edges[end].first == edges[begin].first; ++end)
+            {
+            }
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                for (size_t j = i + 1; j < end; ++j)
+                {
+                    const uint32_t a = edges[i].second;
+                    const uint32_t b = edges[j].second;
+                    if (a != b)
+                    {
+                        ++shared[a][b];
+                        ++shared[b][a];
+                    }
+                }
+            }
+        }
+
+        std::vector<XMFLOAT3> centers(count);
+        XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            const XMFLOAT4& sphere = lods[clusters[c].Meshlet].Self.Sphere;
+            centers[c] = XMFLOAT3(sphere.x, sphere.y, sphere.z);
+            vmin = XMVectorMin(vmin, XMLoadFloat3(&centers[c]));
+            vmax = XMVectorMax(vmax, XMLoadFloat3(&centers[c]));
+        }
+
+        const XMVECTOR scale = XMVectorDivide(XMVectorReplicate(1023.0f), XMVectorMax(XMVectorSubtract(vmax, vmin), XMVectorReplicate(1e-20f)));
+
+        std::vector<std::pair<uint32_t, uint32_t>> order(count);
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            XMFLOAT3 q;
+            XMStoreFloat3(&q, XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&centers[c]), vmin), scale));
+            order[c] = std::make_pair(SpreadBits(uint32_t(q.x)) | (SpreadBits(uint32_t(q.y)) << 1) | (SpreadBits(uint32_t(q.z)) << 2), c);
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<uint8_t> grouped(count);
+        std::unordered_map<uint32_t, uint32_t> frontier;
+
+        for (const auto& entry : order)
+        {
+            const uint32_t seed = entry.second;
+            if (grouped[seed])
+                continue;
+
+            Group group = {};
+            group.Members.push_back(seed);
+            grouped[seed] = 1;
+
+            frontier.clear();
+            for (const auto& n : shared[seed])
+            {
+                if (!grouped[n.first])
+                    frontier[n.first] += n.second;
+            }
+
+            while (group.Members.size() < groupSize && !frontier.empty())
+            {
+                uint32_t best = UINT32_MAX;
+                uint32_t bestShared = 0;
+                float bestDistSq = FLT_MAX;
+
+                for (const auto& candidate : frontier)
+                {
+                    const float distSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&centers[candidate.first]), XMLoadFloat3(&centers[seed]))));
+                    if (candidate.second > bestShared || (candidate.second == bestShared && distSq < bestDistSq))
+                    {
+                        best = candidate.first;
+                        bestShared = candidate.second;
+                        bestDistSq = distSq;
+                    }
+                }
+
+                group.Members.push_back(best);
+                grouped[best] = 1;
+                frontier.erase(best);
+
+                for (const auto& n : shared[best])
+                {
+                    if (!grouped[n.first])
+                        frontier[n.first] += n.second;
+                }
+            }
+
+            groups.push_back(std::move(group));
+        }
+    }
+
+    // Merges the group's clusters, simplifies them to half as many triangles with every vertex on
+    // the group's border locked, and splits the result into meshlets.
+    void SimplifyGroup(const Mesh& base, const PositionStream& positions, const std::vector<Cluster>& clusters, const std::vector<ClusterLod>& lods,
+        const ClusterLodOptions& options, ThreadPool& pool, Group& group)
+    {
+        std::vector<uint32_t> triangles;
+        for (uint32_t member : group.Members)
+        {
+            triangles.insert(triangles.end(), clusters[member].Triangles.begin(), clusters[member].Triangles.end());
+        }
+
+        // Bounds enclose every member's bounds, and the error includes the worst member's, so both
+        // only grow up the hierarchy.
+        XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        float childError = 0.0f;
+
+        for (uint32_t member : group.Members)
+        {
+            const ClusterLodBounds& self = lods[clusters[member].Meshlet].Self;
+            const XMVECTOR center = XMLoadFloat4(&self.Sphere);
+            const XMVECTOR radius = XMVectorReplicate(self.Sphere.w);
+            vmin = XMVectorMin(vmin, XMVectorSubtract(center, radius));
+            vmax = XMVectorMax(vmax, XMVectorAdd(center, radius));
+            childError = max(childError, self.Error);
+        }
+
+        const XMVECTOR center = XMVectorScale(XMVectorAdd(vmin, vmax), 0.5f);
+        float radius = 0.0f;
+        for (uint32_t member : group.Members)
+        {
+            const XMFLOAT4& sphere = lods[clusters[member].Meshlet].Self.Sphere;
+            radius = max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat4(&sphere), center))) + sphere.w);
+        }
+
+        XMStoreFloat4(&group.Bounds.Sphere, center);
+        group.Bounds.Sphere.w = radius;
+
+        // Work on a compact copy of the group's vertices. Edges that don't have exactly two triangles
+        // in the group lie on its border (or are non-manifold) and must stay put.
+        std::vector<uint32_t> vertices(triangles);
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+        const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+        std::vector<XMFLOAT3> localPositions(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            localPositions[v] = positions[vertices[v]];
+        }
+
+        std::vector<uint32_t> local(triangles.size());
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            local[i] = static_cast<uint32_t>(std::lower_bound(vertices.begin(), vertices.end(), triangles[i]) - vertices.begin());
+        }
+
+        std::vector<uint64_t> edges;
+        edges.reserve(local.size());
+        for (size_t i = 0; i < local.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                edges.push_back(EdgeKey(local[i + k], local[i + (k + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<uint8_t> locked(vertexCount);
+        for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+        {
+            for (end = begin + 1; end < edges.size() && edges[end] == edges[begin]; ++end)
+            {
+            }
+
+            if (end - begin != 2)
+            {
+                locked[static_cast<uint32_t>(edges[begin] >> 32)] = 1;
+                locked[static_cast<uint32_t>(edges[begin])] = 1;
+            }
+        }
+
+        const uint32_t triangleCount = static_cast<uint32_t>(triangles.size() / 3);
+
+        SimplifyOptions simplify;
+        simplify.TargetTriangleCount = triangleCount / 2;
+
+        float error = 0.0f;
+        group.Result = SimplifyTriangles(localPositions.data(), nullptr, vertexCount, locked.data(), local, simplify, &error);
+        if (FAILED(group.Result))
+            return;
+
+        group.Bounds.Error = childError + error;
+        group.Simplified = local.size() / 3 <= triangleCount * (1.0f - options.MinReduction);
+        if (!group.Simplified)
+            return;
+
+        for (size_t i = 0; i < local.size(); ++i)
+        {
+            local[i] = vertices[local[i]];
+        }
+
+        group.Result = BuildMeshlets(base, local, options.Meshlets, pool, group.Meshlets);
+    }
+
+    void AddLevel(ClusterLodData& lod, uint32_t level, const std::vector<Cluster>& clusters)
+    {
+        if (lod.LevelTriangles.size() <= level)
+        {
+            lod.LevelTriangles.resize(level + 1, 0);
+            lod.LevelErrors.resize(level + 1, 0.0f);
+        }
+
+        for (const Cluster& cluster : clusters)
+        {
+            lod.LevelTriangles[level] += static_cast<uint32_t>(cluster.Triangles.size() / 3);
+            lod.LevelErrors[level] = max(lod.LevelErrors[level], lod.Lods[cluster.Meshlet].Self.Error);
+        }
+    }
+
+    // Pixels the bounds' error covers on screen, or FLT_MAX when the view is inside the bounds.
+    float ProjectedError(const ClusterLodBounds& bounds, const ClusterLodView& view)
+    {
+        if (bounds.Error <= 0.0f || bounds.Error == FLT_MAX)
+        {
+            return bounds.Error;
+        }
+
+        const XMVECTOR center = XMVector3Transform(XMLoadFloat4(&bounds.Sphere), XMLoadFloat4x4(&view.World));
+        const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMLoadFloat3(&view.ViewPosition)))) - bounds.Sphere.w * view.Scale;
+
+        if (distance <= 0.0f)
+        {
+            return FLT_MAX;
+        }
+
+        return bounds.Error * view.Scale * view.ProjectionScale / distance;
+    }
+}
+
+HRESULT BuildClusterLod(const Mesh& mesh, ClusterLodData& lod, const ClusterLodOptions& options, ThreadPool& pool)
+{
+    if (options.GroupSize < 2 || options.MaxLevelCount < 1 || options.MinReduction < 0.0f || options.MinReduction >= 1.0f)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (mesh.IndexSize != 2 && mesh.IndexSize != 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    const uint32_t subsetCount = static_cast<uint32_t>(mesh.IndexSubsets.size());
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        if (size_t(mesh.IndexSubsets[s].Offset) + mesh.IndexSubsets[s].Count > mesh.IndexCount)
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    lod = ClusterLodData();
+
+    // Every level's meshlets are generated from copies of this; leave out what they don't need.
+    Mesh base = mesh;
+    base.ResetDerivedCullData();
+
+    const PositionStream positions = mesh.GetPositions();
+
+    std::vector<Cluster> clusters;
+    std::vector<Cluster> next;
+    std::vector<Group> groups;
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const Subset& indexSubset = mesh.IndexSubsets[s];
+
+        Subset meshletSubset;
+        meshletSubset.Offset = static_cast<uint32_t>(lod.Meshlets.Meshlets.size());
+
+        // Level 0: the subset as it is.
+        std::vector<uint32_t> triangles(indexSubset.Count);
+        for (uint32_t i = 0; i < indexSubset.Count; ++i)
+        {
+            triangles[i] = mesh.GetIndex(indexSubset.Offset + i);
+        }
+
+        MeshletData meshlets;
+        HRESULT hr = BuildMeshlets(base, triangles, options.Meshlets, pool, meshlets);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        const uint32_t first = AppendMeshlets(lod.Meshlets, meshlets, mesh.IndexSize);
+
+        clusters.resize(meshlets.Meshlets.size());
+        for (uint32_t m = 0; m < meshlets.Meshlets.size(); ++m)
+        {
+            clusters[m].Meshlet = first + m;
+            DecodeMeshlet(meshlets, m, mesh.IndexSize, clusters[m].Triangles);
+
+            ClusterLod clusterLod;
+            clusterLod.Self.Sphere = meshlets.CullingData[m].BoundingSphere;
+            clusterLod.Self.Error = 0.0f;
+            clusterLod.Parent.Sphere = clusterLod.Self.Sphere;
+            clusterLod.Parent.Error = FLT_MAX;
+            clusterLod.Level = 0;
+            lod.Lods.push_back(clusterLod);
+        }
+
+        AddLevel(lod, 0, clusters);
+
+        for (uint32_t level = 1; level < options.MaxLevelCount && clusters.size() > 1; ++level)
+        {
+            groups.clear();
+            PartitionClusters(clusters, lod.Lods, options.GroupSize, groups);
+
+            pool.ParallelFor(static_cast<uint32_t>(groups.size()), [&](uint32_t g)
+            {
+                SimplifyGroup(base, positions, clusters, lod.Lods, options, pool, groups[g]);
+            });
+
+            next.clear();
+            bool progress = false;
+
+            for (Group& group : groups)
+            {
+                if (FAILED(group.Result))
+                {
+                    return group.Result;
+                }
+
+                if (!group.Simplified)
+                {
+                    // Pass the members up as they are; they'll be grouped again with new neighbours.
+                    for (uint32_t member : group.Members)
+                    {
+                        next.push_back(std::move(clusters[member]));
+                    }
+                    continue;
+                }
+
+                progress = true;
+
+                for (uint32_t member : group.Members)
+                {
+                    lod.Lods[clusters[member].Meshlet].Parent = group.Bounds;
+                }
+
+                const uint32_t groupFirst = AppendMeshlets(lod.Meshlets, group.Meshlets, mesh.IndexSize);
+
+                for (uint32_t m = 0; m < group.Meshlets.Meshlets.size(); ++m)
+                {
+                    Cluster cluster;
+                    cluster.Meshlet = groupFirst + m;
+                    DecodeMeshlet(group.Meshlets, m, mesh.IndexSize, cluster.Triangles);
+                    next.push_back(std::move(cluster));
+
+                    ClusterLod clusterLod;
+                    clusterLod.Self = group.Bounds;
+                    clusterLod.Parent.Sphere = group.Bounds.Sphere;
+                    clusterLod.Parent.Error = FLT_MAX;
+                    clusterLod.Level = level;
+                    lod.Lods.push_back(clusterLod);
+                }
+            }
+
+            if (!progress)
+            {
+                break;
+            }
+
+            std::swap(clusters, next);
+            AddLevel(lod, level, clusters);
+        }
+
+        meshletSubset.Count = static_cast<uint32_t>(lod.Meshlets.Meshlets.size()) - meshletSubset.Offset;
+        lod.Meshlets.MeshletSubsets.push_back(meshletSubset);
+    }
+
+    return S_OK;
+}
+
+void SelectClusterLod(const ClusterLodData& lod, const ClusterLodView& view, VisibleMeshlets& selected)
+{
+    const uint32_t subsetCount = static_cast<uint32_t>(lod.Meshlets.MeshletSubsets.size());
+
+    selected.Indices.clear();
+    selected.Subsets.resize(subsetCount);
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const Subset& subset = lod.Meshlets.MeshletSubsets[s];
+        selected.Subsets[s].Offset = static_cast<uint32_t>(selected.Indices.size());
+
+        for (uint32_t m = subset.Offset; m < subset.Offset + subset.Count; ++m)
+        {
+            const ClusterLod& clusterLod = lod.Lods[m];
+
+            if (ProjectedError(clusterLod.Self, view) <= view.ErrorThreshold && ProjectedError(clusterLod.Parent, view) > view.ErrorThreshold)
+            {
+                selected.Indices.push_back(m);
+            }
+        }
+
+        selected.Subsets[s].Count = static_cast<uint32_t>(selected.Indices.size()) - selected.Subsets[s].Offset;
+    }
+}
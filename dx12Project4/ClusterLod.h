@@ -0,0 +1,68 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "MeshletCuller.h"
+#include "MeshletGenerator.h"
+
+// Continuous level of detail built from meshlets, in the style of a cluster DAG. Level 0 is the
+// source mesh split into meshlets. Each further level merges neighbouring meshlets of the one below
+// into groups, simplifies each group with its outer border locked, and splits the result back into
+// meshlets. Because borders never move, any mix of levels that covers the mesh once is crack-free,
+// so detail can be chosen per meshlet at runtime.
+struct ClusterLodOptions
+{
+    MeshletGeneratorOptions Meshlets;           // How every level is split into meshlets
+    uint32_t                GroupSize = 4;      // Meshlets merged and simplified together
+    float                   MinReduction = 0.15f; // Groups that lose less than this fraction of triangles are passed up unsimplified
+    uint32_t                MaxLevelCount = 16;
+};
+
+struct ClusterLodBounds
+{
+    DirectX::XMFLOAT4 Sphere;   // xyz = centre, w = radius; encloses every group beneath this one
+    float             Error;    // Object-space distance the group's surface may be from the source mesh
+};
+
+// Where a meshlet sits in the hierarchy. Self is the group it was built from, and Parent the group it
+// was merged into one level up. Both grow monotonically up the hierarchy, so a meshlet and the
+// meshlets that replace it never disagree about which of them to draw.
+struct ClusterLod
+{
+    ClusterLodBounds Self;      // Error is 0 at level 0
+    ClusterLodBounds Parent;    // Error is FLT_MAX for meshlets that were never simplified further
+    uint32_t         Level;
+};
+
+struct ClusterLodData
+{
+    MeshletData             Meshlets;       // Each MeshletSubsets entry spans every level of its index subset
+    std::vector<ClusterLod> Lods;           // Parallel to Meshlets.Meshlets
+    std::vector<uint32_t>   LevelTriangles; // Triangles in each level, counting meshlets passed up unsimplified
+    std::vector<float>      LevelErrors;    // Largest Self.Error in each level
+};
+
+// Builds the hierarchy for each index subset of the mesh. Reads the same streams as GenerateMeshlets;
+// the groups of each level are simplified in parallel on the pool.
+HRESULT BuildClusterLod(const Mesh& mesh, ClusterLodData& lod, const ClusterLodOptions& options = ClusterLodOptions(), ThreadPool& pool = ThreadPool::GetDefault());
+
+struct ClusterLodView
+{
+    DirectX::XMFLOAT4X4 World;              // Affine object-to-world transform, row-vector convention
+    float               Scale;              // Uniform scale of World
+    DirectX::XMFLOAT3   ViewPosition;       // World space
+    float               ProjectionScale;    // Viewport height / (2 tan(fovY / 2)): pixels per unit at unit distance
+    float               ErrorThreshold;     // Largest acceptable projected error, in pixels
+};
+
+// Picks, for each subset, the meshlets whose own error projects to at most ErrorThreshold pixels while
+// their parent's does not. The selection covers every subset exactly once. Indices are ascending.
+void SelectClusterLod(const ClusterLodData& lod, const ClusterLodView& view, VisibleMeshlets& selected);
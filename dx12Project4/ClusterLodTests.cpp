@@ -0,0 +1,337 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "ClusterLod.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <utility>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    // Outputs of one simplified group, the meshlets that replace its members, found by the subset
+    // and the Self bounds they all share.
+    using GroupOutputs = std::vector<uint32_t>;
+    using GroupKey = std::pair<uint32_t, std::array<float, 5>>;
+
+    uint32_t ReadIndex(const uint8_t* indices, uint32_t indexSize, uint32_t i)
+    {
+        if (indexSize == 4)
+        {
+            uint32_t index;
+            std::memcpy(&index, indices + size_t(i) * 4, sizeof(index));
+            return index;
+        }
+
+        uint16_t index;
+        std::memcpy(&index, indices + size_t(i) * 2, sizeof(index));
+        return index;
+    }
+
+    // The triangle rotated to start at its smallest index, which keeps its winding.
+    Triangle Canonical(uint32_t a, uint32_t b, uint32_t c)
+    {
+        if (b < a && b <= c)
+        {
+            return Triangle{ { b, c, a } };
+        }
+        if (c < a && c < b)
+        {
+            return Triangle{ { c, a, b } };
+        }
+        return Triangle{ { a, b, c } };
+    }
+
+    void AppendTriangles(const MeshletData& data, uint32_t meshletIndex, uint32_t indexSize, std::vector<Triangle>& triangles)
+    {
+        const Meshlet& meshlet = data.Meshlets[meshletIndex];
+        const uint8_t* unique = data.UniqueVertexIndices.data();
+
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            const PackedTriangle& prim = data.PrimitiveIndices[meshlet.PrimOffset + p];
+            triangles.push_back(Canonical(ReadIndex(unique, indexSize, meshlet.VertOffset + prim.i0), ReadIndex(unique, indexSize, meshlet.VertOffset + prim.i1),
+                ReadIndex(unique, indexSize, meshlet.VertOffset + prim.i2)));
+        }
+    }
+
+    // The sorted edges used by exactly one of the meshlets' triangles.
+    std::vector<uint64_t> CollectOpenEdges(const ClusterLodData& lod, const std::vector<uint32_t>& meshlets, uint32_t indexSize)
+    {
+        std::vector<Triangle> triangles;
+        for (uint32_t m : meshlets)
+        {
+            AppendTriangles(lod.Meshlets, m, indexSize, triangles);
+        }
+
+        std::vector<uint64_t> edges;
+        for (const Triangle& t : triangles)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t a = min(t[k], t[(k + 1) % 3]);
+                const uint32_t b = max(t[k], t[(k + 1) % 3]);
+                edges.push_back((uint64_t(a) << 32) | b);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<uint64_t> open;
+        for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+        {
+            for (end = begin + 1; end < edges.size() && edges[end] == edges[begin]; ++end)
+            {
+            }
+
+            if (end - begin == 1)
+            {
+                open.push_back(edges[begin]);
+            }
+        }
+        return open;
+    }
+
+    GroupKey MakeGroupKey(uint32_t subset, const ClusterLodBounds& bounds)
+    {
+        return GroupKey(subset, std::array<float, 5>{ { bounds.Sphere.x, bounds.Sphere.y, bounds.Sphere.z, bounds.Sphere.w, bounds.Error } });
+    }
+
+    // Checks the hierarchy's structure and finds, for each meshlet, the outputs of the group it was
+    // merged into (null for meshlets never simplified further). Level 0 must be the source
+    // triangles, each once and with its winding. Every parent's error must be at least its child's
+    // and its sphere must enclose the child's. A group's outputs all carry the group's bounds as
+    // their Self, and come after its members.
+    uint32_t CheckHierarchy(const Mesh& mesh, const ClusterLodData& lod, std::vector<const GroupOutputs*>& parents,
+        std::map<GroupKey, GroupOutputs>& groups, const wchar_t* filename)
+    {
+        uint32_t errors = Check(lod.Meshlets.MeshletSubsets.size() == mesh.IndexSubsets.size() && lod.Lods.size() == lod.Meshlets.Meshlets.size(),
+            "ClusterLod: %ls has %u meshlet subsets for %u index subsets\n", filename, static_cast<uint32_t>(lod.Meshlets.MeshletSubsets.size()),
+            static_cast<uint32_t>(mesh.IndexSubsets.size()));
+        if (errors > 0)
+        {
+            return errors;
+        }
+
+        uint32_t badLevel0 = 0;
+        uint32_t badErrors = 0;
+        uint32_t badSpheres = 0;
+        uint32_t orphans = 0;
+
+        parents.assign(lod.Lods.size(), nullptr);
+        groups.clear();
+
+        for (uint32_t s = 0; s < mesh.IndexSubsets.size(); ++s)
+        {
+            const Subset& indexSubset = mesh.IndexSubsets[s];
+            const Subset& meshletSubset = lod.Meshlets.MeshletSubsets[s];
+
+            std::vector<Triangle> expected;
+            for (uint32_t i = indexSubset.Offset; i + 2 < indexSubset.Offset + indexSubset.Count; i += 3)
+            {
+                expected.push_back(Canonical(mesh.GetIndex(i), mesh.GetIndex(i + 1), mesh.GetIndex(i + 2)));
+            }
+
+            std::vector<Triangle> level0;
+            for (uint32_t m = meshletSubset.Offset; m < meshletSubset.Offset + meshletSubset.Count; ++m)
+            {
+                if (lod.Lods[m].Level == 0)
+                {
+                    AppendTriangles(lod.Meshlets, m, mesh.IndexSize, level0);
+                }
+                else
+                {
+                    groups[MakeGroupKey(s, lod.Lods[m].Self)].push_back(m);
+                }
+            }
+
+            std::sort(expected.begin(), expected.end());
+            std::sort(level0.begin(), level0.end());
+            badLevel0 += level0 != expected;
+
+            for (uint32_t m = meshletSubset.Offset; m < meshletSubset.Offset + meshletSubset.Count; ++m)
+            {
+                const ClusterLod& clusterLod = lod.Lods[m];
+                const XMFLOAT4& self = clusterLod.Self.Sphere;
+                const XMFLOAT4& parent = clusterLod.Parent.Sphere;
+
+                const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMVectorSet(self.x, self.y, self.z, 0), XMVectorSet(parent.x, parent.y, parent.z, 0))));
+                const float tolerance = 1e-5f * (parent.w + XMVectorGetX(XMVector3Length(XMVectorSet(parent.x, parent.y, parent.z, 0))));
+
+                badErrors += clusterLod.Parent.Error < clusterLod.Self.Error;
+                badSpheres += distance + self.w > parent.w + tolerance;
+
+                if (clusterLod.Parent.Error == FLT_MAX)
+                {
+                    continue;
+                }
+
+                auto group = groups.find(MakeGroupKey(s, clusterLod.Parent));
+                if (group == groups.end() || group->second.front() <= m)
+                {
+                    ++orphans;
+                    continue;
+                }
+                parents[m] = &group->second;
+            }
+        }
+
+        errors += Check(badLevel0 == 0, "ClusterLod: level 0 of %u subsets of %ls isn't the source triangles\n", badLevel0, filename);
+        errors += Check(badErrors == 0, "ClusterLod: %u meshlets of %ls have a parent error below their own\n", badErrors, filename);
+        errors += Check(badSpheres == 0, "ClusterLod: %u meshlets of %ls have a sphere outside their parent's\n", badSpheres, filename);
+        errors += Check(orphans == 0, "ClusterLod: %u meshlets of %ls have a parent no group of a later level matches\n", orphans, filename);
+        return errors;
+    }
+
+    // Builds the hierarchy of every mesh of the asset, then selects from views at a range of
+    // distances, including inside the model, with several error thresholds. Each selection must be
+    // a cut through the hierarchy: every path from a level 0 meshlet up through the groups that
+    // replace it meets exactly one selected meshlet, so each source triangle is drawn once, at one
+    // level of detail. And it must add no open edge the source mesh doesn't have.
+    uint32_t CheckClusterLod(const Model& model, const wchar_t* filename)
+    {
+        const float distances[] = { 0.5f, 1.5f, 6.0f, 24.0f, 96.0f };
+        const float thresholds[] = { 0.25f, 1.0f, 8.0f };
+        const XMFLOAT3 directions[] = { XMFLOAT3(0, 0, 1), XMFLOAT3(1, 0.5f, -1) };
+
+        uint32_t errors = 0;
+        for (auto& mesh : model)
+        {
+            ClusterLodData lod;
+            if (FAILED(BuildClusterLod(mesh, lod)))
+            {
+                errors += Check(false, "ClusterLod: failed to build the hierarchy of %ls\n", filename);
+                continue;
+            }
+
+            std::vector<const GroupOutputs*> parents;
+            std::map<GroupKey, GroupOutputs> groups;
+            const uint32_t hierarchyErrors = CheckHierarchy(mesh, lod, parents, groups, filename);
+            errors += hierarchyErrors;
+            if (hierarchyErrors > 0)
+            {
+                continue;
+            }
+
+            std::vector<uint32_t> level0;
+            for (uint32_t m = 0; m < lod.Lods.size(); ++m)
+            {
+                if (lod.Lods[m].Level == 0)
+                    level0.push_back(m);
+            }
+            const std::vector<uint64_t> sourceOpenEdges = CollectOpenEdges(lod, level0, mesh.IndexSize);
+
+            ClusterLodView view;
+            XMStoreFloat4x4(&view.World, XMMatrixIdentity());
+            view.Scale = 1.0f;
+            view.ProjectionScale = 1080.0f / (2.0f * tanf(XM_PIDIV4 / 2.0f));
+
+            uint32_t badCuts = 0;
+            uint32_t addedOpenEdges = 0;
+            uint32_t coarseSelections = 0;
+
+            std::vector<uint8_t> selectedFlags(lod.Lods.size());
+            std::vector<uint32_t> minPath(lod.Lods.size());
+            std::vector<uint32_t> maxPath(lod.Lods.size());
+
+            for (auto& direction : directions)
+            {
+                for (float distance : distances)
+                {
+                    const XMVECTOR offset = XMVectorScale(XMVector3Normalize(XMLoadFloat3(&direction)), distance * mesh.BoundingSphere.Radius);
+                    XMStoreFloat3(&view.ViewPosition, XMVectorAdd(XMLoadFloat3(&mesh.BoundingSphere.Center), offset));
+
+                    for (float threshold : thresholds)
+                    {
+                        view.ErrorThreshold = threshold;
+
+                        VisibleMeshlets selected;
+                        SelectClusterLod(lod, view, selected);
+
+                        std::fill(selectedFlags.begin(), selectedFlags.end(), uint8_t(0));
+                        for (uint32_t m : selected.Indices)
+                        {
+                            selectedFlags[m] = 1;
+                            coarseSelections += lod.Lods[m].Level > 0;
+                        }
+
+                        // Fewest and most selected meshlets on any path from each meshlet to the top.
+                        // Outputs always come after their group's members, so one pass downwards suffices.
+                        for (uint32_t m = static_cast<uint32_t>(lod.Lods.size()); m-- > 0; )
+                        {
+                            uint32_t fewest = 0;
+                            uint32_t most = 0;
+                            if (parents[m] != nullptr)
+                            {
+                                fewest = UINT32_MAX;
+                                for (uint32_t p : *parents[m])
+                                {
+                                    fewest = min(fewest, minPath[p]);
+                                    most = max(most, maxPath[p]);
+                                }
+                            }
+                            minPath[m] = fewest + selectedFlags[m];
+                            maxPath[m] = most + selectedFlags[m];
+                        }
+
+                        bool cut = selected.Subsets.size() == lod.Meshlets.MeshletSubsets.size();
+                        for (uint32_t m : level0)
+                        {
+                            cut = cut && minPath[m] == 1 && maxPath[m] == 1;
+                        }
+                        badCuts += !cut;
+
+                        for (uint64_t edge : CollectOpenEdges(lod, selected.Indices, mesh.IndexSize))
+                        {
+                            addedOpenEdges += !std::binary_search(sourceOpenEdges.begin(), sourceOpenEdges.end(), edge);
+                        }
+                    }
+                }
+            }
+
+            const uint32_t selectionCount = static_cast<uint32_t>(_countof(directions) * _countof(distances) * _countof(thresholds));
+            errors += Check(badCuts == 0, "ClusterLod: %u of %u selections of %ls don't cover each source triangle once\n", badCuts, selectionCount, filename);
+            errors += Check(addedOpenEdges == 0, "ClusterLod: selections of %ls add %u open edges the source mesh doesn't have\n", filename, addedOpenEdges);
+            errors += Check(lod.LevelTriangles.size() < 2 || coarseSelections > 0, "ClusterLod: no selection of %ls uses a level above 0\n", filename);
+        }
+
+        return errors;
+    }
+}
+
+// Builds the cluster hierarchy of each bundled asset and checks its structure and the selections
+// made from it.
+uint32_t Tests::TestClusterLod(const std::wstring& assetDirectory)
+{
+    uint32_t errors = 0;
+    for (auto filename : c_assetFilenames)
+    {
+        const std::wstring path = assetDirectory + filename;
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            return errors + Check(false, "Failed to load %ls\n", path.c_str());
+        }
+
+        errors += CheckClusterLod(model, filename);
+    }
+    return errors;
+}
@@ -0,0 +1,303 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Compression.h"
+
+#include <cstring>
+
+namespace
+{
+    const uint32_t c_hashLog = 14;
+    const size_t   c_minMatch = 4;
+    const size_t   c_lastLiterals = 5;     // Matches must end this many bytes before the end of input.
+    const size_t   c_matchSearchLimit = 12; // No match may start within this many bytes of the end of input.
+    const size_t   c_maxOffset = 0xFFFF;
+    const uint32_t c_skipTrigger = 6;      // Search step grows by one every 2^c_skipTrigger misses.
+
+    uint32_t Read32(const uint8_t* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t Hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - c_hashLog);
+    }
+
+    uint8_t* WriteLength(uint8_t* op, size_t length)
+    {
+        while (length >= 255)
+        {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+        return op;
+    }
+
+    // Emits one literal run followed by a match. Returns nullptr if dst would overflow.
+    uint8_t* WriteSequence(uint8_t* op, const uint8_t* oend, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+    {
+        const size_t encodedMatch = matchLength - c_minMatch;
+        const size_t worstCase = 1 + (literalLength / 255 + 1) + literalLength + 2 + (encodedMatch / 255 + 1);
+        if (worstCase > static_cast<size_t>(oend - op))
+        {
+            return nullptr;
+        }
+
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>((min(literalLength, size_t(15)) << 4) | min(encodedMatch, size_t(15)));
+
+        if (literalLength >= 15)
+        {
+            op = WriteLength(op, literalLength - 15);
+        }
+
+        std::memcpy(op, literals, literalLength);
+        op += literalLength;
+
+        *op++ = static_cast<uint8_t>(offset & 0xFF);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        if (encodedMatch >= 15)
+        {
+            op = WriteLength(op, encodedMatch - 15);
+        }
+
+        return op;
+    }
+
+    // Emits the closing literal-only sequence. Returns nullptr if dst would overflow.
+    uint8_t* WriteLastLiterals(uint8_t* op, const uint8_t* oend, const uint8_t* literals, size_t literalLength)
+    {
+        const size_t worstCase = 1 + (literalLength / 255 + 1) + literalLength;
+        if (worstCase > static_cast<size_t>(oend - op))
+        {
+            return nullptr;
+        }
+
+        *op++ = static_cast<uint8_t>(min(literalLength, size_t(15)) << 4);
+
+        if (literalLength >= 15)
+        {
+            op = WriteLength(op, literalLength - 15);
+        }
+
+        std::memcpy(op, literals, literalLength);
+        return op + literalLength;
+    }
+}
+
+size_t Compression::GetMaxCompressedSize(size_t srcSize)
+{
+    return srcSize + srcSize / 255 + 16;
+}
+
+size_t Compression::Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const iend = src + srcSize;
+
+    uint8_t* op = dst;
+    const uint8_t* const oend = dst + dstCapacity;
+
+    if (srcSize > c_matchSearchLimit)
+    {
+        // Positions are stored biased by one so that zero marks an empty slot.
+        std::vector<uint32_t> table(size_t(1) << c_hashLog, 0);
+
+        const uint8_t* const searchLimit = iend - c_matchSearchLimit;
+        const uint8_t* const matchLimit = iend - c_lastLiterals;
+
+        uint32_t misses = 0;
+
+        while (ip < searchLimit)
+        {
+            const uint32_t sequence = Read32(ip);
+            const uint32_t hash = Hash(sequence);
+            const uint32_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(ip - src) + 1;
+
+            if (candidate != 0)
+            {
+                const uint8_t* ref = src + candidate - 1;
+
+                if (static_cast<size_t>(ip - ref) <= c_maxOffset && Read32(ref) == sequence)
+                {
+                    const uint8_t* matchEnd = ip + c_minMatch;
+                    const uint8_t* refEnd = ref + c_minMatch;
+                    while (matchEnd < matchLimit && *matchEnd == *refEnd)
+                    {
+                        ++matchEnd;
+                        ++refEnd;
+                    }
+
+                    op = WriteSequence(op, oend, anchor, ip - anchor, ip - ref, matchEnd - ip);
+                    if (op == nullptr)
+                    {
+                        return 0;
+                    }
+
+                    // Seed the table from inside the match to find the next one sooner.
+                    const uint8_t* seed = matchEnd - 2;
+                    table[Hash(Read32(seed))] = static_cast<uint32_t>(seed - src) + 1;
+
+                    ip = matchEnd;
+                    anchor = ip;
+                    misses = 0;
+                    continue;
+                }
+            }
+
+            // Accelerate through incompressible regions.
+            ip += 1 + (misses++ >> c_skipTrigger);
+        }
+    }
+
+    op = WriteLastLiterals(op, oend, anchor, iend - anchor);
+    if (op == nullptr)
+    {
+        return 0;
+    }
+
+    return op - dst;
+}
+
+bool Compression::Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + srcSize;
+
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dstSize;
+
+    while (ip < iend)
+    {
+        const uint32_t token = *ip++;
+
+        // Literal run
+        size_t literalLength = token >> 4;
+        if (literalLength == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= iend)
+                    return false;
+
+                b = *ip++;
+                literalLength += b;
+            } while (b == 255);
+        }
+
+        if (literalLength > static_cast<size_t>(iend - ip) || literalLength > static_cast<size_t>(oend - op))
+        {
+            return false;
+        }
+
+        std::memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        if (ip == iend)
+        {
+            break; // The last sequence has no match.
+        }
+
+        // Match
+        if (iend - ip < 2)
+        {
+            return false;
+        }
+
+        const size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > static_cast<size_t>(op - dst))
+        {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= iend)
+                    return false;
+
+                b = *ip++;
+                matchLength += b;
+            } while (b == 255);
+        }
+        matchLength += c_minMatch;
+
+        if (matchLength > static_cast<size_t>(oend - op))
+        {
+            return false;
+        }
+
+        const uint8_t* ref = op - offset;
+        if (offset >= matchLength)
+        {
+            std::memcpy(op, ref, matchLength);
+        }
+        else
+        {
+            // Overlapping copy replicates the last 'offset' bytes.
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                op[i] = ref[i];
+            }
+        }
+        op += matchLength;
+    }
+
+    return op == oend;
+}
+
+void Compression::ShuffleBytes(const uint8_t* src, size_t size, uint32_t elementSize, uint8_t* dst)
+{
+    const size_t count = size / elementSize;
+
+    for (uint32_t b = 0; b < elementSize; ++b)
+    {
+        uint8_t* out = dst + b * count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = src[i * elementSize + b];
+        }
+    }
+
+    const size_t tail = count * elementSize;
+    std::memcpy(dst + tail, src + tail, size - tail);
+}
+
+void Compression::UnshuffleBytes(const uint8_t* src, size_t size, uint32_t elementSize, uint8_t* dst)
+{
+    const size_t count = size / elementSize;
+
+    for (uint32_t b = 0; b < elementSize; ++b)
+    {
+        const uint8_t* in = src + b * count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            dst[i * elementSize + b] = in[i];
+        }
+    }
+
+    const size_t tail = count * elementSize;
+    std::memcpy(dst + tail, src + tail, size - tail);
+}
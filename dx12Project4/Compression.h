@@ -0,0 +1,36 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A small byte-oriented LZ77 codec in the style of LZ4: a stream of sequences, each a
+// token byte (4-bit literal length, 4-bit match length - 4), extended lengths as runs of
+// 255-valued bytes, the literals, then a 16-bit little-endian match offset. The final
+// sequence carries literals only. Decoding is branch-light and needs no extra memory.
+namespace Compression
+{
+    // Worst-case compressed size for an input of the given size.
+    size_t GetMaxCompressedSize(size_t srcSize);
+
+    // Returns the number of bytes written to dst, or 0 if the output didn't fit in dstCapacity.
+    size_t Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+    // Decodes exactly dstSize bytes into dst. Returns false on malformed or truncated input.
+    bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+    // Transposes the bytes of consecutive elementSize-byte elements so that the same byte of
+    // every element is stored contiguously, which makes float and index streams far more
+    // compressible. Trailing bytes that don't form a whole element are copied through.
+    void ShuffleBytes(const uint8_t* src, size_t size, uint32_t elementSize, uint8_t* dst);
+    void UnshuffleBytes(const uint8_t* src, size_t size, uint32_t elementSize, uint8_t* dst);
+}
@@ -0,0 +1,110 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Tests;
+
+namespace
+{
+    std::vector<uint8_t> MakeNoise(std::mt19937& rng, size_t size)
+    {
+        std::vector<uint8_t> bytes(size);
+        for (auto& b : bytes)
+        {
+            b = static_cast<uint8_t>(rng());
+        }
+        return bytes;
+    }
+
+    // Noise that repeats every period bytes, so each match is exactly period bytes back.
+    std::vector<uint8_t> MakeRepeatingNoise(std::mt19937& rng, size_t period, size_t size)
+    {
+        const std::vector<uint8_t> noise = MakeNoise(rng, period);
+
+        std::vector<uint8_t> bytes(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            bytes[i] = noise[i % period];
+        }
+        return bytes;
+    }
+
+    // Compresses src into a buffer of the worst-case size and decodes it back, which must give the
+    // same bytes. A stream missing its last byte must be rejected.
+    uint32_t CheckRoundTrip(const std::vector<uint8_t>& src, const char* name)
+    {
+        // The codec copies from and to its buffers even when empty, so they mustn't be null.
+        const uint8_t empty = 0;
+        const uint8_t* srcData = src.empty() ? &empty : src.data();
+
+        std::vector<uint8_t> compressed(Compression::GetMaxCompressedSize(src.size()));
+        const size_t compressedSize = Compression::Compress(srcData, src.size(), compressed.data(), compressed.size());
+
+        uint32_t errors = Check(compressedSize > 0, "Compression (%s): %zu bytes didn't fit in the worst-case size\n", name, src.size());
+        if (errors > 0)
+        {
+            return errors;
+        }
+
+        // One spare byte, which must be left alone.
+        std::vector<uint8_t> decoded(src.size() + 1, 0xCD);
+        const bool decodedAll = Compression::Decompress(compressed.data(), compressedSize, decoded.data(), src.size());
+        errors += Check(decodedAll && std::equal(src.begin(), src.end(), decoded.begin()) && decoded[src.size()] == 0xCD,
+            "Compression (%s): %zu bytes don't survive a round trip through %zu compressed bytes\n", name, src.size(), compressedSize);
+
+        if (!src.empty())
+        {
+            errors += Check(!Compression::Decompress(compressed.data(), compressedSize - 1, decoded.data(), src.size()),
+                "Compression (%s): a truncated stream decodes\n", name);
+        }
+        return errors;
+    }
+}
+
+// Round-trips the inputs at the codec's edges: empty and shorter than a match, long runs whose
+// matches overlap their own output, and matches at and around the largest offset a sequence
+// can store.
+uint32_t Tests::TestCompression(const std::wstring&)
+{
+    std::mt19937 rng(23);
+
+    uint32_t errors = CheckRoundTrip({}, "empty");
+    errors += CheckRoundTrip({ 0x2A }, "1 byte");
+    errors += CheckRoundTrip({ 0x2A, 0x2A }, "2 bytes");
+    errors += CheckRoundTrip({ 0x2A, 0x00, 0x2A }, "3 bytes");
+    errors += CheckRoundTrip(MakeNoise(rng, 13), "13 bytes of noise");
+
+    errors += CheckRoundTrip(std::vector<uint8_t>(100000, 0xAB), "run of one byte");
+    errors += CheckRoundTrip(MakeRepeatingNoise(rng, 3, 70000), "run with period 3");
+
+    std::vector<uint8_t> runInNoise = MakeNoise(rng, 4096);
+    runInNoise.insert(runInNoise.begin() + 1000, 5000, 0);
+    errors += CheckRoundTrip(runInNoise, "run within noise");
+
+    // Matches 0xFFFF bytes back are the furthest a sequence can encode; the longer periods must
+    // fall back to literals.
+    const size_t periods[] = { 0xFFFE, 0xFFFF, 0x10000, 0x10001 };
+    for (size_t period : periods)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "period 0x%zX", period);
+        errors += CheckRoundTrip(MakeRepeatingNoise(rng, period, 2 * period + 100), name);
+    }
+
+    return errors;
+}
@@ -0,0 +1,354 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "CullDataGenerator.h"
+
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+    const uint32_t c_laneCount = 4;         // Meshlets per group, one per XMVECTOR lane
+    const uint32_t c_groupsPerBatch = 32;   // Lane groups per pool task
+    const float    c_minConeDot = 0.1f;     // Cones opening wider than this (about 84 degrees) are flagged degenerate
+
+    // Structure-of-arrays staging for one lane group, reused across the groups of a batch.
+    struct LaneScratch
+    {
+        std::vector<XMFLOAT4A> X, Y, Z;         // Positions, indexed by meshlet-local vertex
+        std::vector<XMVECTOR>  NX, NY, NZ, D;   // Unit face normals and plane distances, indexed by primitive
+        std::vector<XMVECTOR>  Valid;           // All bits set where the primitive has non-zero area
+    };
+
+    float& Lane(XMFLOAT4A& v, uint32_t lane) { return (&v.x)[lane]; }
+
+    XMVECTOR XM_CALLCONV Dot3(FXMVECTOR ax, FXMVECTOR ay, FXMVECTOR az, GXMVECTOR bx, HXMVECTOR by, HXMVECTOR bz)
+    {
+        return XMVectorMultiplyAdd(az, bz, XMVectorMultiplyAdd(ay, by, XMVectorMultiply(ax, bx)));
+    }
+
+    // Grows each lane's sphere just enough to cover the lane's point where mask is set.
+    void XM_CALLCONV GrowSphere(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, GXMVECTOR mask, XMVECTOR& centerX, XMVECTOR& centerY, XMVECTOR& centerZ, XMVECTOR& radius)
+    {
+        const XMVECTOR dx = XMVectorSubtract(x, centerX);
+        const XMVECTOR dy = XMVectorSubtract(y, centerY);
+        const XMVECTOR dz = XMVectorSubtract(z, centerZ);
+
+        const XMVECTOR distance = XMVectorSqrt(Dot3(dx, dy, dz, dx, dy, dz));
+        const XMVECTOR grow = XMVectorAndInt(XMVectorGreater(distance, radius), mask);
+
+        // The new sphere spans the old one's far side and the point.
+        const XMVECTOR newRadius = XMVectorScale(XMVectorAdd(radius, distance), 0.5f);
+        const XMVECTOR step = XMVectorSelect(XMVectorZero(), XMVectorDivide(XMVectorSubtract(distance, newRadius), distance), grow);
+
+        centerX = XMVectorMultiplyAdd(dx, step, centerX);
+        centerY = XMVectorMultiplyAdd(dy, step, centerY);
+        centerZ = XMVectorMultiplyAdd(dz, step, centerZ);
+        radius = XMVectorSelect(radius, newRadius, grow);
+    }
+
+    // Computes the culling data of meshlets [first, first + count), count <= c_laneCount.
+    void ComputeLaneGroup(const Mesh& mesh, const PositionStream& positions, uint32_t first, uint32_t count, CullData* out, LaneScratch& scratch)
+    {
+        // Lanes past the end repeat the first meshlet; their results are discarded.
+        const Meshlet* lanes[c_laneCount];
+        uint32_t maxVerts = 0;
+        uint32_t maxPrims = 0;
+
+        for (uint32_t l = 0; l < c_laneCount; ++l)
+        {
+            lanes[l] = &mesh.Meshlets[first + (l < count ? l : 0)];
+            maxVerts = max(maxVerts, lanes[l]->VertCount);
+            maxPrims = max(maxPrims, lanes[l]->PrimCount);
+        }
+
+        if (scratch.X.size() < maxVerts)
+        {
+            scratch.X.resize(maxVerts);
+            scratch.Y.resize(maxVerts);
+            scratch.Z.resize(maxVerts);
+        }
+
+        if (scratch.NX.size() < maxPrims)
+        {
+            scratch.NX.resize(maxPrims);
+            scratch.NY.resize(maxPrims);
+            scratch.NZ.resize(maxPrims);
+            scratch.D.resize(maxPrims);
+            scratch.Valid.resize(maxPrims);
+        }
+
+        // Gather positions. Lanes with fewer vertices repeat their first, which leaves the bounds unchanged.
+        for (uint32_t v = 0; v < maxVerts; ++v)
+        {
+            for (uint32_t l = 0; l < c_laneCount; ++l)
+            {
+                const Meshlet& m = *lanes[l];
+                const XMFLOAT3& p = positions[mesh.GetVertexIndex(m.VertOffset + (v < m.VertCount ? v : 0))];
+
+                Lane(scratch.X[v], l) = p.x;
+                Lane(scratch.Y[v], l) = p.y;
+                Lane(scratch.Z[v], l) = p.z;
+            }
+        }
+
+        // Bounding sphere: whichever is smaller of the box-centred sphere and Ritter's sphere grown
+        // from the box centre; neither is consistently tighter.
+        XMVECTOR minX = XMVectorReplicate(FLT_MAX), minY = minX, minZ = minX;
+        XMVECTOR maxX = XMVectorReplicate(-FLT_MAX), maxY = maxX, maxZ = maxX;
+
+        for (uint32_t v = 0; v < maxVerts; ++v)
+        {
+            XMVECTOR x = XMLoadFloat4A(&scratch.X[v]);
+            XMVECTOR y = XMLoadFloat4A(&scratch.Y[v]);
+            XMVECTOR z = XMLoadFloat4A(&scratch.Z[v]);
+
+            minX = XMVectorMin(minX, x); maxX = XMVectorMax(maxX, x);
+            minY = XMVectorMin(minY, y); maxY = XMVectorMax(maxY, y);
+            minZ = XMVectorMin(minZ, z); maxZ = XMVectorMax(maxZ, z);
+        }
+
+        const XMVECTOR boxCenterX = XMVectorScale(XMVectorAdd(minX, maxX), 0.5f);
+        const XMVECTOR boxCenterY = XMVectorScale(XMVectorAdd(minY, maxY), 0.5f);
+        const XMVECTOR boxCenterZ = XMVectorScale(XMVectorAdd(minZ, maxZ), 0.5f);
+
+        XMVECTOR boxRadiusSq = XMVectorZero();
+        XMVECTOR centerX = boxCenterX, centerY = boxCenterY, centerZ = boxCenterZ;
+        XMVECTOR radius = XMVectorZero();
+
+        for (uint32_t v = 0; v < maxVerts; ++v)
+        {
+            const XMVECTOR x = XMLoadFloat4A(&scratch.X[v]);
+            const XMVECTOR y = XMLoadFloat4A(&scratch.Y[v]);
+            const XMVECTOR z = XMLoadFloat4A(&scratch.Z[v]);
+
+            const XMVECTOR dx = XMVectorSubtract(x, boxCenterX);
+            const XMVECTOR dy = XMVectorSubtract(y, boxCenterY);
+            const XMVECTOR dz = XMVectorSubtract(z, boxCenterZ);
+            boxRadiusSq = XMVectorMax(boxRadiusSq, Dot3(dx, dy, dz, dx, dy, dz));
+
+            GrowSphere(x, y, z, XMVectorTrueInt(), centerX, centerY, centerZ, radius);
+        }
+
+        const XMVECTOR boxRadius = XMVectorSqrt(boxRadiusSq);
+        const XMVECTOR useBox = XMVectorLess(boxRadius, radius);
+
+        centerX = XMVectorSelect(centerX, boxCenterX, useBox);
+        centerY = XMVectorSelect(centerY, boxCenterY, useBox);
+        centerZ = XMVectorSelect(centerZ, boxCenterZ, useBox);
+        radius = XMVectorSelect(radius, boxRadius, useBox);
+
+        // Face normals. Lanes with fewer primitives repeat their first, which leaves the cone unchanged.
+        // Zero-area triangles never rasterize, so they are masked out of the cone entirely.
+        XMVECTOR minNX = XMVectorReplicate(FLT_MAX), minNY = minNX, minNZ = minNX;
+        XMVECTOR maxNX = XMVectorReplicate(-FLT_MAX), maxNY = maxNX, maxNZ = maxNX;
+
+        for (uint32_t j = 0; j < maxPrims; ++j)
+        {
+            XMFLOAT4A corners[3][3]; // [corner][axis]
+
+            for (uint32_t l = 0; l < c_laneCount; ++l)
+            {
+                const Meshlet& m = *lanes[l];
+
+                uint32_t local[3];
+                mesh.GetPrimitive(m.PrimOffset + (j < m.PrimCount ? j : 0), local[0], local[1], local[2]);
+
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    Lane(corners[c][0], l) = Lane(scratch.X[local[c]], l);
+                    Lane(corners[c][1], l) = Lane(scratch.Y[local[c]], l);
+                    Lane(corners[c][2], l) = Lane(scratch.Z[local[c]], l);
+                }
+            }
+
+            const XMVECTOR p0x = XMLoadFloat4A(&corners[0][0]);
+            const XMVECTOR p0y = XMLoadFloat4A(&corners[0][1]);
+            const XMVECTOR p0z = XMLoadFloat4A(&corners[0][2]);
+
+            const XMVECTOR e1x = XMVectorSubtract(XMLoadFloat4A(&corners[1][0]), p0x);
+            const XMVECTOR e1y = XMVectorSubtract(XMLoadFloat4A(&corners[1][1]), p0y);
+            const XMVECTOR e1z = XMVectorSubtract(XMLoadFloat4A(&corners[1][2]), p0z);
+            const XMVECTOR e2x = XMVectorSubtract(XMLoadFloat4A(&corners[2][0]), p0x);
+            const XMVECTOR e2y = XMVectorSubtract(XMLoadFloat4A(&corners[2][1]), p0y);
+            const XMVECTOR e2z = XMVectorSubtract(XMLoadFloat4A(&corners[2][2]), p0z);
+
+            // Front faces are clockwise (the default rasterizer state), so the outward normal is e2 x e1.
+            XMVECTOR nx = XMVectorNegativeMultiplySubtract(e2z, e1y, XMVectorMultiply(e2y, e1z));
+            XMVECTOR ny = XMVectorNegativeMultiplySubtract(e2x, e1z, XMVectorMultiply(e2z, e1x));
+            XMVECTOR nz = XMVectorNegativeMultiplySubtract(e2y, e1x, XMVectorMultiply(e2x, e1y));
+
+            const XMVECTOR lengthSq = Dot3(nx, ny, nz, nx, ny, nz);
+            const XMVECTOR valid = XMVectorGreater(lengthSq, XMVectorZero());
+            const XMVECTOR scale = XMVectorSelect(XMVectorZero(), XMVectorReciprocal(XMVectorSqrt(lengthSq)), valid);
+
+            nx = XMVectorMultiply(nx, scale);
+            ny = XMVectorMultiply(ny, scale);
+            nz = XMVectorMultiply(nz, scale);
+
+            scratch.NX[j] = nx;
+            scratch.NY[j] = ny;
+            scratch.NZ[j] = nz;
+            scratch.D[j] = Dot3(p0x, p0y, p0z, nx, ny, nz);
+            scratch.Valid[j] = valid;
+
+            minNX = XMVectorMin(minNX, XMVectorSelect(minNX, nx, valid)); maxNX = XMVectorMax(maxNX, XMVectorSelect(maxNX, nx, valid));
+            minNY = XMVectorMin(minNY, XMVectorSelect(minNY, ny, valid)); maxNY = XMVectorMax(maxNY, XMVectorSelect(maxNY, ny, valid));
+            minNZ = XMVectorMin(minNZ, XMVectorSelect(minNZ, nz, valid)); maxNZ = XMVectorMax(maxNZ, XMVectorSelect(maxNZ, nz, valid));
+        }
+
+        // The cone axis points at the centre of a sphere around the normals' tips: Ritter's
+        // growing pass, started from the centre of their box.
+        XMVECTOR sumX = XMVectorScale(XMVectorAdd(minNX, maxNX), 0.5f);
+        XMVECTOR sumY = XMVectorScale(XMVectorAdd(minNY, maxNY), 0.5f);
+        XMVECTOR sumZ = XMVectorScale(XMVectorAdd(minNZ, maxNZ), 0.5f);
+        XMVECTOR tipRadius = XMVectorZero();
+
+        for (uint32_t j = 0; j < maxPrims; ++j)
+        {
+            GrowSphere(scratch.NX[j], scratch.NY[j], scratch.NZ[j], scratch.Valid[j], sumX, sumY, sumZ, tipRadius);
+        }
+
+        // Quantize the axis the way UnpackCone decodes it.
+        const XMVECTOR sumLengthSq = Dot3(sumX, sumY, sumZ, sumX, sumY, sumZ);
+
+        const XMVECTOR half = XMVectorReplicate(0.5f);
+        const XMVECTOR unormScale = XMVectorReplicate(255.0f);
+        const XMVECTOR sumScale = XMVectorReciprocal(XMVectorSqrt(sumLengthSq));
+
+        const XMVECTOR quantizedX = XMVectorRound(XMVectorMultiply(XMVectorSaturate(XMVectorMultiplyAdd(XMVectorMultiply(sumX, sumScale), half, half)), unormScale));
+        const XMVECTOR quantizedY = XMVectorRound(XMVectorMultiply(XMVectorSaturate(XMVectorMultiplyAdd(XMVectorMultiply(sumY, sumScale), half, half)), unormScale));
+        const XMVECTOR quantizedZ = XMVectorRound(XMVectorMultiply(XMVectorSaturate(XMVectorMultiplyAdd(XMVectorMultiply(sumZ, sumScale), half, half)), unormScale));
+
+        // Decoded components are odd multiples of 1/255, so the decoded axis is never zero.
+        const XMVECTOR decodeScale = XMVectorReplicate(2.0f / 255.0f);
+        const XMVECTOR one = XMVectorSplatOne();
+
+        XMVECTOR axisX = XMVectorSubtract(XMVectorMultiply(quantizedX, decodeScale), one);
+        XMVECTOR axisY = XMVectorSubtract(XMVectorMultiply(quantizedY, decodeScale), one);
+        XMVECTOR axisZ = XMVectorSubtract(XMVectorMultiply(quantizedZ, decodeScale), one);
+
+        const XMVECTOR axisScale = XMVectorReciprocal(XMVectorSqrt(Dot3(axisX, axisY, axisZ, axisX, axisY, axisZ)));
+        axisX = XMVectorMultiply(axisX, axisScale);
+        axisY = XMVectorMultiply(axisY, axisScale);
+        axisZ = XMVectorMultiply(axisZ, axisScale);
+
+        // Spread against the decoded axis, and the apex: the farthest point back along the axis from
+        // the centre that is needed to lie behind every triangle's plane. Degenerate lanes may divide
+        // by zero here; their results are replaced below.
+        XMVECTOR minDot = one;
+        XMVECTOR maxOffset = XMVectorReplicate(-FLT_MAX);
+
+        for (uint32_t j = 0; j < maxPrims; ++j)
+        {
+            const XMVECTOR nx = scratch.NX[j];
+            const XMVECTOR ny = scratch.NY[j];
+            const XMVECTOR nz = scratch.NZ[j];
+
+            const XMVECTOR dn = Dot3(nx, ny, nz, axisX, axisY, axisZ);
+            const XMVECTOR offset = XMVectorDivide(XMVectorSubtract(Dot3(centerX, centerY, centerZ, nx, ny, nz), scratch.D[j]), dn);
+
+            minDot = XMVectorMin(minDot, XMVectorSelect(one, dn, scratch.Valid[j]));
+            maxOffset = XMVectorMax(maxOffset, XMVectorSelect(maxOffset, offset, scratch.Valid[j]));
+        }
+
+        // -cos(a + 90) = sin(a), rounded up so the decoded cone never narrows.
+        const XMVECTOR sinAngle = XMVectorSqrt(XMVectorMax(XMVectorNegativeMultiplySubtract(minDot, minDot, one), XMVectorZero()));
+        const XMVECTOR quantizedW = XMVectorMin(XMVectorCeiling(XMVectorMultiply(sinAngle, unormScale)), unormScale);
+
+        const XMVECTOR degenerate = XMVectorOrInt(
+            XMVectorLessOrEqual(minDot, XMVectorReplicate(c_minConeDot)),
+            XMVectorEqual(sumLengthSq, XMVectorZero()));
+
+        XMFLOAT4A cx, cy, cz, r, qx, qy, qz, qw, apex;
+        XMStoreFloat4A(&cx, centerX);
+        XMStoreFloat4A(&cy, centerY);
+        XMStoreFloat4A(&cz, centerZ);
+        XMStoreFloat4A(&r, radius);
+        XMStoreFloat4A(&qx, quantizedX);
+        XMStoreFloat4A(&qy, quantizedY);
+        XMStoreFloat4A(&qz, quantizedZ);
+        XMStoreFloat4A(&qw, XMVectorSelect(quantizedW, unormScale, degenerate));
+        XMStoreFloat4A(&apex, XMVectorSelect(maxOffset, XMVectorZero(), degenerate));
+
+        for (uint32_t l = 0; l < count; ++l)
+        {
+            CullData& cull = out[l];
+            cull.BoundingSphere = XMFLOAT4(Lane(cx, l), Lane(cy, l), Lane(cz, l), Lane(r, l));
+            cull.NormalCone[0] = static_cast<uint8_t>(Lane(qx, l));
+            cull.NormalCone[1] = static_cast<uint8_t>(Lane(qy, l));
+            cull.NormalCone[2] = static_cast<uint8_t>(Lane(qz, l));
+            cull.NormalCone[3] = static_cast<uint8_t>(Lane(qw, l));
+            cull.ApexOffset = Lane(apex, l);
+        }
+    }
+}
+
+HRESULT GenerateCullData(const Mesh& mesh, std::vector<CullData>& cullData, ThreadPool& pool)
+{
+    if (mesh.IndexSize != 2 && mesh.IndexSize != 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    const uint32_t meshletCount = static_cast<uint32_t>(mesh.Meshlets.size());
+    const size_t uniqueIndexCount = mesh.UniqueVertexIndices.size() / mesh.IndexSize;
+
+    // Every meshlet must be non-empty and reference only its own vertices.
+    for (uint32_t i = 0; i < meshletCount; ++i)
+    {
+        const Meshlet& m = mesh.Meshlets[i];
+
+        if (m.VertCount == 0 || m.PrimCount == 0 ||
+            size_t(m.VertOffset) + m.VertCount > uniqueIndexCount ||
+            size_t(m.PrimOffset) + m.PrimCount > mesh.PrimitiveIndices.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        for (uint32_t p = 0; p < m.PrimCount; ++p)
+        {
+            uint32_t i0, i1, i2;
+            mesh.GetPrimitive(m.PrimOffset + p, i0, i1, i2);
+
+            if (i0 >= m.VertCount || i1 >= m.VertCount || i2 >= m.VertCount)
+            {
+                return E_INVALIDARG;
+            }
+        }
+    }
+
+    cullData.resize(meshletCount);
+
+    if (meshletCount == 0)
+        return S_OK;
+
+    const PositionStream positions = mesh.GetPositions();
+    const uint32_t groupCount = (meshletCount + c_laneCount - 1) / c_laneCount;
+    const uint32_t batchCount = (groupCount + c_groupsPerBatch - 1) / c_groupsPerBatch;
+
+    pool.ParallelFor(batchCount, [&](uint32_t b)
+    {
+        LaneScratch scratch;
+
+        const uint32_t firstGroup = b * c_groupsPerBatch;
+        const uint32_t lastGroup = min(firstGroup + c_groupsPerBatch, groupCount);
+
+        for (uint32_t g = firstGroup; g < lastGroup; ++g)
+        {
+            const uint32_t first = g * c_laneCount;
+            ComputeLaneGroup(mesh, positions, first, min(c_laneCount, meshletCount - first), &cullData[first], scratch);
+        }
+    });
+
+    return S_OK;
+}
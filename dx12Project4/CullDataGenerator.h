@@ -0,0 +1,29 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "Model.h"
+
+// Computes the culling data MeshAS.hlsl tests each meshlet against, one entry per mesh.Meshlets
+// element. Reads Meshlets, UniqueVertexIndices, PrimitiveIndices and the position stream.
+//
+//   BoundingSphere  Encloses the meshlet's vertices.
+//   NormalCone      xyz: the axis around the meshlet's outward face normals (front faces are
+//                        clockwise) as UNORM8 of axis * 0.5 + 0.5.
+//                   w:   sin of the cone's half-angle as UNORM8, rounded up. This is the -cos(a + 90)
+//                        UnpackCone returns. 0xFF marks the cone degenerate (IsConeDegenerate).
+//   ApexOffset      Distance back along the axis from the sphere centre to the point behind every
+//                   triangle's plane.
+//
+// The cone angle and apex are measured against the axis as the shader will decode it, so
+// quantization never culls a visible meshlet. Meshlets are processed four at a time, one per SIMD
+// lane, in batches spread across the pool.
+HRESULT GenerateCullData(const Mesh& mesh, std::vector<CullData>& cullData, ThreadPool& pool = ThreadPool::GetDefault());
@@ -0,0 +1,52 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "MeshletCuller.h"
+#include "Model.h"
+
+#include <cmath>
+#include <cstdint>
+
+// Views per model in the culling tests and benchmarks.
+const uint32_t c_cullViewCount = 64;
+
+// View number 'view' of an orbit around the model. Cameras look past the model's centre and the
+// model is turned and scaled, so a mix of frustum, cone and no culling is exercised. Narrowing the
+// field of view turns the orbit into close-ups of parts of the model.
+inline void MakeCullParams(const Model& model, uint32_t view, MeshletCullParams& params, float fieldOfView = DirectX::XM_PIDIV4)
+{
+    using namespace DirectX;
+
+    const BoundingSphere& bounds = model.GetBoundingSphere();
+    const float t = float(view) / c_cullViewCount;
+
+    const float scale = 0.5f + 1.5f * t;
+    const XMMATRIX world = XMMatrixScaling(scale, scale, scale) * XMMatrixRotationY(XM_2PI * 3.0f * t);
+
+    const XMVECTOR center = XMVectorScale(XMLoadFloat3(&bounds.Center), scale);
+    const float radius = bounds.Radius * scale;
+
+    const float yaw = XM_2PI * t;
+    const float pitch = 0.6f * sinf(XM_2PI * 5.0f * t);
+    const float distance = radius * (0.8f + 2.5f * (view % 4) / 3.0f);
+
+    const XMVECTOR eye = XMVectorAdd(center, XMVectorScale(XMVectorSet(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch), 0), distance));
+    const XMVECTOR target = XMVectorAdd(center, XMVectorScale(XMVectorSet(sinf(yaw), 0, -cosf(yaw), 0), radius * 0.5f * (view % 3)));
+
+    const XMMATRIX viewMatrix = XMMatrixLookAtRH(eye, target, XMVectorSet(0, 1, 0, 0));
+    const XMMATRIX proj = XMMatrixPerspectiveFovRH(fieldOfView, 16.0f / 9.0f, radius * 0.01f, radius * 10.0f);
+
+    XMStoreFloat4x4(&params.World, world);
+    params.Scale = scale;
+    ComputeFrustumPlanes(viewMatrix * proj, params.Planes);
+    XMStoreFloat3(&params.ViewPosition, eye);
+}
@@ -11,6 +11,7 @@
 
 #include "stdafx.h"
 #include "DX12Practice.h"
+#include "HeapCounter.h"
 
 
 const wchar_t* DX12Practice::c_meshFilename = L"..\\Assets\\Models\\Dragon_LOD0.bin";
@@ -26,7 +27,19 @@ DX12Practice::DX12Practice(UINT width, UINT height, std::wstring name) :
     m_viewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)),
     m_scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     m_frameNumber(0),
-    m_rtvDescriptorSize(0)
+    m_rtvDescriptorSize(0),
+    m_lastAllocationCount(0),
+    m_frameAllocations(0),
+    m_uploadedMeshCount(0),
+    m_cpuCulling(false),
+    m_temporalCulling(false),
+    m_dispatchRuns(),
+    m_meshletRanges(),
+    m_packedGeometry(false),
+    m_recordingChunkCount(0),
+    m_frameConstants(0),
+    m_frameMeshTable(0),
+    m_framePacked(false)
 {
 }
 
@@ -173,6 +186,10 @@ void DX12Practice::LoadPipeline()
             rtvHandle.Offset(1, m_rtvDescriptorSize);
 
             ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocator[n]))); 
+            for (UINT c = 0; c < c_maxRecordingChunks; c++)
+            {
+                ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_chunkAllocators[n][c])));
+            }
         }
     }
 
@@ -208,31 +225,9 @@ void DX12Practice::LoadPipeline()
         m_device->CreateDepthStencilView(m_depthStencil.Get(), &depthStencilDesc, m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
     }
 
-    // Create the constant buffer.
-    {
-        const UINT64 constantBufferSize = sizeof(SceneConstantBuffer) * FrameCount;
-
-        const CD3DX12_HEAP_PROPERTIES constantBufferHeapProps(D3D12_HEAP_TYPE_UPLOAD);
-        const CD3DX12_RESOURCE_DESC constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(constantBufferSize);
-
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &constantBufferHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &constantBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_constantBuffer)));
-
-        // Describe and create a constant buffer view.
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-        cbvDesc.BufferLocation = m_constantBuffer->GetGPUVirtualAddress();
-        cbvDesc.SizeInBytes = constantBufferSize;
-
-        // Map and initialize the constant buffer. We don't unmap this until the
-        // app closes. Keeping things mapped for the lifetime of the resource is okay.
-        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-        ThrowIfFailed(m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_cbvDataBegin)));
-    }
+    // Create the upload ring, which also holds the constant buffer of each frame in flight.
+    ThrowIfFailed(m_uploadRing.Create(m_device.Get(), UploadRingSize));
+    ThrowIfFailed(m_geometryHeap.Create(m_device.Get(), GeometryPageSize));
 }
 
 // Load the sample assets.
@@ -252,6 +247,9 @@ void DX12Practice::LoadAssets()
         // Pull root signature from the precompiled mesh shader.
         ThrowIfFailed(m_device->CreateRootSignature(0, meshShader.data, meshShader.size, IID_PPV_ARGS(&m_rootSignature)));
 
+        // Draw packets set MeshInfo's root constants, then dispatch.
+        ThrowIfFailed(CreateDrawPacketSignature(m_device.Get(), m_rootSignature.Get(), 1, &m_drawPacketSignature));
+
         //ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
 
         D3DX12_MESH_SHADER_PIPELINE_STATE_DESC psoDesc = {};
@@ -283,27 +281,15 @@ void DX12Practice::LoadAssets()
     // to record yet. The main loop expects it to be closed, so close it now.
     ThrowIfFailed(m_commandList->Close());
 
-    m_model.LoadFromFile(c_meshFilename);
-    m_model.UploadGpuResources(m_device.Get(), m_commandQueue.Get(), m_commandAllocator[m_frameIndex].Get(), m_commandList.Get());
-
-
-#if defined(_DEBUG)
-        // Mesh shader file expects a certain vertex layout; assert our mesh conforms to that layout.
-        const D3D12_INPUT_ELEMENT_DESC c_elementDescs[2] =
-        {
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-            { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-        };
-
-        for (auto& mesh : m_model)
-        {
-            assert(mesh.LayoutDesc.NumElements == 2);
-
-            for (uint32_t i = 0; i < _countof(c_elementDescs); ++i)
-                assert(std::memcmp(&mesh.LayoutElems[i], &c_elementDescs[i], sizeof(D3D12_INPUT_ELEMENT_DESC)) == 0);
-        }
+    for (UINT c = 0; c < c_maxRecordingChunks; c++)
+    {
+        ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_chunkAllocators[m_frameIndex][c].Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_chunkLists[c])));
+        ThrowIfFailed(m_chunkLists[c]->Close());
+    }
 
-#endif
+    // Parse the model in the background, with the SoA cull data CullMeshlets reads; meshes are
+    // uploaded and drawn as they become ready.
+    m_modelLoad = m_model.LoadFromFileAsync(c_meshFilename, ModelLoadMode::MemoryMapped, nullptr, ModelLoadFlags_CullDataSoA);
 
         // Create synchronization objects and wait until assets have been uploaded to the GPU.
         {
@@ -330,11 +316,26 @@ void DX12Practice::OnUpdate()
 {
     m_timer.Tick(NULL);
 
+    // The GPU has finished with this frame's previous use (MoveToNextFrame waited on its fence).
+    m_frameArenas[m_frameIndex].Reset();
+
+    const uint64_t allocationCount = HeapCounter::GetAllocationCount();
+    m_frameAllocations = allocationCount - m_lastAllocationCount;
+    m_lastAllocationCount = allocationCount;
+
     if (m_frameCounter++ % 30 == 0)
     {
-        // Update window text with FPS value.
+        // Update window text with FPS value and, in builds that count them, the heap allocations of
+        // the last frame, which should be zero once the model has loaded and the culling buffers have grown.
         wchar_t fps[64];
-        swprintf_s(fps, L"%ufps", m_timer.GetFramesPerSecond());
+        if (HeapCounter::c_enabled)
+        {
+            swprintf_s(fps, L"%ufps, %llu allocs/frame", m_timer.GetFramesPerSecond(), m_frameAllocations);
+        }
+        else
+        {
+            swprintf_s(fps, L"%ufps", m_timer.GetFramesPerSecond());
+        }
         SetCustomWindowText(fps);
     }
 
@@ -349,18 +350,20 @@ void DX12Practice::OnUpdate()
     XMStoreFloat4x4(&m_constantBufferData.WorldViewProj, XMMatrixTranspose(world * view * proj));
     m_constantBufferData.DrawMeshlets = true;
 
-    memcpy(m_cbvDataBegin + sizeof(SceneConstantBuffer) * m_frameIndex, &m_constantBufferData, sizeof(m_constantBufferData));
+    if (m_cpuCulling)
+    {
+        CullScene(world, view, proj);
+    }
 }
 
 // Render the scene.
 void DX12Practice::OnRender()
 {
-    // Record all the commands we need to render the scene into the command list.
+    // Record the frame setup, then the meshes in chunks across the thread pool; the lists are
+    // executed in order with one call.
     PopulateCommandList();
-
-    // Execute the command list.
-    ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-    m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    ThrowIfFailed(RecordInChunks(*this, m_meshletRanges.RecordCosts, m_uploadedMeshCount, c_minRecordingChunkCost, ThreadPool::GetDefault()));
+    ThrowIfFailed(m_uploadRing.Submit(m_commandQueue.Get()));
 
     // Present the frame.
     ThrowIfFailed(m_swapChain->Present(1, 0));
@@ -379,6 +382,21 @@ void DX12Practice::OnDestroy()
 
 void DX12Practice::OnKeyDown(UINT8 key)
 {
+    if (key == 'O')
+    {
+        m_cpuCulling = !m_cpuCulling;
+    }
+    else if (key == 'T')
+    {
+        // The history is stale by the time temporal culling is switched back on.
+        m_temporalCulling = !m_temporalCulling;
+        m_temporalCuller.Reset();
+    }
+    else if (key == 'G')
+    {
+        m_packedGeometry = !m_packedGeometry;
+    }
+
     m_camera.OnKeyDown(key);
 }
 
@@ -387,18 +405,188 @@ void DX12Practice::OnKeyUp(UINT8 key)
     m_camera.OnKeyUp(key);
 }
 
+// Upload any meshes the loader thread has published since the last frame.
+void DX12Practice::UploadReadyMeshes()
+{
+    const uint32_t readyCount = m_model.GetReadyMeshCount();
+
+    if (readyCount == m_uploadedMeshCount)
+    {
+        // Surface a failed load once the loader has nothing left to publish.
+        if (m_modelLoad.valid() && m_modelLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            ThrowIfFailed(m_modelLoad.get());
+        }
+
+        return;
+    }
+
+    // The allocator for this frame is idle (MoveToNextFrame waited on it), so the upload can borrow
+    // it. Every newly ready mesh goes out in one submission, which isn't waited for: it runs ahead of
+    // this frame's command list on the same queue, and this frame's fence covers it.
+    D3D12UploadQueue uploadQueue(m_commandQueue.Get(), m_commandAllocator[m_frameIndex].Get(), m_commandList.Get(), m_uploadRing);
+    UploadBatch uploadBatch(uploadQueue);
+
+    ThrowIfFailed(m_model.UploadGpuResources(m_geometryHeap, uploadBatch, m_uploadedMeshCount, readyCount - m_uploadedMeshCount));
+
+    UploadToken uploadToken;
+    ThrowIfFailed(uploadBatch.Submit(uploadToken));
+
+    for (uint32_t m = m_uploadedMeshCount; m < readyCount; ++m)
+    {
+        m_uploadedMeshes.push_back(&m_model.GetMesh(m));
+        m_unpackedTable.push_back(GetUnpackedOffsets(m_model.GetMesh(m)));
+    }
+
+#if defined(_DEBUG)
+    // Mesh shader file expects a certain vertex layout; assert our mesh conforms to that layout.
+    const D3D12_INPUT_ELEMENT_DESC c_elementDescs[2] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+    };
+
+    for (uint32_t m = m_uploadedMeshCount; m < readyCount; ++m)
+    {
+        auto& mesh = m_model.GetMesh(m);
+        assert(mesh.LayoutDesc.NumElements == 2);
+
+        for (uint32_t i = 0; i < _countof(c_elementDescs); ++i)
+            assert(std::memcmp(&mesh.LayoutElems[i], &c_elementDescs[i], sizeof(D3D12_INPUT_ELEMENT_DESC)) == 0);
+    }
+#endif
+
+    m_uploadedMeshCount = readyCount;
+}
+
+// Fills m_visibleMeshlets for the uploaded meshes: frustum and cone culling, then occlusion culling
+// against the meshes' occluders drawn into m_occlusionCuller, or against the temporal culler's.
+void DX12Practice::CullScene(FXMMATRIX world, CXMMATRIX view, CXMMATRIX proj)
+{
+    const XMMATRIX viewProj = view * proj;
+
+    MeshletCullParams params;
+    XMStoreFloat4x4(&params.World, world);
+    params.Scale = 1.0f;
+    ComputeFrustumPlanes(viewProj, params.Planes);
+    XMStoreFloat3(&params.ViewPosition, XMMatrixInverse(nullptr, view).r[3]);
+
+    m_visibleMeshlets.resize(m_uploadedMeshCount);
+
+    if (m_temporalCulling)
+    {
+        CullSceneTemporal(viewProj, params);
+        return;
+    }
+
+    // Simplifying a large mesh takes a while, so occluders are only built once culling is enabled.
+    while (m_occluders.size() < m_uploadedMeshCount)
+    {
+        m_occluders.emplace_back();
+        ThrowIfFailed(BuildOccluderMesh(m_model.GetMesh(static_cast<uint32_t>(m_occluders.size() - 1)), c_occluderTriangleCount, m_occluders.back()));
+    }
+
+    m_occlusionCuller.Clear(viewProj);
+    for (uint32_t m = 0; m < m_uploadedMeshCount; ++m)
+    {
+        m_occlusionCuller.RenderOccluder(m_occluders[m], world);
+    }
+
+    for (uint32_t m = 0; m < m_uploadedMeshCount; ++m)
+    {
+        auto& mesh = m_model.GetMesh(m);
+        auto& visible = m_visibleMeshlets[m];
+
+        if (!m_occlusionCuller.IsMeshVisible(mesh, params))
+        {
+            visible.Indices.clear();
+            visible.Subsets.assign(mesh.MeshletSubsets.size(), Subset());
+            continue;
+        }
+
+        ThrowIfFailed(CullMeshlets(mesh, params, visible));
+        ThrowIfFailed(m_occlusionCuller.CullOccludedMeshlets(mesh, params, visible));
+    }
+}
+
+// Culls with the temporal culler, each mesh an instance of its own. Both phases run here, so each
+// mesh draws what phase one kept followed by what phase two revealed.
+void DX12Practice::CullSceneTemporal(FXMMATRIX viewProj, const MeshletCullParams& params)
+{
+    m_previousMeshlets.resize(m_uploadedMeshCount);
+    m_revealedMeshlets.resize(m_uploadedMeshCount);
+
+    m_temporalCuller.BeginFrame(viewProj);
+    for (uint32_t m = 0; m < m_uploadedMeshCount; ++m)
+    {
+        ThrowIfFailed(m_temporalCuller.CullPhaseOne(m, m_model.GetMesh(m), params, m_previousMeshlets[m]));
+    }
+
+    for (uint32_t m = 0; m < m_uploadedMeshCount; ++m)
+    {
+        ThrowIfFailed(m_temporalCuller.CullPhaseTwo(m, m_model.GetMesh(m), params, m_revealedMeshlets[m]));
+        MergeVisibleMeshlets(m_previousMeshlets[m], m_revealedMeshlets[m], m_visibleMeshlets[m]);
+    }
+}
+
+// Lay every uploaded mesh out in the shared scene buffers, and stage their data there. The meshes'
+// own buffers stay, so the layout can be toggled back.
+void DX12Practice::BuildSceneGeometry()
+{
+    for (uint32_t m = 0; m < m_uploadedMeshCount; ++m)
+    {
+        uint32_t meshIndex;
+        ThrowIfFailed(AddSceneMesh(m_sceneGeometry, m_model.GetMesh(m), meshIndex));
+    }
+
+    for (uint32_t s = 0; s < SceneStream::Count; ++s)
+    {
+        ThrowIfFailed(m_geometryHeap.Allocate(m_sceneGeometry.GetStreamSize(static_cast<SceneStream::EType>(s)), GeometryAllocator::MinAlignment, m_sceneBuffers[s]));
+    }
+
+    // The allocator is idle and reset, as for UploadReadyMeshes; this frame's command list runs after.
+    D3D12UploadQueue uploadQueue(m_commandQueue.Get(), m_commandAllocator[m_frameIndex].Get(), m_commandList.Get(), m_uploadRing);
+    UploadBatch uploadBatch(uploadQueue);
+
+    for (auto& copy : m_sceneGeometry.GetCopies())
+    {
+        const GeometryAllocation& buffer = m_sceneBuffers[copy.Stream];
+        ThrowIfFailed(uploadBatch.Stage(buffer.Resource, buffer.Offset + copy.DestOffset, copy.Data, copy.Size, D3D12_RESOURCE_STATE_COMMON));
+    }
+
+    UploadToken uploadToken;
+    ThrowIfFailed(uploadBatch.Submit(uploadToken));
+}
+
 void DX12Practice::PopulateCommandList()
 {
     // Command list allocators can only be reset when the associated 
     // command lists have finished execution on the GPU; apps should use 
-    // fences to determine GPU execution progress.
+    // fences to determine GPU execution progress. Mesh uploads record
+    // into this allocator too, so it is reset before them.
     ThrowIfFailed(m_commandAllocator[m_frameIndex]->Reset());
 
+    UploadReadyMeshes();
+
+    if (m_packedGeometry && m_sceneGeometry.GetMeshCount() == 0 && !m_model.IsLoading() && m_uploadedMeshCount == m_model.GetMeshCount())
+    {
+        BuildSceneGeometry();
+    }
+
+    // The culled subsets are split into runs on the pool; recording stays on this thread.
+    LinearArena& arena = m_frameArenas[m_frameIndex];
+    if (m_cpuCulling)
+    {
+        const uint32_t culledMeshCount = min(m_uploadedMeshCount, static_cast<uint32_t>(m_visibleMeshlets.size()));
+        BuildDispatchRuns(m_visibleMeshlets.data(), culledMeshCount, arena, ThreadPool::GetDefault(), m_dispatchRuns);
+    }
+
+    GatherMeshletRanges(m_uploadedMeshes.data(), m_uploadedMeshCount, m_cpuCulling ? &m_dispatchRuns : nullptr, arena, m_meshletRanges);
+
     // However, when ExecuteCommandList() is called on a particular command 
     // list, that command list can then be reset at any time and must be before 
     // re-recording.
-    ThrowIfFailed(m_commandList->Reset(m_commandAllocator[m_frameIndex].Get(), m_depthOnlyPipelineState.Get()));
-    //ThrowIfFailed(m_commandList->Reset(m_commandAllocator.Get(), m_pipelineState.Get()));
+    ThrowIfFailed(m_commandList->Reset(m_commandAllocator[m_frameIndex].Get(), m_pipelineState.Get()));
 
     
 
@@ -420,29 +608,164 @@ void DX12Practice::PopulateCommandList()
     m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
     m_commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
-    m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress() + sizeof(SceneConstantBuffer) * m_frameIndex);
+    // Stage the constants after the uploads have been submitted, so their range is retired with this
+    // frame's command lists rather than with the copies (see OnRender).
+    UploadAllocation constants;
+    ThrowIfFailed(m_uploadRing.Allocate(sizeof(SceneConstantBuffer), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, constants));
+    memcpy(constants.CpuAddress, &m_constantBufferData, sizeof(m_constantBufferData));
+    m_frameConstants = constants.GpuAddress;
+
+    // The mesh table goes through the ring like the constants; it is a few bytes per mesh.
+    m_framePacked = m_packedGeometry && m_sceneGeometry.GetMeshCount() == m_uploadedMeshCount;
+    const auto& meshTable = m_framePacked ? m_sceneGeometry.GetTable() : m_unpackedTable;
+    m_frameMeshTable = 0;
 
-    for (auto& mesh : m_model)
+    if (!meshTable.empty())
     {
-        m_commandList->SetGraphicsRoot32BitConstant(1, mesh.IndexSize, 0);
-        m_commandList->SetGraphicsRootShaderResourceView(2, mesh.VertexResources[0]->GetGPUVirtualAddress());
-        m_commandList->SetGraphicsRootShaderResourceView(3, mesh.MeshletResource->GetGPUVirtualAddress());
-        m_commandList->SetGraphicsRootShaderResourceView(4, mesh.UniqueVertexIndexResource->GetGPUVirtualAddress());
-        m_commandList->SetGraphicsRootShaderResourceView(5, mesh.PrimitiveIndexResource->GetGPUVirtualAddress());
+        UploadAllocation meshTableData;
+        ThrowIfFailed(m_uploadRing.Allocate(meshTable.size() * sizeof(MeshGeometryOffsets), D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT, meshTableData));
+        memcpy(meshTableData.CpuAddress, meshTable.data(), meshTable.size() * sizeof(MeshGeometryOffsets));
+        m_frameMeshTable = meshTableData.GpuAddress;
+    }
+
+    // The meshes themselves are recorded in chunks after this (see OnRender).
+    ThrowIfFailed(m_commandList->Close());
+}
+
+// The state every chunk's command list starts from; command lists inherit none of it.
+void DX12Practice::SetChunkState(ID3D12GraphicsCommandList6* commandList)
+{
+    commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+    commandList->RSSetViewports(1, &m_viewport);
+    commandList->RSSetScissorRects(1, &m_scissorRect);
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
+    commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+
+    commandList->SetGraphicsRootConstantBufferView(0, m_frameConstants);
+    if (m_frameMeshTable != 0)
+    {
+        commandList->SetGraphicsRootShaderResourceView(6, m_frameMeshTable);
+    }
 
-        for (auto& subset : mesh.MeshletSubsets)
+    if (m_framePacked)
+    {
+        for (uint32_t s = 0; s < SceneStream::Count; ++s)
         {
-            m_commandList->SetGraphicsRoot32BitConstant(1, subset.Offset, 1);
-            m_commandList->DispatchMesh(subset.Count, 1, 1);
+            commandList->SetGraphicsRootShaderResourceView(2 + s, m_sceneBuffers[s].GpuAddress);
         }
     }
+}
 
-    // Indicate that the back buffer will now be used to present.
-    const auto toPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-    m_commandList->ResourceBarrier(1, &toPresentBarrier);
+uint32_t DX12Practice::GetMaxChunkCount()
+{
+    // The pool's workers plus the recording thread, which takes part in ParallelFor; RecordInChunks
+    // caps it at c_maxRecordingChunks, which every per-chunk array here is sized by.
+    return ThreadPool::GetDefault().GetThreadCount() + 1;
+}
 
-    ThrowIfFailed(m_commandList->Close());
+// Lay out every chunk's draw packets in one ring allocation, so the pool threads never touch the ring.
+HRESULT DX12Practice::BeginChunks(const RecordingChunk* chunks, uint32_t chunkCount)
+{
+    uint32_t packetCount = 0;
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        const uint32_t first = m_meshletRanges.RangeBases[chunks[c].FirstItem];
+        const uint32_t end = m_meshletRanges.RangeBases[chunks[c].FirstItem + chunks[c].ItemCount];
+
+        m_chunkPacketBases[c] = packetCount;
+        packetCount += GetMaxDrawPacketCount(m_meshletRanges.Ranges + first, end - first);
+    }
+
+    m_recordingChunkCount = chunkCount;
+    m_packetData = UploadAllocation();
+    if (packetCount == 0)
+    {
+        return S_OK;
+    }
+
+    return m_uploadRing.Allocate(packetCount * sizeof(DrawPacket), sizeof(uint32_t), m_packetData);
+}
+
+// Draw only the meshes which have finished uploading; the rest of the model streams in over later
+// frames. Their ranges become draw packets written straight into the ring, and each packet is one
+// dispatch of consecutive meshlets; debug colours therefore restart with each packet.
+HRESULT DX12Practice::RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk)
+{
+    ID3D12CommandAllocator* allocator = m_chunkAllocators[m_frameIndex][chunkIndex].Get();
+    ID3D12GraphicsCommandList6* commandList = m_chunkLists[chunkIndex].Get();
+
+    HRESULT hr = allocator->Reset();
+    if (SUCCEEDED(hr))
+    {
+        hr = commandList->Reset(allocator, m_pipelineState.Get());
+    }
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    SetChunkState(commandList);
+
+    const uint32_t firstRange = m_meshletRanges.RangeBases[chunk.FirstItem];
+    const uint32_t endRange = m_meshletRanges.RangeBases[chunk.FirstItem + chunk.ItemCount];
+    DrawPacket* packets = reinterpret_cast<DrawPacket*>(m_packetData.CpuAddress) + m_chunkPacketBases[chunkIndex];
+    const uint64_t packetOffset = m_packetData.Offset + m_chunkPacketBases[chunkIndex] * sizeof(DrawPacket);
+
+    if (endRange > firstRange)
+    {
+        if (m_framePacked)
+        {
+            // Every mesh reads the same buffers: the whole chunk is one call.
+            const uint32_t packetCount = BuildDrawPackets(m_meshletRanges.Ranges + firstRange, endRange - firstRange, packets);
+            commandList->ExecuteIndirect(m_drawPacketSignature.Get(), packetCount, m_packetData.Resource, packetOffset, nullptr, 0);
+        }
+        else
+        {
+            uint32_t packetCount = 0;
+            for (uint32_t m = chunk.FirstItem; m < chunk.FirstItem + chunk.ItemCount; ++m)
+            {
+                const uint32_t first = m_meshletRanges.RangeBases[m];
+                const uint32_t meshPacketCount = BuildDrawPackets(m_meshletRanges.Ranges + first, m_meshletRanges.RangeBases[m + 1] - first, packets + packetCount);
+                if (meshPacketCount == 0)
+                {
+                    continue;
+                }
+
+                auto& mesh = m_model.GetMesh(m);
+                commandList->SetGraphicsRootShaderResourceView(2, mesh.VertexBuffers[0].GpuAddress);
+                commandList->SetGraphicsRootShaderResourceView(3, mesh.MeshletBuffer.GpuAddress);
+                commandList->SetGraphicsRootShaderResourceView(4, mesh.UniqueVertexIndexBuffer.GpuAddress);
+                commandList->SetGraphicsRootShaderResourceView(5, mesh.PrimitiveIndexBuffer.GpuAddress);
+
+                commandList->ExecuteIndirect(m_drawPacketSignature.Get(), meshPacketCount, m_packetData.Resource, packetOffset + packetCount * sizeof(DrawPacket), nullptr, 0);
+                packetCount += meshPacketCount;
+            }
+        }
+    }
+
+    // Indicate that the back buffer will now be used to present, once the last chunk has drawn.
+    if (chunkIndex + 1 == m_recordingChunkCount)
+    {
+        const auto toPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+        commandList->ResourceBarrier(1, &toPresentBarrier);
+    }
+
+    return commandList->Close();
+}
+
+// The frame setup, then the chunks in order, in one submission.
+HRESULT DX12Practice::SubmitChunks(uint32_t chunkCount)
+{
+    ID3D12CommandList* ppCommandLists[1 + c_maxRecordingChunks] = { m_commandList.Get() };
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        ppCommandLists[1 + c] = m_chunkLists[c].Get();
+    }
 
+    m_commandQueue->ExecuteCommandLists(1 + chunkCount, ppCommandLists);
+    return S_OK;
 }
 
 void DX12Practice::MoveToNextFrame()
@@ -2,14 +2,23 @@
 
 #include "DXBaise.h"
 #include <Model.h>
+#include "DispatchRuns.h"
+#include "DrawPacketSignature.h"
+#include "GeometryHeap.h"
+#include "LinearArena.h"
+#include "OcclusionCuller.h"
+#include "TemporalOcclusionCuller.h"
+#include "ParallelRecording.h"
+#include "SceneGeometry.h"
 #include "SimpleCamera.h"
 #include "StepTimer.h"
+#include "UploadBatch.h"
 
 
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
-class DX12Practice:public DXBaise
+class DX12Practice:public DXBaise, private ChunkRecordingTarget
 {
 public:
     DX12Practice(UINT width, UINT height, std::wstring name);
@@ -86,13 +95,19 @@ private:
     ComPtr<ID3D12DescriptorHeap> m_srvHeap;
     ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
     ComPtr<ID3D12PipelineState> m_pipelineState;
-    ComPtr<ID3D12PipelineState> m_depthOnlyPipelineState;
+    ComPtr<ID3D12CommandSignature> m_drawPacketSignature;
 
     ComPtr<ID3D12GraphicsCommandList6> m_commandList;
     SceneConstantBuffer m_constantBufferData;
-    UINT8* m_cbvDataBegin;
 
-    ComPtr<ID3D12Resource> m_constantBuffer;
+    // Staging for mesh uploads and each frame's scene constants.
+    static const UINT64 UploadRingSize = 32 * 1024 * 1024;
+    UploadRing m_uploadRing;
+
+    // Every mesh buffer, sub-allocated from a few large pages.
+    static const UINT64 GeometryPageSize = 16 * 1024 * 1024;
+    GeometryHeap m_geometryHeap;
+
     UINT m_rtvDescriptorSize;
     bool DepthBoundsTestSupported;
 
@@ -113,14 +128,67 @@ private:
     ComPtr<ID3D12Fence> m_fence;
     UINT64 m_fenceValues[FrameCount];
 
+    // Transient CPU data of each frame in flight, reset when the frame comes round again.
+    LinearArena m_frameArenas[FrameCount];
+    uint64_t m_lastAllocationCount;     // Heap allocations counted at the start of the last frame
+    uint64_t m_frameAllocations;        // Heap allocations during the last whole frame
+
     StepTimer m_timer;
     SimpleCamera m_camera;
     Model m_model;
+    ModelLoadHandle m_modelLoad;
+    uint32_t m_uploadedMeshCount;
+
+    // Optional CPU culling ahead of the meshlet dispatches, toggled with the O key: frustum and
+    // normal cone tests, then occlusion against simplified copies of the meshes.
+    bool m_cpuCulling;
+    OcclusionCuller m_occlusionCuller;
+    std::vector<OccluderMesh> m_occluders;              // Built on first use, one per uploaded mesh
+    std::vector<VisibleMeshlets> m_visibleMeshlets;     // One per uploaded mesh
+
+    // With CPU culling on, the T key switches occlusion to the two-phase temporal culler: last
+    // frame's visible meshlets are kept and the nearest of them become the occluders.
+    bool m_temporalCulling;
+    TemporalOcclusionCuller m_temporalCuller;
+    std::vector<VisibleMeshlets> m_previousMeshlets;    // Scratch: phase one's output, one per uploaded mesh
+    std::vector<VisibleMeshlets> m_revealedMeshlets;    // Scratch: phase two's output, one per uploaded mesh
+
+    // Built in the frame's arena each frame (see DispatchRuns.h): the culled meshes' runs of visible
+    // meshlets, then the ranges every uploaded mesh draws, turned into draw packets when recorded.
+    std::vector<const Mesh*> m_uploadedMeshes;
+    DispatchRuns m_dispatchRuns;
+    FrameMeshletRanges m_meshletRanges;
+
+    // Optional packed geometry, toggled with the G key: every mesh's streams concatenated into one
+    // buffer each, bound once per frame, so meshes only differ in their index into the mesh table.
+    // Built once the whole model has been uploaded.
+    bool m_packedGeometry;
+    SceneGeometryLayout m_sceneGeometry;
+    GeometryAllocation m_sceneBuffers[SceneStream::Count];
+    std::vector<MeshGeometryOffsets> m_unpackedTable;   // One per uploaded mesh, for its own buffers
+
+    // The meshes are recorded in chunks on the thread pool (see ParallelRecording.h), each into its
+    // own command list with an allocator per frame in flight, after m_commandList's frame setup.
+    ComPtr<ID3D12CommandAllocator> m_chunkAllocators[FrameCount][c_maxRecordingChunks];
+    ComPtr<ID3D12GraphicsCommandList6> m_chunkLists[c_maxRecordingChunks];
+    uint32_t m_recordingChunkCount;
+    uint32_t m_chunkPacketBases[c_maxRecordingChunks];  // First draw packet of each chunk in m_packetData
+
+    // What PopulateCommandList set up for the chunks to share this frame.
+    D3D12_GPU_VIRTUAL_ADDRESS m_frameConstants;
+    D3D12_GPU_VIRTUAL_ADDRESS m_frameMeshTable;
+    bool m_framePacked;
+    UploadAllocation m_packetData;
 
 
     void LoadPipeline();
     void LoadAssets();
+    void UploadReadyMeshes();
+    void CullScene(FXMMATRIX world, CXMMATRIX view, CXMMATRIX proj);
+    void CullSceneTemporal(FXMMATRIX viewProj, const MeshletCullParams& params);
+    void BuildSceneGeometry();
     void PopulateCommandList();
+    void SetChunkState(ID3D12GraphicsCommandList6* commandList);
     void MoveToNextFrame();
     void WaitForGpu();
 
@@ -128,6 +196,14 @@ private:
     static const wchar_t* c_meshFilename;
     static const wchar_t* c_meshShaderFilename;
     static const wchar_t* c_pixelShaderFilename;
+    static const uint32_t c_occluderTriangleCount = 256;
+    static const uint64_t c_minRecordingChunkCost = 64;
+
+    // ChunkRecordingTarget
+    uint32_t GetMaxChunkCount() override;
+    HRESULT BeginChunks(const RecordingChunk* chunks, uint32_t chunkCount) override;
+    HRESULT RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk) override;
+    HRESULT SubmitChunks(uint32_t chunkCount) override;
     
 };
 
@@ -12,6 +12,7 @@
 #pragma once
 #include <stdexcept>
 #include "stdafx.h"
+#include "Alignment.h"
 
 
 // Note that while ComPtr is used to manage the lifetime of resources on the CPU,
@@ -0,0 +1,130 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "DispatchRuns.h"
+
+#include <algorithm>
+
+void BuildDispatchRuns(const VisibleMeshlets* visible, uint32_t meshCount, LinearArena& arena, ThreadPool& pool, DispatchRuns& runs)
+{
+    uint32_t subsetCount = 0;
+    uint32_t indexCount = 0;
+    for (uint32_t m = 0; m < meshCount; ++m)
+    {
+        subsetCount += static_cast<uint32_t>(visible[m].Subsets.size());
+        indexCount += static_cast<uint32_t>(visible[m].Indices.size());
+    }
+
+    runs.MeshCount = meshCount;
+    runs.RunBases = arena.Allocate<uint32_t>(meshCount + 1);
+    runs.RunStarts = arena.Allocate<uint32_t>(subsetCount);
+    runs.RunCounts = arena.Allocate<uint32_t>(subsetCount);
+    runs.Runs = arena.Allocate<Subset>(indexCount);
+
+    uint32_t culledSubset = 0;
+    uint32_t indexBase = 0;
+    for (uint32_t m = 0; m < meshCount; ++m)
+    {
+        runs.RunBases[m] = culledSubset;
+        for (auto& subset : visible[m].Subsets)
+        {
+            runs.RunStarts[culledSubset++] = indexBase + subset.Offset;
+        }
+        indexBase += static_cast<uint32_t>(visible[m].Indices.size());
+    }
+    runs.RunBases[meshCount] = culledSubset;
+
+    const DispatchRuns out = runs;
+    pool.ParallelFor(subsetCount, [&out, visible, meshCount](uint32_t r)
+    {
+        const uint32_t m = static_cast<uint32_t>(std::upper_bound(out.RunBases, out.RunBases + meshCount + 1, r) - out.RunBases) - 1;
+        const VisibleMeshlets& mesh = visible[m];
+        const Subset& subset = mesh.Subsets[r - out.RunBases[m]];
+
+        Subset* subsetRuns = out.Runs + out.RunStarts[r];
+        uint32_t runCount = 0;
+
+        for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; )
+        {
+            uint32_t end = i + 1;
+            while (end < subset.Offset + subset.Count && mesh.Indices[end] == mesh.Indices[end - 1] + 1)
+            {
+                ++end;
+            }
+
+            subsetRuns[runCount].Offset = mesh.Indices[i];
+            subsetRuns[runCount].Count = end - i;
+            runCount++;
+            i = end;
+        }
+
+        out.RunCounts[r] = runCount;
+    });
+}
+
+void GatherMeshletRanges(const Mesh* const* meshes, uint32_t meshCount, const DispatchRuns* runs, LinearArena& arena, FrameMeshletRanges& ranges)
+{
+    const uint32_t culledMeshCount = runs ? min(runs->MeshCount, meshCount) : 0;
+
+    ranges.RangeBases = arena.Allocate<uint32_t>(meshCount + 1);
+    ranges.RecordCosts = arena.Allocate<uint32_t>(meshCount);
+
+    uint32_t rangeCount = 0;
+    for (uint32_t m = 0; m < meshCount; ++m)
+    {
+        ranges.RangeBases[m] = rangeCount;
+
+        if (m < culledMeshCount)
+        {
+            for (uint32_t r = runs->RunBases[m]; r < runs->RunBases[m + 1]; ++r)
+            {
+                rangeCount += runs->RunCounts[r];
+            }
+        }
+        else
+        {
+            rangeCount += static_cast<uint32_t>(meshes[m]->MeshletSubsets.size());
+        }
+    }
+    ranges.RangeBases[meshCount] = rangeCount;
+
+    // A mesh costs its root parameter changes plus the packets its ranges may become.
+    for (uint32_t m = 0; m < meshCount; ++m)
+    {
+        ranges.RecordCosts[m] = 1 + ranges.RangeBases[m + 1] - ranges.RangeBases[m];
+    }
+
+    ranges.Ranges = arena.Allocate<MeshletRange>(rangeCount);
+
+    for (uint32_t m = 0; m < meshCount; ++m)
+    {
+        MeshletRange* meshRanges = ranges.Ranges + ranges.RangeBases[m];
+
+        if (m < culledMeshCount)
+        {
+            for (uint32_t r = runs->RunBases[m]; r < runs->RunBases[m + 1]; ++r)
+            {
+                const Subset* subsetRuns = runs->Runs + runs->RunStarts[r];
+                for (uint32_t i = 0; i < runs->RunCounts[r]; ++i)
+                {
+                    *meshRanges++ = MeshletRange{ m, subsetRuns[i].Offset, subsetRuns[i].Count };
+                }
+            }
+        }
+        else
+        {
+            for (auto& subset : meshes[m]->MeshletSubsets)
+            {
+                *meshRanges++ = MeshletRange{ m, subset.Offset, subset.Count };
+            }
+        }
+    }
+}
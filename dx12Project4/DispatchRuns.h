@@ -0,0 +1,49 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "DrawPackets.h"
+#include "LinearArena.h"
+#include "MeshletCuller.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+
+// The culled meshes' visible meshlets as runs of consecutive meshlets, one dispatch each, laid out
+// in a frame arena. Culled subset r of the meshes has RunCounts[r] runs, starting at
+// Runs + RunStarts[r]; mesh m's culled subsets are [RunBases[m], RunBases[m + 1]).
+struct DispatchRuns
+{
+    uint32_t MeshCount;
+    uint32_t* RunBases;
+    uint32_t* RunStarts;
+    uint32_t* RunCounts;
+    Subset* Runs;
+};
+
+// What each mesh draws this frame, laid out in a frame arena: mesh m's ranges are
+// [Ranges + RangeBases[m], Ranges + RangeBases[m + 1]), and RecordCosts[m] is what recording them
+// costs, as RecordInChunks weighs it.
+struct FrameMeshletRanges
+{
+    MeshletRange* Ranges;
+    uint32_t* RangeBases;
+    uint32_t* RecordCosts;
+};
+
+// Splits each subset of visible[0, meshCount) into runs of consecutive visible meshlets. A subset has
+// at most as many runs as visible meshlets, so the runs are laid out like the visible indices. The
+// subsets are split in parallel on the pool.
+void BuildDispatchRuns(const VisibleMeshlets* visible, uint32_t meshCount, LinearArena& arena, ThreadPool& pool, DispatchRuns& runs);
+
+// Collects the ranges of meshes[0, meshCount): the culled runs of the first runs->MeshCount meshes,
+// and every meshlet subset of the rest. runs may be null when nothing was culled.
+void GatherMeshletRanges(const Mesh* const* meshes, uint32_t meshCount, const DispatchRuns* runs, LinearArena& arena, FrameMeshletRanges& ranges);
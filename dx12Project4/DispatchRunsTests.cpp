@@ -0,0 +1,245 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "DispatchRuns.h"
+#include "HeapCounter.h"
+#include "ParallelRecording.h"
+#include "Tests.h"
+
+#include <random>
+
+using namespace Tests;
+
+namespace
+{
+    // Meshes with only their meshlet subsets, and what culling left visible of the first ones.
+    struct RunScene
+    {
+        std::vector<std::vector<Subset>> Subsets;
+        std::vector<Mesh>                Meshes;
+        std::vector<const Mesh*>         MeshPointers;
+        std::vector<VisibleMeshlets>     Visible;
+    };
+
+    void MakeRunScene(std::mt19937& rng, uint32_t meshCount, uint32_t culledMeshCount, RunScene& scene)
+    {
+        scene.Subsets.resize(meshCount);
+        scene.Meshes.resize(meshCount);
+        scene.Visible.resize(culledMeshCount);
+
+        for (uint32_t m = 0; m < meshCount; ++m)
+        {
+            uint32_t offset = 0;
+            const uint32_t subsetCount = rng() % 6;
+            for (uint32_t s = 0; s < subsetCount; ++s)
+            {
+                const uint32_t count = rng() % 3 == 0 ? 0 : rng() % 200;
+                scene.Subsets[m].push_back(Subset{ offset, count });
+                offset += count;
+            }
+            scene.Meshes[m].MeshletSubsets = MakeSpan<const Subset>(scene.Subsets[m].data(), subsetCount);
+            scene.MeshPointers.push_back(&scene.Meshes[m]);
+
+            if (m >= culledMeshCount)
+            {
+                continue;
+            }
+
+            // Anything from nothing to everything visible, in runs of every length.
+            const uint32_t visibleChance = rng() % 101;
+            VisibleMeshlets& visible = scene.Visible[m];
+            for (auto& subset : scene.Subsets[m])
+            {
+                const uint32_t first = static_cast<uint32_t>(visible.Indices.size());
+                for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+                {
+                    if (rng() % 100 < visibleChance)
+                    {
+                        visible.Indices.push_back(i);
+                    }
+                }
+                visible.Subsets.push_back(Subset{ first, static_cast<uint32_t>(visible.Indices.size()) - first });
+            }
+        }
+    }
+
+    // Each mesh's ranges name exactly the meshlets it should draw, in order: its visible meshlets
+    // if it was culled, else every subset. A culled subset's runs are as long as they can be.
+    uint32_t CheckRanges(const RunScene& scene, uint32_t culledMeshCount, const FrameMeshletRanges& ranges)
+    {
+        uint32_t errors = 0;
+        for (uint32_t m = 0; m < scene.Meshes.size(); ++m)
+        {
+            std::vector<uint32_t> expected;
+            uint32_t expectedRangeCount = 0;
+
+            if (m < culledMeshCount)
+            {
+                const VisibleMeshlets& visible = scene.Visible[m];
+                for (auto& subset : visible.Subsets)
+                {
+                    for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+                    {
+                        expected.push_back(visible.Indices[i]);
+                        expectedRangeCount += i == subset.Offset || visible.Indices[i] != visible.Indices[i - 1] + 1;
+                    }
+                }
+            }
+            else
+            {
+                for (auto& subset : scene.Subsets[m])
+                {
+                    for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+                    {
+                        expected.push_back(i);
+                    }
+                }
+                expectedRangeCount = static_cast<uint32_t>(scene.Subsets[m].size());
+            }
+
+            std::vector<uint32_t> drawn;
+            bool meshIndicesMatch = true;
+            for (uint32_t r = ranges.RangeBases[m]; r < ranges.RangeBases[m + 1]; ++r)
+            {
+                meshIndicesMatch = meshIndicesMatch && ranges.Ranges[r].MeshIndex == m;
+                for (uint32_t i = 0; i < ranges.Ranges[r].Count; ++i)
+                {
+                    drawn.push_back(ranges.Ranges[r].Offset + i);
+                }
+            }
+
+            const uint32_t rangeCount = ranges.RangeBases[m + 1] - ranges.RangeBases[m];
+            errors += Check(drawn == expected && meshIndicesMatch, "DispatchRuns: mesh %u draws the wrong meshlets\n", m);
+            errors += Check(rangeCount == expectedRangeCount, "DispatchRuns: mesh %u has %u ranges, expected %u\n", m, rangeCount, expectedRangeCount);
+            errors += Check(ranges.RecordCosts[m] == 1 + rangeCount, "DispatchRuns: mesh %u costs %u for %u ranges\n", m, ranges.RecordCosts[m], rangeCount);
+        }
+        return errors;
+    }
+
+    // Records ranges the way DX12Practice::RecordChunk does, with the command lists taken out: every
+    // chunk's packets come from one allocation in the frame's arena, and each chunk builds its own.
+    class PacketRecorder : public ChunkRecordingTarget
+    {
+    public:
+        PacketRecorder(const FrameMeshletRanges& ranges, LinearArena& arena, uint32_t maxChunks) :
+            m_ranges(ranges), m_arena(arena), m_maxChunks(maxChunks), m_packets(nullptr)
+        {
+        }
+
+        uint32_t GetMaxChunkCount() override { return m_maxChunks; }
+
+        HRESULT BeginChunks(const RecordingChunk* chunks, uint32_t chunkCount) override
+        {
+            uint32_t packetCount = 0;
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                const uint32_t first = m_ranges.RangeBases[chunks[c].FirstItem];
+                m_packetBases[c] = packetCount;
+                packetCount += GetMaxDrawPacketCount(m_ranges.Ranges + first, m_ranges.RangeBases[chunks[c].FirstItem + chunks[c].ItemCount] - first);
+            }
+            m_packets = m_arena.Allocate<DrawPacket>(packetCount);
+            return S_OK;
+        }
+
+        HRESULT RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk) override
+        {
+            const uint32_t first = m_ranges.RangeBases[chunk.FirstItem];
+            const uint32_t end = m_ranges.RangeBases[chunk.FirstItem + chunk.ItemCount];
+            BuildDrawPackets(m_ranges.Ranges + first, end - first, m_packets + m_packetBases[chunkIndex]);
+            return S_OK;
+        }
+
+        HRESULT SubmitChunks(uint32_t) override { return S_OK; }
+
+    private:
+        const FrameMeshletRanges& m_ranges;
+        LinearArena& m_arena;
+        uint32_t m_maxChunks;
+        DrawPacket* m_packets;
+        uint32_t m_packetBases[c_maxRecordingChunks] = {};
+    };
+
+    // DX12Practice's frame path over three frame arenas: once the arenas and the pool have grown to
+    // the scene, building the runs, gathering the ranges and recording them in chunks allocate
+    // nothing, on any thread.
+    uint32_t CheckFrameAllocations(const RunScene& scene, uint32_t culledMeshCount)
+    {
+        const uint32_t c_warmUpFrames = 64;
+        const uint32_t c_frameCount = 128;
+        const uint64_t c_minChunkCost = 64;
+
+        ThreadPool pool(3);
+        LinearArena arenas[3];
+        const uint32_t meshCount = static_cast<uint32_t>(scene.Meshes.size());
+
+        uint64_t steadyAllocations = 0;
+        uint32_t errors = 0;
+        for (uint32_t f = 0; f < c_frameCount; ++f)
+        {
+            const uint64_t start = HeapCounter::GetAllocationCount();
+
+            LinearArena& arena = arenas[f % _countof(arenas)];
+            arena.Reset();
+
+            DispatchRuns runs;
+            BuildDispatchRuns(scene.Visible.data(), culledMeshCount, arena, pool, runs);
+
+            FrameMeshletRanges ranges;
+            GatherMeshletRanges(scene.MeshPointers.data(), meshCount, &runs, arena, ranges);
+
+            PacketRecorder recorder(ranges, arena, pool.GetThreadCount() + 1);
+            errors += FAILED(RecordInChunks(recorder, ranges.RecordCosts, meshCount, c_minChunkCost, pool));
+
+            if (f >= c_warmUpFrames)
+            {
+                steadyAllocations += HeapCounter::GetAllocationCount() - start;
+            }
+        }
+
+        errors += Check(steadyAllocations == 0, "DispatchRuns: %u heap allocations in %u frames after warm-up\n",
+            static_cast<uint32_t>(steadyAllocations), c_frameCount - c_warmUpFrames);
+        return errors;
+    }
+}
+
+uint32_t Tests::TestDispatchRuns(const std::wstring&)
+{
+    std::mt19937 rng(19);
+    ThreadPool pool(3);
+
+    uint32_t errors = 0;
+    for (uint32_t n = 0; n < 50; ++n)
+    {
+        const uint32_t meshCount = rng() % 40;
+        const uint32_t culledMeshCount = meshCount > 0 ? rng() % (meshCount + 1) : 0;
+
+        RunScene scene;
+        MakeRunScene(rng, meshCount, culledMeshCount, scene);
+
+        LinearArena arena;
+        DispatchRuns runs;
+        BuildDispatchRuns(scene.Visible.data(), culledMeshCount, arena, pool, runs);
+
+        FrameMeshletRanges ranges;
+        GatherMeshletRanges(scene.MeshPointers.data(), meshCount, &runs, arena, ranges);
+        errors += CheckRanges(scene, culledMeshCount, ranges);
+
+        // Without runs, every mesh draws all of its subsets.
+        GatherMeshletRanges(scene.MeshPointers.data(), meshCount, nullptr, arena, ranges);
+        errors += CheckRanges(scene, 0, ranges);
+    }
+
+    RunScene scene;
+    MakeRunScene(rng, 200, 150, scene);
+    errors += CheckFrameAllocations(scene, 150);
+
+    return errors;
+}
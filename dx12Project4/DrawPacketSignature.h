@@ -0,0 +1,16 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "DrawPackets.h"
+
+// The command signature of DrawPacket; rootParameterIndex is MeshInfo's root constants.
+HRESULT CreateDrawPacketSignature(ID3D12Device* device, ID3D12RootSignature* rootSignature, uint32_t rootParameterIndex, ID3D12CommandSignature** signature);
@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "DrawPackets.h"
+
+#include <algorithm>
+
+uint32_t GetMaxDrawPacketCount(const MeshletRange* ranges, uint32_t rangeCount)
+{
+    uint32_t count = rangeCount;
+    for (uint32_t i = 0; i < rangeCount; ++i)
+    {
+        count += ranges[i].Count > 0 ? (ranges[i].Count - 1) / c_maxDrawPacketGroups : 0;
+    }
+    return count;
+}
+
+uint32_t BuildDrawPackets(const MeshletRange* ranges, uint32_t rangeCount, DrawPacket* packets)
+{
+    // The open packet stays in registers until nothing more can join it.
+    DrawPacket packet = { 0, 0, 0, 1, 1 };
+    uint32_t packetCount = 0;
+
+    for (uint32_t i = 0; i < rangeCount; ++i)
+    {
+        const MeshletRange& range = ranges[i];
+        uint32_t offset = range.Offset;
+        uint32_t count = range.Count;
+
+        while (count > 0)
+        {
+            const bool joins = packet.ThreadGroupCountX > 0 && packet.MeshIndex == range.MeshIndex
+                && packet.MeshletOffset + packet.ThreadGroupCountX == offset && packet.ThreadGroupCountX < c_maxDrawPacketGroups;
+
+            if (!joins)
+            {
+                if (packet.ThreadGroupCountX > 0)
+                {
+                    packets[packetCount++] = packet;
+                }
+                packet.MeshIndex = range.MeshIndex;
+                packet.MeshletOffset = offset;
+                packet.ThreadGroupCountX = 0;
+            }
+
+            const uint32_t taken = std::min(count, c_maxDrawPacketGroups - packet.ThreadGroupCountX);
+            packet.ThreadGroupCountX += taken;
+            offset += taken;
+            count -= taken;
+        }
+    }
+
+    if (packet.ThreadGroupCountX > 0)
+    {
+        packets[packetCount++] = packet;
+    }
+
+    return packetCount;
+}
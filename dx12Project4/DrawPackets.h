@@ -0,0 +1,46 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+// One command of an ExecuteIndirect over MeshletMS: the two root constants of MeshInfo (b1), then the
+// arguments of a DispatchMesh. Matches the command signature CreateDrawPacketSignature, in
+// DrawPacketSignature.h, describes.
+struct DrawPacket
+{
+    uint32_t MeshIndex;
+    uint32_t MeshletOffset;         // Within the mesh
+    uint32_t ThreadGroupCountX;     // Meshlets drawn
+    uint32_t ThreadGroupCountY;
+    uint32_t ThreadGroupCountZ;
+};
+
+// Meshlets [Offset, Offset + Count) of a mesh, such as a meshlet subset or a run of visible meshlets.
+struct MeshletRange
+{
+    uint32_t MeshIndex;
+    uint32_t Offset;
+    uint32_t Count;
+};
+
+// A dispatch may launch at most this many groups along X.
+const uint32_t c_maxDrawPacketGroups = 65535;
+
+// How many packets BuildDrawPackets can write for ranges, at most: one per range, plus one for each
+// further c_maxDrawPacketGroups meshlets of a long range.
+uint32_t GetMaxDrawPacketCount(const MeshletRange* ranges, uint32_t rangeCount);
+
+// Turns ranges into packets, in order, and returns how many were written. Empty ranges are dropped,
+// and a range which continues the previous one in the same mesh joins its packet, so consecutive
+// subsets or runs become one dispatch; ranges longer than a dispatch allows are split. Packets are
+// only written, never read back, so they may go straight to write-combined memory.
+uint32_t BuildDrawPackets(const MeshletRange* ranges, uint32_t rangeCount, DrawPacket* packets);
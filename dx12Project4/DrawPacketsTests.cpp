@@ -0,0 +1,149 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+#include "DrawPackets.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Tests;
+
+namespace
+{
+    // Builds packets for ranges into a buffer of exactly GetMaxDrawPacketCount entries followed by a
+    // guard, and counts everything wrong with them: meshlets dispatched other than those of ranges in
+    // their order, packets outside a dispatch's limits, packets which could have been joined, and
+    // writes past the bound.
+    uint32_t CheckDrawPackets(const std::vector<MeshletRange>& ranges, uint32_t expectedPacketCount = UINT32_MAX)
+    {
+        const uint32_t maxCount = GetMaxDrawPacketCount(ranges.data(), static_cast<uint32_t>(ranges.size()));
+        const DrawPacket guard = { 0xdeadbeef, 0xdeadbeef, 0xdeadbeef, 0xdeadbeef, 0xdeadbeef };
+        std::vector<DrawPacket> packets(maxCount + 1, guard);
+
+        const uint32_t packetCount = BuildDrawPackets(ranges.data(), static_cast<uint32_t>(ranges.size()), packets.data());
+        uint32_t errors = packetCount > maxCount || std::memcmp(&packets[maxCount], &guard, sizeof(guard)) != 0;
+        errors += expectedPacketCount != UINT32_MAX && packetCount != expectedPacketCount;
+        if (errors > 0)
+        {
+            return errors;
+        }
+
+        // Walk the meshlets the ranges name alongside those the packets dispatch.
+        size_t r = 0;
+        uint32_t inRange = 0;
+        for (uint32_t i = 0; i < packetCount; ++i)
+        {
+            const DrawPacket& packet = packets[i];
+            errors += packet.ThreadGroupCountX == 0 || packet.ThreadGroupCountX > c_maxDrawPacketGroups || packet.ThreadGroupCountY != 1 || packet.ThreadGroupCountZ != 1;
+
+            if (i > 0)
+            {
+                const DrawPacket& prev = packets[i - 1];
+                errors += prev.MeshIndex == packet.MeshIndex && prev.MeshletOffset + prev.ThreadGroupCountX == packet.MeshletOffset && prev.ThreadGroupCountX < c_maxDrawPacketGroups;
+            }
+
+            for (uint32_t g = 0; g < packet.ThreadGroupCountX; ++g)
+            {
+                while (r < ranges.size() && inRange == ranges[r].Count)
+                {
+                    r++;
+                    inRange = 0;
+                }
+                if (r == ranges.size())
+                {
+                    return errors + 1;
+                }
+
+                errors += packet.MeshIndex != ranges[r].MeshIndex || packet.MeshletOffset + g != ranges[r].Offset + inRange;
+                inRange++;
+            }
+        }
+
+        while (r < ranges.size() && inRange == ranges[r].Count)
+        {
+            r++;
+            inRange = 0;
+        }
+        return errors + (r != ranges.size());
+    }
+
+    uint32_t CheckEdgeCases()
+    {
+        const uint32_t maxGroups = c_maxDrawPacketGroups;
+
+        struct
+        {
+            const char*               Name;
+            std::vector<MeshletRange> Ranges;
+            uint32_t                  PacketCount;
+        } const cases[] =
+        {
+            { "empty",                  { },                                                 0 },
+            { "empty ranges",           { { 0, 0, 0 }, { 1, 5, 0 } },                        0 },
+            { "consecutive",            { { 0, 0, 10 }, { 0, 10, 5 }, { 0, 15, 1 } },        1 },
+            { "empty between",          { { 0, 0, 10 }, { 0, 3, 0 }, { 0, 10, 5 } },         1 },
+            { "next mesh",              { { 0, 0, 10 }, { 1, 10, 5 } },                      2 },
+            { "gap",                    { { 0, 0, 10 }, { 0, 11, 5 } },                      2 },
+            { "backwards",              { { 0, 10, 5 }, { 0, 0, 10 } },                      2 },
+            { "overlap",                { { 0, 0, 10 }, { 0, 5, 10 } },                      2 },
+            { "long",                   { { 3, 7, 200000 } },                                4 },
+            { "join up to limit",       { { 0, 0, maxGroups - 5 }, { 0, maxGroups - 5, 10 } },           2 },
+            { "join at limit",          { { 0, 0, maxGroups }, { 0, maxGroups, 1 } },                    2 },
+            { "long after join",        { { 0, 0, 5 }, { 0, 5, 2 * maxGroups } },                  3 },
+        };
+
+        uint32_t errors = 0;
+        for (auto& test : cases)
+        {
+            errors += Check(CheckDrawPackets(test.Ranges, test.PacketCount) == 0, "DrawPackets: case '%s' failed\n", test.Name);
+        }
+        return errors;
+    }
+
+    // Random lists mixing meshes, gaps, empty, overlapping and oversized ranges.
+    uint32_t CheckRandomLists()
+    {
+        const uint32_t maxGroups = c_maxDrawPacketGroups;
+        std::mt19937 rng(11);
+        auto below = [&rng](uint32_t bound) { return static_cast<uint32_t>(rng() % bound); };
+
+        uint32_t failedLists = 0;
+        for (uint32_t n = 0; n < 2000; ++n)
+        {
+            std::vector<MeshletRange> ranges(below(64));
+            uint32_t mesh = 0;
+            uint32_t offset = 0;
+            for (auto& range : ranges)
+            {
+                switch (below(8))
+                {
+                case 0: mesh++; break;
+                case 1: offset += below(4); break;
+                case 2: offset -= std::min(offset, below(8)); break;
+                default: break;
+                }
+                const uint32_t kind = below(16);
+                range = MeshletRange{ mesh, offset, kind == 0 ? 0 : kind == 1 ? maxGroups - below(3) : kind == 2 ? below(3 * maxGroups) : 1 + below(64) };
+                offset += range.Count;
+            }
+            failedLists += CheckDrawPackets(ranges) != 0;
+        }
+
+        return Check(failedLists == 0, "DrawPackets: %u of 2000 random lists failed\n", failedLists);
+    }
+}
+
+uint32_t Tests::TestDrawPackets(const std::wstring&)
+{
+    return CheckEdgeCases() + CheckRandomLists();
+}
@@ -12,7 +12,7 @@
 #include "stdafx.h"
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT cityColumnCount) :
+FrameResource::FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT cityColumnCount, const BoundingSphere& cityBounds) :
     m_fenceValue(0),
     m_cityRowCount(cityRowCount),
     m_cityColumnCount(cityColumnCount)
@@ -28,10 +28,12 @@ FrameResource::FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT city
     ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&m_bundleAllocator)));
 
     // Create an upload heap for the constant buffers.
+    const CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    const CD3DX12_RESOURCE_DESC constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(SceneConstantBuffer) * m_cityRowCount * m_cityColumnCount);
     ThrowIfFailed(pDevice->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        &uploadHeapProps,
         D3D12_HEAP_FLAG_NONE,
-        &CD3DX12_RESOURCE_DESC::Buffer(sizeof(SceneConstantBuffer) * m_cityRowCount * m_cityColumnCount),
+        &constantBufferDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
         IID_PPV_ARGS(&m_cbvUploadHeap)));
@@ -46,6 +48,14 @@ FrameResource::FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT city
     // Update all of the model matrices once; our cities don't move so 
     // we don't need to do this ever again.
     SetCityPositions(8.0f, -8.0f);
+    m_cityCuller.SetInstances(m_modelMatrices.data(), static_cast<UINT>(m_modelMatrices.size()), cityBounds);
+
+    // Until the first update, draw lists cover every city, as the bundle does.
+    m_visibleCities.resize(m_modelMatrices.size());
+    for (UINT i = 0; i < m_visibleCities.size(); i++)
+    {
+        m_visibleCities[i] = i;
+    }
 }
 
 FrameResource::~FrameResource()
@@ -104,43 +114,23 @@ void FrameResource::PopulateCommandList(ID3D12GraphicsCommandList* pCommandList,
     UINT frameResourceDescriptorOffset = 1 + (frameResourceIndex * m_cityRowCount * m_cityColumnCount);
     CD3DX12_GPU_DESCRIPTOR_HANDLE cbvSrvHandle(pCbvSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart(), frameResourceDescriptorOffset, cbvSrvDescriptorSize);
 
-    PIXBeginEvent(pCommandList, 0, L"Draw cities");
-    BOOL usePso1 = TRUE;
-    for (UINT i = 0; i < m_cityRowCount; i++)
+    for (UINT city : m_visibleCities)
     {
-        for (UINT j = 0; j < m_cityColumnCount; j++)
-        {
-            // Alternate which PSO to use; the pixel shader is different on 
-            // each just as a PSO setting demonstration.
-            pCommandList->SetPipelineState(usePso1 ? pPso1 : pPso2);
-            usePso1 = !usePso1;
+        // Alternate which PSO to use; the pixel shader is different on 
+        // each just as a PSO setting demonstration.
+        pCommandList->SetPipelineState(city % 2 == 0 ? pPso1 : pPso2);
 
-            // Set this city's CBV table and move to the next descriptor.
-            pCommandList->SetGraphicsRootDescriptorTable(2, cbvSrvHandle);
-            cbvSrvHandle.Offset(cbvSrvDescriptorSize);
+        // Set this city's CBV table and move to the next descriptor.
+        pCommandList->SetGraphicsRootDescriptorTable(2, cbvSrvHandle);
+        cbvSrvHandle.Offset(cbvSrvDescriptorSize);
 
-            pCommandList->DrawIndexedInstanced(numIndices, 1, 0, 0, 0);
-        }
+        pCommandList->DrawIndexedInstanced(numIndices, 1, 0, 0, 0);
     }
-    PIXEndEvent(pCommandList);
 }
 
-void XM_CALLCONV FrameResource::UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection)
+void XM_CALLCONV FrameResource::UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection, bool cullCities)
 {
-    XMMATRIX model;
-    XMFLOAT4X4 mvp;
-
-    for (UINT i = 0; i < m_cityRowCount; i++)
-    {
-        for (UINT j = 0; j < m_cityColumnCount; j++)
-        {
-            model = XMLoadFloat4x4(&m_modelMatrices[i * m_cityColumnCount + j]);
-
-            // Compute the model-view-projection matrix.
-            XMStoreFloat4x4(&mvp, XMMatrixTranspose(model * view * projection));
-
-            // Copy this matrix into the appropriate location in the upload heap subresource.
-            memcpy(&m_pConstantBuffers[i * m_cityColumnCount + j], &mvp, sizeof(mvp));
-        }
-    }
+    // Visible cities are packed to the front of the upload heap, so the draw list walks the
+    // descriptors in order. The upload heap is write-combined; the culler only ever streams to it.
+    ThrowIfFailed(m_cityCuller.Cull(XMMatrixMultiply(view, projection), m_pConstantBuffers, sizeof(SceneConstantBuffer), m_visibleCities, cullCities));
 }
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "DXBaiseHelper.h"
+#include "InstanceCuller.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -39,7 +40,13 @@ public:
     UINT m_cityRowCount;
     UINT m_cityColumnCount;
 
-    FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT cityColumnCount);
+    // Cities drawn this frame, in constant buffer order: the i-th visible city's MVP is in
+    // m_pConstantBuffers[i].
+    InstanceCuller m_cityCuller;
+    std::vector<UINT> m_visibleCities;
+
+    // cityBounds is the city mesh's object-space bounding sphere, used for frustum culling.
+    FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT cityColumnCount, const BoundingSphere& cityBounds);
     ~FrameResource();
 
     void InitBundle(ID3D12Device* pDevice, ID3D12PipelineState* pPso1, ID3D12PipelineState* pPso2,
@@ -50,5 +57,7 @@ public:
         UINT frameResourceIndex, UINT numIndices, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc, D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc,
         ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, UINT cbvSrvDescriptorSize, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature);
 
-    void XM_CALLCONV UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection);
+    // Frustum culls the cities and writes the MVPs of the visible ones. The bundle draws every city,
+    // so frames that execute it must pass cullCities = false.
+    void XM_CALLCONV UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection, bool cullCities = true);
 };
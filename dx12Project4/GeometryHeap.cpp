@@ -0,0 +1,76 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "GeometryHeap.h"
+
+#include <cassert>
+
+static_assert(GeometryPageTable::PageAlignment == D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, "Pages must be whole buffers");
+
+GeometryHeap::GeometryHeap()
+    : m_device(nullptr)
+{ }
+
+HRESULT GeometryHeap::Create(ID3D12Device* device, uint64_t pageSize)
+{
+    if (device == nullptr || pageSize == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_device = device;
+    m_pageTable.Reset(pageSize);
+    m_pages.clear();
+    return S_OK;
+}
+
+HRESULT GeometryHeap::Allocate(uint64_t size, uint64_t alignment, GeometryAllocation& allocation)
+{
+    uint32_t page = 0;
+    uint64_t offset = 0;
+    bool addedPage = false;
+    m_pageTable.Allocate(size, alignment, page, offset, addedPage);
+
+    if (addedPage)
+    {
+        const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+        const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_pageTable.GetPage(page).GetCapacity());
+
+        Page newPage;
+        HRESULT hr = m_device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&newPage.Resource));
+        if (FAILED(hr))
+        {
+            m_pageTable.RemoveLastPage();
+            return hr;
+        }
+        newPage.GpuBase = newPage.Resource->GetGPUVirtualAddress();
+        m_pages.push_back(std::move(newPage));
+    }
+
+    allocation.Resource = m_pages[page].Resource.Get();
+    allocation.GpuAddress = m_pages[page].GpuBase + offset;
+    allocation.Offset = offset;
+    allocation.Size = size;
+    allocation.Page = page;
+    return S_OK;
+}
+
+void GeometryHeap::Free(GeometryAllocation& allocation)
+{
+    if (allocation.Resource == nullptr)
+    {
+        return;
+    }
+
+    assert(allocation.Page < m_pages.size() && m_pages[allocation.Page].Resource.Get() == allocation.Resource);
+    m_pageTable.Free(allocation.Page, allocation.Offset, allocation.Size);
+    allocation = GeometryAllocation();
+}
@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "GeometryPageTable.h"
+
+#include <cstdint>
+#include <vector>
+
+// A range of a GeometryHeap page; Resource is null if nothing was allocated.
+struct GeometryAllocation
+{
+    ID3D12Resource*           Resource = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+    uint64_t                  Offset = 0;       // Within Resource
+    uint64_t                  Size = 0;
+    uint32_t                  Page = 0;
+};
+
+// Sub-allocates mesh buffers from a few large DEFAULT heap buffers ("pages") instead of a committed
+// resource each, which would round every one of them up to 64 KB. The ranges are placed by a
+// GeometryPageTable, and each of its pages is backed by a committed buffer. Pages are never
+// released, so freed ranges are reused by later loads.
+//
+// Pages stay in the COMMON state: buffers are promoted implicitly to COPY_DEST for uploads and to
+// the shader resource states for reads, and decay back after each ExecuteCommandLists, so ranges of
+// one page can be uploaded and read in different command lists without barriers.
+class GeometryHeap
+{
+public:
+    GeometryHeap();
+
+    GeometryHeap(const GeometryHeap&) = delete;
+    GeometryHeap& operator=(const GeometryHeap&) = delete;
+
+    // Pages are created on demand; pageSize is rounded up to 64 KB.
+    HRESULT Create(ID3D12Device* device, uint64_t pageSize);
+
+    HRESULT Allocate(uint64_t size, uint64_t alignment, GeometryAllocation& allocation);
+
+    // The GPU must be done with the range. Resets allocation.
+    void Free(GeometryAllocation& allocation);
+
+    uint32_t GetPageCount() const { return m_pageTable.GetPageCount(); }
+    uint64_t GetReservedSize() const { return m_pageTable.GetReservedSize(); }
+    uint64_t GetUsedSize() const { return m_pageTable.GetUsedSize(); }
+
+private:
+    struct Page
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        D3D12_GPU_VIRTUAL_ADDRESS              GpuBase;
+    };
+
+    ID3D12Device*     m_device;
+    GeometryPageTable m_pageTable;
+    std::vector<Page> m_pages;      // Parallel to the table's pages
+};
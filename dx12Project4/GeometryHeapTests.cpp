@@ -0,0 +1,190 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+#include "GeometryPageTable.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace Tests;
+
+namespace
+{
+    // A live range of a GeometryPageTable, with what it was allocated with.
+    struct GeometryRange
+    {
+        uint32_t Page;
+        uint64_t Offset;
+        uint64_t Size;
+        uint64_t Alignment;
+    };
+
+    // Counts live ranges which overlap each other, run off their page or break their alignment.
+    uint32_t CountRangeErrors(const GeometryPageTable& pages, const std::vector<std::vector<GeometryRange>>& live)
+    {
+        std::vector<std::vector<std::pair<uint64_t, uint64_t>>> byPage(pages.GetPageCount());
+        uint32_t errors = 0;
+
+        for (auto& model : live)
+        {
+            for (auto& range : model)
+            {
+                const uint64_t end = range.Offset + GeometryAllocator::GetAllocatedSize(range.Size);
+                errors += end > pages.GetPage(range.Page).GetCapacity() || range.Offset % range.Alignment != 0;
+                byPage[range.Page].push_back(std::make_pair(range.Offset, end));
+            }
+        }
+
+        for (auto& ranges : byPage)
+        {
+            std::sort(ranges.begin(), ranges.end());
+            for (size_t i = 1; i < ranges.size(); ++i)
+            {
+                errors += ranges[i].first < ranges[i - 1].second;
+            }
+        }
+
+        return errors;
+    }
+
+    // Best fit, padding and merging within one range, step by step.
+    uint32_t CheckAllocator()
+    {
+        GeometryAllocator allocator(4096);
+        uint64_t a, b, c, d;
+
+        uint32_t errors = 0;
+        errors += Check(allocator.Allocate(100, 16, a) && a == 0 && allocator.GetUsedSize() == 112, "GeometryAllocator: 100 bytes took %u, not 112\n",
+            static_cast<uint32_t>(allocator.GetUsedSize()));
+        errors += Check(allocator.Allocate(64, 256, b) && b == 256, "GeometryAllocator: an aligned range is at %u, not 256\n", static_cast<uint32_t>(b));
+        errors += Check(allocator.GetFreeRangeCount() == 2, "GeometryAllocator: the alignment padding isn't free\n");
+
+        // The padding in front of b is the smallest range that fits.
+        errors += Check(allocator.Allocate(128, 16, c) && c == 112, "GeometryAllocator: best fit chose %u, not the padding at 112\n", static_cast<uint32_t>(c));
+        errors += Check(!allocator.Allocate(8192, 16, d), "GeometryAllocator: a range larger than the capacity was allocated\n");
+
+        allocator.Free(c, 128);
+        allocator.Free(a, 100);
+        errors += Check(allocator.GetFreeRangeCount() == 2 && allocator.GetLargestFreeRange() == 4096 - 320, "GeometryAllocator: freed neighbours weren't merged\n");
+
+        allocator.Free(b, 64);
+        errors += Check(allocator.GetUsedSize() == 0 && allocator.GetFreeRangeCount() == 1 && allocator.GetLargestFreeRange() == 4096,
+            "GeometryAllocator: an empty allocator has %u free ranges\n", allocator.GetFreeRangeCount());
+        return errors;
+    }
+
+    // Unloads and reloads random made-up models, as a scene streaming its content in and out would,
+    // and checks the live ranges never overlap and the pages coalesce back into one free range each
+    // once everything is unloaded.
+    uint32_t CheckChurn()
+    {
+        const uint64_t pageSize = 1024 * 1024;
+        const uint32_t modelCount = 24;
+        const uint32_t churnRounds = 2048;
+
+        // Mesh-like buffers of 16 to 64 KB, some of them 256-byte aligned like MeshInfo, and a
+        // few larger than a page.
+        std::mt19937 rng(7);
+        std::vector<std::vector<GeometryRange>> requests(modelCount);
+        for (auto& model : requests)
+        {
+            const uint32_t bufferCount = 1 + rng() % 20;
+            for (uint32_t i = 0; i < bufferCount; ++i)
+            {
+                const uint64_t size = rng() % 64 == 0 ? pageSize + rng() % pageSize : 1 + rng() % (64 * 1024);
+                model.push_back(GeometryRange{ 0, 0, size, rng() % 4 == 0 ? 256u : 16u });
+            }
+        }
+
+        GeometryPageTable pages(pageSize);
+        std::vector<std::vector<GeometryRange>> live(modelCount);
+        uint32_t errors = 0;
+
+        for (uint32_t round = 0; round < churnRounds; ++round)
+        {
+            const size_t model = rng() % modelCount;
+            for (auto& range : live[model])
+            {
+                pages.Free(range.Page, range.Offset, range.Size);
+            }
+            live[model].clear();
+
+            // Most unloads are followed by a reload; the rest leave the model out for a while.
+            if (rng() % 4 != 0)
+            {
+                for (auto& range : requests[model])
+                {
+                    bool addedPage;
+                    live[model].push_back(range);
+                    pages.Allocate(range.Size, range.Alignment, live[model].back().Page, live[model].back().Offset, addedPage);
+                }
+            }
+
+            if (round % 64 == 0)
+            {
+                errors += CountRangeErrors(pages, live);
+            }
+        }
+        errors += CountRangeErrors(pages, live);
+        errors = Check(errors == 0, "GeometryPageTable: %u live ranges overlap, run off their page or are misaligned\n", errors);
+
+        for (auto& model : live)
+        {
+            for (auto& range : model)
+            {
+                pages.Free(range.Page, range.Offset, range.Size);
+            }
+        }
+
+        uint32_t unmerged = 0;
+        for (uint32_t p = 0; p < pages.GetPageCount(); ++p)
+        {
+            const GeometryAllocator& page = pages.GetPage(p);
+            unmerged += page.GetUsedSize() != 0 || page.GetFreeRangeCount() != 1 || page.GetLargestFreeRange() != page.GetCapacity();
+        }
+        errors += Check(unmerged == 0, "GeometryPageTable: %u of %u pages aren't one free range once everything is freed\n", unmerged, pages.GetPageCount());
+        errors += Check(pages.GetUsedSize() == 0, "GeometryPageTable: %u bytes used once everything is freed\n", static_cast<uint32_t>(pages.GetUsedSize()));
+        return errors;
+    }
+
+    // A range larger than a page gets a page of its own, rounded up to 64 KB, which can be taken back
+    // if it can't be backed; a small one then goes to the free first page.
+    uint32_t CheckOversizePage()
+    {
+        const uint64_t pageSize = 16 * 1024 * 1024;
+        GeometryPageTable pages(pageSize - 100);
+
+        uint32_t page;
+        uint64_t offset;
+        bool addedPage;
+
+        uint32_t errors = 0;
+        errors += Check(pages.GetPageSize() == pageSize, "GeometryPageTable: the page size wasn't rounded up to 64 KB\n");
+
+        pages.Allocate(100, 16, page, offset, addedPage);
+        errors += Check(addedPage && page == 0 && offset == 0, "GeometryPageTable: the first range didn't start the first page\n");
+
+        pages.Allocate(pageSize + 100, 256, page, offset, addedPage);
+        errors += Check(addedPage && page == 1 && offset == 0 && pages.GetPage(page).GetCapacity() == pageSize + GeometryPageTable::PageAlignment,
+            "GeometryPageTable: a range larger than a page didn't get a page of its own\n");
+
+        pages.RemoveLastPage();
+        pages.Allocate(100, 256, page, offset, addedPage);
+        errors += Check(!addedPage && page == 0 && offset == 256 && pages.GetPageCount() == 1, "GeometryPageTable: a small range didn't go to the first page\n");
+        errors += Check(pages.GetReservedSize() == pageSize, "GeometryPageTable: %u bytes reserved, not one page\n", static_cast<uint32_t>(pages.GetReservedSize()));
+        return errors;
+    }
+}
+
+uint32_t Tests::TestGeometryHeap(const std::wstring&)
+{
+    return CheckAllocator() + CheckChurn() + CheckOversizePage();
+}
@@ -0,0 +1,187 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "GeometryPageTable.h"
+
+#include "Alignment.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+const uint64_t GeometryAllocator::MinAlignment;
+const uint64_t GeometryPageTable::PageAlignment;
+
+GeometryAllocator::GeometryAllocator(uint64_t capacity)
+{
+    Reset(capacity);
+}
+
+void GeometryAllocator::Reset(uint64_t capacity)
+{
+    m_capacity = capacity;
+    m_usedSize = 0;
+    m_freeByOffset.clear();
+    m_freeBySize.clear();
+
+    if (capacity > 0)
+    {
+        InsertFree(0, capacity);
+    }
+}
+
+bool GeometryAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+    size = GetAllocatedSize(size);
+    alignment = std::max(alignment, MinAlignment);
+
+    // The smallest range at least size long which still fits once its start is aligned.
+    for (auto it = m_freeBySize.lower_bound(size); it != m_freeBySize.end(); ++it)
+    {
+        const uint64_t rangeOffset = it->second;
+        const uint64_t rangeSize = it->first;
+        const uint64_t start = AlignUp(rangeOffset, alignment);
+        if (start + size > rangeOffset + rangeSize)
+        {
+            continue;
+        }
+
+        EraseFree(m_freeByOffset.find(rangeOffset));
+        if (start > rangeOffset)
+        {
+            InsertFree(rangeOffset, start - rangeOffset);
+        }
+        if (start + size < rangeOffset + rangeSize)
+        {
+            InsertFree(start + size, rangeOffset + rangeSize - start - size);
+        }
+
+        m_usedSize += size;
+        offset = start;
+        return true;
+    }
+
+    return false;
+}
+
+void GeometryAllocator::Free(uint64_t offset, uint64_t size)
+{
+    size = GetAllocatedSize(size);
+    assert(offset + size <= m_capacity);
+    m_usedSize -= size;
+
+    // Merge with the free ranges on either side.
+    auto next = m_freeByOffset.lower_bound(offset);
+    assert(next == m_freeByOffset.end() || next->first >= offset + size);
+
+    if (next != m_freeByOffset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        auto merged = next++;
+        EraseFree(merged);
+    }
+
+    if (next != m_freeByOffset.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset);
+
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            EraseFree(prev);
+        }
+    }
+
+    InsertFree(offset, size);
+}
+
+void GeometryAllocator::InsertFree(uint64_t offset, uint64_t size)
+{
+    m_freeByOffset.emplace(offset, size);
+    m_freeBySize.emplace(size, offset);
+}
+
+void GeometryAllocator::EraseFree(std::map<uint64_t, uint64_t>::iterator range)
+{
+    auto sizes = m_freeBySize.equal_range(range->second);
+    for (auto it = sizes.first; it != sizes.second; ++it)
+    {
+        if (it->second == range->first)
+        {
+            m_freeBySize.erase(it);
+            break;
+        }
+    }
+
+    m_freeByOffset.erase(range);
+}
+
+GeometryPageTable::GeometryPageTable(uint64_t pageSize)
+{
+    Reset(pageSize);
+}
+
+void GeometryPageTable::Reset(uint64_t pageSize)
+{
+    m_pageSize = AlignUp(pageSize, PageAlignment);
+    m_pages.clear();
+}
+
+void GeometryPageTable::Allocate(uint64_t size, uint64_t alignment, uint32_t& page, uint64_t& offset, bool& addedPage)
+{
+    page = 0;
+    while (page < m_pages.size() && !m_pages[page].Allocate(size, alignment, offset))
+    {
+        page++;
+    }
+
+    addedPage = page == m_pages.size();
+    if (addedPage)
+    {
+        // The range starts a page of at least its size, so it fits at offset 0 whatever its alignment.
+        m_pages.emplace_back(std::max(m_pageSize, AlignUp(GeometryAllocator::GetAllocatedSize(size), PageAlignment)));
+        const bool allocated = m_pages.back().Allocate(size, alignment, offset);
+        assert(allocated);
+        (void)allocated;
+    }
+}
+
+void GeometryPageTable::RemoveLastPage()
+{
+    m_pages.pop_back();
+}
+
+void GeometryPageTable::Free(uint32_t page, uint64_t offset, uint64_t size)
+{
+    assert(page < m_pages.size());
+    m_pages[page].Free(offset, size);
+}
+
+uint64_t GeometryPageTable::GetReservedSize() const
+{
+    uint64_t size = 0;
+    for (auto& page : m_pages)
+    {
+        size += page.GetCapacity();
+    }
+    return size;
+}
+
+uint64_t GeometryPageTable::GetUsedSize() const
+{
+    uint64_t size = 0;
+    for (auto& page : m_pages)
+    {
+        size += page.GetUsedSize();
+    }
+    return size;
+}
@@ -0,0 +1,87 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Bookkeeping of a fixed-size range carved into variable-sized allocations, without any D3D
+// objects. Free ranges are kept by offset, to merge a freed range with its neighbours, and by size,
+// to pick the smallest one that fits. Alignment padding at the front of a range stays free.
+//
+// Sizes are rounded up to MinAlignment, and alignments must be powers of two.
+class GeometryAllocator
+{
+public:
+    static const uint64_t MinAlignment = 16;
+
+    explicit GeometryAllocator(uint64_t capacity = 0);
+
+    void Reset(uint64_t capacity);
+
+    // Returns false if no free range is large enough.
+    bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+
+    // size is the one passed to Allocate.
+    void Free(uint64_t offset, uint64_t size);
+
+    uint64_t GetCapacity() const { return m_capacity; }
+    uint64_t GetUsedSize() const { return m_usedSize; }
+    uint32_t GetFreeRangeCount() const { return static_cast<uint32_t>(m_freeByOffset.size()); }
+    uint64_t GetLargestFreeRange() const { return m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first; }
+
+    static uint64_t GetAllocatedSize(uint64_t size) { return size == 0 ? MinAlignment : (size + MinAlignment - 1) & ~(MinAlignment - 1); }
+
+private:
+    void InsertFree(uint64_t offset, uint64_t size);
+    void EraseFree(std::map<uint64_t, uint64_t>::iterator range);
+
+private:
+    uint64_t                          m_capacity;
+    uint64_t                          m_usedSize;
+    std::map<uint64_t, uint64_t>      m_freeByOffset;   // Offset -> size
+    std::multimap<uint64_t, uint64_t> m_freeBySize;     // Size -> offset
+};
+
+// GeometryHeap's pages without any D3D objects. A range goes to the first page with room, and one
+// that fits in none gets a new page: of the standard size, or of its own size rounded up to
+// PageAlignment if it is larger.
+class GeometryPageTable
+{
+public:
+    // D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, which every buffer's size is rounded up to anyway.
+    static const uint64_t PageAlignment = 64 * 1024;
+
+    explicit GeometryPageTable(uint64_t pageSize = 0);
+
+    // Forgets every page; pageSize is rounded up to PageAlignment.
+    void Reset(uint64_t pageSize);
+
+    // Always succeeds; addedPage is set if the range needed a new page, which is the last one.
+    void Allocate(uint64_t size, uint64_t alignment, uint32_t& page, uint64_t& offset, bool& addedPage);
+
+    // Undoes an Allocate that added a page, for when the page can't be backed.
+    void RemoveLastPage();
+
+    // size is the one passed to Allocate.
+    void Free(uint32_t page, uint64_t offset, uint64_t size);
+
+    uint64_t GetPageSize() const { return m_pageSize; }
+    uint32_t GetPageCount() const { return static_cast<uint32_t>(m_pages.size()); }
+    const GeometryAllocator& GetPage(uint32_t page) const { return m_pages[page]; }
+    uint64_t GetReservedSize() const;
+    uint64_t GetUsedSize() const;
+
+private:
+    uint64_t                       m_pageSize;
+    std::vector<GeometryAllocator> m_pages;
+};
@@ -0,0 +1,192 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "HeapCounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(COUNT_HEAP_ALLOCATIONS)
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount(0);
+    thread_local uint64_t t_allocationCount = 0;
+
+    void* CountedAllocate(size_t size)
+    {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        t_allocationCount++;
+
+        return malloc(size > 0 ? size : 1);
+    }
+
+#if defined(__cpp_aligned_new)
+    // Over-aligned types (alignas above the default new alignment) come through the align_val_t
+    // overloads; they count the same, and are freed with the matching function.
+    void* CountedAllocate(size_t size, std::align_val_t alignment)
+    {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        t_allocationCount++;
+
+        const size_t align = static_cast<size_t>(alignment);
+        size = (std::max(size, size_t(1)) + align - 1) / align * align;
+#if defined(_WIN32)
+        return _aligned_malloc(size, align);
+#else
+        return aligned_alloc(align, size);
+#endif
+    }
+
+    void AlignedFree(void* p)
+    {
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+#endif
+}
+
+uint64_t HeapCounter::GetAllocationCount()
+{
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t HeapCounter::GetThreadAllocationCount()
+{
+    return t_allocationCount;
+}
+
+void* operator new(size_t size)
+{
+    void* p = CountedAllocate(size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* p = CountedAllocate(size, alignment);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    AlignedFree(p);
+}
+#endif
+#else
+
+uint64_t HeapCounter::GetAllocationCount()
+{
+    return 0;
+}
+
+uint64_t HeapCounter::GetThreadAllocationCount()
+{
+    return 0;
+}
+#endif // COUNT_HEAP_ALLOCATIONS
@@ -0,0 +1,29 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+// Counts of calls to the global operator new, which HeapCounter.cpp replaces along with its aligned
+// forms, since the process started. Comparing two readings tells whether the code between them touched the heap.
+// The replacement puts an atomic increment on every allocation, so it is only compiled in with
+// COUNT_HEAP_ALLOCATIONS, which the test project defines; without it the counts stay zero.
+namespace HeapCounter
+{
+#if defined(COUNT_HEAP_ALLOCATIONS)
+    const bool c_enabled = true;
+#else
+    const bool c_enabled = false;
+#endif
+
+    uint64_t GetAllocationCount();          // On every thread
+    uint64_t GetThreadAllocationCount();    // On the calling thread
+}
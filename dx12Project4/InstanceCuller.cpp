@@ -0,0 +1,236 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "InstanceCuller.h"
+
+#include "MeshletCuller.h"
+
+#include <cfloat>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+    const uint32_t c_groupsPerBatch = 64;   // Lane groups per pool task
+
+    struct CullConstants
+    {
+        __m128 ViewProj[4][4];
+        __m128 Planes[6][4];
+    };
+
+    __m128 SetLane(__m128 v, uint32_t lane, float value)
+    {
+        float values[4];
+        _mm_storeu_ps(values, v);
+        values[lane] = value;
+        return _mm_loadu_ps(values);
+    }
+
+    // Returns the lanes whose spheres are inside or crossing every frustum plane.
+    uint32_t VisibleMask(const __m128 (&center)[3], __m128 radius, const CullConstants& k)
+    {
+        const __m128 negRadius = _mm_xor_ps(radius, _mm_set1_ps(-0.0f));
+
+        __m128 culled = _mm_setzero_ps();
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(center[0], k.Planes[i][0]), _mm_mul_ps(center[1], k.Planes[i][1])),
+                _mm_mul_ps(center[2], k.Planes[i][2])), k.Planes[i][3]);
+            culled = _mm_or_ps(culled, _mm_cmplt_ps(d, negRadius));
+        }
+
+        return static_cast<uint32_t>(_mm_movemask_ps(culled)) ^ 0xF;
+    }
+
+    // Streams the transpose of world * viewProj for each lane in mask to consecutive slots, returning
+    // the slot after the last one written.
+    uint8_t* StreamMvps(const __m128 (&world)[4][3], uint32_t mask, const CullConstants& k, uint8_t* slot, uint32_t stride)
+    {
+        // Column c of each lane's world * viewProj, which is row c of the transpose HLSL reads. The
+        // world matrices are affine, so only their translation row picks up viewProj's last row.
+        __m128 rows[4][4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            for (uint32_t r = 0; r < 4; ++r)
+            {
+                __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(world[r][0], k.ViewProj[0][c]), _mm_mul_ps(world[r][1], k.ViewProj[1][c])),
+                    _mm_mul_ps(world[r][2], k.ViewProj[2][c]));
+                if (r == 3)
+                {
+                    e = _mm_add_ps(e, k.ViewProj[3][c]);
+                }
+                rows[c][r] = e;
+            }
+
+            // rows[c][r] holds element (r, c) of every lane; transpose so that rows[c][lane] holds column c of one lane.
+            _MM_TRANSPOSE4_PS(rows[c][0], rows[c][1], rows[c][2], rows[c][3]);
+        }
+
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            if ((mask >> lane) & 1)
+            {
+                float* out = reinterpret_cast<float*>(slot);
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    _mm_stream_ps(out + c * 4, rows[c][lane]);
+                }
+                slot += stride;
+            }
+        }
+
+        return slot;
+    }
+
+    uint32_t BitCount(uint32_t mask)
+    {
+        return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+    }
+}
+void InstanceCuller::SetInstances(const XMFLOAT4X4* worlds, uint32_t count, const BoundingSphere& bounds)
+{
+    m_count = count;
+    m_groups.resize((count + LaneCount - 1) / LaneCount);
+
+    for (auto& group : m_groups)
+    {
+        for (uint32_t r = 0; r < 4; ++r)
+            for (uint32_t c = 0; c < 3; ++c)
+                group.World[r][c] = _mm_setzero_ps();
+
+        for (uint32_t c = 0; c < 3; ++c)
+            group.Center[c] = _mm_setzero_ps();
+
+        group.Radius = _mm_set1_ps(-FLT_MAX);
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Group& group = m_groups[i / LaneCount];
+        const uint32_t lane = i % LaneCount;
+        const XMFLOAT4X4& w = worlds[i];
+
+        for (uint32_t r = 0; r < 4; ++r)
+            for (uint32_t c = 0; c < 3; ++c)
+                group.World[r][c] = SetLane(group.World[r][c], lane, w.m[r][c]);
+
+        const XMMATRIX world = XMLoadFloat4x4(&w);
+        const XMVECTOR center = XMVector3Transform(XMLoadFloat3(&bounds.Center), world);
+
+        float scale = 0.0f;
+        for (uint32_t r = 0; r < 3; ++r)
+        {
+            scale = max(scale, XMVectorGetX(XMVector3Length(world.r[r])));
+        }
+
+        group.Center[0] = SetLane(group.Center[0], lane, XMVectorGetX(center));
+        group.Center[1] = SetLane(group.Center[1], lane, XMVectorGetY(center));
+        group.Center[2] = SetLane(group.Center[2], lane, XMVectorGetZ(center));
+        group.Radius = SetLane(group.Radius, lane, bounds.Radius * scale);
+    }
+}
+
+HRESULT XM_CALLCONV InstanceCuller::Cull(FXMMATRIX viewProj, void* constants, uint32_t stride, std::vector<uint32_t>& visible, bool cull, ThreadPool& pool)
+{
+    if (reinterpret_cast<uintptr_t>(constants) % 16 != 0 || stride % 16 != 0 || stride < sizeof(XMFLOAT4X4))
+    {
+        return E_INVALIDARG;
+    }
+
+    XMFLOAT4X4 vp;
+    XMStoreFloat4x4(&vp, viewProj);
+
+    XMFLOAT4 planes[6];
+    ComputeFrustumPlanes(viewProj, planes);
+
+    CullConstants k;
+    for (uint32_t r = 0; r < 4; ++r)
+        for (uint32_t c = 0; c < 4; ++c)
+            k.ViewProj[r][c] = _mm_set1_ps(vp.m[r][c]);
+
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        k.Planes[i][0] = _mm_set1_ps(planes[i].x);
+        k.Planes[i][1] = _mm_set1_ps(planes[i].y);
+        k.Planes[i][2] = _mm_set1_ps(planes[i].z);
+        k.Planes[i][3] = _mm_set1_ps(planes[i].w);
+    }
+
+    const uint32_t groupCount = static_cast<uint32_t>(m_groups.size());
+    const uint32_t batchCount = (groupCount + c_groupsPerBatch - 1) / c_groupsPerBatch;
+
+    m_masks.resize(groupCount);
+    m_batchOffsets.assign(batchCount + 1, 0);
+
+    // Cull first so that each batch knows where its slots start once the counts are summed.
+    pool.ParallelFor(batchCount, [&](uint32_t b)
+    {
+        const uint32_t end = min(groupCount, (b + 1) * c_groupsPerBatch);
+        uint32_t count = 0;
+
+        for (uint32_t g = b * c_groupsPerBatch; g < end; ++g)
+        {
+            // Lanes past the last instance are never written, culled or not.
+            const uint32_t first = g * LaneCount;
+            uint32_t mask = m_count - first >= LaneCount ? 0xF : (1u << (m_count - first)) - 1;
+
+            if (cull)
+            {
+                mask &= VisibleMask(m_groups[g].Center, m_groups[g].Radius, k);
+            }
+
+            m_masks[g] = static_cast<uint8_t>(mask);
+            count += BitCount(mask);
+        }
+
+        m_batchOffsets[b + 1] = count;
+    });
+
+    for (uint32_t b = 0; b < batchCount; ++b)
+    {
+        m_batchOffsets[b + 1] += m_batchOffsets[b];
+    }
+
+    visible.resize(m_batchOffsets[batchCount]);
+
+    pool.ParallelFor(batchCount, [&](uint32_t b)
+    {
+        const uint32_t end = min(groupCount, (b + 1) * c_groupsPerBatch);
+        uint32_t next = m_batchOffsets[b];
+        uint8_t* slot = static_cast<uint8_t*>(constants) + size_t(next) * stride;
+
+        for (uint32_t g = b * c_groupsPerBatch; g < end; ++g)
+        {
+            const uint32_t mask = m_masks[g];
+            if (mask == 0)
+            {
+                continue;
+            }
+
+            slot = StreamMvps(m_groups[g].World, mask, k, slot, stride);
+
+            for (uint32_t lane = 0; lane < LaneCount; ++lane)
+            {
+                if ((mask >> lane) & 1)
+                {
+                    visible[next++] = g * LaneCount + lane;
+                }
+            }
+        }
+
+        // Order this thread's streaming stores before whatever tells the GPU to read them.
+        _mm_sfence();
+    });
+
+    return S_OK;
+}
@@ -0,0 +1,57 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// Instances of one mesh under static affine transforms, stored four to a group as structure of
+// arrays. Each frame Cull tests the instances' bounding spheres against the frustum with SSE and
+// computes world * viewProj for the visible ones only, four at a time, writing them with streaming
+// stores so that write-combined upload memory is filled a whole cache line at a time and never read.
+// Batches of groups are culled, then written, in parallel on the pool.
+class InstanceCuller
+{
+public:
+    static const uint32_t LaneCount = 4;
+
+    // Replaces the instances. Each world matrix is affine in the row-vector convention; bounds is the
+    // mesh's object-space sphere, scaled by the longest axis of each matrix.
+    void SetInstances(const DirectX::XMFLOAT4X4* worlds, uint32_t count, const DirectX::BoundingSphere& bounds);
+
+    uint32_t GetInstanceCount() const { return m_count; }
+
+    // Writes the transpose of world * viewProj for each visible instance, as HLSL expects it, to
+    // consecutive slots of stride bytes starting at constants, and the instance index of each slot
+    // to visible, ascending. Only the first 64 bytes of a slot are written, and constants needs room
+    // for every instance. When cull is false every instance is written.
+    // Fails if constants isn't 16-byte aligned or stride isn't a multiple of 16 of at least 64.
+    HRESULT XM_CALLCONV Cull(DirectX::FXMMATRIX viewProj, void* constants, uint32_t stride, std::vector<uint32_t>& visible, bool cull = true,
+        ThreadPool& pool = ThreadPool::GetDefault());
+
+private:
+    struct Group
+    {
+        __m128 World[4][3];     // Element (r, c) of each lane's world matrix; column 3 is (0, 0, 0, 1)
+        __m128 Center[3];       // World-space sphere centres
+        __m128 Radius;          // -FLT_MAX in unused lanes, which every frustum test rejects
+    };
+
+    std::vector<Group>    m_groups;
+    uint32_t              m_count = 0;
+
+    std::vector<uint8_t>  m_masks;          // Scratch: visible lanes of each group
+    std::vector<uint32_t> m_batchOffsets;   // Scratch: first slot of each batch of groups
+};
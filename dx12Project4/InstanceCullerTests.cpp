@@ -0,0 +1,222 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "InstanceCuller.h"
+#include "MeshletCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    const uint32_t c_viewCount = 8;
+    const uint32_t c_slotSize = 256;        // FrameResource::SceneConstantBuffer
+    const uint8_t  c_untouched = 0xCD;      // Fill of the constant slots before each cull
+
+    bool Untouched(const uint8_t* begin, const uint8_t* end)
+    {
+        return std::all_of(begin, end, [](uint8_t b) { return b == c_untouched; });
+    }
+
+    // Instances in a square grid 8 units apart, each turned and scaled differently, so that every
+    // element of the world matrices matters and the spheres' radii vary.
+    void MakeWorlds(uint32_t count, std::vector<XMFLOAT4X4>& worlds)
+    {
+        const uint32_t side = max(1u, static_cast<uint32_t>(ceilf(sqrtf(float(count)))));
+
+        worlds.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float scale = 0.5f + 0.25f * (i % 5);
+            const XMMATRIX world = XMMatrixScaling(scale, scale, scale) * XMMatrixRotationY(0.7f * i) * XMMatrixTranslation((i % side) * 8.0f, 0.0f, (i / side) * -8.0f);
+            XMStoreFloat4x4(&worlds[i], world);
+        }
+    }
+
+    // View number 'view' of a turn on the spot above the middle of the grid.
+    XMMATRIX MakeViewProj(uint32_t count, uint32_t view)
+    {
+        const float extent = max(1.0f, sqrtf(float(count))) * 8.0f;
+        const float yaw = XM_2PI * view / c_viewCount;
+
+        const XMVECTOR eye = XMVectorSet(extent * 0.5f, 20.0f, -extent * 0.5f, 1.0f);
+        const XMMATRIX viewMatrix = XMMatrixLookToRH(eye, XMVectorSet(sinf(yaw), -0.2f, cosf(yaw), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return viewMatrix * XMMatrixPerspectiveFovRH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, extent);
+    }
+
+    // The instances whose spheres, scaled by the longest axis of their world matrices, aren't wholly
+    // outside a frustum plane, tested one at a time.
+    void CullScalar(const std::vector<XMFLOAT4X4>& worlds, const BoundingSphere& bounds, FXMMATRIX viewProj, std::vector<uint32_t>& visible)
+    {
+        XMFLOAT4 planes[6];
+        ComputeFrustumPlanes(viewProj, planes);
+
+        visible.clear();
+        for (uint32_t i = 0; i < worlds.size(); ++i)
+        {
+            const XMMATRIX world = XMLoadFloat4x4(&worlds[i]);
+
+            XMFLOAT3 center;
+            XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&bounds.Center), world));
+
+            float scale = 0.0f;
+            for (uint32_t r = 0; r < 3; ++r)
+            {
+                scale = max(scale, XMVectorGetX(XMVector3Length(world.r[r])));
+            }
+            const float radius = bounds.Radius * scale;
+
+            bool inside = true;
+            for (const XMFLOAT4& plane : planes)
+            {
+                inside = inside && !(center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w < -radius);
+            }
+            if (inside)
+            {
+                visible.push_back(i);
+            }
+        }
+    }
+
+    // Whether the slot holds the transpose of world * viewProj, as the old per-instance loop in
+    // FrameResource::UpdateConstantBuffers wrote it. The products are summed in a different order,
+    // so rounding is allowed for relative to the largest element.
+    bool MatchesMvp(const uint8_t* slot, const XMFLOAT4X4& world, FXMMATRIX viewProj)
+    {
+        XMFLOAT4X4 expected;
+        XMStoreFloat4x4(&expected, XMMatrixTranspose(XMLoadFloat4x4(&world) * viewProj));
+        const float* b = &expected.m[0][0];
+        const float* a = reinterpret_cast<const float*>(slot);
+
+        float scale = 1.0f;
+        for (uint32_t e = 0; e < 16; ++e)
+        {
+            scale = max(scale, fabsf(b[e]));
+        }
+
+        bool match = true;
+        for (uint32_t e = 0; e < 16; ++e)
+        {
+            match = match && fabsf(a[e] - b[e]) <= 1e-5f * scale;
+        }
+        return match;
+    }
+
+    // Culls count instances from every view, with and without culling. The visible instances must be
+    // the scalar test's, or every instance without culling, in ascending order; each one's slot must
+    // hold its MVP, and nothing past a slot's first 64 bytes or past the last slot may be written.
+    uint32_t CheckCull(uint32_t count, uint64_t& culledCount, uint64_t& keptCount)
+    {
+        const BoundingSphere bounds(XMFLOAT3(0.0f, 1.0f, 0.0f), 4.0f);
+
+        std::vector<XMFLOAT4X4> worlds;
+        MakeWorlds(count, worlds);
+
+        InstanceCuller culler;
+        culler.SetInstances(worlds.data(), count, bounds);
+
+        // Room for one spare slot, to catch writes past the last instance, and for alignment.
+        std::vector<uint8_t> storage(size_t(count + 1) * c_slotSize + c_slotSize);
+        uint8_t* constants = storage.data() + (c_slotSize - reinterpret_cast<uintptr_t>(storage.data()) % c_slotSize) % c_slotSize;
+
+        uint32_t failures = 0;
+        uint32_t wrongSets = 0;
+        uint32_t wrongMvps = 0;
+        uint32_t strayWrites = 0;
+
+        std::vector<uint32_t> visible;
+        std::vector<uint32_t> expected;
+
+        for (uint32_t v = 0; v < c_viewCount; ++v)
+        {
+            const XMMATRIX viewProj = MakeViewProj(count, v);
+
+            for (uint32_t cull = 0; cull < 2; ++cull)
+            {
+                std::fill(storage.begin(), storage.end(), c_untouched);
+                if (FAILED(culler.Cull(viewProj, constants, c_slotSize, visible, cull != 0)))
+                {
+                    ++failures;
+                    continue;
+                }
+
+                if (cull)
+                {
+                    CullScalar(worlds, bounds, viewProj, expected);
+                    culledCount += count - expected.size();
+                    keptCount += expected.size();
+                }
+                else
+                {
+                    expected.resize(count);
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        expected[i] = i;
+                    }
+                }
+
+                if (visible != expected)
+                {
+                    ++wrongSets;
+                    continue;
+                }
+
+                for (uint32_t k = 0; k < visible.size(); ++k)
+                {
+                    const uint8_t* slot = constants + size_t(k) * c_slotSize;
+                    wrongMvps += !MatchesMvp(slot, worlds[visible[k]], viewProj);
+                    strayWrites += !Untouched(slot + sizeof(XMFLOAT4X4), slot + c_slotSize);
+                }
+
+                strayWrites += !Untouched(constants + visible.size() * c_slotSize, storage.data() + storage.size());
+            }
+        }
+
+        uint32_t errors = Check(failures == 0, "InstanceCuller: culling %u instances failed %u times\n", count, failures);
+        errors += Check(wrongSets == 0, "InstanceCuller: %u of %u culls of %u instances kept the wrong instances\n", wrongSets, 2 * c_viewCount, count);
+        errors += Check(wrongMvps == 0, "InstanceCuller: %u MVPs of %u instances differ from world * viewProj\n", wrongMvps, count);
+        errors += Check(strayWrites == 0, "InstanceCuller: culling %u instances wrote outside the visible slots' matrices %u times\n", count, strayWrites);
+        return errors;
+    }
+}
+
+// Counts cover an empty culler, part-filled lane groups, exactly one batch of 64 groups, and
+// several batches with a part-filled group at the end.
+uint32_t Tests::TestInstanceCuller(const std::wstring&)
+{
+    const uint32_t counts[] = { 0, 1, 3, 6, 256, 519 };
+
+    uint32_t errors = 0;
+    uint64_t culledCount = 0;
+    uint64_t keptCount = 0;
+
+    for (uint32_t count : counts)
+    {
+        errors += CheckCull(count, culledCount, keptCount);
+    }
+    errors += Check(culledCount > 0 && keptCount > 0, "InstanceCuller: the views culled %llu instances and kept %llu\n", culledCount, keptCount);
+
+    InstanceCuller culler;
+    std::vector<XMFLOAT4X4> worlds;
+    MakeWorlds(5, worlds);
+    culler.SetInstances(worlds.data(), 5, BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f));
+
+    alignas(16) uint8_t constants[6 * c_slotSize];
+    std::vector<uint32_t> visible;
+    const XMMATRIX viewProj = MakeViewProj(5, 0);
+    errors += Check(culler.Cull(viewProj, constants + 4, c_slotSize, visible) == E_INVALIDARG && culler.Cull(viewProj, constants, 48, visible) == E_INVALIDARG
+        && culler.Cull(viewProj, constants, 72, visible) == E_INVALIDARG, "InstanceCuller: Cull accepted misaligned constants or a bad stride\n");
+    return errors;
+}
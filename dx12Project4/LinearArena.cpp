@@ -0,0 +1,126 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "LinearArena.h"
+
+#include "Alignment.h"
+
+#include <algorithm>
+
+namespace
+{
+    const size_t c_minBlockSize = 64 * 1024;
+    const size_t c_scratchCapacity = 1024 * 1024;
+}
+
+LinearArena::LinearArena(size_t capacity)
+    : m_block(0)
+    , m_offset(0)
+{
+    if (capacity > 0)
+    {
+        AddBlock(capacity);
+    }
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    // Blocks are allocated max_align_t aligned, so aligning offsets is enough up to that.
+    const size_t padding = alignment > alignof(std::max_align_t) ? alignment : 0;
+    size = size > 0 ? size : 1;
+
+    while (m_block < m_blocks.size())
+    {
+        Block& block = m_blocks[m_block];
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.Data.get());
+        const size_t offset = AlignUp(base + m_offset, alignment) - base;
+
+        if (offset + size <= block.Size)
+        {
+            m_offset = offset + size;
+            return block.Data.get() + offset;
+        }
+
+        // Later blocks are kept across Rewind; move on to the next one if there is one.
+        if (m_block + 1 == m_blocks.size())
+        {
+            break;
+        }
+
+        m_block++;
+        m_offset = 0;
+    }
+
+    AddBlock(std::max(GetCapacity(), size + padding));
+
+    m_block = static_cast<uint32_t>(m_blocks.size() - 1);
+    m_offset = 0;
+
+    return Allocate(size, alignment);
+}
+
+void LinearArena::Rewind(const Marker& marker)
+{
+    if (marker.Block == 0 && marker.Offset == 0)
+    {
+        Reset();
+        return;
+    }
+
+    m_block = marker.Block;
+    m_offset = marker.Offset;
+}
+
+void LinearArena::Reset()
+{
+    if (m_blocks.size() > 1)
+    {
+        const size_t capacity = GetCapacity();
+        m_blocks.clear();
+        AddBlock(capacity);
+    }
+
+    m_block = 0;
+    m_offset = 0;
+}
+
+size_t LinearArena::GetCapacity() const
+{
+    size_t capacity = 0;
+    for (auto& block : m_blocks)
+    {
+        capacity += block.Size;
+    }
+    return capacity;
+}
+
+void LinearArena::AddBlock(size_t size)
+{
+    size = std::max(size, c_minBlockSize);
+
+    Block block;
+    block.Data.reset(new uint8_t[size]);
+    block.Size = size;
+    m_blocks.push_back(std::move(block));
+}
+
+ScratchScope::ScratchScope()
+    : m_arena([]() -> LinearArena&
+        {
+            thread_local LinearArena t_scratch(c_scratchCapacity);
+            return t_scratch;
+        }())
+    , m_marker(m_arena.GetMarker())
+{ }
+
+ScratchScope::~ScratchScope()
+{
+    m_arena.Rewind(m_marker);
+}
@@ -0,0 +1,127 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for transient data. Allocating advances an offset within the current block, and
+// memory is only given back all at once, by Reset or by rewinding to a marker. When a block fills, a
+// new one at least as large as all the others is chained on; Reset then merges the chain into a
+// single block, so a workload repeated every frame settles on one block and stops touching the heap.
+//
+// Nothing allocated from an arena is constructed or destroyed by it. An arena is not thread-safe;
+// parallel code should allocate before fanning out.
+class LinearArena
+{
+public:
+    struct Marker
+    {
+        uint32_t Block;
+        size_t   Offset;
+    };
+
+    explicit LinearArena(size_t capacity = 0);
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    // Alignment must be a power of two. Zero-sized allocations return a valid, unique pointer.
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    Marker GetMarker() const { return Marker{ m_block, m_offset }; }
+
+    // Frees everything allocated since marker was taken.
+    void Rewind(const Marker& marker);
+
+    // Frees everything, merging the blocks if more than one was needed.
+    void Reset();
+
+    size_t GetCapacity() const;                         // Bytes in all blocks
+    uint32_t GetBlockCount() const { return static_cast<uint32_t>(m_blocks.size()); }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> Data;
+        size_t                     Size;
+    };
+
+    void AddBlock(size_t size);
+
+    std::vector<Block> m_blocks;
+    uint32_t           m_block;     // Block being allocated from
+    size_t             m_offset;    // Bytes used in that block
+};
+
+// Standard allocator over a LinearArena, for containers that live no longer than the arena's
+// current cycle. Deallocation is a no-op, so a growing vector leaves its old storage behind.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) : m_arena(&arena) { }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.GetArena()) { }
+
+    T* allocate(size_t count) { return m_arena->Allocate<T>(count); }
+    void deallocate(T*, size_t) { }
+
+    LinearArena* GetArena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.GetArena(); }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.GetArena(); }
+
+private:
+    LinearArena* m_arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Scope on this thread's scratch arena, for temporaries such as those of model loading. Everything
+// allocated through any scope is freed when that scope ends, so scopes must end in reverse order of
+// creation, as they do on the stack; a pool task run inside a scope may open its own.
+class ScratchScope
+{
+public:
+    ScratchScope();
+    ~ScratchScope();
+
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    LinearArena& GetArena() { return m_arena; }
+
+    template <typename T>
+    T* Allocate(size_t count) { return m_arena.Allocate<T>(count); }
+
+    template <typename T>
+    ArenaVector<T> MakeVector() { return ArenaVector<T>(ArenaAllocator<T>(m_arena)); }
+
+private:
+    LinearArena&        m_arena;
+    LinearArena::Marker m_marker;
+};
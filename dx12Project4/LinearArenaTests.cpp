@@ -0,0 +1,149 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "HeapCounter.h"
+#include "LinearArena.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tests;
+
+namespace
+{
+    bool IsAligned(const void* p, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+    }
+
+    // Allocations of every power-of-two alignment up to 4 KB are aligned and don't overlap: each is
+    // filled with its own byte, and every one still holds it once the arena has grown past its
+    // first block.
+    uint32_t CheckAllocations()
+    {
+        LinearArena arena(1024);
+
+        struct Allocation
+        {
+            uint8_t* Data;
+            size_t   Size;
+        };
+        std::vector<Allocation> allocations;
+
+        uint32_t errors = 0;
+        for (uint32_t i = 0; i < 400; ++i)
+        {
+            const size_t alignment = size_t(1) << (i % 13);
+            const size_t size = (i * 97) % 3000;
+
+            uint8_t* data = static_cast<uint8_t*>(arena.Allocate(size, alignment));
+            errors += Check(IsAligned(data, alignment), "LinearArena: allocation %u isn't %zu-byte aligned\n", i, alignment);
+
+            memset(data, i & 0xff, std::max(size, size_t(1)));
+            allocations.push_back(Allocation{ data, std::max(size, size_t(1)) });
+        }
+
+        errors += Check(arena.GetBlockCount() > 1, "LinearArena: 400 allocations fit a 1 KB arena\n");
+
+        for (uint32_t i = 0; i < allocations.size(); ++i)
+        {
+            bool intact = true;
+            for (size_t b = 0; b < allocations[i].Size; ++b)
+            {
+                intact = intact && allocations[i].Data[b] == (i & 0xff);
+            }
+            errors += Check(intact, "LinearArena: allocation %u was overwritten\n", i);
+        }
+
+        // Reset merges the chain into one block large enough for everything.
+        const size_t capacity = arena.GetCapacity();
+        arena.Reset();
+        errors += Check(arena.GetBlockCount() == 1 && arena.GetCapacity() == capacity,
+            "LinearArena: Reset left %u blocks of %zu bytes, from %zu\n", arena.GetBlockCount(), arena.GetCapacity(), capacity);
+
+        void* a = arena.Allocate(0);
+        void* b = arena.Allocate(0);
+        errors += Check(a != nullptr && b != nullptr && a != b, "LinearArena: zero-sized allocations aren't unique\n");
+
+        return errors;
+    }
+
+    // Rewinding to a marker hands the same memory out again, and a scratch scope rewinds its
+    // thread's arena when it ends.
+    uint32_t CheckMarkers()
+    {
+        LinearArena arena;
+        arena.Allocate(100);
+
+        const LinearArena::Marker marker = arena.GetMarker();
+        void* first = arena.Allocate(256);
+        arena.Allocate(200 * 1024);
+        arena.Rewind(marker);
+
+        uint32_t errors = Check(arena.Allocate(256) == first, "LinearArena: Rewind didn't free what followed the marker\n");
+
+        void* outer;
+        void* inner;
+        {
+            ScratchScope scope;
+            outer = scope.Allocate<uint32_t>(64);
+            {
+                ScratchScope nested;
+                inner = nested.Allocate<uint32_t>(64);
+            }
+
+            errors += Check(scope.Allocate<uint32_t>(64) == inner, "ScratchScope: a nested scope didn't free its allocations\n");
+        }
+
+        ScratchScope scope;
+        errors += Check(scope.Allocate<uint32_t>(64) == outer, "ScratchScope: a scope didn't free its allocations\n");
+        return errors;
+    }
+
+    // A frame that repeats the same allocations settles on one block: once the first frame has grown
+    // the arena and the next Reset has merged its blocks, the frames never touch the heap.
+    uint32_t CheckSteadyState()
+    {
+        const uint32_t c_frameCount = 16;
+
+        LinearArena arena;
+        uint64_t steadyAllocations = 0;
+
+        for (uint32_t f = 0; f < c_frameCount; ++f)
+        {
+            const uint64_t start = HeapCounter::GetThreadAllocationCount();
+
+            arena.Reset();
+            for (uint32_t i = 0; i < 64; ++i)
+            {
+                arena.Allocate<float>(1000 + i * 100);
+            }
+
+            ArenaVector<uint32_t> values{ ArenaAllocator<uint32_t>(arena) };
+            for (uint32_t i = 0; i < 10000; ++i)
+            {
+                values.push_back(i);
+            }
+
+            if (f > 1)
+            {
+                steadyAllocations += HeapCounter::GetThreadAllocationCount() - start;
+            }
+        }
+
+        return Check(steadyAllocations == 0, "LinearArena: %u heap allocations after the second frame\n", static_cast<uint32_t>(steadyAllocations));
+    }
+}
+
+uint32_t Tests::TestLinearArena(const std::wstring&)
+{
+    return CheckAllocations() + CheckMarkers() + CheckSteadyState();
+}
@@ -12,10 +12,124 @@
 
 #include "stdafx.h"
 #include "DX12Practice.h"
+#include "Benchmarks.h"
+#include "MeshletGenerator.h"
+#include "ModelWriter.h"
+#include "SimpleCamera.h"
+#include "SoftwareRasterizer.h"
 
 _Use_decl_annotations_
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 {
+    // "-benchmark [assetDirectory]" runs the CPU benchmarks without creating a window or device.
+    // "-compress input.bin output.bin" rewrites a model as a block-compressed MSHL file.
+    // "-meshletize input.bin output.bin" rebuilds a model's meshlets before writing it.
+    // "-rasterize input.bin output.bmp" renders the first frame's view on the CPU, without a device.
+    {
+        int argc;
+        LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+        for (int i = 1; i < argc; ++i)
+        {
+            if (_wcsicmp(argv[i], L"-benchmark") == 0 || _wcsicmp(argv[i], L"/benchmark") == 0)
+            {
+                std::wstring assetDirectory = (i + 1 < argc) ? std::wstring(argv[i + 1]) + L"\\" : L"Assets\\";
+                LocalFree(argv);
+
+                return Benchmarks::Run(assetDirectory);
+            }
+
+            if ((_wcsicmp(argv[i], L"-compress") == 0 || _wcsicmp(argv[i], L"/compress") == 0) && i + 2 < argc)
+            {
+                Model model;
+                HRESULT hr = model.LoadFromFile(argv[i + 1]);
+                if (SUCCEEDED(hr))
+                {
+                    hr = WriteModelFile(argv[i + 2], model);
+                }
+                LocalFree(argv);
+
+                return SUCCEEDED(hr) ? 0 : 1;
+            }
+
+            if ((_wcsicmp(argv[i], L"-meshletize") == 0 || _wcsicmp(argv[i], L"/meshletize") == 0) && i + 2 < argc)
+            {
+                Model model;
+                HRESULT hr = model.LoadFromFile(argv[i + 1]);
+
+                std::vector<MeshletData> meshlets(model.GetMeshCount());
+                uint32_t meshIndex = 0;
+
+                for (auto& mesh : model)
+                {
+                    if (SUCCEEDED(hr))
+                    {
+                        hr = GenerateMeshlets(mesh, meshlets[meshIndex]);
+                    }
+                    if (SUCCEEDED(hr))
+                    {
+                        meshlets[meshIndex].AttachTo(mesh);
+                    }
+                    ++meshIndex;
+                }
+
+                if (SUCCEEDED(hr))
+                {
+                    hr = WriteModelFile(argv[i + 2], model);
+                }
+                LocalFree(argv);
+
+                return SUCCEEDED(hr) ? 0 : 1;
+            }
+
+            if ((_wcsicmp(argv[i], L"-rasterize") == 0 || _wcsicmp(argv[i], L"/rasterize") == 0) && i + 2 < argc)
+            {
+                const uint32_t width = 1280;
+                const uint32_t height = 720;
+
+                Model model;
+                HRESULT hr = model.LoadFromFile(argv[i + 1]);
+
+                // The camera and constants DX12Practice starts with.
+                SimpleCamera camera;
+                camera.Init({ 0, 75, 150 });
+
+                const XMMATRIX view = camera.GetViewMatrix();
+                const XMMATRIX proj = camera.GetProjectionMatrix(XM_PI / 3.0f, float(width) / height);
+
+                RasterConstants constants;
+                XMStoreFloat4x4(&constants.World, XMMatrixIdentity());
+                XMStoreFloat4x4(&constants.WorldView, view);
+                XMStoreFloat4x4(&constants.WorldViewProj, view * proj);
+                constants.DrawMeshlets = true;
+
+                const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+                SoftwareRasterizer rasterizer;
+                rasterizer.Clear(width, height, clearColor);
+
+                for (auto& mesh : model)
+                {
+                    if (SUCCEEDED(hr))
+                    {
+                        hr = rasterizer.Draw(mesh, constants);
+                    }
+                }
+
+                if (SUCCEEDED(hr))
+                {
+                    rasterizer.Resolve();
+                    hr = rasterizer.WriteBitmap(argv[i + 2]);
+                }
+                LocalFree(argv);
+
+                return SUCCEEDED(hr) ? 0 : 1;
+            }
+        }
+
+        LocalFree(argv);
+    }
+
     DX12Practice sample(1280, 720, L"D3D12 Hello DX12Practice");
     return Win32Application::Run(&sample, hInstance, nCmdShow);
 }
@@ -0,0 +1,213 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+#if defined(_WIN32)
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+#else
+    , m_file(-1)
+#endif
+{ }
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : MappedFile()
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_file, other.m_file);
+#if defined(_WIN32)
+        std::swap(m_mapping, other.m_mapping);
+#endif
+    }
+
+    return *this;
+}
+
+#if defined(_WIN32)
+
+HRESULT MappedFile::Open(const wchar_t* filename)
+{
+    Close();
+
+    m_file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return E_INVALIDARG;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    // Reads come straight from the file cache.
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr)
+    {
+        Close();
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_data = reinterpret_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr)
+    {
+        Close();
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+
+    return S_OK;
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+
+    if (m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    m_size = 0;
+}
+
+void MappedFile::Prefetch()
+{
+    // PrefetchVirtualMemory arrived in Windows 8, and the Debug configurations target Windows 7
+    // (_WIN32_WINNT=0x0601), where neither it nor WIN32_MEMORY_RANGE_ENTRY is declared. Looking it
+    // up at runtime prefetches in every configuration on Windows 8 and later; on Windows 7 the
+    // pages are read on demand as before.
+    struct MemoryRange
+    {
+        PVOID  VirtualAddress;
+        SIZE_T NumberOfBytes;
+    };
+    using PrefetchVirtualMemoryFn = BOOL(WINAPI*)(HANDLE, ULONG_PTR, MemoryRange*, ULONG);
+
+    static const auto prefetchVirtualMemory = reinterpret_cast<PrefetchVirtualMemoryFn>(
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+
+    if (m_data != nullptr && prefetchVirtualMemory != nullptr)
+    {
+        MemoryRange range = { const_cast<uint8_t*>(m_data), m_size };
+        prefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+}
+
+#else
+
+HRESULT MappedFile::Open(const wchar_t* filename)
+{
+    Close();
+
+    // POSIX paths are narrow; convert using the current locale.
+    size_t length = std::wcstombs(nullptr, filename, 0);
+    if (length == static_cast<size_t>(-1))
+    {
+        return E_INVALIDARG;
+    }
+
+    std::string path(length, '\0');
+    std::wcstombs(&path[0], filename, length + 1);
+
+    m_file = open(path.c_str(), O_RDONLY);
+    if (m_file < 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    struct stat info = {};
+    if (fstat(m_file, &info) != 0 || info.st_size == 0)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_data = reinterpret_cast<const uint8_t*>(data);
+    m_size = static_cast<size_t>(info.st_size);
+
+    return S_OK;
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+
+    if (m_file >= 0)
+    {
+        close(m_file);
+        m_file = -1;
+    }
+
+    m_size = 0;
+}
+
+void MappedFile::Prefetch()
+{
+    if (m_data != nullptr)
+    {
+        madvise(const_cast<uint8_t*>(m_data), m_size, MADV_WILLNEED);
+    }
+}
+
+#endif
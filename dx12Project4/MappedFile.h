@@ -0,0 +1,50 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+// Read-only view of a whole file mapped into the address space. Writing through it faults.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    HRESULT Open(const wchar_t* filename);
+    void Close();
+
+    // Hints the OS to start reading the whole file in the background so later page faults hit the cache.
+    // Does nothing on Windows 7, which lacks PrefetchVirtualMemory.
+    void Prefetch();
+
+    bool IsOpen() const { return m_data != nullptr; }
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const uint8_t* m_data;
+    size_t   m_size;
+
+#if defined(_WIN32)
+    HANDLE   m_file;
+    HANDLE   m_mapping;
+#else
+    int      m_file;
+#endif
+};
@@ -0,0 +1,665 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    const double c_boundaryWeight = 10.0;   // Weight of an open edge's constraint plane, per unit of squared edge length
+    const float  c_minFlipCosine = 0.25f;   // A face may turn by at most acos(0.25) in one collapse
+    const float  c_insideTolerance = 1e-5f; // Outward movement allowed for rounding, per unit of collapse length
+
+    // Symmetric 4x4 quadric: the weighted sum of squared distances to a set of planes.
+    struct Quadric
+    {
+        double A00, A01, A02, A11, A12, A22;
+        double B0, B1, B2;
+        double C;
+        double Weight;
+
+        // Normal attribute: the weighted sums of the absorbed vertices' normals and squared lengths.
+        double N0, N1, N2;
+        double NSq;
+        double NormalWeight;
+    };
+
+    void AddPlane(Quadric& q, double nx, double ny, double nz, double d, double weight)
+    {
+        q.A00 += weight * nx * nx;
+        q.A01 += weight * nx * ny;
+        q.A02 += weight * nx * nz;
+        q.A11 += weight * ny * ny;
+        q.A12 += weight * ny * nz;
+        q.A22 += weight * nz * nz;
+        q.B0 += weight * nx * d;
+        q.B1 += weight * ny * d;
+        q.B2 += weight * nz * d;
+        q.C += weight * d * d;
+        q.Weight += weight;
+    }
+
+    void AddQuadric(Quadric& q, const Quadric& r)
+    {
+        q.A00 += r.A00; q.A01 += r.A01; q.A02 += r.A02;
+        q.A11 += r.A11; q.A12 += r.A12; q.A22 += r.A22;
+        q.B0 += r.B0; q.B1 += r.B1; q.B2 += r.B2;
+        q.C += r.C;
+        q.Weight += r.Weight;
+        q.N0 += r.N0; q.N1 += r.N1; q.N2 += r.N2;
+        q.NSq += r.NSq;
+        q.NormalWeight += r.NormalWeight;
+    }
+
+    void AddNormal(Quadric& q, const XMFLOAT3& n, double weight)
+    {
+        q.N0 += weight * n.x;
+        q.N1 += weight * n.y;
+        q.N2 += weight * n.z;
+        q.NSq += weight * (double(n.x) * n.x + double(n.y) * n.y + double(n.z) * n.z);
+        q.NormalWeight += weight;
+    }
+
+    // Weighted sum of squared plane distances of p.
+    double Evaluate(const Quadric& q, const XMFLOAT3& p)
+    {
+        const double x = p.x, y = p.y, z = p.z;
+
+        const double result =
+            q.A00 * x * x + 2.0 * q.A01 * x * y + 2.0 * q.A02 * x * z +
+            q.A11 * y * y + 2.0 * q.A12 * y * z + q.A22 * z * z +
+            2.0 * (q.B0 * x + q.B1 * y + q.B2 * z) + q.C;
+
+        return max(result, 0.0);
+    }
+
+    // Weighted sum of squared distances of n from the absorbed vertices' normals.
+    double EvaluateNormal(const Quadric& q, const XMFLOAT3& n)
+    {
+        const double x = n.x, y = n.y, z = n.z;
+        const double result = q.NSq - 2.0 * (q.N0 * x + q.N1 * y + q.N2 * z) + q.NormalWeight * (x * x + y * y + z * z);
+
+        return max(result, 0.0);
+    }
+
+    XMVECTOR FaceNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+    {
+        const XMVECTOR v0 = XMLoadFloat3(&p0);
+        return XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&p1), v0), XMVectorSubtract(XMLoadFloat3(&p2), v0));
+    }
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    void ComputeQuadrics(const XMFLOAT3* positions, const XMFLOAT3* normals, const std::vector<uint32_t>& indices, std::vector<Quadric>& quadrics)
+    {
+        const uint32_t triCount = static_cast<uint32_t>(indices.size() / 3);
+
+        std::vector<uint64_t> edges;
+        edges.reserve(indices.size());
+
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            const uint32_t* tri = &indices[t * 3];
+
+            const XMVECTOR normal = FaceNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+            const float length = XMVectorGetX(XMVector3Length(normal));
+            if (length <= 0.0f)
+                continue;
+
+            XMFLOAT3 n;
+            XMStoreFloat3(&n, XMVectorScale(normal, 1.0f / length));
+
+            const XMFLOAT3& p = positions[tri[0]];
+            const double d = -(double(n.x) * p.x + double(n.y) * p.y + double(n.z) * p.z);
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                AddPlane(quadrics[tri[i]], n.x, n.y, n.z, d, 0.5 * length);
+                if (normals)
+                {
+                    AddNormal(quadrics[tri[i]], normals[tri[i]], 0.5 * length);
+                }
+                edges.push_back(EdgeKey(tri[i], tri[(i + 1) % 3]));
+            }
+        }
+
+        // Open edges (used by one triangle) get a plane through the edge, perpendicular to the face,
+        // so that collapses along the border cost as much as ones that move it.
+        std::sort(edges.begin(), edges.end());
+
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            const uint32_t* tri = &indices[t * 3];
+
+            const XMVECTOR normal = XMVector3Normalize(FaceNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]));
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                const uint32_t a = tri[i];
+                const uint32_t b = tri[(i + 1) % 3];
+
+                auto range = std::equal_range(edges.begin(), edges.end(), EdgeKey(a, b));
+                if (range.second - range.first != 1)
+                    continue;
+
+                const XMVECTOR pa = XMLoadFloat3(&positions[a]);
+                const XMVECTOR edge = XMVectorSubtract(XMLoadFloat3(&positions[b]), pa);
+                const float lengthSq = XMVectorGetX(XMVector3LengthSq(edge));
+
+                XMFLOAT3 m;
+                XMStoreFloat3(&m, XMVector3Normalize(XMVector3Cross(edge, normal)));
+                if (lengthSq <= 0.0f || !(m.x == m.x))
+                    continue;
+
+                const double d = -XMVectorGetX(XMVector3Dot(XMLoadFloat3(&m), pa));
+                AddPlane(quadrics[a], m.x, m.y, m.z, d, c_boundaryWeight * lengthSq);
+                AddPlane(quadrics[b], m.x, m.y, m.z, d, c_boundaryWeight * lengthSq);
+            }
+        }
+    }
+
+    // Copies locked (all clear if null) into pinned and also sets the ends of every open edge.
+    void PinOpenEdges(const std::vector<uint32_t>& indices, const uint8_t* locked, uint32_t vertexCount, std::vector<uint8_t>& pinned)
+    {
+        pinned.assign(vertexCount, 0);
+        if (locked)
+        {
+            std::copy(locked, locked + vertexCount, pinned.begin());
+        }
+
+        std::vector<uint64_t> edges;
+        edges.reserve(indices.size());
+        for (uint32_t i = 0; i < indices.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                edges.push_back(EdgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        for (size_t e = 0; e < edges.size(); ++e)
+        {
+            const bool open = (e == 0 || edges[e - 1] != edges[e]) && (e + 1 == edges.size() || edges[e + 1] != edges[e]);
+            if (open)
+            {
+                pinned[edges[e] >> 32] = 1;
+                pinned[static_cast<uint32_t>(edges[e])] = 1;
+            }
+        }
+    }
+
+    struct Collapse
+    {
+        float    Error;     // Squared
+        uint32_t From;
+        uint32_t To;
+
+        bool operator<(const Collapse& other) const { return Error < other.Error; }
+    };
+
+    // Cost of moving from onto to, as a squared distance. The kept vertex's normal is charged for
+    // its mean squared deviation from the absorbed ones, scaled by normalWeightSq.
+    float CollapseError(const XMFLOAT3* positions, const XMFLOAT3* normals, double normalWeightSq, const std::vector<Quadric>& quadrics, uint32_t from, uint32_t to)
+    {
+        Quadric q = quadrics[from];
+        AddQuadric(q, quadrics[to]);
+
+        double error = q.Weight > 0.0 ? Evaluate(q, positions[to]) / q.Weight : 0.0;
+        if (normals && q.NormalWeight > 0.0)
+        {
+            error += normalWeightSq * EvaluateNormal(q, normals[to]) / q.NormalWeight;
+        }
+        return static_cast<float>(error);
+    }
+
+    // Triangles around each vertex, as offsets into a shared list.
+    struct Adjacency
+    {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Triangles;
+    };
+
+    void BuildAdjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount, Adjacency& adjacency)
+    {
+        adjacency.Offsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : indices)
+        {
+            ++adjacency.Offsets[index + 1];
+        }
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            adjacency.Offsets[v + 1] += adjacency.Offsets[v];
+        }
+
+        adjacency.Triangles.resize(indices.size());
+
+        std::vector<uint32_t> cursor(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+        for (uint32_t i = 0; i < indices.size(); ++i)
+        {
+            adjacency.Triangles[cursor[indices[i]]++] = i / 3;
+        }
+    }
+
+    // Rejects a collapse that would turn any surviving triangle around from by too much, or with
+    // keepInside, one that would move from in front of any triangle around it. FaceNormal points
+    // away from the side a triangle is seen clockwise from, so behind is along it.
+    bool IsCollapseValid(const XMFLOAT3* positions, const std::vector<uint32_t>& indices, const Adjacency& adjacency, uint32_t from, uint32_t to,
+        bool keepInside)
+    {
+        const XMVECTOR move = XMVectorSubtract(XMLoadFloat3(&positions[to]), XMLoadFloat3(&positions[from]));
+        const float moveLength = XMVectorGetX(XMVector3Length(move));
+
+        for (uint32_t i = adjacency.Offsets[from]; i < adjacency.Offsets[from + 1]; ++i)
+        {
+            const uint32_t* tri = &indices[adjacency.Triangles[i] * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+
+            XMFLOAT3 moved[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                if (tri[k] == from)
+                    moved[k] = positions[to];
+            }
+
+            const XMVECTOR before = FaceNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+            const XMVECTOR after = FaceNormal(moved[0], moved[1], moved[2]);
+
+            const float beforeLength = XMVectorGetX(XMVector3Length(before));
+            const float dot = XMVectorGetX(XMVector3Dot(before, after));
+            if (!(dot > c_minFlipCosine * beforeLength * XMVectorGetX(XMVector3Length(after))))
+                return false;
+
+            if (keepInside && XMVectorGetX(XMVector3Dot(before, move)) < -c_insideTolerance * beforeLength * moveLength)
+                return false;
+        }
+        return true;
+    }
+}
+
+HRESULT SimplifyTriangles(const XMFLOAT3* positions, const XMFLOAT3* normals, uint32_t vertexCount, const uint8_t* locked,
+    std::vector<uint32_t>& indices, const SimplifyOptions& options, float* error)
+{
+    if (indices.size() % 3 != 0 || options.NormalWeight < 0.0f)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (uint32_t index : indices)
+    {
+        if (index >= vertexCount)
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    if (options.NormalWeight == 0.0f)
+    {
+        normals = nullptr;
+    }
+
+    ComputeQuadrics(positions, normals, indices, quadrics);
+    const double normalWeightSq = double(options.NormalWeight) * options.NormalWeight;
+
+    const double maxErrorSq = double(options.MaxError) * options.MaxError;
+    float worstError = 0.0f;
+
+    // An open border has no triangles behind it to hold it in, so inward-only collapses could still
+    // grow it within its own plane; instead its vertices don't move.
+    std::vector<uint8_t> pinned;
+    if (options.KeepInside)
+    {
+        PinOpenEdges(indices, locked, vertexCount, pinned);
+        locked = pinned.data();
+    }
+
+    Adjacency adjacency;
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+
+    // Each pass ranks every edge, then makes the cheapest collapses whose neighbourhoods don't overlap.
+    while (indices.size() / 3 > options.TargetTriangleCount)
+    {
+        BuildAdjacency(indices, vertexCount, adjacency);
+
+        edges.clear();
+        for (uint32_t i = 0; i < indices.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                edges.push_back(EdgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t edge : edges)
+        {
+            const uint32_t a = static_cast<uint32_t>(edge >> 32);
+            const uint32_t b = static_cast<uint32_t>(edge);
+
+            const bool canMoveA = locked == nullptr || !locked[a];
+            const bool canMoveB = locked == nullptr || !locked[b];
+
+            Collapse best = { FLT_MAX, 0, 0 };
+            if (canMoveA)
+            {
+                best = { CollapseError(positions, normals, normalWeightSq, quadrics, a, b), a, b };
+            }
+            if (canMoveB)
+            {
+                const float cost = CollapseError(positions, normals, normalWeightSq, quadrics, b, a);
+                if (cost < best.Error)
+                {
+                    best = { cost, b, a };
+                }
+            }
+
+            if (canMoveA || canMoveB)
+            {
+                collapses.push_back(best);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), uint8_t(0));
+
+        const size_t excess = indices.size() / 3 - options.TargetTriangleCount;
+        size_t removed = 0;
+        uint32_t collapseCount = 0;
+        bool reachedMaxError = false;
+
+        for (const Collapse& c : collapses)
+        {
+            if (c.Error > maxErrorSq)
+            {
+                reachedMaxError = true;
+                break;
+            }
+
+            if (touched[c.From] || touched[c.To])
+                continue;
+
+            if (!IsCollapseValid(positions, indices, adjacency, c.From, c.To, options.KeepInside))
+                continue;
+
+            // Freeze the one-ring of from: its triangles change shape, so later tests this pass
+            // would read stale adjacency.
+            for (uint32_t i = adjacency.Offsets[c.From]; i < adjacency.Offsets[c.From + 1]; ++i)
+            {
+                const uint32_t* tri = &indices[adjacency.Triangles[i] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+
+                removed += tri[0] == c.To || tri[1] == c.To || tri[2] == c.To;
+            }
+            touched[c.To] = 1;
+
+            remap[c.From] = c.To;
+            AddQuadric(quadrics[c.To], quadrics[c.From]);
+            worstError = max(worstError, c.Error);
+            ++collapseCount;
+
+            if (removed >= excess)
+                break;
+        }
+
+        if (collapseCount == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const uint32_t a = remap[indices[i]];
+            const uint32_t b = remap[indices[i + 1]];
+            const uint32_t c = remap[indices[i + 2]];
+
+            if (a != b && b != c && c != a)
+            {
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+        }
+        indices.resize(write);
+
+        if (reachedMaxError)
+            break;
+    }
+
+    if (error)
+    {
+        *error = sqrtf(worstError);
+    }
+
+    return S_OK;
+}
+
+void SimplifiedMesh::AttachTo(Mesh& mesh)
+{
+    for (uint32_t slot = 0; slot < Vertices.size(); ++slot)
+    {
+        mesh.Vertices[slot] = MakeSpan(Vertices[slot].data(), static_cast<uint32_t>(Vertices[slot].size()));
+    }
+    mesh.VertexCount = VertexCount;
+
+    mesh.Indices = MakeSpan(Indices.data(), static_cast<uint32_t>(Indices.size()));
+    mesh.IndexCount = static_cast<uint32_t>(Indices.size() / mesh.IndexSize);
+    mesh.IndexSubsets = MakeSpan(IndexSubsets.data(), static_cast<uint32_t>(IndexSubsets.size()));
+
+    Meshlets.AttachTo(mesh);
+    mesh.ComputeBounds();
+
+    mesh.VBViews.clear();
+    mesh.IBView = D3D12_INDEX_BUFFER_VIEW();
+    mesh.VertexBuffers.clear();
+    mesh.IndexBuffer = GeometryAllocation();
+    mesh.MeshletBuffer = GeometryAllocation();
+    mesh.UniqueVertexIndexBuffer = GeometryAllocation();
+    mesh.PrimitiveIndexBuffer = GeometryAllocation();
+    mesh.CullDataBuffer = GeometryAllocation();
+    mesh.MeshInfoBuffer = GeometryAllocation();
+}
+
+HRESULT SimplifyMesh(const Mesh& mesh, SimplifiedMesh& simplified, const SimplifyOptions& options,
+    const MeshletGeneratorOptions& meshletOptions, ThreadPool& pool)
+{
+    if (mesh.IndexSize != 2 && mesh.IndexSize != 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    const uint32_t subsetCount = static_cast<uint32_t>(mesh.IndexSubsets.size());
+
+    // Triangles in the subsets before each one, and in all of them.
+    std::vector<uint64_t> trianglesBefore(subsetCount + 1, 0);
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const Subset& subset = mesh.IndexSubsets[s];
+        if (size_t(subset.Offset) + subset.Count > mesh.IndexCount || subset.Count % 3 != 0)
+        {
+            return E_INVALIDARG;
+        }
+        trianglesBefore[s + 1] = trianglesBefore[s] + subset.Count / 3;
+    }
+
+    const uint64_t triangleCount = trianglesBefore[subsetCount];
+
+    // Work on packed copies of the attributes, and lock the vertices where subsets meet.
+    const PositionStream positionStream = mesh.GetPositions();
+    const PositionStream normalStream = mesh.GetNormals();
+
+    std::vector<XMFLOAT3> positions(mesh.VertexCount);
+    std::vector<XMFLOAT3> normals(normalStream.Data && options.NormalWeight > 0.0f ? mesh.VertexCount : 0);
+
+    for (uint32_t v = 0; v < mesh.VertexCount; ++v)
+    {
+        positions[v] = positionStream[v];
+    }
+    for (uint32_t v = 0; v < normals.size(); ++v)
+    {
+        normals[v] = normalStream[v];
+    }
+
+    std::vector<uint32_t> owner(mesh.VertexCount, UINT32_MAX);
+    std::vector<uint8_t> locked(mesh.VertexCount);
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const Subset& subset = mesh.IndexSubsets[s];
+        for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+        {
+            const uint32_t v = mesh.GetIndex(i);
+            if (v >= mesh.VertexCount)
+            {
+                return E_INVALIDARG;
+            }
+
+            if (owner[v] == UINT32_MAX)
+            {
+                owner[v] = s;
+            }
+            else if (owner[v] != s)
+            {
+                locked[v] = 1;
+            }
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> subsetIndices(subsetCount);
+    std::vector<HRESULT> results(subsetCount, S_OK);
+
+    simplified = SimplifiedMesh();
+    simplified.SubsetErrors.resize(subsetCount);
+
+    pool.ParallelFor(subsetCount, [&](uint32_t s)
+    {
+        const Subset& subset = mesh.IndexSubsets[s];
+
+        std::vector<uint32_t>& indices = subsetIndices[s];
+        indices.resize(subset.Count);
+        for (uint32_t i = 0; i < subset.Count; ++i)
+        {
+            indices[i] = mesh.GetIndex(subset.Offset + i);
+        }
+
+        // Rounding the running total rather than each share keeps the shares summing to the target.
+        SimplifyOptions subsetOptions = options;
+        subsetOptions.TargetTriangleCount = triangleCount == 0 ? 0 :
+            static_cast<uint32_t>(options.TargetTriangleCount * trianglesBefore[s + 1] / triangleCount - options.TargetTriangleCount * trianglesBefore[s] / triangleCount);
+
+        results[s] = SimplifyTriangles(positions.data(), normals.empty() ? nullptr : normals.data(), mesh.VertexCount, locked.data(),
+            indices, subsetOptions, &simplified.SubsetErrors[s]);
+    });
+
+    for (HRESULT hr : results)
+    {
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    // Renumber the surviving vertices in order of first use and copy them out of every stream.
+    std::vector<uint32_t> remap(mesh.VertexCount, UINT32_MAX);
+    std::vector<uint32_t> sources;
+
+    for (auto& indices : subsetIndices)
+    {
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == UINT32_MAX)
+            {
+                remap[index] = static_cast<uint32_t>(sources.size());
+                sources.push_back(index);
+            }
+            index = remap[index];
+        }
+    }
+
+    simplified.VertexCount = static_cast<uint32_t>(sources.size());
+    simplified.Vertices.resize(mesh.Vertices.size());
+
+    for (uint32_t slot = 0; slot < mesh.Vertices.size(); ++slot)
+    {
+        const uint32_t stride = mesh.VertexStrides[slot];
+        const uint8_t* src = mesh.Vertices[slot].data();
+
+        std::vector<uint8_t>& dst = simplified.Vertices[slot];
+        dst.resize(size_t(stride) * sources.size());
+
+        for (uint32_t v = 0; v < sources.size(); ++v)
+        {
+            std::memcpy(&dst[size_t(v) * stride], src + size_t(sources[v]) * stride, stride);
+        }
+    }
+
+    for (auto& indices : subsetIndices)
+    {
+        Subset subset;
+        subset.Offset = static_cast<uint32_t>(simplified.Indices.size() / mesh.IndexSize);
+        subset.Count = static_cast<uint32_t>(indices.size());
+        simplified.IndexSubsets.push_back(subset);
+
+        for (uint32_t index : indices)
+        {
+            if (mesh.IndexSize == 4)
+            {
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&index);
+                simplified.Indices.insert(simplified.Indices.end(), bytes, bytes + 4);
+            }
+            else
+            {
+                const uint16_t index16 = static_cast<uint16_t>(index);
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&index16);
+                simplified.Indices.insert(simplified.Indices.end(), bytes, bytes + 2);
+            }
+        }
+    }
+
+    // GenerateMeshlets reads only the vertex layout and streams and the index buffer, so the view
+    // copies nothing else; the source's meshlets and the cull data derived from them would be stale.
+    Mesh view;
+    std::copy(std::begin(mesh.LayoutElems), std::end(mesh.LayoutElems), view.LayoutElems);
+    view.LayoutDesc.pInputElementDescs = view.LayoutElems;
+    view.LayoutDesc.NumElements = mesh.LayoutDesc.NumElements;
+    view.VertexStrides = mesh.VertexStrides;
+    view.Vertices.resize(simplified.Vertices.size());
+    for (uint32_t slot = 0; slot < simplified.Vertices.size(); ++slot)
+    {
+        view.Vertices[slot] = MakeSpan(simplified.Vertices[slot].data(), static_cast<uint32_t>(simplified.Vertices[slot].size()));
+    }
+    view.VertexCount = simplified.VertexCount;
+    view.IndexSize = mesh.IndexSize;
+    view.Indices = MakeSpan(simplified.Indices.data(), static_cast<uint32_t>(simplified.Indices.size()));
+    view.IndexCount = static_cast<uint32_t>(simplified.Indices.size() / mesh.IndexSize);
+    view.IndexSubsets = MakeSpan(simplified.IndexSubsets.data(), static_cast<uint32_t>(simplified.IndexSubsets.size()));
+
+    return GenerateMeshlets(view, simplified.Meshlets, meshletOptions, pool);
+}
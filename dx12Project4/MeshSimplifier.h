@@ -0,0 +1,71 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "MeshletGenerator.h"
+
+#include <DirectXMath.h>
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+struct SimplifyOptions
+{
+    uint32_t TargetTriangleCount = 0;   // Stop once no more than this many triangles remain
+    float    MaxError = FLT_MAX;        // Skip collapses whose error would exceed this, in position units
+    float    NormalWeight = 0.0f;       // Position units charged per unit of normal deviation; 0 ignores normals
+    bool     KeepInside = false;        // Only make collapses that move the surface inwards
+};
+
+// Reduces an indexed triangle list with quadric error metric edge collapses. Each collapse moves one
+// endpoint of an edge onto the other, so the result indexes the same vertices and none are created.
+// Vertices flagged in locked (which may be null) never move, which keeps borders shared with other
+// geometry intact; open edges are also weighted to hold their shape. Collapses that would flip a
+// triangle are rejected, and triangles that become degenerate are removed.
+//
+// With KeepInside, a vertex may only move onto a point on or behind the plane of every triangle
+// around it, as in the inner progressive hull (Sander et al.), and vertices on open edges don't
+// move, so the result never reaches outside the original surface. Triangles face the side from
+// which they appear clockwise, as the renderer draws them in its right-handed world space. Fewer
+// collapses qualify, so TargetTriangleCount may not be reached.
+//
+// The error of a collapse is the area-weighted RMS distance of the merged vertex from the planes of
+// the triangles it has absorbed. With normals (which may be null) and a NormalWeight, the RMS
+// deviation of the kept vertex's normal from the absorbed vertices' normals is added, scaled by
+// NormalWeight. error, if given, receives the largest error of any collapse made.
+HRESULT SimplifyTriangles(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals, uint32_t vertexCount, const uint8_t* locked,
+    std::vector<uint32_t>& indices, const SimplifyOptions& options, float* error = nullptr);
+
+// A simplified copy of a mesh: the vertices its triangles still use, its index buffer and subsets,
+// and meshlets regenerated from them, laid out as the Mesh spans and MSHL files expect.
+struct SimplifiedMesh
+{
+    uint32_t                          VertexCount = 0;
+    std::vector<std::vector<uint8_t>> Vertices;         // Parallel to the source's Vertices, with the same strides
+    std::vector<uint8_t>              Indices;          // The source's IndexSize bytes per entry
+    std::vector<Subset>               IndexSubsets;
+    MeshletData                       Meshlets;
+    std::vector<float>                SubsetErrors;     // Largest collapse error in each subset
+
+    // Points the spans of mesh, a copy of the source, at this data, which must outlive the mesh's use
+    // of it. Rebuilds the mesh's bounds, drops the SoA cull data and meshlet tree derived from the
+    // source's meshlets, and drops the GPU resources it shared with the source, so the mesh can be
+    // written with WriteModelFile or uploaded afresh.
+    void AttachTo(Mesh& mesh);
+};
+
+// Simplifies each index subset of the mesh independently and in parallel on the pool. Vertices
+// shared between subsets are locked so the subsets still meet. TargetTriangleCount applies to the
+// whole mesh and is shared out in proportion to each subset's triangles; the normal cost reads the
+// mesh's normals when it has them.
+HRESULT SimplifyMesh(const Mesh& mesh, SimplifiedMesh& simplified, const SimplifyOptions& options,
+    const MeshletGeneratorOptions& meshletOptions = MeshletGeneratorOptions(), ThreadPool& pool = ThreadPool::GetDefault());
@@ -0,0 +1,280 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "MeshSimplifier.h"
+#include "ModelWriter.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    // The clockwise face normal of a triangle, unnormalized.
+    XMVECTOR FaceNormal(const XMFLOAT3* positions, uint32_t i0, uint32_t i1, uint32_t i2)
+    {
+        const XMVECTOR a = XMLoadFloat3(&positions[i0]);
+        const XMVECTOR b = XMLoadFloat3(&positions[i1]);
+        const XMVECTOR c = XMLoadFloat3(&positions[i2]);
+        return XMVector3Cross(XMVectorSubtract(c, a), XMVectorSubtract(b, a));
+    }
+
+    // Triangles with a repeated or out-of-range index.
+    uint32_t CountBadTriangles(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        uint32_t bad = 0;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            bad += a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || c == a;
+        }
+        return bad;
+    }
+
+    // Locked vertices the source uses that the result no longer does: each was collapsed onto
+    // another vertex, so its position has moved.
+    uint32_t CountMovedLockedVertices(const std::vector<uint32_t>& source, const std::vector<uint32_t>& result, const std::vector<uint8_t>& locked)
+    {
+        std::vector<uint8_t> used(locked.size());
+        for (uint32_t index : result)
+        {
+            used[index] = 1;
+        }
+
+        std::vector<uint8_t> moved(locked.size());
+        for (uint32_t index : source)
+        {
+            moved[index] = locked[index] && !used[index];
+        }
+        return static_cast<uint32_t>(std::count(moved.begin(), moved.end(), uint8_t(1)));
+    }
+
+    // A wavy wall facing +z, with the column of vertices down its middle locked, simplified to a
+    // quarter of its triangles. The column must survive, and every triangle must still face +z.
+    uint32_t CheckWall()
+    {
+        PositionMesh wall;
+        if (FAILED(BuildWall(0.1f, 2.0f, false, wall)))
+        {
+            return Check(false, "MeshSimplifier: failed to build the wall\n");
+        }
+
+        const uint32_t vertexCount = static_cast<uint32_t>(wall.Positions.size());
+        std::vector<uint8_t> locked(vertexCount);
+        for (uint32_t j = 0; j <= c_wallQuads; ++j)
+        {
+            locked[j * (c_wallQuads + 1) + c_wallQuads / 2] = 1;
+        }
+
+        SimplifyOptions options;
+        options.TargetTriangleCount = static_cast<uint32_t>(wall.Indices.size() / 3 / 4);
+
+        std::vector<uint32_t> indices = wall.Indices;
+        if (FAILED(SimplifyTriangles(wall.Positions.data(), nullptr, vertexCount, locked.data(), indices, options)))
+        {
+            return Check(false, "MeshSimplifier: failed to simplify the wall\n");
+        }
+
+        uint32_t flipped = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            flipped += XMVectorGetZ(FaceNormal(wall.Positions.data(), indices[i], indices[i + 1], indices[i + 2])) <= 0.0f;
+        }
+
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        uint32_t errors = Check(indices.size() % 3 == 0 && triangleCount <= options.TargetTriangleCount,
+            "MeshSimplifier: the wall kept %u triangles for a target of %u\n", triangleCount, options.TargetTriangleCount);
+        errors += Check(CountBadTriangles(indices, vertexCount) == 0, "MeshSimplifier: the wall has degenerate or out-of-range triangles\n");
+        errors += Check(CountMovedLockedVertices(wall.Indices, indices, locked) == 0, "MeshSimplifier: locked vertices of the wall moved\n");
+        errors += Check(flipped == 0, "MeshSimplifier: %u triangles of the wall turned away from +z\n", flipped);
+        return errors;
+    }
+
+    // A closed sphere of unit radius around the origin, simplified to an eighth of its triangles.
+    // It stays star-shaped around the origin, so every triangle must still face outwards.
+    uint32_t CheckSphere()
+    {
+        const uint32_t rings = 24;
+        const uint32_t segments = 48;
+
+        // A vertex at each pole, and segments around each ring in between.
+        std::vector<XMFLOAT3> positions;
+        positions.push_back(XMFLOAT3(0, 1, 0));
+        for (uint32_t j = 1; j < rings; ++j)
+        {
+            const float theta = XM_PI * j / rings;
+            for (uint32_t i = 0; i < segments; ++i)
+            {
+                const float phi = XM_2PI * i / segments;
+                positions.push_back(XMFLOAT3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)));
+            }
+        }
+        positions.push_back(XMFLOAT3(0, -1, 0));
+
+        const uint32_t south = static_cast<uint32_t>(positions.size() - 1);
+        auto ringVertex = [&](uint32_t j, uint32_t i) { return j == 0 ? 0 : j == rings ? south : 1 + (j - 1) * segments + i % segments; };
+
+        // Each triangle is wound to face away from the origin.
+        std::vector<uint32_t> source;
+        auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c)
+        {
+            if (a == b || b == c || c == a)
+                return;
+
+            const XMVECTOR centroid = XMVectorAdd(XMVectorAdd(XMLoadFloat3(&positions[a]), XMLoadFloat3(&positions[b])), XMLoadFloat3(&positions[c]));
+            const bool outwards = XMVectorGetX(XMVector3Dot(FaceNormal(positions.data(), a, b, c), centroid)) > 0.0f;
+
+            const uint32_t triangle[] = { a, outwards ? b : c, outwards ? c : b };
+            source.insert(source.end(), triangle, triangle + 3);
+        };
+
+        for (uint32_t j = 0; j < rings; ++j)
+        {
+            for (uint32_t i = 0; i < segments; ++i)
+            {
+                addTriangle(ringVertex(j, i), ringVertex(j, i + 1), ringVertex(j + 1, i + 1));
+                addTriangle(ringVertex(j, i), ringVertex(j + 1, i + 1), ringVertex(j + 1, i));
+            }
+        }
+
+        const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+
+        SimplifyOptions options;
+        options.TargetTriangleCount = static_cast<uint32_t>(source.size() / 3 / 8);
+
+        std::vector<uint32_t> indices = source;
+        if (FAILED(SimplifyTriangles(positions.data(), nullptr, vertexCount, nullptr, indices, options)))
+        {
+            return Check(false, "MeshSimplifier: failed to simplify the sphere\n");
+        }
+
+        uint32_t flipped = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const XMVECTOR centroid = XMVectorAdd(XMVectorAdd(XMLoadFloat3(&positions[indices[i]]), XMLoadFloat3(&positions[indices[i + 1]])),
+                XMLoadFloat3(&positions[indices[i + 2]]));
+            flipped += XMVectorGetX(XMVector3Dot(FaceNormal(positions.data(), indices[i], indices[i + 1], indices[i + 2]), centroid)) <= 0.0f;
+        }
+
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        uint32_t errors = Check(indices.size() % 3 == 0 && triangleCount <= options.TargetTriangleCount,
+            "MeshSimplifier: the sphere kept %u triangles for a target of %u\n", triangleCount, options.TargetTriangleCount);
+        errors += Check(CountBadTriangles(indices, vertexCount) == 0, "MeshSimplifier: the sphere has degenerate or out-of-range triangles\n");
+        errors += Check(flipped == 0, "MeshSimplifier: %u triangles of the sphere turned inwards\n", flipped);
+        return errors;
+    }
+
+    std::array<float, 3> PositionKey(const XMFLOAT3& position)
+    {
+        return std::array<float, 3>{ { position.x, position.y, position.z } };
+    }
+
+    // Simplifies every mesh of the asset to half its triangles. Each must meet the target, and the
+    // vertices where its subsets meet, which SimplifyMesh locks, must keep their positions. The
+    // first mesh is written through the MSHL path and must reload unchanged.
+    uint32_t CheckAsset(const Model& model, const wchar_t* filename)
+    {
+        const wchar_t* copyPath = L"MeshSimplifierTests.lod.bin";
+
+        uint32_t errors = 0;
+        bool first = true;
+
+        for (auto& mesh : model)
+        {
+            SimplifyOptions options;
+            options.TargetTriangleCount = mesh.IndexCount / 3 / 2;
+
+            SimplifiedMesh simplified;
+            if (FAILED(SimplifyMesh(mesh, simplified, options)))
+            {
+                errors += Check(false, "MeshSimplifier: failed to simplify %ls\n", filename);
+                continue;
+            }
+
+            Mesh lod = mesh;
+            simplified.AttachTo(lod);
+
+            const uint32_t triangleCount = lod.IndexCount / 3;
+            errors += Check(triangleCount <= options.TargetTriangleCount, "MeshSimplifier: %ls kept %u triangles for a target of %u\n",
+                filename, triangleCount, options.TargetTriangleCount);
+
+            // The vertices used by more than one subset.
+            std::vector<uint32_t> owner(mesh.VertexCount, UINT32_MAX);
+            std::vector<uint8_t> shared(mesh.VertexCount);
+            for (uint32_t s = 0; s < mesh.IndexSubsets.size(); ++s)
+            {
+                const Subset& subset = mesh.IndexSubsets[s];
+                for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+                {
+                    const uint32_t v = mesh.GetIndex(i);
+                    shared[v] |= owner[v] != UINT32_MAX && owner[v] != s;
+                    owner[v] = s;
+                }
+            }
+
+            std::vector<std::array<float, 3>> kept;
+            const PositionStream lodPositions = lod.GetPositions();
+            for (uint32_t i = 0; i < lod.IndexCount; ++i)
+            {
+                kept.push_back(PositionKey(lodPositions[lod.GetIndex(i)]));
+            }
+            std::sort(kept.begin(), kept.end());
+
+            const PositionStream positions = mesh.GetPositions();
+            uint32_t moved = 0;
+            for (uint32_t v = 0; v < mesh.VertexCount; ++v)
+            {
+                moved += shared[v] && !std::binary_search(kept.begin(), kept.end(), PositionKey(positions[v]));
+            }
+            errors += Check(moved == 0, "MeshSimplifier: %u vertices shared between subsets of %ls moved\n", moved, filename);
+
+            if (!first)
+            {
+                continue;
+            }
+            first = false;
+
+            Model reloaded;
+            const bool loaded = SUCCEEDED(WriteModelFile(copyPath, &lod, 1)) && SUCCEEDED(reloaded.LoadFromFile(copyPath));
+            errors += Check(loaded && reloaded.GetMeshCount() == 1 && SameMesh(lod, reloaded.GetMesh(0)),
+                "MeshSimplifier: the simplified %ls doesn't survive a write and reload\n", filename);
+        }
+
+        _wremove(copyPath);
+        return errors;
+    }
+}
+
+// Simplifies hand-built meshes whose every triangle's facing is known, then every bundled asset.
+uint32_t Tests::TestMeshSimplifier(const std::wstring& assetDirectory)
+{
+    uint32_t errors = CheckWall();
+    errors += CheckSphere();
+
+    for (auto filename : c_assetFilenames)
+    {
+        const std::wstring path = assetDirectory + filename;
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            return errors + Check(false, "Failed to load %ls\n", path.c_str());
+        }
+
+        errors += CheckAsset(model, filename);
+    }
+    return errors;
+}
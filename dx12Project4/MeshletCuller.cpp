@@ -0,0 +1,791 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "MeshletCuller.h"
+
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CULL_AVX_FUNCTION
+#else
+#define CULL_AVX_FUNCTION __attribute__((target("avx")))
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    const float c_degenerateCone = 255.0f;
+
+    uint32_t LoadCone(const CullData& c)
+    {
+        uint32_t packed;
+        std::memcpy(&packed, c.NormalCone, sizeof(packed));
+        return packed;
+    }
+
+    // Reference implementation, written to match IsVisible line for line.
+    bool IsVisibleScalar(const CullData& c, const MeshletCullParams& p)
+    {
+        const float (&w)[4][4] = p.World.m;
+
+        const float cx = c.BoundingSphere.x * w[0][0] + c.BoundingSphere.y * w[1][0] + c.BoundingSphere.z * w[2][0] + w[3][0];
+        const float cy = c.BoundingSphere.x * w[0][1] + c.BoundingSphere.y * w[1][1] + c.BoundingSphere.z * w[2][1] + w[3][1];
+        const float cz = c.BoundingSphere.x * w[0][2] + c.BoundingSphere.y * w[1][2] + c.BoundingSphere.z * w[2][2] + w[3][2];
+        const float radius = c.BoundingSphere.w * p.Scale;
+
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            const XMFLOAT4& plane = p.Planes[i];
+            if (cx * plane.x + cy * plane.y + cz * plane.z + plane.w < -radius)
+            {
+                return false;
+            }
+        }
+
+        if (c.NormalCone[3] == 0xFF)
+        {
+            return true;
+        }
+
+        const float cutoff = c.NormalCone[3] / 255.0f;
+        const float ax = c.NormalCone[0] / 255.0f * 2.0f - 1.0f;
+        const float ay = c.NormalCone[1] / 255.0f * 2.0f - 1.0f;
+        const float az = c.NormalCone[2] / 255.0f * 2.0f - 1.0f;
+
+        float tx = ax * w[0][0] + ay * w[1][0] + az * w[2][0];
+        float ty = ax * w[0][1] + ay * w[1][1] + az * w[2][1];
+        float tz = ax * w[0][2] + ay * w[1][2] + az * w[2][2];
+
+        const float axisLength = sqrtf(tx * tx + ty * ty + tz * tz);
+        tx = tx / axisLength;
+        ty = ty / axisLength;
+        tz = tz / axisLength;
+
+        const float offset = c.ApexOffset * p.Scale;
+
+        float vx = p.ViewPosition.x - (cx - tx * offset);
+        float vy = p.ViewPosition.y - (cy - ty * offset);
+        float vz = p.ViewPosition.z - (cz - tz * offset);
+
+        const float viewLength = sqrtf(vx * vx + vy * vy + vz * vz);
+        vx = vx / viewLength;
+        vy = vy / viewLength;
+        vz = vz / viewLength;
+
+        return !(vx * -tx + vy * -ty + vz * -tz > cutoff);
+    }
+
+    // Appends first + k for each set bit k of mask. Every lane is written and only visible ones
+    // advance the cursor, so there are no branches. The cursor never passes the number of meshlets
+    // tested so far, so the stray writes land at most one slot past the last meshlet tested.
+    uint32_t Compact(uint32_t* out, uint32_t count, uint32_t first, uint32_t mask, uint32_t laneCount)
+    {
+        for (uint32_t k = 0; k < laneCount; ++k)
+        {
+            out[count] = first + k;
+            count += (mask >> k) & 1;
+        }
+        return count;
+    }
+
+    // Bits of the group of lanes starting at meshlet g that fall inside [first, end).
+    uint32_t RangeMask(uint32_t g, uint32_t first, uint32_t end, uint32_t laneCount)
+    {
+        const uint32_t lo = first > g ? first - g : 0;
+        const uint32_t hi = min(end - g, laneCount);
+        return ((1u << hi) - 1) & ~((1u << lo) - 1);
+    }
+
+    //
+    // SSE: four meshlets per group
+    //
+
+    struct SseConstants
+    {
+        __m128 World[4][3];
+        __m128 Planes[6][4];
+        __m128 View[3];
+        __m128 Scale;
+    };
+
+    void LoadConstants(const MeshletCullParams& p, SseConstants& k)
+    {
+        for (uint32_t r = 0; r < 4; ++r)
+            for (uint32_t c = 0; c < 3; ++c)
+                k.World[r][c] = _mm_set1_ps(p.World.m[r][c]);
+
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            k.Planes[i][0] = _mm_set1_ps(p.Planes[i].x);
+            k.Planes[i][1] = _mm_set1_ps(p.Planes[i].y);
+            k.Planes[i][2] = _mm_set1_ps(p.Planes[i].z);
+            k.Planes[i][3] = _mm_set1_ps(p.Planes[i].w);
+        }
+
+        k.View[0] = _mm_set1_ps(p.ViewPosition.x);
+        k.View[1] = _mm_set1_ps(p.ViewPosition.y);
+        k.View[2] = _mm_set1_ps(p.ViewPosition.z);
+        k.Scale = _mm_set1_ps(p.Scale);
+    }
+
+    // Unpacks four packed cones into per-byte float vectors.
+    void UnpackCones(__m128i packed, __m128 (&bytes)[4])
+    {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+
+        bytes[0] = _mm_cvtepi32_ps(_mm_and_si128(packed, mask));
+        bytes[1] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 8), mask));
+        bytes[2] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 16), mask));
+        bytes[3] = _mm_cvtepi32_ps(_mm_srli_epi32(packed, 24));
+    }
+
+    // Joins four ConeAxis words with their ConeCutoff bytes into the packed NormalCone layout.
+    __m128i LoadConesSoA(const CullDataSoA& d, uint32_t g)
+    {
+        int cutoff;
+        std::memcpy(&cutoff, d.ConeCutoff + g, sizeof(cutoff));
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i w = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(cutoff), zero), zero);
+        const __m128i axis = _mm_load_si128(reinterpret_cast<const __m128i*>(d.ConeAxis + g));
+
+        return _mm_or_si128(axis, _mm_slli_epi32(w, 24));
+    }
+
+    // Moves the sphere centres to world space and returns the lanes outside any frustum plane.
+    __m128 FrustumCulledSse(__m128 x, __m128 y, __m128 z, __m128 r, const SseConstants& k, __m128 (&center)[3])
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            center[c] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, k.World[0][c]), _mm_mul_ps(y, k.World[1][c])), _mm_mul_ps(z, k.World[2][c])), k.World[3][c]);
+        }
+
+        const __m128 negRadius = _mm_xor_ps(_mm_mul_ps(r, k.Scale), _mm_set1_ps(-0.0f));
+
+        __m128 culled = _mm_setzero_ps();
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(center[0], k.Planes[i][0]), _mm_mul_ps(center[1], k.Planes[i][1])), _mm_mul_ps(center[2], k.Planes[i][2])), k.Planes[i][3]);
+            culled = _mm_or_ps(culled, _mm_cmplt_ps(d, negRadius));
+        }
+        return culled;
+    }
+
+    // Returns the lanes whose normal cone faces away from the view position. Degenerate cones never cull.
+    __m128 ConeCulledSse(const __m128 (&center)[3], const __m128 (&cone)[4], __m128 apexOffset, const SseConstants& k)
+    {
+        const __m128 unorm = _mm_set1_ps(255.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        const __m128 cutoff = _mm_div_ps(cone[3], unorm);
+        const __m128 degenerate = _mm_cmpeq_ps(cone[3], _mm_set1_ps(c_degenerateCone));
+
+        const __m128 ax = _mm_sub_ps(_mm_mul_ps(_mm_div_ps(cone[0], unorm), two), one);
+        const __m128 ay = _mm_sub_ps(_mm_mul_ps(_mm_div_ps(cone[1], unorm), two), one);
+        const __m128 az = _mm_sub_ps(_mm_mul_ps(_mm_div_ps(cone[2], unorm), two), one);
+
+        __m128 tx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, k.World[0][0]), _mm_mul_ps(ay, k.World[1][0])), _mm_mul_ps(az, k.World[2][0]));
+        __m128 ty = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, k.World[0][1]), _mm_mul_ps(ay, k.World[1][1])), _mm_mul_ps(az, k.World[2][1]));
+        __m128 tz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, k.World[0][2]), _mm_mul_ps(ay, k.World[1][2])), _mm_mul_ps(az, k.World[2][2]));
+
+        const __m128 axisLength = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz)));
+        tx = _mm_div_ps(tx, axisLength);
+        ty = _mm_div_ps(ty, axisLength);
+        tz = _mm_div_ps(tz, axisLength);
+
+        const __m128 offset = _mm_mul_ps(apexOffset, k.Scale);
+
+        __m128 vx = _mm_sub_ps(k.View[0], _mm_sub_ps(center[0], _mm_mul_ps(tx, offset)));
+        __m128 vy = _mm_sub_ps(k.View[1], _mm_sub_ps(center[1], _mm_mul_ps(ty, offset)));
+        __m128 vz = _mm_sub_ps(k.View[2], _mm_sub_ps(center[2], _mm_mul_ps(tz, offset)));
+
+        const __m128 viewLength = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        vx = _mm_div_ps(vx, viewLength);
+        vy = _mm_div_ps(vy, viewLength);
+        vz = _mm_div_ps(vz, viewLength);
+
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_xor_ps(tx, signBit)), _mm_mul_ps(vy, _mm_xor_ps(ty, signBit))), _mm_mul_ps(vz, _mm_xor_ps(tz, signBit)));
+
+        return _mm_andnot_ps(degenerate, _mm_cmpgt_ps(d, cutoff));
+    }
+
+    uint32_t VisibleMaskSse(const CullData* c, const SseConstants& k)
+    {
+        // Transpose the four spheres into x, y, z and radius vectors.
+        __m128 sx = _mm_loadu_ps(&c[0].BoundingSphere.x);
+        __m128 sy = _mm_loadu_ps(&c[1].BoundingSphere.x);
+        __m128 sz = _mm_loadu_ps(&c[2].BoundingSphere.x);
+        __m128 sr = _mm_loadu_ps(&c[3].BoundingSphere.x);
+        _MM_TRANSPOSE4_PS(sx, sy, sz, sr);
+
+        __m128 center[3];
+        __m128 culled = FrustumCulledSse(sx, sy, sz, sr, k, center);
+
+        __m128 cone[4];
+        UnpackCones(_mm_setr_epi32(LoadCone(c[0]), LoadCone(c[1]), LoadCone(c[2]), LoadCone(c[3])), cone);
+
+        const __m128 apexOffset = _mm_setr_ps(c[0].ApexOffset, c[1].ApexOffset, c[2].ApexOffset, c[3].ApexOffset);
+        culled = _mm_or_ps(culled, ConeCulledSse(center, cone, apexOffset, k));
+
+        return static_cast<uint32_t>(_mm_movemask_ps(culled)) ^ 0xF;
+    }
+
+    // As VisibleMaskSse for the aligned group of four starting at meshlet g.
+    uint32_t VisibleMaskSoASse(const CullDataSoA& d, uint32_t g, const SseConstants& k)
+    {
+        __m128 center[3];
+        __m128 culled = FrustumCulledSse(_mm_load_ps(d.CenterX + g), _mm_load_ps(d.CenterY + g), _mm_load_ps(d.CenterZ + g), _mm_load_ps(d.Radius + g), k, center);
+
+        // Leave the cone arrays untouched when the frustum rejects the whole group.
+        if (_mm_movemask_ps(culled) == 0xF)
+        {
+            return 0;
+        }
+
+        __m128 cone[4];
+        UnpackCones(LoadConesSoA(d, g), cone);
+
+        culled = _mm_or_ps(culled, ConeCulledSse(center, cone, _mm_load_ps(d.ApexOffset + g), k));
+
+        return static_cast<uint32_t>(_mm_movemask_ps(culled)) ^ 0xF;
+    }
+
+    uint32_t CullRangeSse(const CullData* cullData, uint32_t first, uint32_t end, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        SseConstants k;
+        LoadConstants(params, k);
+
+        uint32_t i = first;
+        for (; i + 8 <= end; i += 8)
+        {
+            const uint32_t mask = VisibleMaskSse(cullData + i, k) | (VisibleMaskSse(cullData + i + 4, k) << 4);
+            count = Compact(out, count, i, mask, 8);
+        }
+
+        for (; i < end; ++i)
+        {
+            out[count] = i;
+            count += IsVisibleScalar(cullData[i], params);
+        }
+
+        return count;
+    }
+
+    // Walks whole aligned groups, including the partial ones at either end of the range, and
+    // masks off the lanes outside it.
+    uint32_t CullRangeSoASse(const CullDataSoA& d, uint32_t first, uint32_t end, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        SseConstants k;
+        LoadConstants(params, k);
+
+        for (uint32_t g = first & ~7u; g < end; g += 8)
+        {
+            const uint32_t mask = VisibleMaskSoASse(d, g, k) | (VisibleMaskSoASse(d, g + 4, k) << 4);
+            count = Compact(out, count, g, mask & RangeMask(g, first, end, 8), 8);
+        }
+
+        return count;
+    }
+
+    //
+    // Meshlet tree: four child slots per node
+    //
+
+    const uint32_t c_maxTreeDepth = 32;
+
+    // Returns the slots of the node that can be rejected outright: those whose sphere is outside a
+    // frustum plane, and those whose every triangle faces away from the view position. For a slot with
+    // world-space centre c, radius r and cone (a, sin h), every point p of the sphere and normal n of
+    // the cone satisfy dot(n, p - v) > 0 when dot(a, c - v) > sin h * |c - v| + r * (1 + sin h).
+    uint32_t RejectedSlots(const MeshletTreeNode& node, const SseConstants& k)
+    {
+        __m128 center[3];
+        const __m128 radius = _mm_load_ps(node.Radius);
+        const __m128 culled = FrustumCulledSse(_mm_load_ps(node.CenterX), _mm_load_ps(node.CenterY), _mm_load_ps(node.CenterZ), radius, k, center);
+
+        const __m128 ax = _mm_load_ps(node.ConeX);
+        const __m128 ay = _mm_load_ps(node.ConeY);
+        const __m128 az = _mm_load_ps(node.ConeZ);
+        const __m128 coneSin = _mm_load_ps(node.ConeSin);
+
+        const __m128 tx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, k.World[0][0]), _mm_mul_ps(ay, k.World[1][0])), _mm_mul_ps(az, k.World[2][0]));
+        const __m128 ty = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, k.World[0][1]), _mm_mul_ps(ay, k.World[1][1])), _mm_mul_ps(az, k.World[2][1]));
+        const __m128 tz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, k.World[0][2]), _mm_mul_ps(ay, k.World[1][2])), _mm_mul_ps(az, k.World[2][2]));
+
+        const __m128 vx = _mm_sub_ps(center[0], k.View[0]);
+        const __m128 vy = _mm_sub_ps(center[1], k.View[1]);
+        const __m128 vz = _mm_sub_ps(center[2], k.View[2]);
+
+        // World is a uniform scale times a rotation, so dividing by Scale renormalizes the axis.
+        const __m128 along = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, tx), _mm_mul_ps(vy, ty)), _mm_mul_ps(vz, tz)), k.Scale);
+        const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+
+        const __m128 bound = _mm_add_ps(_mm_mul_ps(coneSin, distance), _mm_mul_ps(_mm_mul_ps(radius, k.Scale), _mm_add_ps(coneSin, _mm_set1_ps(1.0f))));
+        const __m128 backFacing = _mm_cmpgt_ps(along, bound);
+
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_or_ps(culled, backFacing)));
+    }
+
+    // Appends meshlets[k] for each set bit k of mask, like Compact.
+    uint32_t CompactLeaf(uint32_t* out, uint32_t count, const uint32_t* meshlets, uint32_t mask)
+    {
+        for (uint32_t k = 0; k < MeshletTree::LeafSize; ++k)
+        {
+            out[count] = meshlets[k];
+            count += (mask >> k) & 1;
+        }
+        return count;
+    }
+
+    // Walks the tree from root, handing the leaves that survive the node tests to cullLeaf.
+    template <typename CullLeaf>
+    uint32_t CullTree(const MeshletTree& tree, uint32_t root, const SseConstants& k, CullLeaf cullLeaf, uint32_t count)
+    {
+        // Each level pushes at most three more nodes than it pops.
+        uint32_t stack[c_maxTreeDepth * 3 + 1];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = root;
+
+        while (stackSize > 0)
+        {
+            const MeshletTreeNode& node = tree.Nodes[stack[--stackSize]];
+
+            const uint32_t rejected = RejectedSlots(node, k);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                if (rejected & (1u << i))
+                    continue;
+
+                if (node.LeafCount[i] > 0)
+                {
+                    count = cullLeaf(node.Child[i], node.LeafCount[i], count);
+                }
+                else
+                {
+                    stack[stackSize++] = node.Child[i];
+                }
+            }
+        }
+
+        return count;
+    }
+
+    // Leaves get the same per-meshlet test as the flat scan.
+    uint32_t CullTreeSse(const MeshletTree& tree, uint32_t root, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        SseConstants k;
+        LoadConstants(params, k);
+
+        return CullTree(tree, root, k, [&](uint32_t first, uint32_t leafCount, uint32_t n)
+        {
+            const uint32_t mask = VisibleMaskSoASse(tree.CullingData, first, k) | (VisibleMaskSoASse(tree.CullingData, first + 4, k) << 4);
+            return CompactLeaf(out, n, tree.MeshletIndices.data() + first, mask & ((1u << leafCount) - 1));
+        }, count);
+    }
+
+    //
+    // AVX: eight meshlets per group
+    //
+
+    struct AvxConstants
+    {
+        __m256 World[4][3];
+        __m256 Planes[6][4];
+        __m256 View[3];
+        __m256 Scale;
+    };
+
+    CULL_AVX_FUNCTION void LoadConstants(const MeshletCullParams& p, AvxConstants& k)
+    {
+        for (uint32_t r = 0; r < 4; ++r)
+            for (uint32_t c = 0; c < 3; ++c)
+                k.World[r][c] = _mm256_set1_ps(p.World.m[r][c]);
+
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            k.Planes[i][0] = _mm256_set1_ps(p.Planes[i].x);
+            k.Planes[i][1] = _mm256_set1_ps(p.Planes[i].y);
+            k.Planes[i][2] = _mm256_set1_ps(p.Planes[i].z);
+            k.Planes[i][3] = _mm256_set1_ps(p.Planes[i].w);
+        }
+
+        k.View[0] = _mm256_set1_ps(p.ViewPosition.x);
+        k.View[1] = _mm256_set1_ps(p.ViewPosition.y);
+        k.View[2] = _mm256_set1_ps(p.ViewPosition.z);
+        k.Scale = _mm256_set1_ps(p.Scale);
+    }
+
+    CULL_AVX_FUNCTION __m256 Combine(__m128 lo, __m128 hi)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    // Unpacks the cones of two groups of four into per-byte float vectors. Integer work stays
+    // 128 bits wide so that only AVX, not AVX2, is required.
+    CULL_AVX_FUNCTION void UnpackCones(__m128i lo, __m128i hi, __m256 (&bytes)[4])
+    {
+        __m128 coneBytes[2][4];
+        UnpackCones(lo, coneBytes[0]);
+        UnpackCones(hi, coneBytes[1]);
+
+        for (uint32_t b = 0; b < 4; ++b)
+        {
+            bytes[b] = Combine(coneBytes[0][b], coneBytes[1][b]);
+        }
+    }
+
+    CULL_AVX_FUNCTION __m256 FrustumCulledAvx(__m256 x, __m256 y, __m256 z, __m256 r, const AvxConstants& k, __m256 (&center)[3])
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            center[c] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, k.World[0][c]), _mm256_mul_ps(y, k.World[1][c])), _mm256_mul_ps(z, k.World[2][c])), k.World[3][c]);
+        }
+
+        const __m256 negRadius = _mm256_xor_ps(_mm256_mul_ps(r, k.Scale), _mm256_set1_ps(-0.0f));
+
+        __m256 culled = _mm256_setzero_ps();
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(center[0], k.Planes[i][0]), _mm256_mul_ps(center[1], k.Planes[i][1])), _mm256_mul_ps(center[2], k.Planes[i][2])), k.Planes[i][3]);
+            culled = _mm256_or_ps(culled, _mm256_cmp_ps(d, negRadius, _CMP_LT_OQ));
+        }
+        return culled;
+    }
+
+    CULL_AVX_FUNCTION __m256 ConeCulledAvx(const __m256 (&center)[3], const __m256 (&cone)[4], __m256 apexOffset, const AvxConstants& k)
+    {
+        const __m256 unorm = _mm256_set1_ps(255.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        const __m256 cutoff = _mm256_div_ps(cone[3], unorm);
+        const __m256 degenerate = _mm256_cmp_ps(cone[3], _mm256_set1_ps(c_degenerateCone), _CMP_EQ_OQ);
+
+        const __m256 ax = _mm256_sub_ps(_mm256_mul_ps(_mm256_div_ps(cone[0], unorm), two), one);
+        const __m256 ay = _mm256_sub_ps(_mm256_mul_ps(_mm256_div_ps(cone[1], unorm), two), one);
+        const __m256 az = _mm256_sub_ps(_mm256_mul_ps(_mm256_div_ps(cone[2], unorm), two), one);
+
+        __m256 tx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, k.World[0][0]), _mm256_mul_ps(ay, k.World[1][0])), _mm256_mul_ps(az, k.World[2][0]));
+        __m256 ty = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, k.World[0][1]), _mm256_mul_ps(ay, k.World[1][1])), _mm256_mul_ps(az, k.World[2][1]));
+        __m256 tz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, k.World[0][2]), _mm256_mul_ps(ay, k.World[1][2])), _mm256_mul_ps(az, k.World[2][2]));
+
+        const __m256 axisLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)), _mm256_mul_ps(tz, tz)));
+        tx = _mm256_div_ps(tx, axisLength);
+        ty = _mm256_div_ps(ty, axisLength);
+        tz = _mm256_div_ps(tz, axisLength);
+
+        const __m256 offset = _mm256_mul_ps(apexOffset, k.Scale);
+
+        __m256 vx = _mm256_sub_ps(k.View[0], _mm256_sub_ps(center[0], _mm256_mul_ps(tx, offset)));
+        __m256 vy = _mm256_sub_ps(k.View[1], _mm256_sub_ps(center[1], _mm256_mul_ps(ty, offset)));
+        __m256 vz = _mm256_sub_ps(k.View[2], _mm256_sub_ps(center[2], _mm256_mul_ps(tz, offset)));
+
+        const __m256 viewLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)));
+        vx = _mm256_div_ps(vx, viewLength);
+        vy = _mm256_div_ps(vy, viewLength);
+        vz = _mm256_div_ps(vz, viewLength);
+
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        const __m256 d = _mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(vx, _mm256_xor_ps(tx, signBit)),
+            _mm256_mul_ps(vy, _mm256_xor_ps(ty, signBit))),
+            _mm256_mul_ps(vz, _mm256_xor_ps(tz, signBit)));
+
+        return _mm256_andnot_ps(degenerate, _mm256_cmp_ps(d, cutoff, _CMP_GT_OQ));
+    }
+
+    CULL_AVX_FUNCTION uint32_t VisibleMaskAvx(const CullData* c, const AvxConstants& k)
+    {
+        // Transpose each half's spheres, then join the halves.
+        __m128 sx[2], sy[2], sz[2], sr[2];
+
+        for (uint32_t h = 0; h < 2; ++h)
+        {
+            const CullData* q = c + h * 4;
+
+            sx[h] = _mm_loadu_ps(&q[0].BoundingSphere.x);
+            sy[h] = _mm_loadu_ps(&q[1].BoundingSphere.x);
+            sz[h] = _mm_loadu_ps(&q[2].BoundingSphere.x);
+            sr[h] = _mm_loadu_ps(&q[3].BoundingSphere.x);
+            _MM_TRANSPOSE4_PS(sx[h], sy[h], sz[h], sr[h]);
+        }
+
+        __m256 center[3];
+        __m256 culled = FrustumCulledAvx(Combine(sx[0], sx[1]), Combine(sy[0], sy[1]), Combine(sz[0], sz[1]), Combine(sr[0], sr[1]), k, center);
+
+        __m256 cone[4];
+        UnpackCones(
+            _mm_setr_epi32(LoadCone(c[0]), LoadCone(c[1]), LoadCone(c[2]), LoadCone(c[3])),
+            _mm_setr_epi32(LoadCone(c[4]), LoadCone(c[5]), LoadCone(c[6]), LoadCone(c[7])), cone);
+
+        const __m256 apexOffset = _mm256_setr_ps(
+            c[0].ApexOffset, c[1].ApexOffset, c[2].ApexOffset, c[3].ApexOffset,
+            c[4].ApexOffset, c[5].ApexOffset, c[6].ApexOffset, c[7].ApexOffset);
+
+        culled = _mm256_or_ps(culled, ConeCulledAvx(center, cone, apexOffset, k));
+
+        return static_cast<uint32_t>(_mm256_movemask_ps(culled)) ^ 0xFF;
+    }
+
+    CULL_AVX_FUNCTION uint32_t VisibleMaskSoAAvx(const CullDataSoA& d, uint32_t g, const AvxConstants& k)
+    {
+        __m256 center[3];
+        __m256 culled = FrustumCulledAvx(_mm256_load_ps(d.CenterX + g), _mm256_load_ps(d.CenterY + g), _mm256_load_ps(d.CenterZ + g), _mm256_load_ps(d.Radius + g), k, center);
+
+        if (_mm256_movemask_ps(culled) == 0xFF)
+        {
+            return 0;
+        }
+
+        __m256 cone[4];
+        UnpackCones(LoadConesSoA(d, g), LoadConesSoA(d, g + 4), cone);
+
+        culled = _mm256_or_ps(culled, ConeCulledAvx(center, cone, _mm256_load_ps(d.ApexOffset + g), k));
+
+        return static_cast<uint32_t>(_mm256_movemask_ps(culled)) ^ 0xFF;
+    }
+
+    CULL_AVX_FUNCTION uint32_t CullRangeAvx(const CullData* cullData, uint32_t first, uint32_t end, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        AvxConstants k;
+        LoadConstants(params, k);
+
+        uint32_t i = first;
+        for (; i + 16 <= end; i += 16)
+        {
+            const uint32_t mask = VisibleMaskAvx(cullData + i, k) | (VisibleMaskAvx(cullData + i + 8, k) << 8);
+            count = Compact(out, count, i, mask, 16);
+        }
+
+        for (; i < end; ++i)
+        {
+            out[count] = i;
+            count += IsVisibleScalar(cullData[i], params);
+        }
+
+        return count;
+    }
+
+    CULL_AVX_FUNCTION uint32_t CullTreeAvx(const MeshletTree& tree, uint32_t root, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        SseConstants nodeConstants;
+        LoadConstants(params, nodeConstants);
+
+        AvxConstants k;
+        LoadConstants(params, k);
+
+        return CullTree(tree, root, nodeConstants, [&](uint32_t first, uint32_t leafCount, uint32_t n)
+        {
+            const uint32_t mask = VisibleMaskSoAAvx(tree.CullingData, first, k);
+            return CompactLeaf(out, n, tree.MeshletIndices.data() + first, mask & ((1u << leafCount) - 1));
+        }, count);
+    }
+
+    // One group per iteration: the padding only guarantees whole groups of CullDataSoA::LaneCount.
+    CULL_AVX_FUNCTION uint32_t CullRangeSoAAvx(const CullDataSoA& d, uint32_t first, uint32_t end, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        AvxConstants k;
+        LoadConstants(params, k);
+
+        for (uint32_t g = first & ~7u; g < end; g += 8)
+        {
+            count = Compact(out, count, g, VisibleMaskSoAAvx(d, g, k) & RangeMask(g, first, end, 8), 8);
+        }
+
+        return count;
+    }
+
+    uint32_t CullRangeScalar(const CullData* cullData, uint32_t first, uint32_t end, const MeshletCullParams& params, uint32_t* out, uint32_t count)
+    {
+        for (uint32_t i = first; i < end; ++i)
+        {
+            if (IsVisibleScalar(cullData[i], params))
+            {
+                out[count++] = i;
+            }
+        }
+        return count;
+    }
+
+    bool IsAvxSupported()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+
+        // AVX needs both CPU support and the OS saving YMM state on context switches.
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+        return __builtin_cpu_supports("avx") != 0;
+#endif
+    }
+
+    CullPath ResolvePath(CullPath path)
+    {
+        if ((path == CullPath::Best || path == CullPath::AVX) && IsCullPathSupported(CullPath::AVX))
+            return CullPath::AVX;
+
+        if (path != CullPath::Scalar && IsCullPathSupported(CullPath::SSE))
+            return CullPath::SSE;
+
+        return CullPath::Scalar;
+    }
+}
+
+void ComputeFrustumPlanes(FXMMATRIX viewProj, XMFLOAT4 (&planes)[6])
+{
+    const XMMATRIX vp = XMMatrixTranspose(viewProj);
+
+    XMStoreFloat4(&planes[0], XMPlaneNormalize(XMVectorAdd(vp.r[3], vp.r[0])));      // Left
+    XMStoreFloat4(&planes[1], XMPlaneNormalize(XMVectorSubtract(vp.r[3], vp.r[0]))); // Right
+    XMStoreFloat4(&planes[2], XMPlaneNormalize(XMVectorAdd(vp.r[3], vp.r[1])));      // Bottom
+    XMStoreFloat4(&planes[3], XMPlaneNormalize(XMVectorSubtract(vp.r[3], vp.r[1]))); // Top
+    XMStoreFloat4(&planes[4], XMPlaneNormalize(vp.r[2]));                            // Near
+    XMStoreFloat4(&planes[5], XMPlaneNormalize(XMVectorSubtract(vp.r[3], vp.r[2]))); // Far
+}
+
+bool IsCullPathSupported(CullPath path)
+{
+    // x64 always has SSE2.
+    static const bool s_avx = IsAvxSupported();
+
+    switch (path)
+    {
+    case CullPath::AVX: return s_avx;
+    default:            return true;
+    }
+}
+
+HRESULT CullMeshlets(const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& visible, CullPath path, CullDataLayout layout)
+{
+    const uint32_t meshletCount = static_cast<uint32_t>(mesh.CullingData.size());
+    const uint32_t subsetCount = static_cast<uint32_t>(mesh.MeshletSubsets.size());
+
+    size_t testCount = 0;
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        if (size_t(mesh.MeshletSubsets[s].Offset) + mesh.MeshletSubsets[s].Count > meshletCount)
+        {
+            return E_INVALIDARG;
+        }
+        testCount += mesh.MeshletSubsets[s].Count;
+    }
+
+    path = ResolvePath(path);
+
+    // Only the SIMD paths read the SoA copy, so only they build it.
+    static const CullDataSoA noSoA;
+    const bool wantSoA = layout == CullDataLayout::StructOfArrays && path != CullPath::Scalar;
+    const CullDataSoA& soa = wantSoA ? mesh.GetCullDataSoA() : noSoA;
+    const bool useSoA = wantSoA && soa.Count == meshletCount;
+
+    visible.Indices.resize(testCount + 1);
+    visible.Subsets.resize(subsetCount);
+
+    const CullData* cullData = mesh.CullingData.data();
+    uint32_t* out = visible.Indices.data();
+    uint32_t count = 0;
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const uint32_t first = mesh.MeshletSubsets[s].Offset;
+        const uint32_t end = first + mesh.MeshletSubsets[s].Count;
+
+        visible.Subsets[s].Offset = count;
+
+        switch (path)
+        {
+        case CullPath::AVX:
+            count = useSoA ? CullRangeSoAAvx(soa, first, end, params, out, count) : CullRangeAvx(cullData, first, end, params, out, count);
+            break;
+
+        case CullPath::SSE:
+            count = useSoA ? CullRangeSoASse(soa, first, end, params, out, count) : CullRangeSse(cullData, first, end, params, out, count);
+            break;
+
+        default:
+            count = CullRangeScalar(cullData, first, end, params, out, count);
+            break;
+        }
+
+        visible.Subsets[s].Count = count - visible.Subsets[s].Offset;
+    }
+
+    visible.Indices.resize(count);
+
+    return S_OK;
+}
+
+HRESULT CullMeshletTree(const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& visible, CullPath path)
+{
+    const MeshletTree& tree = mesh.GetMeshletTree();
+    const uint32_t subsetCount = static_cast<uint32_t>(mesh.MeshletSubsets.size());
+
+    if (tree.Roots.size() != subsetCount)
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t testCount = 0;
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        testCount += mesh.MeshletSubsets[s].Count;
+    }
+
+    path = ResolvePath(path);
+
+    visible.Indices.resize(testCount + 1);
+    visible.Subsets.resize(subsetCount);
+
+    uint32_t* out = visible.Indices.data();
+    uint32_t count = 0;
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        visible.Subsets[s].Offset = count;
+
+        if (tree.Roots[s] != UINT32_MAX)
+        {
+            if (path == CullPath::AVX)
+                count = CullTreeAvx(tree, tree.Roots[s], params, out, count);
+            else
+                count = CullTreeSse(tree, tree.Roots[s], params, out, count);
+        }
+
+        visible.Subsets[s].Count = count - visible.Subsets[s].Offset;
+    }
+
+    visible.Indices.resize(count);
+
+    return S_OK;
+}
+
+void MergeVisibleMeshlets(const VisibleMeshlets& a, const VisibleMeshlets& b, VisibleMeshlets& merged)
+{
+    merged.Indices.clear();
+    merged.Subsets.resize(a.Subsets.size());
+
+    for (uint32_t s = 0; s < a.Subsets.size(); ++s)
+    {
+        merged.Subsets[s].Offset = static_cast<uint32_t>(merged.Indices.size());
+        merged.Indices.insert(merged.Indices.end(), a.Indices.begin() + a.Subsets[s].Offset, a.Indices.begin() + a.Subsets[s].Offset + a.Subsets[s].Count);
+        merged.Indices.insert(merged.Indices.end(), b.Indices.begin() + b.Subsets[s].Offset, b.Indices.begin() + b.Subsets[s].Offset + b.Subsets[s].Count);
+        merged.Subsets[s].Count = static_cast<uint32_t>(merged.Indices.size()) - merged.Subsets[s].Offset;
+    }
+}
@@ -0,0 +1,69 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "Model.h"
+
+// CPU counterpart of IsVisible in MeshAS.hlsl. Each meshlet's bounding sphere is tested against
+// the six frustum planes, then its normal cone against the view position. Every path performs the
+// same operations in the same order, so the SIMD paths agree bit for bit with the scalar one.
+enum class CullPath
+{
+    Scalar,
+    SSE,    // Four lanes; two groups (8 meshlets) per iteration
+    AVX,    // Eight lanes; two groups (16 meshlets) per iteration, one over the SoA layout
+    Best,   // The widest path the CPU supports
+};
+
+// Which copy of the cull data the SIMD paths read. The scalar path always reads CullingData.
+enum class CullDataLayout
+{
+    ArrayOfStructs,     // Mesh::CullingData
+    StructOfArrays,     // Mesh::GetCullDataSoA, built on first use; falls back to CullingData when it is out of date
+};
+
+struct MeshletCullParams
+{
+    DirectX::XMFLOAT4X4 World;          // Affine object-to-world transform, row-vector convention
+    float               Scale;          // Uniform scale of World, applied to radii and apex offsets
+    DirectX::XMFLOAT4   Planes[6];      // World-space frustum planes, normals facing inwards
+    DirectX::XMFLOAT3   ViewPosition;   // World-space position the cones are tested from
+};
+
+// Visible meshlets, grouped by meshlet subset.
+struct VisibleMeshlets
+{
+    std::vector<uint32_t> Indices;      // Indices into Mesh::Meshlets; see each culling function for the order
+    std::vector<Subset>   Subsets;      // Ranges of Indices, parallel to Mesh::MeshletSubsets
+};
+
+// The normalized left, right, bottom, top, near and far planes of a view-projection matrix.
+void ComputeFrustumPlanes(DirectX::FXMMATRIX viewProj, DirectX::XMFLOAT4 (&planes)[6]);
+
+bool IsCullPathSupported(CullPath path);
+
+// Culls every meshlet of the mesh, leaving Indices ascending within each subset. An unsupported
+// path falls back to the widest supported one.
+// Fails if the mesh's CullingData doesn't cover its meshlet subsets.
+HRESULT CullMeshlets(const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& visible,
+    CullPath path = CullPath::Best, CullDataLayout layout = CullDataLayout::StructOfArrays);
+
+// Culls through Mesh::GetMeshletTree, which is built on first use. Whole groups of meshlets are
+// rejected by their combined sphere and normal cone; the meshlets of surviving leaves get the same
+// per-meshlet test as CullMeshlets. A group is only rejected if each of its meshlets is outside a
+// frustum plane or every triangle in it faces away, so the result is a subset of CullMeshlets'.
+// Indices within a subset are in tree order. Nodes are always tested with SSE; path picks the leaf
+// test, and Scalar means SSE.
+// Fails if the tree doesn't match the mesh's meshlet subsets.
+HRESULT CullMeshletTree(const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& visible, CullPath path = CullPath::Best);
+
+// Concatenates two meshlet lists of the same mesh subset by subset, a's meshlets first.
+void MergeVisibleMeshlets(const VisibleMeshlets& a, const VisibleMeshlets& b, VisibleMeshlets& merged);
@@ -0,0 +1,203 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "CullViews.h"
+#include "MeshletCuller.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    // The five Dragon LODs come first in c_assetFilenames.
+    const uint32_t c_dragonLodCount = 5;
+
+    struct CullConfig
+    {
+        const char*    Name;
+        CullPath       Path;
+        CullDataLayout Layout;
+    };
+
+    const CullConfig c_simdConfigs[] =
+    {
+        { "sse",     CullPath::SSE, CullDataLayout::ArrayOfStructs },
+        { "sse-soa", CullPath::SSE, CullDataLayout::StructOfArrays },
+        { "avx",     CullPath::AVX, CullDataLayout::ArrayOfStructs },
+        { "avx-soa", CullPath::AVX, CullDataLayout::StructOfArrays },
+    };
+
+    bool SameMeshlets(const VisibleMeshlets& a, const VisibleMeshlets& b)
+    {
+        bool same = a.Indices == b.Indices && a.Subsets.size() == b.Subsets.size();
+        for (uint32_t s = 0; same && s < a.Subsets.size(); ++s)
+        {
+            same = a.Subsets[s].Offset == b.Subsets[s].Offset && a.Subsets[s].Count == b.Subsets[s].Count;
+        }
+        return same;
+    }
+
+    // Every SIMD path, over either cull data layout, must keep exactly the meshlets the scalar path
+    // keeps, in the same order. The views must cull some meshlets and keep others, or the
+    // comparison proves nothing.
+    uint32_t CheckPathsMatchScalar(const Model& model, const wchar_t* filename)
+    {
+        const Mesh& mesh = *model.begin();
+        uint32_t mismatches[_countof(c_simdConfigs)] = {};
+        uint32_t failures = 0;
+        uint64_t visibleCount = 0;
+
+        for (uint32_t v = 0; v < c_cullViewCount; ++v)
+        {
+            MeshletCullParams params;
+            MakeCullParams(model, v, params);
+
+            VisibleMeshlets reference;
+            failures += FAILED(CullMeshlets(mesh, params, reference, CullPath::Scalar));
+            visibleCount += reference.Indices.size();
+
+            for (uint32_t c = 0; c < _countof(c_simdConfigs); ++c)
+            {
+                if (!IsCullPathSupported(c_simdConfigs[c].Path))
+                {
+                    continue;
+                }
+
+                VisibleMeshlets visible;
+                failures += FAILED(CullMeshlets(mesh, params, visible, c_simdConfigs[c].Path, c_simdConfigs[c].Layout));
+                mismatches[c] += !SameMeshlets(visible, reference);
+            }
+        }
+
+        uint32_t errors = Check(failures == 0, "MeshletCuller: culling %ls failed %u times\n", filename, failures);
+        errors += Check(visibleCount > 0 && visibleCount < uint64_t(mesh.Meshlets.size()) * c_cullViewCount,
+            "MeshletCuller: the views of %ls keep %llu of %llu meshlets\n", filename, visibleCount, uint64_t(mesh.Meshlets.size()) * c_cullViewCount);
+
+        for (uint32_t c = 0; c < _countof(c_simdConfigs); ++c)
+        {
+            errors += Check(mismatches[c] == 0, "MeshletCuller: %s differs from scalar in %u of %u views of %ls\n",
+                c_simdConfigs[c].Name, mismatches[c], c_cullViewCount, filename);
+        }
+        return errors;
+    }
+
+    // The tree only rejects groups whose every meshlet the flat scan rejects, so in each subset its
+    // meshlets must be among the flat scan's, for whole-model views and for close-ups alike. And it
+    // only rejects a group if each meshlet is outside a frustum plane or faces away entirely, so it
+    // must keep every meshlet the flat scan keeps that has a triangle facing the view position.
+    // Each leaf test path must keep the same meshlets.
+    uint32_t CheckTreeMatchesFlatScan(const Model& model, const wchar_t* filename)
+    {
+        const float closeUpFieldOfView = XM_PIDIV4 / 8.0f;
+        const CullPath leafPaths[] = { CullPath::Scalar, CullPath::SSE, CullPath::AVX };
+
+        uint32_t failures = 0;
+        uint32_t violations = 0;
+        uint32_t missing = 0;
+        uint32_t pathMismatches = 0;
+        uint64_t wholeModelRequired = 0;
+
+        for (auto& mesh : model)
+        {
+            for (uint32_t v = 0; v < 2 * c_cullViewCount; ++v)
+            {
+                MeshletCullParams params;
+                MakeCullParams(model, v % c_cullViewCount, params, v < c_cullViewCount ? XM_PIDIV4 : closeUpFieldOfView);
+
+                VisibleMeshlets flat;
+                failures += FAILED(CullMeshlets(mesh, params, flat, CullPath::Scalar, CullDataLayout::ArrayOfStructs));
+
+                // The flat scan's meshlets that face the view position, in the mesh's own space.
+                XMFLOAT3 objectViewPosition;
+                XMStoreFloat3(&objectViewPosition, XMVector3Transform(XMLoadFloat3(&params.ViewPosition), XMMatrixInverse(nullptr, XMLoadFloat4x4(&params.World))));
+
+                std::vector<uint8_t> facing(flat.Indices.size());
+                for (uint32_t i = 0; i < flat.Indices.size(); ++i)
+                {
+                    facing[i] = MeshletFacesPosition(mesh, flat.Indices[i], objectViewPosition);
+                    wholeModelRequired += v < c_cullViewCount && facing[i];
+                }
+
+                VisibleMeshlets first;
+                for (uint32_t p = 0; p < _countof(leafPaths); ++p)
+                {
+                    if (!IsCullPathSupported(leafPaths[p]))
+                    {
+                        continue;
+                    }
+
+                    VisibleMeshlets tree;
+                    if (FAILED(CullMeshletTree(mesh, params, tree, leafPaths[p])) || tree.Subsets.size() != flat.Subsets.size())
+                    {
+                        ++failures;
+                        continue;
+                    }
+
+                    if (p == 0)
+                    {
+                        first = tree;
+                    }
+                    else
+                    {
+                        pathMismatches += !SameMeshlets(tree, first);
+                    }
+
+                    for (uint32_t s = 0; s < tree.Subsets.size(); ++s)
+                    {
+                        auto flatBegin = flat.Indices.begin() + flat.Subsets[s].Offset;
+                        auto treeBegin = tree.Indices.begin() + tree.Subsets[s].Offset;
+                        std::sort(treeBegin, treeBegin + tree.Subsets[s].Count);
+
+                        violations += !std::includes(flatBegin, flatBegin + flat.Subsets[s].Count, treeBegin, treeBegin + tree.Subsets[s].Count);
+
+                        for (uint32_t i = flat.Subsets[s].Offset; i < flat.Subsets[s].Offset + flat.Subsets[s].Count; ++i)
+                        {
+                            missing += facing[i] && !std::binary_search(treeBegin, treeBegin + tree.Subsets[s].Count, flat.Indices[i]);
+                        }
+                    }
+                }
+            }
+        }
+
+        uint32_t errors = Check(failures == 0, "MeshletCuller: tree culling %ls failed %u times\n", filename, failures);
+        errors += Check(violations == 0, "MeshletCuller: the tree kept meshlets the flat scan culled in %u subsets of %ls\n", violations, filename);
+        errors += Check(missing == 0, "MeshletCuller: the tree culled %u meshlets of %ls that the flat scan kept and that face the view\n", missing, filename);
+        errors += Check(wholeModelRequired > 0, "MeshletCuller: no meshlet of %ls faces the whole-model views, so the tree's culling proves nothing\n", filename);
+        errors += Check(pathMismatches == 0, "MeshletCuller: the tree's leaf paths disagree in %u views of %ls\n", pathMismatches, filename);
+        return errors;
+    }
+}
+
+uint32_t Tests::TestMeshletCuller(const std::wstring& assetDirectory)
+{
+    uint32_t errors = 0;
+    for (uint32_t f = 0; f < c_assetCount; ++f)
+    {
+        const std::wstring path = assetDirectory + c_assetFilenames[f];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            return errors + Check(false, "Failed to load %ls\n", path.c_str());
+        }
+
+        if (f < c_dragonLodCount)
+        {
+            errors += CheckPathsMatchScalar(model, c_assetFilenames[f]);
+        }
+        errors += CheckTreeMatchesFlatScan(model, c_assetFilenames[f]);
+    }
+    return errors;
+}
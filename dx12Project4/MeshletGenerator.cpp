@@ -0,0 +1,653 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "MeshletGenerator.h"
+
+#include "CullDataGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    // Triangles per leaf of the centroid tree.
+    const uint32_t c_leafSize = 8;
+
+    // Meshlets of one subset, with offsets relative to the subset's own streams.
+    struct SubsetMeshlets
+    {
+        std::vector<Meshlet>        Meshlets;
+        std::vector<uint32_t>       UniqueVertexIndices;
+        std::vector<PackedTriangle> PrimitiveIndices;
+    };
+
+    XMVECTOR XM_CALLCONV ComputeFaceNormal(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2)
+    {
+        return XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+    }
+
+    // Accumulates triangles into a meshlet until either limit would be exceeded.
+    class MeshletBuilder
+    {
+    public:
+        MeshletBuilder(const MeshletGeneratorOptions& options, uint32_t vertexCount)
+            : m_maxVerts(options.MaxVerts)
+            , m_maxPrims(options.MaxPrims)
+            , m_localIndices(vertexCount, UINT32_MAX)
+        { }
+
+        // Number of the triangle's vertices not yet in the meshlet.
+        uint32_t CountNewVerts(const uint32_t* tri) const
+        {
+            uint32_t count = m_localIndices[tri[0]] == UINT32_MAX;
+            count += m_localIndices[tri[1]] == UINT32_MAX && tri[1] != tri[0];
+            count += m_localIndices[tri[2]] == UINT32_MAX && tri[2] != tri[0] && tri[2] != tri[1];
+            return count;
+        }
+
+        bool TryAdd(const uint32_t* tri)
+        {
+            if (m_verts.size() + CountNewVerts(tri) > m_maxVerts || m_prims.size() + 1 > m_maxPrims)
+            {
+                return false;
+            }
+
+            uint32_t local[3];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t& slot = m_localIndices[tri[k]];
+                if (slot == UINT32_MAX)
+                {
+                    slot = static_cast<uint32_t>(m_verts.size());
+                    m_verts.push_back(tri[k]);
+                }
+                local[k] = slot;
+            }
+
+            PackedTriangle prim;
+            prim.i0 = local[0];
+            prim.i1 = local[1];
+            prim.i2 = local[2];
+            m_prims.push_back(prim);
+
+            return true;
+        }
+
+        bool IsEmpty() const { return m_prims.empty(); }
+
+        void Flush(SubsetMeshlets& out)
+        {
+            Meshlet meshlet;
+            meshlet.VertCount = static_cast<uint32_t>(m_verts.size());
+            meshlet.VertOffset = static_cast<uint32_t>(out.UniqueVertexIndices.size());
+            meshlet.PrimCount = static_cast<uint32_t>(m_prims.size());
+            meshlet.PrimOffset = static_cast<uint32_t>(out.PrimitiveIndices.size());
+
+            out.Meshlets.push_back(meshlet);
+            out.UniqueVertexIndices.insert(out.UniqueVertexIndices.end(), m_verts.begin(), m_verts.end());
+            out.PrimitiveIndices.insert(out.PrimitiveIndices.end(), m_prims.begin(), m_prims.end());
+
+            for (uint32_t v : m_verts)
+            {
+                m_localIndices[v] = UINT32_MAX;
+            }
+
+            m_verts.clear();
+            m_prims.clear();
+        }
+
+    private:
+        uint32_t                    m_maxVerts;
+        uint32_t                    m_maxPrims;
+
+        std::vector<uint32_t>       m_localIndices; // Mesh vertex index -> meshlet-local index, or UINT32_MAX
+        std::vector<uint32_t>       m_verts;
+        std::vector<PackedTriangle> m_prims;
+    };
+
+    // Nearest-live-point queries over triangle centroids, used to seed each meshlet next to the
+    // previous one. Nodes count their live points so exhausted branches are skipped.
+    class CentroidTree
+    {
+    public:
+        explicit CentroidTree(const std::vector<XMFLOAT3>& points)
+            : m_points(points)
+            , m_items(points.size())
+            , m_leafOf(points.size())
+            , m_removed(points.size(), 0)
+        {
+            for (uint32_t i = 0; i < m_items.size(); ++i)
+            {
+                m_items[i] = i;
+            }
+
+            if (!m_items.empty())
+            {
+                Build(0, static_cast<uint32_t>(m_items.size()), UINT32_MAX);
+            }
+        }
+
+        void Remove(uint32_t item)
+        {
+            m_removed[item] = 1;
+
+            for (uint32_t n = m_leafOf[item]; n != UINT32_MAX; n = m_nodes[n].Parent)
+            {
+                --m_nodes[n].Live;
+            }
+        }
+
+        // Returns UINT32_MAX once every point has been removed.
+        uint32_t FindNearest(const XMFLOAT3& p) const
+        {
+            uint32_t best = UINT32_MAX;
+            float bestDistSq = FLT_MAX;
+
+            if (!m_nodes.empty())
+            {
+                Search(0, p, best, bestDistSq);
+            }
+
+            return best;
+        }
+
+    private:
+        struct Node
+        {
+            uint32_t Begin;
+            uint32_t End;
+            uint32_t Parent;
+            uint32_t Live;
+            uint32_t Children[2];   // UINT32_MAX for leaves
+            uint32_t Axis;
+            float    Split;
+        };
+
+        static float Coord(const XMFLOAT3& p, uint32_t axis) { return (&p.x)[axis]; }
+
+        uint32_t Build(uint32_t begin, uint32_t end, uint32_t parent)
+        {
+            const uint32_t index = static_cast<uint32_t>(m_nodes.size());
+
+            Node node = { begin, end, parent, end - begin, { UINT32_MAX, UINT32_MAX }, 0, 0.0f };
+            m_nodes.push_back(node);
+
+            if (end - begin <= c_leafSize)
+            {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    m_leafOf[m_items[i]] = index;
+                }
+                return index;
+            }
+
+            // Split the widest axis at the median.
+            XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+            XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                XMVECTOR p = XMLoadFloat3(&m_points[m_items[i]]);
+                vmin = XMVectorMin(vmin, p);
+                vmax = XMVectorMax(vmax, p);
+            }
+
+            XMFLOAT3 extents;
+            XMStoreFloat3(&extents, XMVectorSubtract(vmax, vmin));
+
+            const uint32_t axis = (extents.x >= extents.y && extents.x >= extents.z) ? 0 : (extents.y >= extents.z ? 1 : 2);
+            const uint32_t mid = begin + (end - begin) / 2;
+
+            std::nth_element(m_items.begin() + begin, m_items.begin() + mid, m_items.begin() + end, [&](uint32_t a, uint32_t b)
+            {
+                return Coord(m_points[a], axis) < Coord(m_points[b], axis);
+            });
+
+            m_nodes[index].Axis = axis;
+            m_nodes[index].Split = Coord(m_points[m_items[mid]], axis);
+
+            const uint32_t left = Build(begin, mid, index);
+            const uint32_t right = Build(mid, end, index);
+
+            m_nodes[index].Children[0] = left;
+            m_nodes[index].Children[1] = right;
+
+            return index;
+        }
+
+        void Search(uint32_t n, const XMFLOAT3& p, uint32_t& best, float& bestDistSq) const
+        {
+            const Node& node = m_nodes[n];
+
+            if (node.Live == 0)
+                return;
+
+            if (node.Children[0] == UINT32_MAX)
+            {
+                for (uint32_t i = node.Begin; i < node.End; ++i)
+                {
+                    const uint32_t item = m_items[i];
+                    if (m_removed[item])
+                        continue;
+
+                    const float distSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&m_points[item]), XMLoadFloat3(&p))));
+                    if (distSq < bestDistSq)
+                    {
+                        best = item;
+                        bestDistSq = distSq;
+                    }
+                }
+                return;
+            }
+
+            const float delta = Coord(p, node.Axis) - node.Split;
+            const uint32_t nearSide = delta < 0 ? 0 : 1;
+
+            Search(node.Children[nearSide], p, best, bestDistSq);
+
+            if (delta * delta < bestDistSq)
+            {
+                Search(node.Children[1 - nearSide], p, best, bestDistSq);
+            }
+        }
+
+    private:
+        const std::vector<XMFLOAT3>& m_points;
+        std::vector<uint32_t>        m_items;
+        std::vector<uint32_t>        m_leafOf;
+        std::vector<uint8_t>         m_removed;
+        std::vector<Node>            m_nodes;
+    };
+
+    // Greedily packs the subset's triangles, in index order, into meshlets.
+    void BuildSubsetMeshletsInOrder(const Mesh& mesh, const Subset& subset, const MeshletGeneratorOptions& options, SubsetMeshlets& out)
+    {
+        MeshletBuilder builder(options, mesh.VertexCount);
+
+        for (uint32_t i = 0; i + 3 <= subset.Count; i += 3)
+        {
+            const uint32_t tri[3] =
+            {
+                mesh.GetIndex(subset.Offset + i + 0),
+                mesh.GetIndex(subset.Offset + i + 1),
+                mesh.GetIndex(subset.Offset + i + 2),
+            };
+
+            if (!builder.TryAdd(tri))
+            {
+                builder.Flush(out);
+                builder.TryAdd(tri);
+            }
+        }
+
+        if (!builder.IsEmpty())
+        {
+            builder.Flush(out);
+        }
+    }
+
+    // Grows each meshlet outward from a seed triangle. Candidates are the unused triangles sharing a
+    // vertex with the meshlet; the one adding the fewest new vertices wins, ties going to the triangle
+    // closest to the meshlet's centroid and best aligned with its average normal. When no neighbour is
+    // left, the nearest unused triangle continues the meshlet, and the next meshlet is seeded where
+    // this one ended so consecutive meshlets stay spatially coherent.
+    void BuildSubsetMeshletsLocality(const Mesh& mesh, const Subset& subset, const MeshletGeneratorOptions& options, SubsetMeshlets& out)
+    {
+        const PositionStream positions = mesh.GetPositions();
+        const uint32_t triCount = subset.Count / 3;
+
+        if (triCount == 0)
+            return;
+
+        std::vector<uint32_t> indices(triCount * 3);
+        std::vector<XMFLOAT3> centroids(triCount);
+        std::vector<XMFLOAT3> normals(triCount);
+
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                indices[t * 3 + k] = mesh.GetIndex(subset.Offset + t * 3 + k);
+            }
+
+            XMVECTOR p0 = XMLoadFloat3(&positions[indices[t * 3 + 0]]);
+            XMVECTOR p1 = XMLoadFloat3(&positions[indices[t * 3 + 1]]);
+            XMVECTOR p2 = XMLoadFloat3(&positions[indices[t * 3 + 2]]);
+
+            XMStoreFloat3(&centroids[t], XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), 1.0f / 3.0f));
+            XMStoreFloat3(&normals[t], ComputeFaceNormal(p0, p1, p2));
+        }
+
+        // Vertex -> triangle adjacency in compressed rows.
+        std::vector<uint32_t> adjacencyOffsets(mesh.VertexCount + 1, 0);
+        for (uint32_t v : indices)
+        {
+            ++adjacencyOffsets[v + 1];
+        }
+        for (uint32_t v = 0; v < mesh.VertexCount; ++v)
+        {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < indices.size(); ++i)
+            {
+                adjacency[cursor[indices[i]]++] = i / 3;
+            }
+        }
+
+        CentroidTree tree(centroids);
+        MeshletBuilder builder(options, mesh.VertexCount);
+
+        std::vector<uint8_t>  used(triCount, 0);
+        std::vector<uint32_t> candidateOf(triCount, UINT32_MAX); // Meshlet that last queued the triangle
+        std::vector<uint32_t> candidates;
+
+        const float coneWeight = min(max(options.ConeWeight, 0.0f), 1.0f);
+
+        uint32_t meshletIndex = 0;
+        XMVECTOR centroidSum = XMVectorZero();
+        XMVECTOR normalSum = XMVectorZero();
+        uint32_t meshletTris = 0;
+        float    radius = 0.0f;
+
+        auto addTriangle = [&](uint32_t t)
+        {
+            if (!builder.TryAdd(&indices[t * 3]))
+                return false;
+
+            used[t] = 1;
+            tree.Remove(t);
+
+            centroidSum = XMVectorAdd(centroidSum, XMLoadFloat3(&centroids[t]));
+            normalSum = XMVectorAdd(normalSum, XMLoadFloat3(&normals[t]));
+            ++meshletTris;
+
+            XMVECTOR center = XMVectorScale(centroidSum, 1.0f / meshletTris);
+            radius = max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&centroids[t]), center))));
+
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t v = indices[t * 3 + k];
+                for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a)
+                {
+                    const uint32_t neighbour = adjacency[a];
+                    if (!used[neighbour] && candidateOf[neighbour] != meshletIndex)
+                    {
+                        candidateOf[neighbour] = meshletIndex;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+
+            return true;
+        };
+
+        // Returns the best queued candidate, dropping those used since they were queued.
+        auto pickCandidate = [&]()
+        {
+            const XMVECTOR center = XMVectorScale(centroidSum, 1.0f / meshletTris);
+            const XMVECTOR axis = XMVector3Normalize(normalSum);
+
+            uint32_t best = UINT32_MAX;
+            uint32_t bestNewVerts = UINT32_MAX;
+            float bestCost = FLT_MAX;
+
+            size_t liveCount = 0;
+            for (size_t i = 0; i < candidates.size(); ++i)
+            {
+                const uint32_t t = candidates[i];
+                if (used[t])
+                    continue;
+
+                candidates[liveCount++] = t;
+
+                const uint32_t newVerts = builder.CountNewVerts(&indices[t * 3]);
+                if (newVerts > bestNewVerts)
+                    continue;
+
+                const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&centroids[t]), center)));
+                const float spread = 0.5f - 0.5f * XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normals[t]), axis));
+                const float cost = (1.0f - coneWeight) * distance / (distance + radius + FLT_EPSILON) + coneWeight * spread;
+
+                if (newVerts < bestNewVerts || cost < bestCost)
+                {
+                    best = t;
+                    bestNewVerts = newVerts;
+                    bestCost = cost;
+                }
+            }
+
+            candidates.resize(liveCount);
+            return best;
+        };
+
+        XMFLOAT3 seedPoint = centroids[0];
+
+        for (;;)
+        {
+            const uint32_t seed = tree.FindNearest(seedPoint);
+            if (seed == UINT32_MAX)
+                break;
+
+            centroidSum = XMVectorZero();
+            normalSum = XMVectorZero();
+            meshletTris = 0;
+            radius = 0.0f;
+            candidates.clear();
+
+            addTriangle(seed);
+
+            for (;;)
+            {
+                uint32_t next = pickCandidate();
+
+                if (next == UINT32_MAX)
+                {
+                    XMFLOAT3 center;
+                    XMStoreFloat3(&center, XMVectorScale(centroidSum, 1.0f / meshletTris));
+                    next = tree.FindNearest(center);
+                }
+
+                // The best candidate adds the fewest vertices, so if it doesn't fit nothing else will.
+                if (next == UINT32_MAX || !addTriangle(next))
+                    break;
+            }
+
+            XMStoreFloat3(&seedPoint, XMVectorScale(centroidSum, 1.0f / meshletTris));
+
+            builder.Flush(out);
+            ++meshletIndex;
+        }
+    }
+}
+
+void MeshletData::AttachTo(Mesh& mesh)
+{
+    mesh.MeshletSubsets = MakeSpan(MeshletSubsets.data(), static_cast<uint32_t>(MeshletSubsets.size()));
+    mesh.Meshlets = MakeSpan(Meshlets.data(), static_cast<uint32_t>(Meshlets.size()));
+    mesh.UniqueVertexIndices = MakeSpan(UniqueVertexIndices.data(), static_cast<uint32_t>(UniqueVertexIndices.size()));
+    mesh.PrimitiveIndices = MakeSpan(PrimitiveIndices.data(), static_cast<uint32_t>(PrimitiveIndices.size()));
+    mesh.CullingData = MakeSpan(CullingData.data(), static_cast<uint32_t>(CullingData.size()));
+    mesh.ResetDerivedCullData();
+}
+
+HRESULT GenerateMeshlets(const Mesh& mesh, MeshletData& meshlets, const MeshletGeneratorOptions& options, ThreadPool& pool)
+{
+    if (options.MaxVerts < 3 || options.MaxVerts > c_maxMeshletVerts || options.MaxPrims < 1 || options.MaxPrims > c_maxMeshletPrims)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (mesh.IndexSize != 2 && mesh.IndexSize != 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    const uint32_t subsetCount = static_cast<uint32_t>(mesh.IndexSubsets.size());
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        if (size_t(mesh.IndexSubsets[s].Offset) + mesh.IndexSubsets[s].Count > mesh.IndexCount)
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    // Both builders index per-vertex arrays, and the positions, with every index they read.
+    if (mesh.Indices.size() < size_t(mesh.IndexCount) * mesh.IndexSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (uint32_t i = 0; i < mesh.IndexCount; ++i)
+    {
+        if (mesh.GetIndex(i) >= mesh.VertexCount)
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    std::vector<SubsetMeshlets> subsets(subsetCount);
+
+    pool.ParallelFor(subsetCount, [&](uint32_t s)
+    {
+        if (options.Strategy == MeshletStrategy::Locality)
+        {
+            BuildSubsetMeshletsLocality(mesh, mesh.IndexSubsets[s], options, subsets[s]);
+        }
+        else
+        {
+            BuildSubsetMeshletsInOrder(mesh, mesh.IndexSubsets[s], options, subsets[s]);
+        }
+    });
+
+    // Concatenate the subsets, rebasing their offsets into the combined streams.
+    meshlets = MeshletData();
+
+    for (auto& subset : subsets)
+    {
+        Subset meshletSubset;
+        meshletSubset.Offset = static_cast<uint32_t>(meshlets.Meshlets.size());
+        meshletSubset.Count = static_cast<uint32_t>(subset.Meshlets.size());
+        meshlets.MeshletSubsets.push_back(meshletSubset);
+
+        const uint32_t vertBase = static_cast<uint32_t>(meshlets.UniqueVertexIndices.size() / mesh.IndexSize);
+        const uint32_t primBase = static_cast<uint32_t>(meshlets.PrimitiveIndices.size());
+
+        for (Meshlet m : subset.Meshlets)
+        {
+            m.VertOffset += vertBase;
+            m.PrimOffset += primBase;
+            meshlets.Meshlets.push_back(m);
+        }
+
+        const size_t vertByteBase = meshlets.UniqueVertexIndices.size();
+        meshlets.UniqueVertexIndices.resize(vertByteBase + subset.UniqueVertexIndices.size() * mesh.IndexSize);
+
+        uint8_t* dst = meshlets.UniqueVertexIndices.data() + vertByteBase;
+        for (uint32_t index : subset.UniqueVertexIndices)
+        {
+            if (mesh.IndexSize == 4)
+            {
+                std::memcpy(dst, &index, sizeof(index));
+            }
+            else
+            {
+                const uint16_t index16 = static_cast<uint16_t>(index);
+                std::memcpy(dst, &index16, sizeof(index16));
+            }
+            dst += mesh.IndexSize;
+        }
+
+        meshlets.PrimitiveIndices.insert(meshlets.PrimitiveIndices.end(), subset.PrimitiveIndices.begin(), subset.PrimitiveIndices.end());
+    }
+
+    // Culling data reads the combined streams through a copy of the mesh with them attached.
+    Mesh view = mesh;
+    meshlets.AttachTo(view);
+
+    return GenerateCullData(view, meshlets.CullingData, pool);
+}
+
+MeshletStats ComputeMeshletStats(const Mesh& mesh, const MeshletGeneratorOptions& options)
+{
+    MeshletStats stats = {};
+
+    const uint32_t meshletCount = static_cast<uint32_t>(mesh.Meshlets.size());
+    if (meshletCount == 0)
+        return stats;
+
+    const PositionStream positions = mesh.GetPositions();
+    const bool hasCullData = mesh.CullingData.size() == meshletCount;
+
+    uint64_t totalVerts = 0;
+    uint64_t totalPrims = 0;
+    double coneAngleSum = 0.0;
+    double radiusSum = 0.0;
+
+    std::vector<XMFLOAT3> normals;
+
+    for (uint32_t i = 0; i < meshletCount; ++i)
+    {
+        const Meshlet& meshlet = mesh.Meshlets[i];
+
+        totalVerts += meshlet.VertCount;
+        totalPrims += meshlet.PrimCount;
+
+        // Cone around the average face normal, opening to the least aligned face.
+        normals.clear();
+        XMVECTOR normalSum = XMVectorZero();
+
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            uint32_t i0, i1, i2;
+            mesh.GetPrimitive(meshlet.PrimOffset + p, i0, i1, i2);
+
+            XMVECTOR n = ComputeFaceNormal(
+                XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + i0)]),
+                XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + i1)]),
+                XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + i2)]));
+
+            normals.emplace_back();
+            XMStoreFloat3(&normals.back(), n);
+            normalSum = XMVectorAdd(normalSum, n);
+        }
+
+        const XMVECTOR axis = XMVector3Normalize(normalSum);
+
+        float minDot = 1.0f;
+        for (auto& n : normals)
+        {
+            minDot = min(minDot, XMVectorGetX(XMVector3Dot(XMLoadFloat3(&n), axis)));
+        }
+
+        coneAngleSum += XMConvertToDegrees(acosf(max(minDot, -1.0f)));
+
+        if (hasCullData)
+        {
+            radiusSum += mesh.CullingData[i].BoundingSphere.w;
+        }
+    }
+
+    stats.MeshletCount = meshletCount;
+    stats.AverageVertFill = static_cast<float>(double(totalVerts) / (double(meshletCount) * options.MaxVerts));
+    stats.AveragePrimFill = static_cast<float>(double(totalPrims) / (double(meshletCount) * options.MaxPrims));
+    stats.VertsPerTriangle = totalPrims ? static_cast<float>(double(totalVerts) / double(totalPrims)) : 0.0f;
+    stats.MeanConeAngle = static_cast<float>(coneAngleSum / meshletCount);
+    stats.MeanRadius = static_cast<float>(radiusSum / meshletCount);
+
+    return stats;
+}
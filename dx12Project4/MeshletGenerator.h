@@ -0,0 +1,61 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "Model.h"
+#include "MeshletLimits.h"
+
+enum class MeshletStrategy
+{
+    IndexOrder,     // Pack triangles in index buffer order; fast, and only as good as the index order.
+    Locality,       // Grow each meshlet from its neighbours, favouring shared vertices, then proximity and facing.
+};
+
+struct MeshletGeneratorOptions
+{
+    uint32_t        MaxVerts = c_maxMeshletVerts;   // At most c_maxMeshletVerts, MeshletMS.hlsl's vertex output count.
+    uint32_t        MaxPrims = c_maxMeshletPrims;   // At most c_maxMeshletPrims, MeshletMS.hlsl's primitive output count.
+    MeshletStrategy Strategy = MeshletStrategy::Locality;
+    float           ConeWeight = 0.5f;  // Locality only: 0 ranks candidates purely by distance, 1 purely by normal agreement.
+};
+
+// Meshlet streams for one mesh, laid out exactly as the Mesh spans and MSHL files expect.
+struct MeshletData
+{
+    std::vector<Subset>         MeshletSubsets;         // Parallel to the mesh's IndexSubsets
+    std::vector<Meshlet>        Meshlets;
+    std::vector<uint8_t>        UniqueVertexIndices;    // Mesh::IndexSize bytes per entry
+    std::vector<PackedTriangle> PrimitiveIndices;
+    std::vector<CullData>       CullingData;
+
+    // Points the mesh's meshlet spans at this data, which must outlive the mesh's use of it, and
+    // drops the mesh's SoA cull data and meshlet tree.
+    void AttachTo(Mesh& mesh);
+};
+
+// Partitions the triangles of each index subset into meshlets, replacing whatever meshlets the
+// asset was exported with. Only Indices, IndexSubsets and the position stream are read. Subsets
+// are built in parallel on the pool, and CullingData is filled in by GenerateCullData. Returns
+// E_INVALIDARG for limits the renderer can't draw, and for subsets or indices outside the mesh.
+HRESULT GenerateMeshlets(const Mesh& mesh, MeshletData& meshlets, const MeshletGeneratorOptions& options = MeshletGeneratorOptions(), ThreadPool& pool = ThreadPool::GetDefault());
+
+struct MeshletStats
+{
+    uint32_t MeshletCount;
+    float    AverageVertFill;   // Mean VertCount / MaxVerts
+    float    AveragePrimFill;   // Mean PrimCount / MaxPrims
+    float    VertsPerTriangle;  // Unique vertex entries per triangle; lower means more reuse
+    float    MeanConeAngle;     // Mean half-angle, in degrees, of the cone around each meshlet's face normals
+    float    MeanRadius;        // Mean CullData bounding sphere radius
+};
+
+// Measures the meshlets currently attached to the mesh, whether baked or generated.
+MeshletStats ComputeMeshletStats(const Mesh& mesh, const MeshletGeneratorOptions& options = MeshletGeneratorOptions());
@@ -0,0 +1,311 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "MeshletCuller.h"
+#include "MeshletGenerator.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    uint32_t ReadIndex(const uint8_t* indices, uint32_t indexSize, uint32_t i)
+    {
+        if (indexSize == 4)
+        {
+            uint32_t index;
+            std::memcpy(&index, indices + size_t(i) * 4, sizeof(index));
+            return index;
+        }
+
+        uint16_t index;
+        std::memcpy(&index, indices + size_t(i) * 2, sizeof(index));
+        return index;
+    }
+
+    // The triangle rotated to start at its smallest index, which keeps its winding.
+    Triangle Canonical(uint32_t a, uint32_t b, uint32_t c)
+    {
+        if (b < a && b <= c)
+        {
+            return Triangle{ { b, c, a } };
+        }
+        if (c < a && c < b)
+        {
+            return Triangle{ { c, a, b } };
+        }
+        return Triangle{ { a, b, c } };
+    }
+
+    // Checks generated meshlets against the mesh they were built from: one meshlet subset per index
+    // subset, laid out back to back; every meshlet within the options' limits and its primitives
+    // within its vertices; and each subset's meshlets drawing exactly the subset's triangles, each
+    // once and with its winding.
+    uint32_t CheckMeshlets(const Mesh& mesh, const MeshletData& data, const MeshletGeneratorOptions& options, const char* name)
+    {
+        uint32_t errors = Check(data.MeshletSubsets.size() == mesh.IndexSubsets.size() && data.CullingData.size() == data.Meshlets.size(),
+            "MeshletGenerator (%s): %u meshlet subsets for %u index subsets\n", name, static_cast<uint32_t>(data.MeshletSubsets.size()), static_cast<uint32_t>(mesh.IndexSubsets.size()));
+        if (errors > 0)
+        {
+            return errors;
+        }
+
+        uint32_t overLimit = 0;
+        uint32_t badPrimitives = 0;
+        uint32_t badSubsets = 0;
+        uint32_t nextMeshlet = 0;
+
+        for (uint32_t s = 0; s < mesh.IndexSubsets.size(); ++s)
+        {
+            const Subset& indexSubset = mesh.IndexSubsets[s];
+            const Subset& meshletSubset = data.MeshletSubsets[s];
+            badSubsets += meshletSubset.Offset != nextMeshlet || meshletSubset.Offset + meshletSubset.Count > data.Meshlets.size();
+            if (badSubsets > 0)
+            {
+                break;
+            }
+            nextMeshlet += meshletSubset.Count;
+
+            std::vector<Triangle> expected;
+            for (uint32_t i = indexSubset.Offset; i + 2 < indexSubset.Offset + indexSubset.Count; i += 3)
+            {
+                expected.push_back(Canonical(ReadIndex(mesh.Indices.data(), mesh.IndexSize, i), ReadIndex(mesh.Indices.data(), mesh.IndexSize, i + 1),
+                    ReadIndex(mesh.Indices.data(), mesh.IndexSize, i + 2)));
+            }
+
+            std::vector<Triangle> drawn;
+            for (uint32_t m = meshletSubset.Offset; m < meshletSubset.Offset + meshletSubset.Count; ++m)
+            {
+                const Meshlet& meshlet = data.Meshlets[m];
+                overLimit += meshlet.VertCount == 0 || meshlet.VertCount > options.MaxVerts || meshlet.PrimCount == 0 || meshlet.PrimCount > options.MaxPrims
+                    || (meshlet.VertOffset + meshlet.VertCount) * mesh.IndexSize > data.UniqueVertexIndices.size() || meshlet.PrimOffset + meshlet.PrimCount > data.PrimitiveIndices.size();
+                if (overLimit > 0)
+                {
+                    break;
+                }
+
+                for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+                {
+                    const PackedTriangle& prim = data.PrimitiveIndices[meshlet.PrimOffset + p];
+                    if (prim.i0 >= meshlet.VertCount || prim.i1 >= meshlet.VertCount || prim.i2 >= meshlet.VertCount)
+                    {
+                        badPrimitives++;
+                        continue;
+                    }
+
+                    const uint8_t* unique = data.UniqueVertexIndices.data();
+                    drawn.push_back(Canonical(ReadIndex(unique, mesh.IndexSize, meshlet.VertOffset + prim.i0), ReadIndex(unique, mesh.IndexSize, meshlet.VertOffset + prim.i1),
+                        ReadIndex(unique, mesh.IndexSize, meshlet.VertOffset + prim.i2)));
+                }
+            }
+
+            std::sort(expected.begin(), expected.end());
+            std::sort(drawn.begin(), drawn.end());
+            badSubsets += drawn != expected;
+        }
+
+        errors += Check(overLimit == 0, "MeshletGenerator (%s): a meshlet is empty, over %u vertices or %u primitives, or runs off its streams\n", name, options.MaxVerts, options.MaxPrims);
+        errors += Check(badPrimitives == 0, "MeshletGenerator (%s): %u primitives index past their meshlet's vertices\n", name, badPrimitives);
+        errors += Check(badSubsets == 0 && nextMeshlet == data.Meshlets.size(), "MeshletGenerator (%s): %u subsets don't draw each of their triangles once\n", name, badSubsets);
+        return errors;
+    }
+
+    // Checks the cull data of generated meshlets: each meshlet's sphere must contain its vertices,
+    // and its normal cone, tested as MeshAS.hlsl does, must never reject it from a position that
+    // sees one of its triangles front-facing. The positions lie inside, around and far from the
+    // mesh, along the axes and the diagonals. Degenerate cones never reject anything.
+    uint32_t CheckCullData(const Mesh& sourceMesh, const MeshletData& data, const char* name)
+    {
+        Mesh mesh = sourceMesh;
+        MeshletData attached = data;
+        attached.AttachTo(mesh);
+
+        const PositionStream positions = mesh.GetPositions();
+
+        uint32_t outsideSphere = 0;
+        for (uint32_t m = 0; m < mesh.Meshlets.size(); ++m)
+        {
+            const Meshlet& meshlet = mesh.Meshlets[m];
+            const XMFLOAT4& sphere = mesh.CullingData[m].BoundingSphere;
+            const XMVECTOR center = XMVectorSet(sphere.x, sphere.y, sphere.z, 0);
+            const float tolerance = 1e-5f * (sphere.w + XMVectorGetX(XMVector3Length(center)));
+
+            for (uint32_t v = 0; v < meshlet.VertCount; ++v)
+            {
+                const XMVECTOR p = XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + v)]);
+                outsideSphere += XMVectorGetX(XMVector3Length(XMVectorSubtract(p, center))) > sphere.w + tolerance;
+            }
+        }
+
+        // Planes that every sphere is inside, so only the cones cull.
+        MeshletCullParams params;
+        XMStoreFloat4x4(&params.World, XMMatrixIdentity());
+        params.Scale = 1.0f;
+        std::fill(std::begin(params.Planes), std::end(params.Planes), XMFLOAT4(0, 0, 0, 1));
+
+        const XMFLOAT3 directions[] =
+        {
+            XMFLOAT3(1, 0, 0), XMFLOAT3(-1, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(0, 0, -1),
+            XMFLOAT3(1, 1, 1), XMFLOAT3(1, 1, -1), XMFLOAT3(1, -1, 1), XMFLOAT3(1, -1, -1),
+            XMFLOAT3(-1, 1, 1), XMFLOAT3(-1, 1, -1), XMFLOAT3(-1, -1, 1), XMFLOAT3(-1, -1, -1),
+        };
+        const float distances[] = { 0.5f, 1.5f, 4.0f };
+
+        uint32_t failures = 0;
+        uint32_t wronglyCulled = 0;
+        uint64_t culledCount = 0;
+
+        std::vector<uint8_t> kept(mesh.Meshlets.size());
+        for (auto& direction : directions)
+        {
+            for (float distance : distances)
+            {
+                const XMVECTOR offset = XMVectorScale(XMVector3Normalize(XMLoadFloat3(&direction)), distance * mesh.BoundingSphere.Radius);
+                XMStoreFloat3(&params.ViewPosition, XMVectorAdd(XMLoadFloat3(&mesh.BoundingSphere.Center), offset));
+
+                VisibleMeshlets visible;
+                if (FAILED(CullMeshlets(mesh, params, visible, CullPath::Scalar)))
+                {
+                    ++failures;
+                    continue;
+                }
+
+                std::fill(kept.begin(), kept.end(), uint8_t(0));
+                for (uint32_t m : visible.Indices)
+                {
+                    kept[m] = 1;
+                }
+
+                for (uint32_t m = 0; m < mesh.Meshlets.size(); ++m)
+                {
+                    if (!kept[m])
+                    {
+                        ++culledCount;
+                        wronglyCulled += MeshletFacesPosition(mesh, m, params.ViewPosition);
+                    }
+                }
+            }
+        }
+
+        uint32_t errors = Check(outsideSphere == 0, "MeshletGenerator (%s): %u meshlet vertices lie outside their meshlet's sphere\n", name, outsideSphere);
+        errors += Check(failures == 0, "MeshletGenerator (%s): culling the generated meshlets failed %u times\n", name, failures);
+        errors += Check(wronglyCulled == 0, "MeshletGenerator (%s): normal cones rejected %u meshlets from positions seeing them front-facing\n", name, wronglyCulled);
+        errors += Check(culledCount > 0, "MeshletGenerator (%s): the normal cones reject nothing from any position\n", name);
+        return errors;
+    }
+
+    bool Identical(const MeshletData& a, const MeshletData& b)
+    {
+        auto same = [](const void* x, const void* y, size_t size) { return size == 0 || std::memcmp(x, y, size) == 0; };
+
+        // PackedTriangle's top two bits are never written, so its fields are compared one by one.
+        auto samePrimitive = [](const PackedTriangle& x, const PackedTriangle& y) { return x.i0 == y.i0 && x.i1 == y.i1 && x.i2 == y.i2; };
+
+        return a.MeshletSubsets.size() == b.MeshletSubsets.size() && a.Meshlets.size() == b.Meshlets.size()
+            && a.UniqueVertexIndices == b.UniqueVertexIndices && a.PrimitiveIndices.size() == b.PrimitiveIndices.size()
+            && same(a.MeshletSubsets.data(), b.MeshletSubsets.data(), a.MeshletSubsets.size() * sizeof(Subset))
+            && same(a.Meshlets.data(), b.Meshlets.data(), a.Meshlets.size() * sizeof(Meshlet))
+            && std::equal(a.PrimitiveIndices.begin(), a.PrimitiveIndices.end(), b.PrimitiveIndices.begin(), samePrimitive);
+    }
+
+    // An index past the last vertex must be rejected by either strategy rather than read.
+    uint32_t CheckOutOfRangeIndex()
+    {
+        PositionMesh wall;
+        BuildWall(0.0f, 0.0f, false, wall);
+
+        uint32_t errors = 0;
+        for (auto strategy : { MeshletStrategy::IndexOrder, MeshletStrategy::Locality })
+        {
+            MeshletGeneratorOptions options;
+            options.Strategy = strategy;
+
+            MeshletData meshlets;
+            wall.Indices.back() = wall.Mesh.VertexCount - 1;
+            errors += Check(SUCCEEDED(GenerateMeshlets(wall.Mesh, meshlets, options)), "MeshletGenerator: a mesh using its last vertex is rejected\n");
+
+            wall.Indices.back() = wall.Mesh.VertexCount;
+            errors += Check(GenerateMeshlets(wall.Mesh, meshlets, options) == E_INVALIDARG, "MeshletGenerator: an index past the last vertex is accepted\n");
+        }
+        return errors;
+    }
+}
+
+// Generates meshlets for every mesh of the bundled assets with both strategies, at MeshletMS.hlsl's
+// limits and at smaller ones, on one worker and on several, and checks each set, its cull data, and
+// that the workers don't change the result. Limits over the shader's, and indices past the vertices, are
+// rejected.
+uint32_t Tests::TestMeshletGenerator(const std::wstring& assetDirectory)
+{
+    const struct { const char* Name; MeshletStrategy Strategy; uint32_t MaxVerts; uint32_t MaxPrims; } configs[] =
+    {
+        { "index order",         MeshletStrategy::IndexOrder, c_maxMeshletVerts, c_maxMeshletPrims },
+        { "locality",            MeshletStrategy::Locality,   c_maxMeshletVerts, c_maxMeshletPrims },
+        { "locality, 32/40",     MeshletStrategy::Locality,   32, 40 },
+        { "index order, 3/1",    MeshletStrategy::IndexOrder, 3,  1 },
+    };
+
+    ThreadPool serialPool(1);
+    ThreadPool pool(3);
+
+    uint32_t errors = CheckOutOfRangeIndex();
+    for (auto filename : c_assetFilenames)
+    {
+        const std::wstring path = assetDirectory + filename;
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            return errors + Check(false, "Failed to load %ls\n", path.c_str());
+        }
+
+        for (auto& mesh : model)
+        {
+            MeshletGeneratorOptions tooManyVerts;
+            tooManyVerts.MaxVerts = c_maxMeshletVerts + 1;
+            MeshletGeneratorOptions tooManyPrims;
+            tooManyPrims.MaxPrims = c_maxMeshletPrims + 1;
+
+            MeshletData rejected;
+            errors += Check(GenerateMeshlets(mesh, rejected, tooManyVerts, pool) == E_INVALIDARG && GenerateMeshlets(mesh, rejected, tooManyPrims, pool) == E_INVALIDARG,
+                "MeshletGenerator: %ls accepts limits over MeshletMS.hlsl's outputs\n", filename);
+
+            for (auto& config : configs)
+            {
+                MeshletGeneratorOptions options;
+                options.Strategy = config.Strategy;
+                options.MaxVerts = config.MaxVerts;
+                options.MaxPrims = config.MaxPrims;
+
+                MeshletData serial;
+                MeshletData parallel;
+                const bool generated = SUCCEEDED(GenerateMeshlets(mesh, serial, options, serialPool)) && SUCCEEDED(GenerateMeshlets(mesh, parallel, options, pool));
+                errors += Check(generated, "MeshletGenerator (%s): generating meshlets for %ls failed\n", config.Name, filename);
+                if (generated)
+                {
+                    const uint32_t meshletErrors = CheckMeshlets(mesh, parallel, options, config.Name);
+                    errors += meshletErrors == 0 ? CheckCullData(mesh, parallel, config.Name) : meshletErrors;
+                    errors += Check(Identical(serial, parallel), "MeshletGenerator (%s): %ls gets other meshlets on 3 workers than on 1\n", config.Name, filename);
+                }
+            }
+        }
+    }
+
+    return errors;
+}
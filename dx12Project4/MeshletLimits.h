@@ -0,0 +1,22 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+// Included by both MeshletMS.hlsl and the C++ code, so the shader's output arrays and the largest
+// meshlets the generator will build can't disagree. Both must stay within the mesh shader's
+// 128 threads.
+#define MESHLET_MAX_VERTS 64
+#define MESHLET_MAX_PRIMS 126
+
+#ifdef __cplusplus
+const uint32_t c_maxMeshletVerts = MESHLET_MAX_VERTS;
+const uint32_t c_maxMeshletPrims = MESHLET_MAX_PRIMS;
+#endif
@@ -8,13 +8,15 @@
 // PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
 //
 //*********************************************************
+#include "MeshletLimits.h"
 
 #define ROOT_SIG "CBV(b0), \
                   RootConstants(b1, num32bitconstants=2), \
                   SRV(t0), \
                   SRV(t1), \
                   SRV(t2), \
-                  SRV(t3)"
+                  SRV(t3), \
+                  SRV(t4)"
 
 struct Constants
 {
@@ -25,9 +27,20 @@ struct Constants
 };
 
 struct MeshInfo
+{
+    uint MeshIndex;
+    uint MeshletOffset;
+};
+
+// Where the mesh's data starts in the bound buffers: zero when they are its own, and its place in the
+// shared buffers when the whole scene is packed together. UniqueIndexOffset is in bytes.
+struct MeshOffsets
 {
     uint IndexBytes;
+    uint VertexOffset;
     uint MeshletOffset;
+    uint UniqueIndexOffset;
+    uint PrimitiveOffset;
 };
 
 struct Vertex
@@ -59,6 +72,7 @@ StructuredBuffer<Vertex>  Vertices            : register(t0);
 StructuredBuffer<Meshlet> Meshlets            : register(t1);
 ByteAddressBuffer         UniqueVertexIndices : register(t2);
 StructuredBuffer<uint>    PrimitiveIndices    : register(t3);
+StructuredBuffer<MeshOffsets> MeshTable       : register(t4);
 
 
 /////
@@ -70,24 +84,24 @@ uint3 UnpackPrimitive(uint primitive)
     return uint3(primitive & 0x3FF, (primitive >> 10) & 0x3FF, (primitive >> 20) & 0x3FF);
 }
 
-uint3 GetPrimitive(Meshlet m, uint index)
+uint3 GetPrimitive(MeshOffsets mesh, Meshlet m, uint index)
 {
-    return UnpackPrimitive(PrimitiveIndices[m.PrimOffset + index]);
+    return UnpackPrimitive(PrimitiveIndices[mesh.PrimitiveOffset + m.PrimOffset + index]);
 }
 
-uint GetVertexIndex(Meshlet m, uint localIndex)
+uint GetVertexIndex(MeshOffsets mesh, Meshlet m, uint localIndex)
 {
     localIndex = m.VertOffset + localIndex;
 
-    if (MeshInfo.IndexBytes == 4) // 32-bit Vertex Indices
+    if (mesh.IndexBytes == 4) // 32-bit Vertex Indices
     {
-        return UniqueVertexIndices.Load(localIndex * 4);
+        return UniqueVertexIndices.Load(mesh.UniqueIndexOffset + localIndex * 4);
     }
     else // 16-bit Vertex Indices
     {
         // Byte address must be 4-byte aligned.
         uint wordOffset = (localIndex & 0x1);
-        uint byteOffset = (localIndex / 2) * 4;
+        uint byteOffset = mesh.UniqueIndexOffset + (localIndex / 2) * 4;
 
         // Grab the pair of 16-bit indices, shift & mask off proper 16-bits.
         uint indexPair = UniqueVertexIndices.Load(byteOffset);
@@ -117,22 +131,23 @@ VertexOut GetVertexAttributes(uint meshletIndex, uint vertexIndex)
 void main(
     uint gtid : SV_GroupThreadID,
     uint gid : SV_GroupID,
-    out indices uint3 tris[126],
-    out vertices VertexOut verts[64]
+    out indices uint3 tris[MESHLET_MAX_PRIMS],
+    out vertices VertexOut verts[MESHLET_MAX_VERTS]
 )
 {
-    Meshlet m = Meshlets[MeshInfo.MeshletOffset + gid];
+    MeshOffsets mesh = MeshTable[MeshInfo.MeshIndex];
+    Meshlet m = Meshlets[mesh.MeshletOffset + MeshInfo.MeshletOffset + gid];
 
     SetMeshOutputCounts(m.VertCount, m.PrimCount);
 
     if (gtid < m.PrimCount)
     {
-        tris[gtid] = GetPrimitive(m, gtid);
+        tris[gtid] = GetPrimitive(mesh, m, gtid);
     }
 
     if (gtid < m.VertCount)
     {
-        uint vertexIndex = GetVertexIndex(m, gtid);
+        uint vertexIndex = mesh.VertexOffset + GetVertexIndex(mesh, m, gtid);
         verts[gtid] = GetVertexAttributes(gid, vertexIndex);
     }
 }
@@ -10,184 +10,276 @@
 //*********************************************************
 #include "stdafx.h"
 #include "Model.h"
+#include "ModelFormat.h"
 
+#include "Compression.h"
 #include "DXBaiseHelper.h"
-
+#include "LinearArena.h"
+#include "UploadBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <unordered_set>
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
+using namespace ModelFormat;
 
 namespace
 {
-    const D3D12_INPUT_ELEMENT_DESC c_elementDescs[Attribute::Count] =
-    {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-        { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-        { "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
-    };
-
-    const uint32_t c_sizeMap[] =
-    {
-        12, // Position
-        12, // Normal
-        8,  // TexCoord
-        12, // Tangent
-        12, // Bitangent
-    };
+    const uint32_t c_boundsChunkSize = 16 * 1024; // Vertices per task when scanning for bounds
+    const uint64_t c_geometryAlignment = 16;      // Of GPU buffers read through root SRVs or as vertex and index buffers
 
-    const uint32_t c_prolog = 'MSHL';
+    const float c_noCone = 2.0f;            // MeshletTreeNode::ConeSin of a cone that rejects nothing
+    const float c_coneAxisError = 0.007f;   // Worst-case angle, in radians, between a UNORM8 axis and its source
+    const float c_treeRadiusSlack = 1e-5f;  // Relative growth of tree spheres to absorb rounding when culling
 
-    enum FileVersion
+    template <typename T>
+    size_t GetAlignedSize(T size)
     {
-        FILE_VERSION_INITIAL = 0,
-        CURRENT_FILE_VERSION = FILE_VERSION_INITIAL
-    };
+        const size_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+        const size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+        return alignedSize;
+    }
 
-    struct FileHeader
+    // In-place view of a complete MSHL file; all pointers alias the caller's storage.
+    struct FileLayout
     {
-        uint32_t Prolog;
-        uint32_t Version;
-
-        uint32_t MeshCount;
-        uint32_t AccessorCount;
-        uint32_t BufferViewCount;
-        uint32_t BufferSize;
+        const FileHeader*        Header;
+        const MeshHeader*        Meshes;
+        const Accessor*          Accessors;
+        const BufferView*        BufferViews;
+        const uint8_t*           Buffer;        // Null for compressed files until the blocks are decoded.
+
+        const CompressionHeader* Compressed;    // Null for uncompressed files.
+        const BlockHeader*       Blocks;
+        const uint8_t*           Payload;
+
+        const MeshBounds*        Bounds;        // Null when the file has no bounds section.
+        const BoundsRecord*      SubsetBounds;
     };
 
-    struct MeshHeader
+    HRESULT ParseBoundsSection(const uint8_t* data, size_t size, FileLayout& file)
     {
-        uint32_t Indices;
-        uint32_t IndexSubsets;
-        uint32_t Attributes[Attribute::Count];
+        if (size < sizeof(BoundsHeader))
+        {
+            return E_FAIL;
+        }
 
-        uint32_t Meshlets;
-        uint32_t MeshletSubsets;
-        uint32_t UniqueVertexIndices;
-        uint32_t PrimitiveIndices;
-        uint32_t CullData;
-    };
+        auto header = reinterpret_cast<const BoundsHeader*>(data);
 
-    struct BufferView
-    {
-        uint32_t Offset;
-        uint32_t Size;
-    };
+        if (header->Prolog != c_boundsProlog || header->MeshCount != file.Header->MeshCount)
+        {
+            return E_FAIL;
+        }
 
-    struct Accessor
-    {
-        uint32_t BufferView;
-        uint32_t Offset;
-        uint32_t Size;
-        uint32_t Stride;
-        uint32_t Count;
-    };
+        if (sizeof(BoundsHeader) + size_t(header->MeshCount) * sizeof(MeshBounds) + size_t(header->SubsetCount) * sizeof(BoundsRecord) != size)
+        {
+            return E_FAIL;
+        }
 
-    uint32_t GetFormatSize(DXGI_FORMAT format)
-    {
-        switch (format)
+        file.Bounds = reinterpret_cast<const MeshBounds*>(header + 1);
+        file.SubsetBounds = reinterpret_cast<const BoundsRecord*>(file.Bounds + header->MeshCount);
+
+        for (uint32_t i = 0; i < header->MeshCount; ++i)
         {
-        case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
-        case DXGI_FORMAT_R32G32B32_FLOAT: return 12;
-        case DXGI_FORMAT_R32G32_FLOAT: return 8;
-        case DXGI_FORMAT_R32_FLOAT: return 4;
-        default: throw std::exception("Unimplemented type");
+            if (size_t(file.Bounds[i].FirstSubset) + file.Bounds[i].SubsetCount > header->SubsetCount)
+            {
+                return E_FAIL;
+            }
         }
-    }
 
-    template <typename T, typename U>
-    constexpr T DivRoundUp(T num, U denom)
-    {
-        return (num + denom - 1) / denom;
+        return S_OK;
     }
 
-    template <typename T>
-    size_t GetAlignedSize(T size)
+    HRESULT ParseFileLayout(const uint8_t* data, size_t size, FileLayout& file)
     {
-        const size_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
-        const size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
-        return alignedSize;
-    }
-}
+        if (size < sizeof(FileHeader))
+        {
+            return E_FAIL;
+        }
 
-HRESULT Model::LoadFromFile(const wchar_t* filename)
-{
-    std::ifstream stream(filename, std::ios::binary);
-    if (!stream.is_open())
-    {
-        return E_INVALIDARG;
-    }
+        auto header = reinterpret_cast<const FileHeader*>(data);
 
-    std::vector<MeshHeader> meshes;
-    std::vector<BufferView> bufferViews;
-    std::vector<Accessor> accessors;
+        if (header->Prolog != c_prolog)
+        {
+            return E_FAIL; // Incorrect file format.
+        }
 
-    FileHeader header;
-    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (header->Version > CURRENT_FILE_VERSION)
+        {
+            return E_FAIL; // Version mismatch between export and import serialization code.
+        }
 
-    if (header.Prolog != c_prolog)
-    {
-        return E_FAIL; // Incorrect file format.
-    }
+        const size_t metadataSize = sizeof(FileHeader)
+            + size_t(header->MeshCount) * sizeof(MeshHeader)
+            + size_t(header->AccessorCount) * sizeof(Accessor)
+            + size_t(header->BufferViewCount) * sizeof(BufferView);
 
-    if (header.Version != CURRENT_FILE_VERSION)
-    {
-        return E_FAIL; // Version mismatch between export and import serialization code.
-    }
+        if (metadataSize > size)
+        {
+            return E_FAIL;
+        }
+
+        file.Header = header;
+        file.Meshes = reinterpret_cast<const MeshHeader*>(header + 1);
+        file.Accessors = reinterpret_cast<const Accessor*>(file.Meshes + header->MeshCount);
+        file.BufferViews = reinterpret_cast<const BufferView*>(file.Accessors + header->AccessorCount);
+        file.Buffer = nullptr;
+        file.Compressed = nullptr;
+        file.Blocks = nullptr;
+        file.Payload = nullptr;
+        file.Bounds = nullptr;
+        file.SubsetBounds = nullptr;
+
+        size_t dataEnd = 0;
+
+        if (header->Version == FILE_VERSION_INITIAL)
+        {
+            dataEnd = metadataSize + header->BufferSize;
+            if (dataEnd > size)
+            {
+                return E_FAIL; // There's a problem if the file isn't completely described by its header.
+            }
+
+            file.Buffer = data + metadataSize;
+        }
+        else
+        {
+            if (metadataSize + sizeof(CompressionHeader) > size)
+            {
+                return E_FAIL;
+            }
+
+            file.Compressed = reinterpret_cast<const CompressionHeader*>(data + metadataSize);
+            file.Blocks = reinterpret_cast<const BlockHeader*>(file.Compressed + 1);
+            file.Payload = reinterpret_cast<const uint8_t*>(file.Blocks + file.Compressed->BlockCount);
+
+            const size_t blockTableSize = sizeof(CompressionHeader) + size_t(file.Compressed->BlockCount) * sizeof(BlockHeader);
+            dataEnd = metadataSize + blockTableSize + file.Compressed->PayloadSize;
+            if (dataEnd > size)
+            {
+                return E_FAIL;
+            }
+
+            // Blocks must be sorted and disjoint so they can be decoded concurrently.
+            size_t blockEnd = 0;
+            for (uint32_t i = 0; i < file.Compressed->BlockCount; ++i)
+            {
+                const BlockHeader& block = file.Blocks[i];
+
+                if (block.Offset < blockEnd
+                    || size_t(block.Offset) + block.Size > header->BufferSize
+                    || size_t(block.PayloadOffset) + block.PayloadSize > file.Compressed->PayloadSize
+                    || block.Encoding > BLOCK_ENCODING_LZ_SHUFFLE
+                    || (block.Encoding == BLOCK_ENCODING_LZ_SHUFFLE && block.ElementSize == 0)
+                    || (block.Encoding == BLOCK_ENCODING_RAW && block.PayloadSize != block.Size))
+                {
+                    return E_FAIL;
+                }
+
+                blockEnd = size_t(block.Offset) + block.Size;
+            }
+        }
+
+        for (uint32_t i = 0; i < header->BufferViewCount; ++i)
+        {
+            if (size_t(file.BufferViews[i].Offset) + file.BufferViews[i].Size > header->BufferSize)
+            {
+                return E_FAIL;
+            }
+        }
 
-    // Read mesh metdata
-    meshes.resize(header.MeshCount);
-    stream.read(reinterpret_cast<char*>(meshes.data()), meshes.size() * sizeof(meshes[0]));
+        // Anything after the data must be a well-formed bounds section.
+        if (dataEnd != size)
+        {
+            return ParseBoundsSection(data + dataEnd, size - dataEnd, file);
+        }
+
+        return S_OK;
+    }
 
-    accessors.resize(header.AccessorCount);
-    stream.read(reinterpret_cast<char*>(accessors.data()), accessors.size() * sizeof(accessors[0]));
+    // Decodes every block of a compressed file directly into its final offset within buffer,
+    // which must be BufferSize bytes and zero-filled. Blocks are independent, so they're spread
+    // across the pool.
+    HRESULT DecodeBlocks(const FileLayout& file, uint8_t* buffer, ThreadPool& pool)
+    {
+        std::atomic<bool> failed{ false };
 
-    bufferViews.resize(header.BufferViewCount);
-    stream.read(reinterpret_cast<char*>(bufferViews.data()), bufferViews.size() * sizeof(bufferViews[0]));
+        pool.ParallelFor(file.Compressed->BlockCount, [&](uint32_t i)
+        {
+            const BlockHeader& block = file.Blocks[i];
+            const uint8_t* src = file.Payload + block.PayloadOffset;
+            uint8_t* dst = buffer + block.Offset;
 
-    m_buffer.resize(header.BufferSize);
-    stream.read(reinterpret_cast<char*>(m_buffer.data()), header.BufferSize);
+            switch (block.Encoding)
+            {
+            case BLOCK_ENCODING_RAW:
+                std::memcpy(dst, src, block.Size);
+                break;
 
-    char eofbyte;
-    stream.read(&eofbyte, 1); // Read last byte to hit the eof bit
+            case BLOCK_ENCODING_LZ:
+                if (!Compression::Decompress(src, block.PayloadSize, dst, block.Size))
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+                break;
 
-    assert(stream.eof()); // There's a problem if we didn't completely consume the file contents.
+            case BLOCK_ENCODING_LZ_SHUFFLE:
+            {
+                // Shuffled blocks need one extra pass; keep the staging buffer around per thread.
+                thread_local std::vector<uint8_t> staging;
+                staging.resize(block.Size);
+
+                if (Compression::Decompress(src, block.PayloadSize, staging.data(), block.Size))
+                {
+                    Compression::UnshuffleBytes(staging.data(), block.Size, block.ElementSize, dst);
+                }
+                else
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+                break;
+            }
+            }
+        });
 
-    stream.close();
+        return failed.load() ? E_FAIL : S_OK;
+    }
 
-    // Populate mesh data from binary data and metadata.
-    m_meshes.resize(meshes.size());
-    for (uint32_t i = 0; i < static_cast<uint32_t>(meshes.size()); ++i)
+    // Points the mesh's spans at its data within the file buffer.
+    void PopulateMesh(const FileLayout& file, uint32_t index, Mesh& mesh)
     {
-        auto& meshView = meshes[i];
-        auto& mesh = m_meshes[i];
+        auto& meshView = file.Meshes[index];
 
         // Index data
         {
-            Accessor& accessor = accessors[meshView.Indices];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.Indices];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
             mesh.IndexSize = accessor.Size;
             mesh.IndexCount = accessor.Count;
 
-            mesh.Indices = MakeSpan(m_buffer.data() + bufferView.Offset, bufferView.Size);
+            mesh.Indices = MakeSpan(file.Buffer + bufferView.Offset, bufferView.Size);
         }
 
         // Index Subset data
         {
-            Accessor& accessor = accessors[meshView.IndexSubsets];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.IndexSubsets];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            mesh.IndexSubsets = MakeSpan(reinterpret_cast<Subset*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            mesh.IndexSubsets = MakeSpan(reinterpret_cast<const Subset*>(file.Buffer + bufferView.Offset), accessor.Count);
         }
 
         // Vertex data & layout metadata
 
         // Determine the number of unique Buffer Views associated with the vertex attributes & copy vertex buffers.
-        std::vector<uint32_t> vbMap;
+        ScratchScope scratch;
+        ArenaVector<uint32_t> vbMap = scratch.MakeVector<uint32_t>();
 
         mesh.LayoutDesc.pInputElementDescs = mesh.LayoutElems;
         mesh.LayoutDesc.NumElements = 0;
@@ -197,7 +289,7 @@ HRESULT Model::LoadFromFile(const wchar_t* filename)
             if (meshView.Attributes[j] == -1)
                 continue;
 
-            Accessor& accessor = accessors[meshView.Attributes[j]];
+            const Accessor& accessor = file.Accessors[meshView.Attributes[j]];
 
             auto it = std::find(vbMap.begin(), vbMap.end(), accessor.BufferView);
             if (it != vbMap.end())
@@ -207,9 +299,9 @@ HRESULT Model::LoadFromFile(const wchar_t* filename)
 
             // New buffer view encountered; add to list and copy vertex data
             vbMap.push_back(accessor.BufferView);
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            Span<uint8_t> verts = MakeSpan(m_buffer.data() + bufferView.Offset, bufferView.Size);
+            Span<const uint8_t> verts = MakeSpan(file.Buffer + bufferView.Offset, bufferView.Size);
 
             mesh.VertexStrides.push_back(accessor.Stride);
             mesh.Vertices.push_back(verts);
@@ -222,7 +314,7 @@ HRESULT Model::LoadFromFile(const wchar_t* filename)
             if (meshView.Attributes[j] == -1)
                 continue;
 
-            Accessor& accessor = accessors[meshView.Attributes[j]];
+            const Accessor& accessor = file.Accessors[meshView.Attributes[j]];
 
             // Determine which vertex buffer index holds this attribute's data
             auto it = std::find(vbMap.begin(), vbMap.end(), accessor.BufferView);
@@ -235,270 +327,900 @@ HRESULT Model::LoadFromFile(const wchar_t* filename)
 
         // Meshlet data
         {
-            Accessor& accessor = accessors[meshView.Meshlets];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.Meshlets];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            mesh.Meshlets = MakeSpan(reinterpret_cast<Meshlet*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            mesh.Meshlets = MakeSpan(reinterpret_cast<const Meshlet*>(file.Buffer + bufferView.Offset), accessor.Count);
         }
 
         // Meshlet Subset data
         {
-            Accessor& accessor = accessors[meshView.MeshletSubsets];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.MeshletSubsets];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            mesh.MeshletSubsets = MakeSpan(reinterpret_cast<Subset*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            mesh.MeshletSubsets = MakeSpan(reinterpret_cast<const Subset*>(file.Buffer + bufferView.Offset), accessor.Count);
         }
 
         // Unique Vertex Index data
         {
-            Accessor& accessor = accessors[meshView.UniqueVertexIndices];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.UniqueVertexIndices];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            mesh.UniqueVertexIndices = MakeSpan(m_buffer.data() + bufferView.Offset, bufferView.Size);
+            mesh.UniqueVertexIndices = MakeSpan(file.Buffer + bufferView.Offset, bufferView.Size);
         }
 
         // Primitive Index data
         {
-            Accessor& accessor = accessors[meshView.PrimitiveIndices];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.PrimitiveIndices];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            mesh.PrimitiveIndices = MakeSpan(reinterpret_cast<PackedTriangle*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            mesh.PrimitiveIndices = MakeSpan(reinterpret_cast<const PackedTriangle*>(file.Buffer + bufferView.Offset), accessor.Count);
         }
 
         // Cull data
         {
-            Accessor& accessor = accessors[meshView.CullData];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            const Accessor& accessor = file.Accessors[meshView.CullData];
+            const BufferView& bufferView = file.BufferViews[accessor.BufferView];
 
-            mesh.CullingData = MakeSpan(reinterpret_cast<CullData*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            mesh.CullingData = MakeSpan(reinterpret_cast<const CullData*>(file.Buffer + bufferView.Offset), accessor.Count);
         }
     }
 
-    // Build bounding spheres for each mesh
-    for (uint32_t i = 0; i < static_cast<uint32_t>(m_meshes.size()); ++i)
+    // Copies the exported bounds of a mesh. Fails if the file has none, or if they don't cover every subset.
+    bool ReadPrecomputedBounds(const FileLayout& file, uint32_t index, Mesh& mesh)
     {
-        auto& m = m_meshes[i];
+        if (file.Bounds == nullptr || file.Bounds[index].SubsetCount != mesh.IndexSubsets.size())
+        {
+            return false;
+        }
 
-        uint32_t vbIndexPos = 0;
+        const MeshBounds& bounds = file.Bounds[index];
 
-        // Find the index of the vertex buffer of the position attribute
-        for (uint32_t j = 1; j < m.LayoutDesc.NumElements; ++j)
+        mesh.BoundingSphere = bounds.Bounds.Sphere;
+        mesh.BoundingBox = bounds.Bounds.Box;
+
+        mesh.SubsetBoundingSpheres.resize(bounds.SubsetCount);
+        mesh.SubsetBoundingBoxes.resize(bounds.SubsetCount);
+
+        for (uint32_t s = 0; s < bounds.SubsetCount; ++s)
+        {
+            mesh.SubsetBoundingSpheres[s] = file.SubsetBounds[bounds.FirstSubset + s].Sphere;
+            mesh.SubsetBoundingBoxes[s] = file.SubsetBounds[bounds.FirstSubset + s].Box;
+        }
+
+        return true;
+    }
+
+    // The fallback scan makes two SIMD passes over the points getIndex(begin) .. getIndex(end - 1):
+    // one for the box corners, then one for the largest squared distance from the box center,
+    // which becomes the sphere's radius. Unlike an incremental sphere fit, both passes split
+    // into independent ranges, so large meshes are spread across the thread pool.
+    template <typename GetIndex>
+    void AccumulateBox(const PositionStream& positions, uint32_t begin, uint32_t end, GetIndex getIndex, XMVECTOR& vmin, XMVECTOR& vmax)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            XMVECTOR p = XMLoadFloat3(&positions[getIndex(i)]);
+            vmin = XMVectorMin(vmin, p);
+            vmax = XMVectorMax(vmax, p);
+        }
+    }
+
+    template <typename GetIndex>
+    XMVECTOR AccumulateDistanceSq(const PositionStream& positions, uint32_t begin, uint32_t end, GetIndex getIndex, FXMVECTOR center)
+    {
+        XMVECTOR maxDistSq = XMVectorZero();
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            XMVECTOR p = XMLoadFloat3(&positions[getIndex(i)]);
+            maxDistSq = XMVectorMax(maxDistSq, XMVector3LengthSq(XMVectorSubtract(p, center)));
+        }
+
+        return maxDistSq;
+    }
+
+    void XM_CALLCONV StoreBounds(FXMVECTOR vmin, FXMVECTOR vmax, FXMVECTOR maxDistSq, BoundingSphere& sphere, BoundingBox& box)
+    {
+        BoundingBox::CreateFromPoints(box, vmin, vmax);
+
+        sphere.Center = box.Center;
+        sphere.Radius = XMVectorGetX(XMVectorSqrt(maxDistSq));
+    }
+
+    template <typename GetIndex>
+    void ComputeBounds(const PositionStream& positions, uint32_t begin, uint32_t end, GetIndex getIndex, BoundingSphere& sphere, BoundingBox& box)
+    {
+        if (begin == end)
         {
-            auto& desc = m.LayoutElems[j];
-            if (strcmp(desc.SemanticName, "POSITION") == 0)
+            sphere = BoundingSphere(XMFLOAT3(0, 0, 0), 0);
+            box = BoundingBox(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0));
+            return;
+        }
+
+        XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        AccumulateBox(positions, begin, end, getIndex, vmin, vmax);
+
+        XMVECTOR center = XMVectorScale(XMVectorAdd(vmin, vmax), 0.5f);
+        StoreBounds(vmin, vmax, AccumulateDistanceSq(positions, begin, end, getIndex, center), sphere, box);
+    }
+
+    // Scans the position stream for the bounds of the whole mesh and of each subset.
+    void ComputeMeshBounds(Mesh& mesh, ThreadPool& pool)
+    {
+        const PositionStream positions = mesh.GetPositions();
+        auto vertexIndex = [](uint32_t i) { return i; };
+
+        // Whole mesh: reduce the results of fixed-size vertex ranges.
+        {
+            const uint32_t chunkCount = DivRoundUp(mesh.VertexCount, c_boundsChunkSize);
+
+            ScratchScope scratch;
+            XMFLOAT3* chunkMin = scratch.Allocate<XMFLOAT3>(chunkCount);
+            XMFLOAT3* chunkMax = scratch.Allocate<XMFLOAT3>(chunkCount);
+
+            pool.ParallelFor(chunkCount, [&](uint32_t c)
             {
-                vbIndexPos = j;
-                break;
+                XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+                XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+                AccumulateBox(positions, c * c_boundsChunkSize, min((c + 1) * c_boundsChunkSize, mesh.VertexCount), vertexIndex, vmin, vmax);
+
+                XMStoreFloat3(&chunkMin[c], vmin);
+                XMStoreFloat3(&chunkMax[c], vmax);
+            });
+
+            XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+            XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                vmin = XMVectorMin(vmin, XMLoadFloat3(&chunkMin[c]));
+                vmax = XMVectorMax(vmax, XMLoadFloat3(&chunkMax[c]));
+            }
+
+            XMFLOAT3 center;
+            XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(vmin, vmax), 0.5f));
+
+            float* chunkDistSq = scratch.Allocate<float>(chunkCount);
+
+            pool.ParallelFor(chunkCount, [&](uint32_t c)
+            {
+                XMVECTOR distSq = AccumulateDistanceSq(positions, c * c_boundsChunkSize, min((c + 1) * c_boundsChunkSize, mesh.VertexCount), vertexIndex, XMLoadFloat3(&center));
+                chunkDistSq[c] = XMVectorGetX(distSq);
+            });
+
+            XMVECTOR maxDistSq = XMVectorZero();
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                maxDistSq = XMVectorMax(maxDistSq, XMVectorReplicate(chunkDistSq[c]));
+            }
+
+            if (chunkCount == 0)
+            {
+                vmin = vmax = XMVectorZero();
             }
+
+            StoreBounds(vmin, vmax, maxDistSq, mesh.BoundingSphere, mesh.BoundingBox);
         }
 
-        // Find the byte offset of the position attribute with its vertex buffer
-        uint32_t positionOffset = 0;
+        // Subsets: one task each, over the vertices referenced by the subset's indices.
+        const uint32_t subsetCount = static_cast<uint32_t>(mesh.IndexSubsets.size());
+
+        mesh.SubsetBoundingSpheres.resize(subsetCount);
+        mesh.SubsetBoundingBoxes.resize(subsetCount);
 
-        for (uint32_t j = 0; j < m.LayoutDesc.NumElements; ++j)
+        pool.ParallelFor(subsetCount, [&](uint32_t s)
         {
-            auto& desc = m.LayoutElems[j];
-            if (strcmp(desc.SemanticName, "POSITION") == 0)
+            const Subset& subset = mesh.IndexSubsets[s];
+            const uint32_t begin = subset.Offset;
+            const uint32_t end = subset.Offset + subset.Count;
+
+            if (mesh.IndexSize == 4)
             {
-                break;
+                const uint32_t* indices = reinterpret_cast<const uint32_t*>(mesh.Indices.data());
+                ComputeBounds(positions, begin, end, [indices](uint32_t i) { return indices[i]; }, mesh.SubsetBoundingSpheres[s], mesh.SubsetBoundingBoxes[s]);
+            }
+            else
+            {
+                const uint16_t* indices = reinterpret_cast<const uint16_t*>(mesh.Indices.data());
+                ComputeBounds(positions, begin, end, [indices](uint32_t i) { return uint32_t(indices[i]); }, mesh.SubsetBoundingSpheres[s], mesh.SubsetBoundingBoxes[s]);
             }
+        });
+    }
+
+    // Copies cull data into the arrays of a new CullDataSoA.
+    CullDataSoA MakeCullDataSoA(const CullData* cullData, uint32_t count)
+    {
+        const uint32_t paddedCount = DivRoundUp(count, CullDataSoA::LaneCount) * CullDataSoA::LaneCount;
+
+        CullDataSoA soa;
+        soa.Count = count;
+        soa.PaddedCount = paddedCount;
+
+        if (count > 0)
+        {
+            // Six 4-byte arrays, then the byte array; each 4-byte array is a multiple of 32 bytes long.
+            const size_t alignment = 32;
+            const size_t size = size_t(paddedCount) * (6 * sizeof(float) + sizeof(uint8_t));
 
-            if (desc.InputSlot == vbIndexPos)
+            soa.Storage.reset(new uint8_t[size + alignment - 1](), std::default_delete<uint8_t[]>());
+
+            uint8_t* base = soa.Storage.get();
+            base += (alignment - reinterpret_cast<uintptr_t>(base) % alignment) % alignment;
+
+            float* centerX = reinterpret_cast<float*>(base);
+            float* centerY = centerX + paddedCount;
+            float* centerZ = centerY + paddedCount;
+            float* radius = centerZ + paddedCount;
+            uint32_t* coneAxis = reinterpret_cast<uint32_t*>(radius + paddedCount);
+            float* apexOffset = reinterpret_cast<float*>(coneAxis + paddedCount);
+            uint8_t* coneCutoff = reinterpret_cast<uint8_t*>(apexOffset + paddedCount);
+
+            for (uint32_t i = 0; i < count; ++i)
             {
-                positionOffset += GetFormatSize(m.LayoutElems[j].Format);
+                const CullData& c = cullData[i];
+
+                centerX[i] = c.BoundingSphere.x;
+                centerY[i] = c.BoundingSphere.y;
+                centerZ[i] = c.BoundingSphere.z;
+                radius[i] = c.BoundingSphere.w;
+                coneAxis[i] = c.NormalCone[0] | (uint32_t(c.NormalCone[1]) << 8) | (uint32_t(c.NormalCone[2]) << 16);
+                coneCutoff[i] = c.NormalCone[3];
+                apexOffset[i] = c.ApexOffset;
             }
+
+            soa.CenterX = centerX;
+            soa.CenterY = centerY;
+            soa.CenterZ = centerZ;
+            soa.Radius = radius;
+            soa.ConeAxis = coneAxis;
+            soa.ConeCutoff = coneCutoff;
+            soa.ApexOffset = apexOffset;
         }
 
-        XMFLOAT3* v0 = reinterpret_cast<XMFLOAT3*>(m.Vertices[vbIndexPos].data() + positionOffset);
-        uint32_t stride = m.VertexStrides[vbIndexPos];
+        return soa;
+    }
 
-        BoundingSphere::CreateFromPoints(m.BoundingSphere, m.VertexCount, v0, stride);
+    struct TreeItem
+    {
+        XMFLOAT3 Center;
+        float    Radius;
+        XMFLOAT3 Axis;
+        float    HalfAngle;                  // XM_PIDIV2 when the meshlet's cone is degenerate
+        uint32_t Meshlet;
+    };
 
-        if (i == 0)
+    TreeItem MakeTreeItem(const CullData& c, uint32_t meshlet)
+    {
+        TreeItem item;
+        item.Center = XMFLOAT3(c.BoundingSphere.x, c.BoundingSphere.y, c.BoundingSphere.z);
+        item.Radius = c.BoundingSphere.w;
+        item.Meshlet = meshlet;
+
+        // Decode the cone as MeshAS does; the stored byte is the sine of its half-angle. Round both
+        // the axis and the angle outwards to cover quantization.
+        const XMVECTOR axis = XMVectorSubtract(XMVectorScale(XMVectorSet(c.NormalCone[0], c.NormalCone[1], c.NormalCone[2], 0), 2.0f / 255.0f), XMVectorSplatOne());
+        XMStoreFloat3(&item.Axis, XMVector3Normalize(axis));
+
+        item.HalfAngle = XM_PIDIV2;
+        if (c.NormalCone[3] < 254)
         {
-            m_boundingSphere = m.BoundingSphere;
+            item.HalfAngle = min(asinf((c.NormalCone[3] + 1) / 255.0f) + c_coneAxisError, XM_PIDIV2);
         }
-        else
+        return item;
+    }
+
+    // Bounds items [begin, end) with the sphere and normal cone in slot i of node.
+    void BoundTreeItems(const TreeItem* begin, const TreeItem* end, MeshletTreeNode& node, uint32_t i)
+    {
+        XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        XMVECTOR axisSum = XMVectorZero();
+
+        for (const TreeItem* item = begin; item != end; ++item)
+        {
+            const XMVECTOR center = XMLoadFloat3(&item->Center);
+            const XMVECTOR radius = XMVectorReplicate(item->Radius);
+            vmin = XMVectorMin(vmin, XMVectorSubtract(center, radius));
+            vmax = XMVectorMax(vmax, XMVectorAdd(center, radius));
+            axisSum = XMVectorAdd(axisSum, XMLoadFloat3(&item->Axis));
+        }
+
+        const XMVECTOR center = XMVectorScale(XMVectorAdd(vmin, vmax), 0.5f);
+
+        float radius = 0.0f;
+        float angle = 0.0f;
+        const bool hasAxis = XMVectorGetX(XMVector3LengthSq(axisSum)) > 1e-6f;
+        const XMVECTOR axis = XMVector3Normalize(axisSum);
+
+        for (const TreeItem* item = begin; item != end; ++item)
         {
-            BoundingSphere::CreateMerged(m_boundingSphere, m_boundingSphere, m.BoundingSphere);
+            radius = max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&item->Center), center))) + item->Radius);
+
+            const float cosine = XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&item->Axis)));
+            angle = max(angle, acosf(min(max(cosine, -1.0f), 1.0f)) + item->HalfAngle);
         }
+
+        XMFLOAT3 c;
+        XMStoreFloat3(&c, center);
+        const float extent = max(max(fabsf(c.x), fabsf(c.y)), fabsf(c.z));
+
+        XMFLOAT3 a;
+        XMStoreFloat3(&a, axis);
+
+        node.CenterX[i] = c.x;
+        node.CenterY[i] = c.y;
+        node.CenterZ[i] = c.z;
+        node.Radius[i] = radius + (radius + extent) * c_treeRadiusSlack;
+        node.ConeX[i] = a.x;
+        node.ConeY[i] = a.y;
+        node.ConeZ[i] = a.z;
+        node.ConeSin[i] = hasAxis && angle < XM_PIDIV2 ? sinf(angle) : c_noCone;
     }
 
-    return S_OK;
-}
+    // Partitions items along the longest axis of their centres' bounds. The first part gets half the
+    // leaves, rounded up to a multiple of granularity, so that subtrees and leaves stay full.
+    TreeItem* SplitTreeItems(TreeItem* begin, TreeItem* end, uint32_t granularity)
+    {
+        XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        for (const TreeItem* item = begin; item != end; ++item)
+        {
+            vmin = XMVectorMin(vmin, XMLoadFloat3(&item->Center));
+            vmax = XMVectorMax(vmax, XMLoadFloat3(&item->Center));
+        }
 
-HRESULT Model::UploadGpuResources(ID3D12Device* device, ID3D12CommandQueue* cmdQueue, ID3D12CommandAllocator* cmdAlloc, ID3D12GraphicsCommandList* cmdList)
-{
-    for (uint32_t i = 0; i < m_meshes.size(); ++i)
+        XMFLOAT3 extent;
+        XMStoreFloat3(&extent, XMVectorSubtract(vmax, vmin));
+        const uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+        const uint32_t leafCount = DivRoundUp(static_cast<uint32_t>(end - begin), MeshletTree::LeafSize);
+
+        TreeItem* mid = begin + DivRoundUp(DivRoundUp(leafCount, 2u), granularity) * granularity * MeshletTree::LeafSize;
+        std::nth_element(begin, mid, end, [axis](const TreeItem& a, const TreeItem& b)
+        {
+            return (&a.Center.x)[axis] < (&b.Center.x)[axis];
+        });
+        return mid;
+    }
+
+    // Builds the node over items [begin, end) and everything beneath it; returns its index.
+    uint32_t BuildTreeNode(TreeItem* begin, TreeItem* end, const CullData* cullData, MeshletTree& tree, ArenaVector<CullData>& leafData)
     {
-        auto& m = m_meshes[i];
+        const uint32_t nodeIndex = static_cast<uint32_t>(tree.Nodes.size());
+        tree.Nodes.emplace_back();
 
-        // Create committed D3D resources of proper sizes
-        auto indexDesc = CD3DX12_RESOURCE_DESC::Buffer(m.Indices.size());
-        auto meshletDesc = CD3DX12_RESOURCE_DESC::Buffer(m.Meshlets.size() * sizeof(m.Meshlets[0]));
-        auto cullDataDesc = CD3DX12_RESOURCE_DESC::Buffer(m.CullingData.size() * sizeof(m.CullingData[0]));
-        auto vertexIndexDesc = CD3DX12_RESOURCE_DESC::Buffer(DivRoundUp(m.UniqueVertexIndices.size(), 4) * 4);
-        auto primitiveDesc = CD3DX12_RESOURCE_DESC::Buffer(m.PrimitiveIndices.size() * sizeof(m.PrimitiveIndices[0]));
-        auto meshInfoDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(MeshInfo));
+        // Each child takes up to childLeaves leaves, the fewest that lets four children hold them
+        // all. Halve the items, then halve each half again while it is too big for one child.
+        const uint32_t leafCount = DivRoundUp(static_cast<uint32_t>(end - begin), MeshletTree::LeafSize);
 
-        auto defaultHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-        ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &indexDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.IndexResource)));
-        ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &meshletDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.MeshletResource)));
-        ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &cullDataDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.CullDataResource)));
-        ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &vertexIndexDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.UniqueVertexIndexResource)));
-        ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &primitiveDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.PrimitiveIndexResource)));
-        ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &meshInfoDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.MeshInfoResource)));
+        uint32_t childLeaves = 1;
+        while (childLeaves * 4 < leafCount)
+        {
+            childLeaves *= 4;
+        }
 
+        TreeItem* parts[5] = { begin, end };
+        uint32_t partCount = 1;
 
-        m.IBView.BufferLocation = m.IndexResource->GetGPUVirtualAddress();
-        m.IBView.Format = m.IndexSize == 4 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
-        m.IBView.SizeInBytes = m.IndexCount * m.IndexSize;
+        if (leafCount > 1)
+        {
+            TreeItem* mid = SplitTreeItems(begin, end, childLeaves);
+            partCount = 0;
 
-        m.VertexResources.resize(m.Vertices.size());
-        m.VBViews.resize(m.Vertices.size());
+            TreeItem* halves[3] = { begin, mid, end };
+            for (uint32_t h = 0; h < 2; ++h)
+            {
+                TreeItem* first = halves[h];
+                TreeItem* last = halves[h + 1];
+
+                parts[partCount++] = first;
+                if (size_t(last - first) > size_t(childLeaves) * MeshletTree::LeafSize)
+                {
+                    parts[partCount++] = SplitTreeItems(first, last, childLeaves);
+                }
+            }
+            parts[partCount] = end;
+        }
 
-        for (uint32_t j = 0; j < m.Vertices.size(); ++j)
+        MeshletTreeNode node = {};
+        for (uint32_t i = 0; i < 4; ++i)
         {
-            auto vertexDesc = CD3DX12_RESOURCE_DESC::Buffer(m.Vertices[j].size());
-            device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &vertexDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m.VertexResources[j]));
+            node.Radius[i] = -FLT_MAX;
+            node.ConeSin[i] = c_noCone;
+        }
 
-            m.VBViews[j].BufferLocation = m.VertexResources[j]->GetGPUVirtualAddress();
-            m.VBViews[j].SizeInBytes = static_cast<uint32_t>(m.Vertices[j].size());
-            m.VBViews[j].StrideInBytes = m.VertexStrides[j];
+        for (uint32_t i = 0; i < partCount; ++i)
+        {
+            BoundTreeItems(parts[i], parts[i + 1], node, i);
+
+            const uint32_t count = static_cast<uint32_t>(parts[i + 1] - parts[i]);
+            if (count <= MeshletTree::LeafSize)
+            {
+                const uint32_t first = static_cast<uint32_t>(leafData.size());
+                node.Child[i] = first;
+                node.LeafCount[i] = count;
+
+                leafData.resize(first + MeshletTree::LeafSize, CullData());
+                tree.MeshletIndices.resize(first + MeshletTree::LeafSize, 0);
+
+                for (uint32_t j = 0; j < count; ++j)
+                {
+                    leafData[first + j] = cullData[parts[i][j].Meshlet];
+                    tree.MeshletIndices[first + j] = parts[i][j].Meshlet;
+                }
+            }
+            else
+            {
+                node.Child[i] = BuildTreeNode(parts[i], parts[i + 1], cullData, tree, leafData);
+            }
         }
 
-        // Create upload resources
-        std::vector<ComPtr<ID3D12Resource>> vertexUploads;
-        ComPtr<ID3D12Resource>              indexUpload;
-        ComPtr<ID3D12Resource>              meshletUpload;
-        ComPtr<ID3D12Resource>              cullDataUpload;
-        ComPtr<ID3D12Resource>              uniqueVertexIndexUpload;
-        ComPtr<ID3D12Resource>              primitiveIndexUpload;
-        ComPtr<ID3D12Resource>              meshInfoUpload;
-
-        auto uploadHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &indexDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&indexUpload)));
-        ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &meshletDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&meshletUpload)));
-        ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &cullDataDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&cullDataUpload)));
-        ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &vertexIndexDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&uniqueVertexIndexUpload)));
-        ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &primitiveDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&primitiveIndexUpload)));
-        ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &meshInfoDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&meshInfoUpload)));
-
-        // Map & copy memory to upload heap
-        vertexUploads.resize(m.Vertices.size());
-        for (uint32_t j = 0; j < m.Vertices.size(); ++j)
+        tree.Nodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    // Finds the vertex buffer holding the attribute with the given semantic and its byte offset
+    // within each vertex. Returns null if the mesh has no such attribute.
+    const D3D12_INPUT_ELEMENT_DESC* FindAttribute(const Mesh& mesh, const char* semantic, uint32_t& slot, uint32_t& offset)
+    {
+        const D3D12_INPUT_ELEMENT_DESC* found = nullptr;
+
+        for (uint32_t j = 0; j < mesh.LayoutDesc.NumElements; ++j)
+        {
+            if (strcmp(mesh.LayoutElems[j].SemanticName, semantic) == 0)
+            {
+                found = &mesh.LayoutElems[j];
+                slot = found->InputSlot;
+                break;
+            }
+        }
+
+        offset = 0;
+
+        for (uint32_t j = 0; found != nullptr && j < mesh.LayoutDesc.NumElements; ++j)
         {
-            auto vertexDesc = CD3DX12_RESOURCE_DESC::Buffer(m.Vertices[j].size());
-            ThrowIfFailed(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &vertexDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&vertexUploads[j])));
+            auto& desc = mesh.LayoutElems[j];
+            if (&desc == found)
+            {
+                break;
+            }
 
-            uint8_t* memory = nullptr;
-            vertexUploads[j]->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, m.Vertices[j].data(), m.Vertices[j].size());
-            vertexUploads[j]->Unmap(0, nullptr);
+            if (desc.InputSlot == slot)
+            {
+                offset += GetFormatSize(desc.Format);
+            }
         }
 
+        return found;
+    }
+
+    // Builds the tree over the mesh's meshlet subsets; empty if CullingData doesn't cover them, so
+    // culling through it fails rather than reads out of bounds.
+    MeshletTree BuildMeshletTree(const Mesh& mesh)
+    {
+        MeshletTree tree;
+
+        const uint32_t meshletCount = static_cast<uint32_t>(mesh.CullingData.size());
+        const uint32_t subsetCount = static_cast<uint32_t>(mesh.MeshletSubsets.size());
+
+        for (uint32_t s = 0; s < subsetCount; ++s)
         {
-            uint8_t* memory = nullptr;
-            indexUpload->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, m.Indices.data(), m.Indices.size());
-            indexUpload->Unmap(0, nullptr);
+            if (size_t(mesh.MeshletSubsets[s].Offset) + mesh.MeshletSubsets[s].Count > meshletCount)
+            {
+                return MeshletTree();
+            }
         }
 
+        tree.Roots.resize(subsetCount, UINT32_MAX);
+
+        ScratchScope scratch;
+        ArenaVector<TreeItem> items = scratch.MakeVector<TreeItem>();
+        ArenaVector<CullData> leafData = scratch.MakeVector<CullData>();
+        items.reserve(meshletCount);
+
+        for (uint32_t s = 0; s < subsetCount; ++s)
         {
-            uint8_t* memory = nullptr;
-            meshletUpload->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, m.Meshlets.data(), m.Meshlets.size() * sizeof(m.Meshlets[0]));
-            meshletUpload->Unmap(0, nullptr);
+            const Subset& subset = mesh.MeshletSubsets[s];
+            if (subset.Count == 0)
+                continue;
+
+            items.clear();
+            for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+            {
+                items.push_back(MakeTreeItem(mesh.CullingData[i], i));
+            }
+
+            tree.Roots[s] = BuildTreeNode(items.data(), items.data() + items.size(), mesh.CullingData.data(), tree, leafData);
         }
 
+        tree.CullingData = MakeCullDataSoA(leafData.data(), static_cast<uint32_t>(leafData.size()));
+
+        return tree;
+    }
+}
+
+PositionStream Mesh::GetPositions() const
+{
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    FindAttribute(*this, "POSITION", slot, offset);
+
+    PositionStream positions = { Vertices[slot].data() + offset, VertexStrides[slot] };
+    return positions;
+}
+
+PositionStream Mesh::GetNormals() const
+{
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    const D3D12_INPUT_ELEMENT_DESC* desc = FindAttribute(*this, "NORMAL", slot, offset);
+
+    if (desc == nullptr || desc->Format != DXGI_FORMAT_R32G32B32_FLOAT)
+    {
+        PositionStream none = { nullptr, 0 };
+        return none;
+    }
+
+    PositionStream normals = { Vertices[slot].data() + offset, VertexStrides[slot] };
+    return normals;
+}
+
+void Mesh::ComputeBounds(ThreadPool& pool)
+{
+    ComputeMeshBounds(*this, pool);
+}
+
+const CullDataSoA& Mesh::GetCullDataSoA() const
+{
+    DerivedCullData& derived = *DerivedCulling;
+    std::call_once(derived.SoAOnce, [&]()
+    {
+        derived.SoA = MakeCullDataSoA(CullingData.data(), static_cast<uint32_t>(CullingData.size()));
+    });
+
+    return derived.SoA;
+}
+
+const MeshletTree& Mesh::GetMeshletTree() const
+{
+    DerivedCullData& derived = *DerivedCulling;
+    std::call_once(derived.TreeOnce, [&]()
+    {
+        derived.Tree = BuildMeshletTree(*this);
+    });
+
+    return derived.Tree;
+}
+
+void Mesh::ResetDerivedCullData()
+{
+    DerivedCulling = std::make_shared<DerivedCullData>();
+}
+
+Model::~Model()
+{
+    // The loader thread writes into this object; it must finish before we go away.
+    WaitForLoad();
+    ReleaseGpuResources();
+}
+
+HRESULT Model::LoadFromFile(const wchar_t* filename, ModelLoadMode mode, uint32_t flags)
+{
+    WaitForLoad();
+    ReleaseGpuResources();
+
+    return Load(filename, mode, nullptr, flags);
+}
+
+ModelLoadHandle Model::LoadFromFileAsync(const wchar_t* filename, ModelLoadMode mode, MeshReadyCallback onMeshReady, uint32_t flags)
+{
+    WaitForLoad();
+
+    // Load replaces the meshes, so their ranges must go back to the heap first, on this thread.
+    ReleaseGpuResources();
+
+    // Reset the published count before the worker starts so stale meshes are never reported as ready.
+    m_readyMeshCount.store(0, std::memory_order_release);
+
+    std::wstring path = filename;
+    m_loadTask = std::async(std::launch::async, [this, path, mode, onMeshReady, flags]()
+    {
+        return Load(path.c_str(), mode, onMeshReady, flags);
+    }).share();
+
+    return m_loadTask;
+}
+
+bool Model::IsLoading() const
+{
+    return m_loadTask.valid() && m_loadTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void Model::WaitForLoad()
+{
+    if (m_loadTask.valid())
+    {
+        m_loadTask.wait();
+    }
+}
+
+HRESULT Model::Load(const wchar_t* filename, ModelLoadMode mode, const MeshReadyCallback& onMeshReady, uint32_t flags)
+{
+    m_readyMeshCount.store(0, std::memory_order_release);
+
+    m_meshes.clear();
+    m_buffer.clear();
+    m_decodedBuffer.clear();
+    m_mapping.Close();
+    m_bytesCopied = 0;
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    if (mode == ModelLoadMode::MemoryMapped)
+    {
+        // Every span handed out below points directly into the mapped view.
+        HRESULT hr = m_mapping.Open(filename);
+        if (FAILED(hr))
         {
-            uint8_t* memory = nullptr;
-            cullDataUpload->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, m.CullingData.data(), m.CullingData.size() * sizeof(m.CullingData[0]));
-            cullDataUpload->Unmap(0, nullptr);
+            return hr;
         }
 
+        // Let the OS stream the file in while the header and metadata are being processed.
+        m_mapping.Prefetch();
+
+        data = m_mapping.data();
+        size = m_mapping.size();
+    }
+    else
+    {
+        std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+        if (!stream.is_open())
         {
-            uint8_t* memory = nullptr;
-            uniqueVertexIndexUpload->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, m.UniqueVertexIndices.data(), m.UniqueVertexIndices.size());
-            uniqueVertexIndexUpload->Unmap(0, nullptr);
+            return E_INVALIDARG;
         }
 
+        m_buffer.resize(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0);
+        stream.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+
+        if (!stream)
         {
-            uint8_t* memory = nullptr;
-            primitiveIndexUpload->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, m.PrimitiveIndices.data(), m.PrimitiveIndices.size() * sizeof(m.PrimitiveIndices[0]));
-            primitiveIndexUpload->Unmap(0, nullptr);
+            return E_FAIL;
         }
 
+        data = m_buffer.data();
+        size = m_buffer.size();
+        m_bytesCopied = size;
+    }
+
+    FileLayout file;
+    HRESULT hr = ParseFileLayout(data, size, file);
+
+    if (SUCCEEDED(hr) && file.Compressed != nullptr)
+    {
+        // Spans point into the decoded buffer; view padding isn't stored, so start from zeros.
+        m_decodedBuffer.assign(file.Header->BufferSize, 0);
+        m_bytesCopied += m_decodedBuffer.size();
+
+        hr = DecodeBlocks(file, m_decodedBuffer.data(), ThreadPool::GetDefault());
+        file.Buffer = m_decodedBuffer.data();
+    }
+
+    if (FAILED(hr))
+    {
+        m_buffer.clear();
+        m_decodedBuffer.clear();
+        m_mapping.Close();
+        m_bytesCopied = 0;
+        return hr;
+    }
+
+    // Size the mesh array up front; published meshes must never move underneath a reader.
+    m_meshes.resize(file.Header->MeshCount);
+
+    // Meshes are independent, so each is prepared by its own pool task; they are still published
+    // in file order, on this thread, as each one finishes.
+    ThreadPool& pool = ThreadPool::GetDefault();
+
+    std::vector<ThreadPool::TaskHandle> meshTasks(file.Header->MeshCount);
+    for (uint32_t i = 0; i < file.Header->MeshCount; ++i)
+    {
+        meshTasks[i] = pool.Schedule([this, &file, &pool, i, flags]()
         {
-            MeshInfo info = {};
-            info.IndexSize = m.IndexSize;
-            info.MeshletCount = static_cast<uint32_t>(m.Meshlets.size());
-            info.LastMeshletVertCount = m.Meshlets.back().VertCount;
-            info.LastMeshletPrimCount = m.Meshlets.back().PrimCount;
+            auto& mesh = m_meshes[i];
+
+            PopulateMesh(file, i, mesh);
+
+            if (flags & ModelLoadFlags_CullDataSoA)
+            {
+                mesh.GetCullDataSoA();
+            }
+            if (flags & ModelLoadFlags_MeshletTree)
+            {
+                mesh.GetMeshletTree();
+            }
+
+            if (!ReadPrecomputedBounds(file, i, mesh))
+            {
+                ComputeMeshBounds(mesh, pool);
+            }
+        });
+    }
+
+    BoundingSphere boundingSphere;
+    BoundingBox boundingBox;
+
+    for (uint32_t i = 0; i < file.Header->MeshCount; ++i)
+    {
+        auto& mesh = m_meshes[i];
 
+        pool.Wait(meshTasks[i]);
 
-            uint8_t* memory = nullptr;
-            meshInfoUpload->Map(0, nullptr, reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, &info, sizeof(MeshInfo));
-            meshInfoUpload->Unmap(0, nullptr);
+        if (i == 0)
+        {
+            boundingSphere = mesh.BoundingSphere;
+            boundingBox = mesh.BoundingBox;
+        }
+        else
+        {
+            BoundingSphere::CreateMerged(boundingSphere, boundingSphere, mesh.BoundingSphere);
+            BoundingBox::CreateMerged(boundingBox, boundingBox, mesh.BoundingBox);
         }
 
-        // Populate our command list
-        cmdList->Reset(cmdAlloc, nullptr);
+        // Publish the mesh; readers acquire this count before touching m_meshes[i].
+        m_readyMeshCount.store(i + 1, std::memory_order_release);
 
-        for (uint32_t j = 0; j < m.Vertices.size(); ++j)
+        if (onMeshReady)
         {
-            cmdList->CopyResource(m.VertexResources[j].Get(), vertexUploads[j].Get());
-            const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m.VertexResources[j].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-            cmdList->ResourceBarrier(1, &barrier);
+            onMeshReady(i);
         }
+    }
 
-        D3D12_RESOURCE_BARRIER postCopyBarriers[6];
+    m_boundingSphere = boundingSphere;
+    m_boundingBox = boundingBox;
 
-        cmdList->CopyResource(m.IndexResource.Get(), indexUpload.Get());
-        postCopyBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m.IndexResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    return S_OK;
+}
+
+HRESULT LoadModels(const std::vector<std::wstring>& filenames, std::vector<std::unique_ptr<Model>>& models, ModelLoadMode mode, ThreadPool& pool, std::vector<HRESULT>* results,
+    uint32_t flags)
+{
+    const uint32_t fileCount = static_cast<uint32_t>(filenames.size());
 
-        cmdList->CopyResource(m.MeshletResource.Get(), meshletUpload.Get());
-        postCopyBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m.MeshletResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    models.resize(fileCount);
+    std::vector<HRESULT> fileResults(fileCount, S_OK);
 
-        cmdList->CopyResource(m.CullDataResource.Get(), cullDataUpload.Get());
-        postCopyBarriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(m.CullDataResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    // One task per file: while one worker is blocked on I/O for its file, the others are
+    // fixing up metadata and computing bounds for theirs.
+    pool.ParallelFor(fileCount, [&](uint32_t i)
+    {
+        models[i] = std::make_unique<Model>();
+        fileResults[i] = models[i]->LoadFromFile(filenames[i].c_str(), mode, flags);
+    });
 
-        cmdList->CopyResource(m.UniqueVertexIndexResource.Get(), uniqueVertexIndexUpload.Get());
-        postCopyBarriers[3] = CD3DX12_RESOURCE_BARRIER::Transition(m.UniqueVertexIndexResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    HRESULT hr = S_OK;
+    for (HRESULT fileResult : fileResults)
+    {
+        if (FAILED(fileResult))
+        {
+            hr = fileResult;
+            break;
+        }
+    }
 
-        cmdList->CopyResource(m.PrimitiveIndexResource.Get(), primitiveIndexUpload.Get());
-        postCopyBarriers[4] = CD3DX12_RESOURCE_BARRIER::Transition(m.PrimitiveIndexResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    if (results != nullptr)
+    {
+        *results = std::move(fileResults);
+    }
 
-        cmdList->CopyResource(m.MeshInfoResource.Get(), meshInfoUpload.Get());
-        postCopyBarriers[5] = CD3DX12_RESOURCE_BARRIER::Transition(m.MeshInfoResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    return hr;
+}
 
-        cmdList->ResourceBarrier(ARRAYSIZE(postCopyBarriers), postCopyBarriers);
+HRESULT Model::UploadGpuResources(GeometryHeap& heap, UploadBatch& batch, uint32_t firstMesh, uint32_t meshCount)
+{
+    assert(m_geometryHeap == nullptr || m_geometryHeap == &heap);
+    m_geometryHeap = &heap;
 
-        ThrowIfFailed(cmdList->Close());
+    // Only meshes which have been published by the loader may be uploaded.
+    const uint32_t endMesh = min(GetReadyMeshCount(), meshCount == UINT32_MAX ? UINT32_MAX : firstMesh + meshCount);
 
-        ID3D12CommandList* ppCommandLists[] = { cmdList };
-        cmdQueue->ExecuteCommandLists(1, ppCommandLists);
+    for (uint32_t i = firstMesh; i < endMesh; ++i)
+    {
+        auto& m = m_meshes[i];
 
-        // Create our sync fence
-        ComPtr<ID3D12Fence> fence;
-        ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+        MeshInfo info = {};
+        info.IndexSize = m.IndexSize;
+        info.MeshletCount = static_cast<uint32_t>(m.Meshlets.size());
+        info.LastMeshletVertCount = m.Meshlets.back().VertCount;
+        info.LastMeshletPrimCount = m.Meshlets.back().PrimCount;
 
-        cmdQueue->Signal(fence.Get(), 1);
+        // Sub-allocate every buffer from the heap and stage its contents; the heap's pages need no
+        // transitions, so the batch records nothing but the copies.
+        struct
+        {
+            GeometryAllocation* Dest;
+            const void*         Data;
+            uint64_t            Size;
+            uint64_t            Alignment;
+        } const copies[] =
+        {
+            { &m.IndexBuffer,             m.Indices.data(),             m.Indices.size(),                                         c_geometryAlignment },
+            { &m.MeshletBuffer,           m.Meshlets.data(),            m.Meshlets.size() * sizeof(m.Meshlets[0]),                c_geometryAlignment },
+            { &m.CullDataBuffer,          m.CullingData.data(),         m.CullingData.size() * sizeof(m.CullingData[0]),          c_geometryAlignment },
+            { &m.UniqueVertexIndexBuffer, m.UniqueVertexIndices.data(), m.UniqueVertexIndices.size(),                             c_geometryAlignment },
+            { &m.PrimitiveIndexBuffer,    m.PrimitiveIndices.data(),    m.PrimitiveIndices.size() * sizeof(m.PrimitiveIndices[0]), c_geometryAlignment },
+            { &m.MeshInfoBuffer,          &info,                        sizeof(MeshInfo),                                         D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT },
+        };
+
+        m.VertexBuffers.resize(m.Vertices.size());
+        m.VBViews.resize(m.Vertices.size());
 
-        // Wait for GPU
-        if (fence->GetCompletedValue() != 1)
+        for (uint32_t j = 0; j < m.Vertices.size(); ++j)
         {
-            HANDLE event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-            fence->SetEventOnCompletion(1, event);
+            auto& buffer = m.VertexBuffers[j];
+
+            HRESULT hr = heap.Allocate(m.Vertices[j].size(), c_geometryAlignment, buffer);
+            if (SUCCEEDED(hr))
+            {
+                hr = batch.Stage(buffer.Resource, buffer.Offset, m.Vertices[j].data(), m.Vertices[j].size(), D3D12_RESOURCE_STATE_COMMON);
+            }
+            if (FAILED(hr))
+            {
+                return hr;
+            }
 
-            WaitForSingleObjectEx(event, INFINITE, false);
-            CloseHandle(event);
+            m.VBViews[j].BufferLocation = buffer.GpuAddress;
+            m.VBViews[j].SizeInBytes = static_cast<uint32_t>(m.Vertices[j].size());
+            m.VBViews[j].StrideInBytes = m.VertexStrides[j];
+        }
+
+        for (auto& copy : copies)
+        {
+            HRESULT hr = heap.Allocate(copy.Size, copy.Alignment, *copy.Dest);
+            if (SUCCEEDED(hr))
+            {
+                hr = batch.Stage(copy.Dest->Resource, copy.Dest->Offset, copy.Data, copy.Size, D3D12_RESOURCE_STATE_COMMON);
+            }
+            if (FAILED(hr))
+            {
+                return hr;
+            }
         }
+
+        m.IBView.BufferLocation = m.IndexBuffer.GpuAddress;
+        m.IBView.Format = m.IndexSize == 4 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+        m.IBView.SizeInBytes = m.IndexCount * m.IndexSize;
     }
 
     return S_OK;
 }
+
+void Model::ReleaseGpuResources()
+{
+    if (m_geometryHeap == nullptr)
+    {
+        return;
+    }
+
+    for (auto& m : m_meshes)
+    {
+        for (auto& buffer : m.VertexBuffers)
+        {
+            m_geometryHeap->Free(buffer);
+        }
+        m.VertexBuffers.clear();
+        m.VBViews.clear();
+        m.IBView = D3D12_INDEX_BUFFER_VIEW();
+
+        m_geometryHeap->Free(m.IndexBuffer);
+        m_geometryHeap->Free(m.MeshletBuffer);
+        m_geometryHeap->Free(m.CullDataBuffer);
+        m_geometryHeap->Free(m.UniqueVertexIndexBuffer);
+        m_geometryHeap->Free(m.PrimitiveIndexBuffer);
+        m_geometryHeap->Free(m.MeshInfoBuffer);
+    }
+
+    m_geometryHeap = nullptr;
+}
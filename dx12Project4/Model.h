@@ -10,10 +10,22 @@
 //*********************************************************
 #pragma once
 
+#include "GeometryHeap.h"
+#include "MappedFile.h"
 #include "Span.h"
+#include "ThreadPool.h"
 
 #include <DirectXCollision.h>
 
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class UploadBatch;
+
 struct Attribute
 {
     enum EType : uint32_t
@@ -67,38 +79,119 @@ struct CullData
     float             ApexOffset;     // apex = center - axis * offset
 };
 
+// Structure-of-arrays copy of a mesh's CullingData, so SIMD culling reads each field with aligned
+// loads and can skip the cone fields of meshlets the frustum test already rejected. Every array
+// starts on a 32-byte boundary and holds PaddedCount entries; the padding is zero. Copies of the
+// mesh share the storage, which is never modified after it is built.
+struct CullDataSoA
+{
+    static const uint32_t LaneCount = 8;
+
+    uint32_t        Count = 0;
+    uint32_t        PaddedCount = 0;            // Count rounded up to a multiple of LaneCount
+
+    const float*    CenterX = nullptr;
+    const float*    CenterY = nullptr;
+    const float*    CenterZ = nullptr;
+    const float*    Radius = nullptr;
+    const uint32_t* ConeAxis = nullptr;         // NormalCone with the cutoff byte cleared
+    const uint8_t*  ConeCutoff = nullptr;       // NormalCone[3]; 0xFF when degenerate
+    const float*    ApexOffset = nullptr;
+
+    std::shared_ptr<uint8_t> Storage;
+};
+
+// Four-wide node of a MeshletTree. Each child slot bounds everything beneath it with a sphere and a
+// normal cone, stored as arrays so that one node tests all four slots at once.
+struct alignas(16) MeshletTreeNode
+{
+    float    CenterX[4];
+    float    CenterY[4];
+    float    CenterZ[4];
+    float    Radius[4];     // -FLT_MAX for an empty slot, which every frustum test rejects
+    float    ConeX[4];      // Unit normal cone axis
+    float    ConeY[4];
+    float    ConeZ[4];
+    float    ConeSin[4];    // Sine of the cone's half-angle; 2 when the cone can't reject anything
+    uint32_t Child[4];      // Index of an inner node, or of a leaf's first MeshletTree::CullingData entry
+    uint32_t LeafCount[4];  // Meshlets in a leaf slot; 0 for inner nodes and empty slots
+};
+
+// Bounding volume hierarchy over the meshlets of each meshlet subset, so culling can reject whole
+// groups of meshlets with one test. A leaf holds up to LeafSize meshlets, and its cull data fills
+// one aligned SIMD group of CullingData; unused entries are zero.
+struct MeshletTree
+{
+    static const uint32_t LeafSize = CullDataSoA::LaneCount;
+
+    std::vector<MeshletTreeNode> Nodes;
+    std::vector<uint32_t>        Roots;          // Root node of each meshlet subset; UINT32_MAX if empty
+    CullDataSoA                  CullingData;
+    std::vector<uint32_t>        MeshletIndices; // Mesh::Meshlets index of each CullingData entry
+};
+
+// Copies of a mesh's CullingData in other layouts, each built once, on first use, and shared by
+// copies of the mesh.
+struct DerivedCullData
+{
+    std::once_flag SoAOnce;
+    CullDataSoA    SoA;
+
+    std::once_flag TreeOnce;
+    MeshletTree    Tree;
+};
+
+// Strided view of a three-component float attribute within a vertex buffer, such as the positions.
+struct PositionStream
+{
+    const uint8_t* Data;
+    uint32_t       Stride;
+
+    const DirectX::XMFLOAT3& operator[](uint32_t index) const
+    {
+        return *reinterpret_cast<const DirectX::XMFLOAT3*>(Data + size_t(index) * Stride);
+    }
+};
+
 struct Mesh
 {
     D3D12_INPUT_ELEMENT_DESC   LayoutElems[Attribute::Count];
     D3D12_INPUT_LAYOUT_DESC    LayoutDesc;
 
-    std::vector<Span<uint8_t>> Vertices;
+    std::vector<Span<const uint8_t>> Vertices;
     std::vector<uint32_t>      VertexStrides;
     uint32_t                   VertexCount;
     DirectX::BoundingSphere    BoundingSphere;
+    DirectX::BoundingBox       BoundingBox;
+
+    // Bounds of each subset's triangles, parallel to IndexSubsets and MeshletSubsets.
+    std::vector<DirectX::BoundingSphere> SubsetBoundingSpheres;
+    std::vector<DirectX::BoundingBox>    SubsetBoundingBoxes;
 
-    Span<Subset>               IndexSubsets;
-    Span<uint8_t>              Indices;
+    Span<const Subset>         IndexSubsets;
+    Span<const uint8_t>        Indices;
     uint32_t                   IndexSize;
     uint32_t                   IndexCount;
 
-    Span<Subset>               MeshletSubsets;
-    Span<Meshlet>              Meshlets;
-    Span<uint8_t>              UniqueVertexIndices;
-    Span<PackedTriangle>       PrimitiveIndices;
-    Span<CullData>             CullingData;
+    Span<const Subset>         MeshletSubsets;
+    Span<const Meshlet>        Meshlets;
+    Span<const uint8_t>        UniqueVertexIndices;
+    Span<const PackedTriangle> PrimitiveIndices;
+    Span<const CullData>       CullingData;
+    std::shared_ptr<DerivedCullData> DerivedCulling = std::make_shared<DerivedCullData>(); // Built on first use
 
     // D3D resource references
     std::vector<D3D12_VERTEX_BUFFER_VIEW>  VBViews;
     D3D12_INDEX_BUFFER_VIEW                IBView;
 
-    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> VertexResources;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              IndexResource;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              MeshletResource;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              UniqueVertexIndexResource;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              PrimitiveIndexResource;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              CullDataResource;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              MeshInfoResource;
+    // Ranges of the GeometryHeap the model was uploaded to
+    std::vector<GeometryAllocation>        VertexBuffers;
+    GeometryAllocation                     IndexBuffer;
+    GeometryAllocation                     MeshletBuffer;
+    GeometryAllocation                     UniqueVertexIndexBuffer;
+    GeometryAllocation                     PrimitiveIndexBuffer;
+    GeometryAllocation                     CullDataBuffer;
+    GeometryAllocation                     MeshInfoBuffer;
 
     // Calculates the number of instances of the last meshlet which can be packed into a single threadgroup.
     uint32_t GetLastMeshletPackCount(uint32_t subsetIndex, uint32_t maxGroupVerts, uint32_t maxGroupPrims)
@@ -120,6 +213,40 @@ struct Mesh
         i2 = prim.i2;
     }
 
+    uint32_t GetIndex(uint32_t index) const
+    {
+        const uint8_t* addr = Indices.data() + index * IndexSize;
+        if (IndexSize == 4)
+        {
+            return *reinterpret_cast<const uint32_t*>(addr);
+        }
+        else
+        {
+            return *reinterpret_cast<const uint16_t*>(addr);
+        }
+    }
+
+    PositionStream GetPositions() const;
+
+    // Data is null if the mesh has no three-component float normals.
+    PositionStream GetNormals() const;
+
+    // Recomputes the mesh and subset bounds from the vertices, as the loader does for files without them.
+    void ComputeBounds(ThreadPool& pool = ThreadPool::GetDefault());
+
+    // Structure-of-arrays copy of CullingData, built on first use unless the model was loaded with
+    // ModelLoadFlags_CullDataSoA. Safe to call from several threads at once.
+    const CullDataSoA& GetCullDataSoA() const;
+
+    // Tree over the meshlets of each meshlet subset, built on first use unless the model was loaded
+    // with ModelLoadFlags_MeshletTree. Empty if CullingData doesn't cover the meshlet subsets. Safe
+    // to call from several threads at once.
+    const MeshletTree& GetMeshletTree() const;
+
+    // Drops the copies GetCullDataSoA and GetMeshletTree built, so the next calls rebuild them. Call
+    // after pointing CullingData or MeshletSubsets at new data.
+    void ResetDerivedCullData();
+
     uint32_t GetVertexIndex(uint32_t index) const
     {
         const uint8_t* addr = UniqueVertexIndices.data() + index * IndexSize;
@@ -134,24 +261,92 @@ struct Mesh
     }
 };
 
+enum class ModelLoadMode
+{
+    Copy,           // Read the whole file into a heap buffer owned by the model.
+    MemoryMapped,   // Map the file and build every Span directly on top of the mapping.
+};
+
+// Work the loader may do up front rather than on first use.
+enum ModelLoadFlags : uint32_t
+{
+    ModelLoadFlags_None         = 0,
+    ModelLoadFlags_CullDataSoA  = 0x1,  // Build each mesh's GetCullDataSoA
+    ModelLoadFlags_MeshletTree  = 0x2,  // Build each mesh's GetMeshletTree
+};
+
+// Invoked on the loader thread as soon as the mesh at meshIndex may be read.
+using MeshReadyCallback = std::function<void(uint32_t meshIndex)>;
+
+// Completes with the HRESULT of an asynchronous load.
+using ModelLoadHandle = std::shared_future<HRESULT>;
+
 class Model
 {
 public:
-    HRESULT LoadFromFile(const wchar_t* filename);
-    HRESULT UploadGpuResources(ID3D12Device* device, ID3D12CommandQueue* cmdQueue, ID3D12CommandAllocator* cmdAlloc, ID3D12GraphicsCommandList* cmdList);
+    Model() = default;
+    ~Model();
+
+    // Both loads replace the current meshes, returning their GPU buffers to the heap first (see
+    // ReleaseGpuResources).
+    HRESULT LoadFromFile(const wchar_t* filename, ModelLoadMode mode = ModelLoadMode::Copy, uint32_t flags = ModelLoadFlags_None);
+
+    // Parses the file on a worker thread and returns immediately. Meshes are published in
+    // file order; the first GetReadyMeshCount() meshes are complete and safe to read or upload
+    // while the rest of the file is still being processed.
+    ModelLoadHandle LoadFromFileAsync(const wchar_t* filename, ModelLoadMode mode = ModelLoadMode::MemoryMapped, MeshReadyCallback onMeshReady = nullptr, uint32_t flags = ModelLoadFlags_None);
+    bool IsLoading() const;
+    void WaitForLoad();
+
+    // Allocates the GPU buffers of meshes [firstMesh, firstMesh + meshCount), clamped to the published
+    // meshes, from heap and stages their contents into batch. Nothing is uploaded until the batch is
+    // submitted, so the meshes of several calls, or models, can share one submission. Every call must
+    // pass the same heap, which must outlive the model.
+    HRESULT UploadGpuResources(GeometryHeap& heap, UploadBatch& batch, uint32_t firstMesh = 0, uint32_t meshCount = UINT32_MAX);
+
+    // Returns every mesh's buffers to the heap; also done by the destructor and before a reload. The
+    // GPU must be done with them.
+    void ReleaseGpuResources();
 
     uint32_t GetMeshCount() const { return static_cast<uint32_t>(m_meshes.size()); }
+    uint32_t GetReadyMeshCount() const { return m_readyMeshCount.load(std::memory_order_acquire); }
     const Mesh& GetMesh(uint32_t i) const { return m_meshes[i]; }
 
+    // Valid once loading has completed.
     const DirectX::BoundingSphere& GetBoundingSphere() const { return m_boundingSphere; }
+    const DirectX::BoundingBox& GetBoundingBox() const { return m_boundingBox; }
+
+    // Number of bytes copied into CPU memory by the last load: the file itself unless memory-mapped,
+    // plus the decoded buffer of a compressed file.
+    size_t GetBytesCopied() const { return m_bytesCopied; }
 
     // Iterator interface
     auto begin() { return m_meshes.begin(); }
     auto end() { return m_meshes.end(); }
+    auto begin() const { return m_meshes.begin(); }
+    auto end() const { return m_meshes.end(); }
+
+private:
+    HRESULT Load(const wchar_t* filename, ModelLoadMode mode, const MeshReadyCallback& onMeshReady, uint32_t flags);
 
 private:
     std::vector<Mesh>                      m_meshes;
     DirectX::BoundingSphere                m_boundingSphere;
+    DirectX::BoundingBox                   m_boundingBox;
 
     std::vector<uint8_t>                   m_buffer;
+    std::vector<uint8_t>                   m_decodedBuffer;
+    MappedFile                             m_mapping;
+    size_t                                 m_bytesCopied = 0;
+
+    std::atomic<uint32_t>                  m_readyMeshCount{ 0 };
+    ModelLoadHandle                        m_loadTask;
+
+    GeometryHeap*                          m_geometryHeap = nullptr;
 };
+
+// Loads several MSHL files concurrently, one pool task per file. results (optional) receives
+// one HRESULT per file; the return value is the first failure, or S_OK.
+HRESULT LoadModels(const std::vector<std::wstring>& filenames, std::vector<std::unique_ptr<Model>>& models,
+    ModelLoadMode mode = ModelLoadMode::MemoryMapped, ThreadPool& pool = ThreadPool::GetDefault(), std::vector<HRESULT>* results = nullptr,
+    uint32_t flags = ModelLoadFlags_None);
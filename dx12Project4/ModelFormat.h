@@ -0,0 +1,148 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "Model.h"
+
+// On-disk layout of MSHL model files, shared by the loader and the writer.
+namespace ModelFormat
+{
+    const D3D12_INPUT_ELEMENT_DESC c_elementDescs[Attribute::Count] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+        { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+        { "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 1 },
+    };
+
+    const uint32_t c_sizeMap[] =
+    {
+        12, // Position
+        12, // Normal
+        8,  // TexCoord
+        12, // Tangent
+        12, // Bitangent
+    };
+
+    const uint32_t c_prolog = 'MSHL';
+
+    enum FileVersion
+    {
+        FILE_VERSION_INITIAL = 0,
+        FILE_VERSION_COMPRESSED = 1,    // Buffer data stored as a table of (optionally) LZ-compressed blocks.
+        CURRENT_FILE_VERSION = FILE_VERSION_COMPRESSED
+    };
+
+    struct FileHeader
+    {
+        uint32_t Prolog;
+        uint32_t Version;
+
+        uint32_t MeshCount;
+        uint32_t AccessorCount;
+        uint32_t BufferViewCount;
+        uint32_t BufferSize;
+    };
+
+    struct MeshHeader
+    {
+        uint32_t Indices;
+        uint32_t IndexSubsets;
+        uint32_t Attributes[Attribute::Count];
+
+        uint32_t Meshlets;
+        uint32_t MeshletSubsets;
+        uint32_t UniqueVertexIndices;
+        uint32_t PrimitiveIndices;
+        uint32_t CullData;
+    };
+
+    struct BufferView
+    {
+        uint32_t Offset;
+        uint32_t Size;
+    };
+
+    struct Accessor
+    {
+        uint32_t BufferView;
+        uint32_t Offset;
+        uint32_t Size;
+        uint32_t Stride;
+        uint32_t Count;
+    };
+
+    inline uint32_t GetFormatSize(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+        case DXGI_FORMAT_R32G32B32_FLOAT: return 12;
+        case DXGI_FORMAT_R32G32_FLOAT: return 8;
+        case DXGI_FORMAT_R32_FLOAT: return 4;
+        default: throw std::exception("Unimplemented type");
+        }
+    }
+
+    // Version 1 files follow the buffer view table with a CompressionHeader, then
+    // CompressionHeader::BlockCount BlockHeaders, then the block payload. Each block
+    // covers part of exactly one buffer view and decodes to [Offset, Offset + Size) of the
+    // uncompressed buffer; bytes not covered by any block (view padding) are zero.
+    enum BlockEncoding : uint32_t
+    {
+        BLOCK_ENCODING_RAW = 0,         // Payload is the uncompressed bytes.
+        BLOCK_ENCODING_LZ = 1,          // Payload is an LZ-compressed stream (see Compression.h).
+        BLOCK_ENCODING_LZ_SHUFFLE = 2,  // As LZ, but the bytes of each ElementSize-byte element were transposed before compression.
+    };
+
+    struct CompressionHeader
+    {
+        uint32_t BlockCount;
+        uint32_t PayloadSize;
+    };
+
+    struct BlockHeader
+    {
+        uint32_t Offset;            // Destination offset within the uncompressed buffer
+        uint32_t Size;              // Uncompressed size
+        uint32_t PayloadOffset;     // Offset of the encoded bytes within the payload
+        uint32_t PayloadSize;       // Encoded size
+        uint32_t Encoding;          // BlockEncoding
+        uint32_t ElementSize;       // Shuffle granularity for BLOCK_ENCODING_LZ_SHUFFLE, otherwise unused
+    };
+
+    // Optional bounds section, appended after the buffer (v0) or the block payload (v1). Files
+    // without it end right after their data, so any trailing bytes are read as this section:
+    // a BoundsHeader, MeshCount MeshBounds, then SubsetCount BoundsRecords. A mesh's subset
+    // records parallel its IndexSubsets; SubsetCount of zero means they weren't exported.
+    const uint32_t c_boundsProlog = 'BNDS';
+
+    struct BoundsHeader
+    {
+        uint32_t Prolog;
+        uint32_t MeshCount;
+        uint32_t SubsetCount;
+    };
+
+    struct BoundsRecord
+    {
+        DirectX::BoundingSphere Sphere;
+        DirectX::BoundingBox    Box;
+    };
+
+    struct MeshBounds
+    {
+        BoundsRecord Bounds;
+        uint32_t     FirstSubset;
+        uint32_t     SubsetCount;
+    };
+}
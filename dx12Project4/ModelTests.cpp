@@ -0,0 +1,460 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "Model.h"
+#include "ModelFormat.h"
+#include "ModelWriter.h"
+#include "TestMeshes.h"
+
+#include <cstring>
+#include <memory>
+#include <fstream>
+#include <thread>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    // Returns the index of the first mesh that differs, or the smaller mesh count if the models
+    // differ only in length; the models match if that equals both counts.
+    uint32_t FirstDifference(const Model& a, const Model& b)
+    {
+        const uint32_t meshCount = min(a.GetMeshCount(), b.GetMeshCount());
+
+        uint32_t i = 0;
+        while (i < meshCount && SameMesh(a.GetMesh(i), b.GetMesh(i)))
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    bool SameModel(const Model& a, const Model& b)
+    {
+        return a.GetMeshCount() == b.GetMeshCount() && FirstDifference(a, b) == a.GetMeshCount();
+    }
+
+    // A memory-mapped load points every span into the mapping instead of a heap copy of the file;
+    // the meshes it builds must be the same, byte for byte.
+    uint32_t CheckMemoryMappedLoad(const std::wstring& path, const wchar_t* filename)
+    {
+        Model copied;
+        Model mapped;
+        if (FAILED(copied.LoadFromFile(path.c_str(), ModelLoadMode::Copy)) || FAILED(mapped.LoadFromFile(path.c_str(), ModelLoadMode::MemoryMapped)))
+        {
+            return Check(false, "Model: failed to load %ls\n", filename);
+        }
+
+        return Check(SameModel(copied, mapped), "Model: mesh %u of %ls differs between copied and memory-mapped loads\n", FirstDifference(copied, mapped), filename);
+    }
+
+    // Loads the file asynchronously while polling the published count. Each mesh must be
+    // announced once, in file order, only after it is published, and must match the mesh a
+    // synchronous load builds.
+    uint32_t CheckAsyncLoad(const std::wstring& path, const wchar_t* filename)
+    {
+        Model expected;
+        if (FAILED(expected.LoadFromFile(path.c_str())))
+        {
+            return Check(false, "Model: failed to load %ls\n", filename);
+        }
+
+        Model model;
+        uint32_t callbackCount = 0;
+        uint32_t outOfOrder = 0;
+        uint32_t unpublished = 0;
+        uint32_t mismatched = 0;
+
+        ModelLoadHandle handle = model.LoadFromFileAsync(path.c_str(), ModelLoadMode::MemoryMapped, [&](uint32_t meshIndex)
+        {
+            outOfOrder += meshIndex != callbackCount++;
+            unpublished += model.GetReadyMeshCount() <= meshIndex;
+            mismatched += meshIndex >= expected.GetMeshCount() || !SameMesh(model.GetMesh(meshIndex), expected.GetMesh(meshIndex));
+        });
+
+        uint32_t lastReady = 0;
+        uint32_t decreases = 0;
+        while (model.IsLoading())
+        {
+            const uint32_t ready = model.GetReadyMeshCount();
+            decreases += ready < lastReady;
+            lastReady = ready;
+            std::this_thread::yield();
+        }
+
+        const HRESULT hr = handle.get();
+        decreases += model.GetReadyMeshCount() < lastReady;
+
+        uint32_t errors = Check(SUCCEEDED(hr), "Model: asynchronous load of %ls failed (0x%08X)\n", filename, static_cast<uint32_t>(hr));
+        errors += Check(decreases == 0, "Model: the ready mesh count of %ls went down %u times\n", filename, decreases);
+        errors += Check(callbackCount == expected.GetMeshCount() && model.GetReadyMeshCount() == expected.GetMeshCount(),
+            "Model: %u callbacks and %u ready meshes for the %u meshes of %ls\n", callbackCount, model.GetReadyMeshCount(), expected.GetMeshCount(), filename);
+        errors += Check(outOfOrder == 0 && unpublished == 0, "Model: %u meshes of %ls announced out of file order, %u before being published\n", outOfOrder, filename, unpublished);
+        errors += Check(mismatched == 0 && SameModel(model, expected), "Model: %u meshes of %ls differ from a synchronous load\n", mismatched, filename);
+        return errors;
+    }
+
+    // A missing file and one that isn't an MSHL file must both fail through the handle, without
+    // publishing or announcing any mesh.
+    uint32_t CheckAsyncLoadFailure()
+    {
+        const wchar_t* const garbagePath = L"ModelTests.garbage.bin";
+        {
+            std::ofstream stream(garbagePath, std::ios::binary | std::ios::trunc);
+            stream << "This is not a model file.";
+        }
+
+        const wchar_t* const badPaths[] = { L"ModelTests.missing.bin", garbagePath };
+
+        uint32_t errors = 0;
+        for (auto path : badPaths)
+        {
+            Model model;
+            uint32_t callbackCount = 0;
+
+            const HRESULT hr = model.LoadFromFileAsync(path, ModelLoadMode::MemoryMapped, [&](uint32_t) { ++callbackCount; }).get();
+            errors += Check(FAILED(hr) && callbackCount == 0 && model.GetReadyMeshCount() == 0,
+                "Model: asynchronous load of %ls returned 0x%08X with %u meshes announced\n", path, static_cast<uint32_t>(hr), callbackCount);
+        }
+
+        _wremove(garbagePath);
+        return errors;
+    }
+
+    bool ReadFileBytes(const wchar_t* path, std::vector<uint8_t>& bytes)
+    {
+        std::ifstream stream(path, std::ios::binary | std::ios::ate);
+        if (!stream.is_open())
+        {
+            return false;
+        }
+
+        bytes.resize(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0);
+        stream.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+        return !stream.fail();
+    }
+
+    // Adds the number of blocks of a version 1 file stored with each encoding to counts: raw, LZ,
+    // LZ shuffled per 32-bit component, and LZ shuffled per element of another size.
+    bool CountBlockEncodings(const wchar_t* path, uint32_t (&counts)[4])
+    {
+        using namespace ModelFormat;
+
+        std::vector<uint8_t> bytes;
+        if (!ReadFileBytes(path, bytes) || bytes.size() < sizeof(FileHeader))
+        {
+            return false;
+        }
+
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(bytes.data());
+        const size_t blockTable = sizeof(FileHeader) + size_t(header->MeshCount) * sizeof(MeshHeader)
+            + size_t(header->AccessorCount) * sizeof(Accessor) + size_t(header->BufferViewCount) * sizeof(BufferView);
+        if (header->Version != FILE_VERSION_COMPRESSED || blockTable + sizeof(CompressionHeader) > bytes.size())
+        {
+            return false;
+        }
+
+        const CompressionHeader* compression = reinterpret_cast<const CompressionHeader*>(bytes.data() + blockTable);
+        if (blockTable + sizeof(CompressionHeader) + size_t(compression->BlockCount) * sizeof(BlockHeader) > bytes.size())
+        {
+            return false;
+        }
+
+        const BlockHeader* blocks = reinterpret_cast<const BlockHeader*>(compression + 1);
+        for (uint32_t i = 0; i < compression->BlockCount; ++i)
+        {
+            switch (blocks[i].Encoding)
+            {
+            case BLOCK_ENCODING_RAW:        counts[0]++; break;
+            case BLOCK_ENCODING_LZ:         counts[1]++; break;
+            case BLOCK_ENCODING_LZ_SHUFFLE: counts[blocks[i].ElementSize == 4 ? 2 : 3]++; break;
+            default:                        return false;
+            }
+        }
+        return true;
+    }
+
+    // Rewrites the asset uncompressed (v0) and block-compressed (v1) and reloads both copies, which
+    // must match the source in every span. The blocks are small so that the writer picks every
+    // encoding somewhere across the assets; their counts are added to encodingCounts.
+    uint32_t CheckWriteRoundTrip(const std::wstring& path, const wchar_t* filename, uint32_t (&encodingCounts)[4])
+    {
+        Model source;
+        if (FAILED(source.LoadFromFile(path.c_str())))
+        {
+            return Check(false, "Model: failed to load %ls\n", filename);
+        }
+
+        const wchar_t* const copyPath = L"ModelTests.copy.bin";
+        const bool versions[] = { false, true };
+
+        uint32_t errors = 0;
+        for (bool compress : versions)
+        {
+            ModelWriteOptions options;
+            options.Compress = compress;
+            options.BlockSize = 1024;
+
+            Model copy;
+            HRESULT hr = WriteModelFile(copyPath, source, options);
+            if (SUCCEEDED(hr))
+            {
+                hr = copy.LoadFromFile(copyPath);
+            }
+
+            errors += Check(SUCCEEDED(hr), "Model: writing and reloading %ls as v%u failed (0x%08X)\n", filename, uint32_t(compress), static_cast<uint32_t>(hr));
+            if (SUCCEEDED(hr))
+            {
+                errors += Check(SameModel(copy, source), "Model: mesh %u of %ls changes when written as v%u and reloaded\n", FirstDifference(copy, source), filename, uint32_t(compress));
+            }
+            if (SUCCEEDED(hr) && compress)
+            {
+                errors += Check(CountBlockEncodings(copyPath, encodingCounts), "Model: the v1 copy of %ls has a malformed block table\n", filename);
+            }
+        }
+
+        _wremove(copyPath);
+        return errors;
+    }
+
+    bool WriteFileBytes(const wchar_t* path, const std::vector<uint8_t>& bytes)
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return !stream.fail();
+    }
+
+    // Whether the sphere and box contain the point, allowing for the rounding of the radius and
+    // of the box's center and extents.
+    bool BoundsContain(const BoundingSphere& sphere, const BoundingBox& box, const XMFLOAT3& point)
+    {
+        const XMVECTOR p = XMLoadFloat3(&point);
+        const XMVECTOR center = XMLoadFloat3(&box.Center);
+        const XMVECTOR extents = XMLoadFloat3(&box.Extents);
+
+        const float scale = max(XMVectorGetX(XMVector3Length(p)), 1.0f);
+        const XMVECTOR tolerance = XMVectorReplicate(1e-5f * scale);
+
+        const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(p, XMLoadFloat3(&sphere.Center))));
+        return distance <= sphere.Radius + 1e-5f * scale
+            && XMVector3LessOrEqual(XMVectorAbs(XMVectorSubtract(p, center)), XMVectorAdd(extents, tolerance));
+    }
+
+    // Counts the mesh's vertices outside its bounds, and the vertices of each subset's triangles
+    // outside the subset's bounds; a subset without bounds misses all of them.
+    uint32_t CountUnboundedVertices(const Mesh& mesh)
+    {
+        const PositionStream positions = mesh.GetPositions();
+
+        uint32_t outside = 0;
+        for (uint32_t v = 0; v < mesh.VertexCount; ++v)
+        {
+            outside += !BoundsContain(mesh.BoundingSphere, mesh.BoundingBox, positions[v]);
+        }
+
+        for (uint32_t s = 0; s < mesh.IndexSubsets.size(); ++s)
+        {
+            const Subset& subset = mesh.IndexSubsets[s];
+            const bool hasBounds = s < mesh.SubsetBoundingSpheres.size() && s < mesh.SubsetBoundingBoxes.size();
+            for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+            {
+                outside += !hasBounds || !BoundsContain(mesh.SubsetBoundingSpheres[s], mesh.SubsetBoundingBoxes[s], positions[mesh.GetIndex(i)]);
+            }
+        }
+        return outside;
+    }
+
+    void GrowBounds(BoundingSphere& sphere, BoundingBox& box)
+    {
+        sphere.Center.x += 1.0f;
+        sphere.Radius = sphere.Radius * 2.0f + 3.0f;
+        box.Extents.y = box.Extents.y * 2.0f + 5.0f;
+    }
+
+    // Exported bounds must be read back as written: the mesh's bounds are grown before writing, so
+    // a loader that scanned the vertices instead would get other values. Without the section, the
+    // loader must compute bounds that contain every vertex. A v0 file whose trailing bytes aren't a
+    // well-formed bounds section must be rejected in either load mode.
+    uint32_t CheckBoundsSection(const std::wstring& path, const wchar_t* filename)
+    {
+        Model source;
+        if (FAILED(source.LoadFromFile(path.c_str())))
+        {
+            return Check(false, "Model: failed to load %ls\n", filename);
+        }
+
+        Mesh mesh = source.GetMesh(0);
+        GrowBounds(mesh.BoundingSphere, mesh.BoundingBox);
+        for (uint32_t s = 0; s < mesh.SubsetBoundingSpheres.size(); ++s)
+        {
+            GrowBounds(mesh.SubsetBoundingSpheres[s], mesh.SubsetBoundingBoxes[s]);
+        }
+
+        const wchar_t* const copyPath = L"ModelTests.bounds.bin";
+        const bool versions[] = { false, true };
+
+        uint32_t errors = 0;
+        for (bool compress : versions)
+        {
+            ModelWriteOptions options;
+            options.Compress = compress;
+
+            Model copy;
+            const bool loaded = SUCCEEDED(WriteModelFile(copyPath, &mesh, 1, options)) && SUCCEEDED(copy.LoadFromFile(copyPath));
+            errors += Check(loaded && copy.GetMeshCount() == 1 && SameBounds(copy.GetMesh(0), mesh),
+                "Model: the bounds %ls was written with as v%u don't come back unchanged\n", filename, uint32_t(compress));
+
+            options.WriteBounds = false;
+            const bool scanned = SUCCEEDED(WriteModelFile(copyPath, source, options)) && SUCCEEDED(copy.LoadFromFile(copyPath));
+            uint32_t outside = 0;
+            for (uint32_t i = 0; scanned && i < copy.GetMeshCount(); ++i)
+            {
+                outside += CountUnboundedVertices(copy.GetMesh(i));
+            }
+            errors += Check(scanned && outside == 0, "Model: bounds computed for %ls written as v%u without them miss %u vertices\n", filename, uint32_t(compress), outside);
+        }
+
+        // v0 files with and without the section; the section starts where the shorter one ends.
+        ModelWriteOptions options;
+        options.Compress = false;
+
+        std::vector<uint8_t> withBounds;
+        std::vector<uint8_t> withoutBounds;
+        bool written = SUCCEEDED(WriteModelFile(copyPath, source, options)) && ReadFileBytes(copyPath, withBounds);
+        options.WriteBounds = false;
+        written = written && SUCCEEDED(WriteModelFile(copyPath, source, options)) && ReadFileBytes(copyPath, withoutBounds);
+        written = written && withBounds.size() > withoutBounds.size() + sizeof(ModelFormat::BoundsHeader);
+
+        errors += Check(written, "Model: failed to write v0 copies of %ls\n", filename);
+        if (written)
+        {
+            const size_t sectionOffset = withoutBounds.size();
+
+            std::vector<uint8_t> truncated(withBounds.begin(), withBounds.end() - 1);
+            std::vector<uint8_t> prologOnly(withBounds.begin(), withBounds.begin() + sectionOffset + sizeof(uint32_t));
+
+            std::vector<uint8_t> garbage = withoutBounds;
+            garbage.insert(garbage.end(), 64, 0x5A);
+
+            std::vector<uint8_t> wrongMeshCount = withBounds;
+            reinterpret_cast<ModelFormat::BoundsHeader*>(wrongMeshCount.data() + sectionOffset)->MeshCount++;
+
+            const struct { const char* Name; const std::vector<uint8_t>& Bytes; } corruptions[] =
+            {
+                { "a truncated bounds section",       truncated },
+                { "only the bounds prolog",           prologOnly },
+                { "garbage after the buffer",         garbage },
+                { "bounds for another mesh count",    wrongMeshCount },
+            };
+
+            const ModelLoadMode modes[] = { ModelLoadMode::Copy, ModelLoadMode::MemoryMapped };
+
+            for (auto& corruption : corruptions)
+            {
+                for (auto mode : modes)
+                {
+                    Model copy;
+                    const bool rejected = WriteFileBytes(copyPath, corruption.Bytes) && FAILED(copy.LoadFromFile(copyPath, mode));
+                    errors += Check(rejected, "Model: a v0 copy of %ls with %s loads\n", filename, corruption.Name);
+                }
+            }
+        }
+
+        _wremove(copyPath);
+        return errors;
+    }
+
+    // Loads every asset, plus a missing file in the middle of the list, with LoadModels on pools of
+    // one and three workers. Each file's result and model must match a serial LoadFromFile, and
+    // the missing file's failure must be the one returned.
+    uint32_t CheckLoadModels(const std::wstring& assetDirectory)
+    {
+        std::vector<std::wstring> paths;
+        for (auto filename : c_assetFilenames)
+        {
+            paths.push_back(assetDirectory + filename);
+        }
+
+        const uint32_t missingFile = c_assetCount / 2;
+        paths.insert(paths.begin() + missingFile, assetDirectory + L"Missing.bin");
+
+        const ModelLoadMode modes[] = { ModelLoadMode::Copy, ModelLoadMode::MemoryMapped };
+        const uint32_t workerCounts[] = { 1, 3 };
+
+        uint32_t errors = 0;
+        for (auto mode : modes)
+        {
+            // The error a failed load returns depends on the mode.
+            std::vector<std::unique_ptr<Model>> expected;
+            std::vector<HRESULT> expectedResults;
+            for (auto& path : paths)
+            {
+                expected.push_back(std::make_unique<Model>());
+                expectedResults.push_back(expected.back()->LoadFromFile(path.c_str(), mode));
+            }
+
+            errors += Check(FAILED(expectedResults[missingFile]), "Model: loading a missing file succeeded\n");
+
+            for (uint32_t workerCount : workerCounts)
+            {
+                ThreadPool pool(workerCount);
+
+                std::vector<std::unique_ptr<Model>> models;
+                std::vector<HRESULT> results;
+                const HRESULT hr = LoadModels(paths, models, mode, pool, &results);
+
+                errors += Check(hr == expectedResults[missingFile], "LoadModels (%u workers): returned 0x%08X rather than the missing file's 0x%08X\n",
+                    workerCount, static_cast<uint32_t>(hr), static_cast<uint32_t>(expectedResults[missingFile]));
+                if (models.size() != paths.size() || results.size() != paths.size())
+                {
+                    errors += Check(false, "LoadModels (%u workers): %u models and %u results for %u files\n", workerCount,
+                        static_cast<uint32_t>(models.size()), static_cast<uint32_t>(results.size()), static_cast<uint32_t>(paths.size()));
+                    continue;
+                }
+
+                for (uint32_t i = 0; i < paths.size(); ++i)
+                {
+                    const bool same = results[i] == expectedResults[i] && models[i] != nullptr && (FAILED(results[i]) || SameModel(*models[i], *expected[i]));
+                    errors += Check(same, "LoadModels (%u workers): %ls doesn't match a serial load\n", workerCount, paths[i].c_str());
+                }
+            }
+        }
+
+        return errors;
+    }
+}
+
+// Loads each bundled asset through every path Model offers and checks they agree. Scratch files
+// are written to the working directory and removed afterwards.
+uint32_t Tests::TestModel(const std::wstring& assetDirectory)
+{
+    uint32_t errors = CheckAsyncLoadFailure();
+    errors += CheckLoadModels(assetDirectory);
+
+    uint32_t encodingCounts[4] = {};
+    for (auto filename : c_assetFilenames)
+    {
+        const std::wstring path = assetDirectory + filename;
+
+        errors += CheckMemoryMappedLoad(path, filename);
+        errors += CheckAsyncLoad(path, filename);
+        errors += CheckWriteRoundTrip(path, filename, encodingCounts);
+        errors += CheckBoundsSection(path, filename);
+    }
+
+    errors += Check(encodingCounts[0] > 0 && encodingCounts[1] > 0 && encodingCounts[2] > 0 && encodingCounts[3] > 0,
+        "Model: the v1 copies have %u raw, %u LZ, %u component-shuffled and %u element-shuffled blocks; each encoding should occur\n",
+        encodingCounts[0], encodingCounts[1], encodingCounts[2], encodingCounts[3]);
+    return errors;
+}
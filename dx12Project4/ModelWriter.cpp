@@ -0,0 +1,363 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "ModelWriter.h"
+#include "ModelFormat.h"
+
+#include "Compression.h"
+
+#include <fstream>
+
+using namespace ModelFormat;
+
+namespace
+{
+    // Matches the exporter, which starts every buffer view on a page boundary.
+    const size_t c_viewAlignment = 4096;
+
+    // Blocks that don't shrink by at least this fraction are stored raw; decoding them isn't worth it.
+    const double c_minCompressionGain = 1.0 / 32.0;
+
+    struct BufferBuilder
+    {
+        std::vector<uint8_t>    Buffer;
+        std::vector<BufferView> Views;
+        std::vector<uint32_t>   ViewStrides;    // Element size of each view; guides block shuffling.
+        std::vector<Accessor>   Accessors;
+
+        uint32_t AddView(const void* data, size_t size, uint32_t stride)
+        {
+            Buffer.resize((Buffer.size() + c_viewAlignment - 1) & ~(c_viewAlignment - 1));
+
+            BufferView view = { static_cast<uint32_t>(Buffer.size()), static_cast<uint32_t>(size) };
+            Buffer.insert(Buffer.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+            Views.push_back(view);
+            ViewStrides.push_back(stride);
+            return static_cast<uint32_t>(Views.size() - 1);
+        }
+
+        uint32_t AddAccessor(uint32_t view, uint32_t offset, uint32_t size, uint32_t stride, uint32_t count)
+        {
+            Accessor accessor = { view, offset, size, stride, count };
+            Accessors.push_back(accessor);
+            return static_cast<uint32_t>(Accessors.size() - 1);
+        }
+
+        template <typename T>
+        uint32_t AddArray(Span<T> data)
+        {
+            uint32_t view = AddView(data.data(), data.size() * sizeof(T), sizeof(T));
+            return AddAccessor(view, 0, sizeof(T), sizeof(T), static_cast<uint32_t>(data.size()));
+        }
+    };
+
+    int32_t FindAttribute(const char* semanticName)
+    {
+        for (uint32_t i = 0; i < Attribute::Count; ++i)
+        {
+            if (strcmp(c_elementDescs[i].SemanticName, semanticName) == 0)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Rebuilds the mesh's file header, accessors and buffer views from its in-memory spans.
+    MeshHeader AddMesh(const Mesh& mesh, BufferBuilder& builder)
+    {
+        MeshHeader header;
+        std::fill(std::begin(header.Attributes), std::end(header.Attributes), uint32_t(-1));
+
+        {
+            uint32_t view = builder.AddView(mesh.Indices.data(), mesh.Indices.size(), mesh.IndexSize);
+            header.Indices = builder.AddAccessor(view, 0, mesh.IndexSize, mesh.IndexSize, mesh.IndexCount);
+        }
+
+        header.IndexSubsets = builder.AddArray(mesh.IndexSubsets);
+
+        // One buffer view per vertex stream; attributes sharing a stream are interleaved in layout order.
+        std::vector<uint32_t> streamViews;
+        for (uint32_t j = 0; j < mesh.Vertices.size(); ++j)
+        {
+            streamViews.push_back(builder.AddView(mesh.Vertices[j].data(), mesh.Vertices[j].size(), mesh.VertexStrides[j]));
+        }
+
+        std::vector<uint32_t> streamOffsets(mesh.Vertices.size(), 0);
+        for (uint32_t j = 0; j < mesh.LayoutDesc.NumElements; ++j)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& desc = mesh.LayoutElems[j];
+            const uint32_t formatSize = GetFormatSize(desc.Format);
+
+            int32_t attribute = FindAttribute(desc.SemanticName);
+            if (attribute >= 0)
+            {
+                header.Attributes[attribute] = builder.AddAccessor(streamViews[desc.InputSlot], streamOffsets[desc.InputSlot], formatSize,
+                    mesh.VertexStrides[desc.InputSlot], mesh.VertexCount);
+            }
+
+            streamOffsets[desc.InputSlot] += formatSize;
+        }
+
+        header.Meshlets = builder.AddArray(mesh.Meshlets);
+        header.MeshletSubsets = builder.AddArray(mesh.MeshletSubsets);
+
+        {
+            uint32_t view = builder.AddView(mesh.UniqueVertexIndices.data(), mesh.UniqueVertexIndices.size(), mesh.IndexSize);
+            header.UniqueVertexIndices = builder.AddAccessor(view, 0, mesh.IndexSize, mesh.IndexSize,
+                static_cast<uint32_t>(mesh.UniqueVertexIndices.size() / mesh.IndexSize));
+        }
+
+        header.PrimitiveIndices = builder.AddArray(mesh.PrimitiveIndices);
+        header.CullData = builder.AddArray(mesh.CullingData);
+
+        return header;
+    }
+
+    // Returns the compressed bytes, or an empty vector if compression failed.
+    std::vector<uint8_t> CompressBlock(const uint8_t* src, size_t size)
+    {
+        std::vector<uint8_t> compressed(Compression::GetMaxCompressedSize(size));
+        compressed.resize(Compression::Compress(src, size, compressed.data(), compressed.size()));
+        return compressed;
+    }
+
+    struct EncodedBlock
+    {
+        BlockHeader          Header;
+        std::vector<uint8_t> Payload;
+    };
+
+    // Splits every buffer view into blocks and encodes each with whichever encoding is smallest.
+    // Shuffling is tried both per 32-bit component and per whole element of the view.
+    std::vector<EncodedBlock> EncodeBlocks(const BufferBuilder& builder, uint32_t blockSize)
+    {
+        std::vector<EncodedBlock> blocks;
+
+        for (uint32_t v = 0; v < builder.Views.size(); ++v)
+        {
+            const BufferView& view = builder.Views[v];
+
+            // Keep whole elements in each block so shuffled streams stay aligned.
+            const uint32_t stride = max(builder.ViewStrides[v], 1u);
+            const uint32_t viewBlockSize = max(blockSize / stride, 1u) * stride;
+
+            for (uint32_t offset = 0; offset < view.Size; offset += viewBlockSize)
+            {
+                EncodedBlock block = {};
+                block.Header.Offset = view.Offset + offset;
+                block.Header.Size = min(viewBlockSize, view.Size - offset);
+                block.Header.ElementSize = stride;
+                blocks.push_back(std::move(block));
+            }
+        }
+
+        ThreadPool::GetDefault().ParallelFor(static_cast<uint32_t>(blocks.size()), [&](uint32_t i)
+        {
+            BlockHeader& header = blocks[i].Header;
+            const uint8_t* src = builder.Buffer.data() + header.Offset;
+
+            // Start from the raw bytes and keep any encoding that beats the best so far.
+            const size_t worthwhileSize = header.Size - static_cast<size_t>(header.Size * c_minCompressionGain);
+
+            header.Encoding = BLOCK_ENCODING_RAW;
+            blocks[i].Payload.assign(src, src + header.Size);
+
+            auto consider = [&](std::vector<uint8_t>&& payload, BlockEncoding encoding, uint32_t elementSize)
+            {
+                if (!payload.empty() && payload.size() < worthwhileSize && payload.size() < blocks[i].Payload.size())
+                {
+                    header.Encoding = encoding;
+                    header.ElementSize = elementSize;
+                    blocks[i].Payload = std::move(payload);
+                }
+            };
+
+            const uint32_t stride = header.ElementSize;
+            std::vector<uint8_t> shuffled(header.Size);
+
+            auto considerShuffled = [&](uint32_t elementSize)
+            {
+                Compression::ShuffleBytes(src, header.Size, elementSize, shuffled.data());
+                consider(CompressBlock(shuffled.data(), header.Size), BLOCK_ENCODING_LZ_SHUFFLE, elementSize);
+            };
+
+            consider(CompressBlock(src, header.Size), BLOCK_ENCODING_LZ, 0);
+            considerShuffled(4);
+
+            if (stride > 1 && stride != 4)
+            {
+                considerShuffled(stride);
+            }
+
+            if (header.Encoding != BLOCK_ENCODING_LZ_SHUFFLE)
+            {
+                header.ElementSize = 0;
+            }
+
+            header.PayloadSize = static_cast<uint32_t>(blocks[i].Payload.size());
+        });
+
+        uint32_t payloadOffset = 0;
+        for (auto& block : blocks)
+        {
+            block.Header.PayloadOffset = payloadOffset;
+            payloadOffset += block.Header.PayloadSize;
+        }
+
+        return blocks;
+    }
+
+    template <typename T>
+    void Write(std::ofstream& stream, const T* data, size_t count)
+    {
+        stream.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+    }
+
+    void WriteBoundsSection(std::ofstream& stream, const std::vector<const Mesh*>& meshes)
+    {
+        std::vector<MeshBounds> meshBounds;
+        std::vector<BoundsRecord> subsetBounds;
+
+        for (auto mesh : meshes)
+        {
+            MeshBounds bounds;
+            bounds.Bounds.Sphere = mesh->BoundingSphere;
+            bounds.Bounds.Box = mesh->BoundingBox;
+            bounds.FirstSubset = static_cast<uint32_t>(subsetBounds.size());
+            bounds.SubsetCount = 0;
+
+            // Meshes built without per-subset bounds export none; the loader computes them.
+            const size_t subsetCount = mesh->IndexSubsets.size();
+            if (mesh->SubsetBoundingSpheres.size() == subsetCount && mesh->SubsetBoundingBoxes.size() == subsetCount)
+            {
+                for (size_t s = 0; s < subsetCount; ++s)
+                {
+                    BoundsRecord record;
+                    record.Sphere = mesh->SubsetBoundingSpheres[s];
+                    record.Box = mesh->SubsetBoundingBoxes[s];
+                    subsetBounds.push_back(record);
+                }
+                bounds.SubsetCount = static_cast<uint32_t>(subsetCount);
+            }
+
+            meshBounds.push_back(bounds);
+        }
+
+        BoundsHeader header = {};
+        header.Prolog = c_boundsProlog;
+        header.MeshCount = static_cast<uint32_t>(meshBounds.size());
+        header.SubsetCount = static_cast<uint32_t>(subsetBounds.size());
+
+        Write(stream, &header, 1);
+        Write(stream, meshBounds.data(), meshBounds.size());
+        Write(stream, subsetBounds.data(), subsetBounds.size());
+    }
+
+    HRESULT WriteMeshes(const wchar_t* filename, const std::vector<const Mesh*>& meshes, const ModelWriteOptions& options)
+    {
+        if (options.BlockSize == 0)
+        {
+            return E_INVALIDARG;
+        }
+
+        BufferBuilder builder;
+        std::vector<MeshHeader> meshHeaders;
+
+        for (auto mesh : meshes)
+        {
+            meshHeaders.push_back(AddMesh(*mesh, builder));
+        }
+
+        builder.Buffer.resize((builder.Buffer.size() + c_viewAlignment - 1) & ~(c_viewAlignment - 1));
+
+        FileHeader header = {};
+        header.Prolog = c_prolog;
+        header.Version = options.Compress ? FILE_VERSION_COMPRESSED : FILE_VERSION_INITIAL;
+        header.MeshCount = static_cast<uint32_t>(meshes.size());
+        header.AccessorCount = static_cast<uint32_t>(builder.Accessors.size());
+        header.BufferViewCount = static_cast<uint32_t>(builder.Views.size());
+        header.BufferSize = static_cast<uint32_t>(builder.Buffer.size());
+
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+        {
+            return E_INVALIDARG;
+        }
+
+        Write(stream, &header, 1);
+        Write(stream, meshHeaders.data(), meshHeaders.size());
+        Write(stream, builder.Accessors.data(), builder.Accessors.size());
+        Write(stream, builder.Views.data(), builder.Views.size());
+
+        if (options.Compress)
+        {
+            auto blocks = EncodeBlocks(builder, options.BlockSize);
+
+            CompressionHeader compression = {};
+            compression.BlockCount = static_cast<uint32_t>(blocks.size());
+            for (auto& block : blocks)
+            {
+                compression.PayloadSize += block.Header.PayloadSize;
+            }
+
+            // Pad so that any section following the payload stays 4-byte aligned.
+            const uint32_t padding[1] = {};
+            const uint32_t paddingSize = (4 - compression.PayloadSize % 4) % 4;
+            compression.PayloadSize += paddingSize;
+
+            Write(stream, &compression, 1);
+            for (auto& block : blocks)
+            {
+                Write(stream, &block.Header, 1);
+            }
+            for (auto& block : blocks)
+            {
+                Write(stream, block.Payload.data(), block.Payload.size());
+            }
+            Write(stream, reinterpret_cast<const uint8_t*>(padding), paddingSize);
+        }
+        else
+        {
+            Write(stream, builder.Buffer.data(), builder.Buffer.size());
+        }
+
+        if (options.WriteBounds)
+        {
+            WriteBoundsSection(stream, meshes);
+        }
+
+        return stream ? S_OK : E_FAIL;
+    }
+}
+
+HRESULT WriteModelFile(const wchar_t* filename, const Mesh* meshes, uint32_t meshCount, const ModelWriteOptions& options)
+{
+    std::vector<const Mesh*> meshPtrs;
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        meshPtrs.push_back(&meshes[i]);
+    }
+
+    return WriteMeshes(filename, meshPtrs, options);
+}
+
+HRESULT WriteModelFile(const wchar_t* filename, const Model& model, const ModelWriteOptions& options)
+{
+    std::vector<const Mesh*> meshPtrs;
+    for (uint32_t i = 0; i < model.GetMeshCount(); ++i)
+    {
+        meshPtrs.push_back(&model.GetMesh(i));
+    }
+
+    return WriteMeshes(filename, meshPtrs, options);
+}
@@ -0,0 +1,24 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "Model.h"
+
+struct ModelWriteOptions
+{
+    bool     Compress = true;       // Write FILE_VERSION_COMPRESSED; otherwise the raw FILE_VERSION_INITIAL layout.
+    uint32_t BlockSize = 64 * 1024; // Maximum uncompressed bytes per block. Smaller blocks decode with more parallelism.
+    bool     WriteBounds = true;    // Append each mesh's and subset's bounds so the loader needn't scan the vertices.
+};
+
+// Serializes meshes into an MSHL file that Model::LoadFromFile can read back.
+HRESULT WriteModelFile(const wchar_t* filename, const Mesh* meshes, uint32_t meshCount, const ModelWriteOptions& options = ModelWriteOptions());
+HRESULT WriteModelFile(const wchar_t* filename, const Model& model, const ModelWriteOptions& options = ModelWriteOptions());
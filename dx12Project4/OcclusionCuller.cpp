@@ -0,0 +1,729 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "OcclusionCuller.h"
+
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+    const float c_infinity = INFINITY;
+
+    enum ClipCode : uint32_t
+    {
+        CLIP_LEFT   = 0x01,
+        CLIP_RIGHT  = 0x02,
+        CLIP_BOTTOM = 0x04,
+        CLIP_TOP    = 0x08,
+        CLIP_NEAR   = 0x10,
+        CLIP_FAR    = 0x20,
+    };
+
+    uint32_t GetClipCode(const XMFLOAT4& v)
+    {
+        return (v.x < -v.w ? CLIP_LEFT : 0) | (v.x > v.w ? CLIP_RIGHT : 0) |
+            (v.y < -v.w ? CLIP_BOTTOM : 0) | (v.y > v.w ? CLIP_TOP : 0) |
+            (v.z < 0.0f ? CLIP_NEAR : 0) | (v.z > v.w ? CLIP_FAR : 0);
+    }
+
+    uint32_t ReadIndex(const uint8_t* indices, uint32_t indexSize, uint32_t i)
+    {
+        if (indexSize == 4)
+        {
+            uint32_t index;
+            std::memcpy(&index, indices + size_t(i) * 4, sizeof(index));
+            return index;
+        }
+
+        uint16_t index;
+        std::memcpy(&index, indices + size_t(i) * 2, sizeof(index));
+        return index;
+    }
+
+    // Bits [lo, hi) of a row of a tile.
+    uint32_t SpanMask(int32_t lo, int32_t hi)
+    {
+        return hi > lo ? static_cast<uint32_t>((uint64_t(1) << hi) - (uint64_t(1) << lo)) : 0;
+    }
+
+    bool IsZero(__m128i v)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_setzero_si128())) == 0xFFFF;
+    }
+
+    bool IsFull(__m128i v)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_set1_epi32(-1))) == 0xFFFF;
+    }
+
+    // ceil(v) for v >= 0; SSE2 has no rounding instruction.
+    __m128 Ceil(__m128 v)
+    {
+        const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        return _mm_add_ps(t, _mm_and_ps(_mm_cmplt_ps(t, v), _mm_set1_ps(1.0f)));
+    }
+
+    // floor(v) for v >= 0.
+    __m128 Floor(__m128 v)
+    {
+        return _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+    }
+
+    float HorizontalMin(__m128 v)
+    {
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    float HorizontalMax(__m128 v)
+    {
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    // A scan-converting edge: for a pixel row at height y its boundary lies at X + Slope * (y - Y).
+    struct SpanEdge
+    {
+        __m128 X;
+        __m128 Y;
+        __m128 Slope;
+    };
+
+    SpanEdge MakeSpanEdge(float x, float y, float slope)
+    {
+        SpanEdge e = { _mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(slope) };
+        return e;
+    }
+
+    __m128 EvaluateSpanEdge(const SpanEdge& e, __m128 y)
+    {
+        return _mm_add_ps(e.X, _mm_mul_ps(e.Slope, _mm_sub_ps(y, e.Y)));
+    }
+}
+
+HRESULT BuildOccluderMesh(const Mesh& mesh, uint32_t maxTriangles, OccluderMesh& occluder)
+{
+    const PositionStream positions = mesh.GetPositions();
+    if (positions.Data == nullptr || (mesh.IndexSize != 2 && mesh.IndexSize != 4))
+    {
+        return E_INVALIDARG;
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.IndexCount);
+
+    for (uint32_t s = 0; s < mesh.IndexSubsets.size(); ++s)
+    {
+        const Subset& subset = mesh.IndexSubsets[s];
+        if (size_t(subset.Offset) + subset.Count > mesh.IndexCount)
+        {
+            return E_INVALIDARG;
+        }
+
+        for (uint32_t i = 0; i < subset.Count - subset.Count % 3; ++i)
+        {
+            const uint32_t index = mesh.GetIndex(subset.Offset + i);
+            if (index >= mesh.VertexCount)
+            {
+                return E_INVALIDARG;
+            }
+            indices.push_back(index);
+        }
+    }
+
+    std::vector<XMFLOAT3> vertices(mesh.VertexCount);
+    for (uint32_t v = 0; v < mesh.VertexCount; ++v)
+    {
+        vertices[v] = positions[v];
+    }
+
+    if (indices.size() / 3 > maxTriangles)
+    {
+        SimplifyOptions options;
+        options.TargetTriangleCount = maxTriangles;
+        options.KeepInside = true;
+
+        const HRESULT hr = SimplifyTriangles(vertices.data(), nullptr, mesh.VertexCount, nullptr, indices, options);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    // Keep only the vertices the triangles still use, in first-use order.
+    std::vector<uint32_t> remap(mesh.VertexCount, UINT32_MAX);
+
+    occluder.Positions.clear();
+    occluder.Indices.resize(indices.size());
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        uint32_t& slot = remap[indices[i]];
+        if (slot == UINT32_MAX)
+        {
+            slot = static_cast<uint32_t>(occluder.Positions.size());
+            occluder.Positions.push_back(vertices[indices[i]]);
+        }
+        occluder.Indices[i] = slot;
+    }
+
+    return S_OK;
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+    : m_width(width)
+    , m_height(height)
+    , m_tilesX(width / TileWidth)
+    , m_tilesY(height / TileHeight)
+    , m_tiles(m_tilesX * m_tilesY)
+    , m_stats()
+{
+    assert(width % TileWidth == 0 && height % TileHeight == 0);
+
+    Clear(XMMatrixIdentity());
+}
+
+void OcclusionCuller::Clear(FXMMATRIX viewProj)
+{
+    XMStoreFloat4x4(&m_viewProj, viewProj);
+
+    for (auto& tile : m_tiles)
+    {
+        std::memset(tile.Mask, 0, sizeof(tile.Mask));
+        tile.ZMax[0] = 1.0f;
+        tile.ZMax[1] = 0.0f;
+    }
+
+    m_stats = OcclusionStats();
+}
+
+void OcclusionCuller::RenderOccluder(const Mesh& mesh, FXMMATRIX world)
+{
+    const PositionStream positions = mesh.GetPositions();
+    if (positions.Data == nullptr)
+        return;
+
+    RenderTriangles(positions.Data, positions.Stride, mesh.VertexCount, mesh.Indices.data(), mesh.IndexSize, mesh.IndexCount, world);
+}
+
+void OcclusionCuller::RenderOccluder(const OccluderMesh& occluder, FXMMATRIX world)
+{
+    RenderTriangles(reinterpret_cast<const uint8_t*>(occluder.Positions.data()), sizeof(XMFLOAT3), static_cast<uint32_t>(occluder.Positions.size()),
+        reinterpret_cast<const uint8_t*>(occluder.Indices.data()), sizeof(uint32_t), static_cast<uint32_t>(occluder.Indices.size()), world);
+}
+
+HRESULT OcclusionCuller::RenderMeshlets(const Mesh& mesh, FXMMATRIX world, const VisibleMeshlets& meshlets)
+{
+    const PositionStream positions = mesh.GetPositions();
+    if (positions.Data == nullptr || (mesh.IndexSize != 2 && mesh.IndexSize != 4))
+    {
+        return E_INVALIDARG;
+    }
+
+    const XMMATRIX worldViewProj = XMMatrixMultiply(world, XMLoadFloat4x4(&m_viewProj));
+
+    for (uint32_t index : meshlets.Indices)
+    {
+        if (index >= mesh.Meshlets.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        const Meshlet& meshlet = mesh.Meshlets[index];
+        if (size_t(meshlet.VertOffset) + meshlet.VertCount > mesh.UniqueVertexIndices.size() / mesh.IndexSize ||
+            size_t(meshlet.PrimOffset) + meshlet.PrimCount > mesh.PrimitiveIndices.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        m_clipVertices.resize(meshlet.VertCount);
+        for (uint32_t v = 0; v < meshlet.VertCount; ++v)
+        {
+            const uint32_t vertexIndex = mesh.GetVertexIndex(meshlet.VertOffset + v);
+            if (vertexIndex >= mesh.VertexCount)
+            {
+                return E_INVALIDARG;
+            }
+
+            XMStoreFloat4(&m_clipVertices[v], XMVector3Transform(XMLoadFloat3(&positions[vertexIndex]), worldViewProj));
+        }
+
+        m_stats.OccluderTriangleCount += meshlet.PrimCount;
+
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            uint32_t i0, i1, i2;
+            mesh.GetPrimitive(meshlet.PrimOffset + p, i0, i1, i2);
+
+            if (i0 >= meshlet.VertCount || i1 >= meshlet.VertCount || i2 >= meshlet.VertCount)
+            {
+                return E_INVALIDARG;
+            }
+
+            const XMFLOAT4 clip[3] = { m_clipVertices[i0], m_clipVertices[i1], m_clipVertices[i2] };
+            RasterizeTriangle(clip);
+        }
+    }
+
+    return S_OK;
+}
+
+void OcclusionCuller::RenderTriangles(const uint8_t* positions, uint32_t stride, uint32_t vertexCount, const uint8_t* indices, uint32_t indexSize,
+    uint32_t indexCount, FXMMATRIX world)
+{
+    const XMMATRIX worldViewProj = XMMatrixMultiply(world, XMLoadFloat4x4(&m_viewProj));
+
+    m_clipVertices.resize(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        const XMFLOAT3& position = *reinterpret_cast<const XMFLOAT3*>(positions + size_t(v) * stride);
+        XMStoreFloat4(&m_clipVertices[v], XMVector3Transform(XMLoadFloat3(&position), worldViewProj));
+    }
+
+    const uint32_t triangleCount = indexCount / 3;
+    m_stats.OccluderTriangleCount += triangleCount;
+
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t i0 = ReadIndex(indices, indexSize, t * 3 + 0);
+        const uint32_t i1 = ReadIndex(indices, indexSize, t * 3 + 1);
+        const uint32_t i2 = ReadIndex(indices, indexSize, t * 3 + 2);
+
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount)
+            continue;
+
+        const XMFLOAT4 clip[3] = { m_clipVertices[i0], m_clipVertices[i1], m_clipVertices[i2] };
+        RasterizeTriangle(clip);
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(const XMFLOAT4 (&clip)[3])
+{
+    const uint32_t codes[3] = { GetClipCode(clip[0]), GetClipCode(clip[1]), GetClipCode(clip[2]) };
+
+    // Entirely outside one plane; occluders past the far plane hide nothing that is drawn.
+    if (codes[0] & codes[1] & codes[2])
+        return;
+
+    // Only the near plane is clipped; the spans clamp everything else to the target.
+    XMFLOAT4 polygon[4];
+    uint32_t count = 0;
+
+    if (((codes[0] | codes[1] | codes[2]) & CLIP_NEAR) == 0)
+    {
+        polygon[0] = clip[0];
+        polygon[1] = clip[1];
+        polygon[2] = clip[2];
+        count = 3;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const XMFLOAT4& a = clip[i];
+            const XMFLOAT4& b = clip[(i + 1) % 3];
+
+            if (a.z >= 0.0f)
+            {
+                polygon[count++] = a;
+            }
+
+            if ((a.z >= 0.0f) != (b.z >= 0.0f))
+            {
+                const float t = a.z / (a.z - b.z);
+                XMStoreFloat4(&polygon[count++], XMVectorLerp(XMLoadFloat4(&a), XMLoadFloat4(&b), t));
+            }
+        }
+    }
+
+    float x[4];
+    float y[4];
+    float z[4];
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float invW = 1.0f / polygon[i].w;
+        x[i] = (polygon[i].x * invW * 0.5f + 0.5f) * m_width;
+        y[i] = (0.5f - polygon[i].y * invW * 0.5f) * m_height;
+        z[i] = polygon[i].z * invW;
+    }
+
+    for (uint32_t i = 2; i < count; ++i)
+    {
+        const float tx[3] = { x[0], x[i - 1], x[i] };
+        const float ty[3] = { y[0], y[i - 1], y[i] };
+        const float tz[3] = { z[0], z[i - 1], z[i] };
+        RasterizeProjected(tx, ty, tz);
+    }
+}
+
+void OcclusionCuller::RasterizeProjected(const float (&x)[3], const float (&y)[3], const float (&z)[3])
+{
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+    // Back-facing, degenerate, or not finite.
+    if (!(area > 0.0f))
+        return;
+
+    // Pixels whose centres lie within the bounds.
+    const float minX = min(min(x[0], x[1]), x[2]);
+    const float maxX = max(max(x[0], x[1]), x[2]);
+    const float minY = min(min(y[0], y[1]), y[2]);
+    const float maxY = max(max(y[0], y[1]), y[2]);
+
+    const int32_t colFirst = static_cast<int32_t>(ceilf(min(max(minX - 0.5f, 0.0f), float(m_width))));
+    const int32_t colLast = static_cast<int32_t>(floorf(max(min(maxX - 0.5f, m_width - 1.0f), -1.0f)));
+    const int32_t rowFirst = static_cast<int32_t>(ceilf(min(max(minY - 0.5f, 0.0f), float(m_height))));
+    const int32_t rowLast = static_cast<int32_t>(floorf(max(min(maxY - 0.5f, m_height - 1.0f), -1.0f)));
+
+    if (colFirst > colLast || rowFirst > rowLast)
+        return;
+
+    ++m_stats.RasterTriangleCount;
+
+    // Each edge runs from vertex i to vertex i + 1, with the triangle on its right. An edge heading up
+    // the screen bounds each row's span on the left, one heading down bounds it on the right, and a
+    // horizontal edge lies on the first or last row and is already accounted for by the row bounds.
+    // A triangle has one or two edges on each side; missing ones are padded with infinite bounds.
+    SpanEdge leftEdges[2] = { MakeSpanEdge(-c_infinity, 0.0f, 0.0f), MakeSpanEdge(-c_infinity, 0.0f, 0.0f) };
+    SpanEdge rightEdges[2] = { MakeSpanEdge(c_infinity, 0.0f, 0.0f), MakeSpanEdge(c_infinity, 0.0f, 0.0f) };
+    uint32_t leftCount = 0;
+    uint32_t rightCount = 0;
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const uint32_t j = (i + 1) % 3;
+        if (y[i] == y[j])
+            continue;
+
+        const SpanEdge edge = MakeSpanEdge(x[i], y[i], (x[j] - x[i]) / (y[j] - y[i]));
+        if (y[j] < y[i])
+        {
+            leftEdges[leftCount++ & 1] = edge;
+        }
+        else
+        {
+            rightEdges[rightCount++ & 1] = edge;
+        }
+    }
+
+    // Depth plane, and the triangle's farthest depth which caps its extrapolation.
+    const float zdX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    const float zdY = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    const float zFar = min(max(max(z[0], z[1]), z[2]), 1.0f);
+
+    const __m128 rowOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 tileWidth = _mm_set1_ps(float(TileWidth));
+
+    const int32_t tileColFirst = colFirst / TileWidth;
+    const int32_t tileColLast = colLast / TileWidth;
+
+    for (int32_t ty = rowFirst / TileHeight; ty <= rowLast / TileHeight; ++ty)
+    {
+        const int32_t tileY = ty * TileHeight;
+        const __m128 rowY = _mm_add_ps(_mm_set1_ps(float(tileY)), rowOffsets);
+
+        // Covered pixels of each row are [first, end): centres x + 0.5 between the bounds.
+        const __m128 left = _mm_max_ps(EvaluateSpanEdge(leftEdges[0], rowY), EvaluateSpanEdge(leftEdges[1], rowY));
+        const __m128 right = _mm_min_ps(EvaluateSpanEdge(rightEdges[0], rowY), EvaluateSpanEdge(rightEdges[1], rowY));
+
+        const __m128 bounds = _mm_set1_ps(float(m_width));
+        const __m128 first = Ceil(_mm_min_ps(_mm_max_ps(_mm_sub_ps(left, half), zero), bounds));
+        const __m128 end = Floor(_mm_min_ps(_mm_max_ps(_mm_add_ps(right, half), zero), bounds));
+
+        // Rows of the tile outside the triangle's rows.
+        uint32_t rowMask[TileHeight];
+        for (uint32_t r = 0; r < TileHeight; ++r)
+        {
+            rowMask[r] = (tileY + int32_t(r) >= rowFirst && tileY + int32_t(r) <= rowLast) ? ~0u : 0u;
+        }
+
+        const float y0 = float(max(tileY, rowFirst)) + 0.5f;
+        const float y1 = float(min(tileY + int32_t(TileHeight) - 1, rowLast)) + 0.5f;
+
+        for (int32_t tx = tileColFirst; tx <= tileColLast; ++tx)
+        {
+            const int32_t tileX = tx * TileWidth;
+            const __m128 origin = _mm_set1_ps(float(tileX));
+
+            __m128i lo = _mm_cvttps_epi32(_mm_max_ps(_mm_sub_ps(first, origin), zero));
+            __m128i hi = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_sub_ps(end, origin), zero), tileWidth));
+
+            int32_t los[TileHeight];
+            int32_t his[TileHeight];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(los), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(his), hi);
+
+            uint32_t rows[TileHeight];
+            for (uint32_t r = 0; r < TileHeight; ++r)
+            {
+                rows[r] = SpanMask(los[r], his[r]) & rowMask[r];
+            }
+
+            const __m128i coverage = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows));
+            if (IsZero(coverage))
+                continue;
+
+            // The plane's largest value over the covered part of the tile lies at one of its corners.
+            const float x0 = float(max(tileX, colFirst)) + 0.5f;
+            const float x1 = float(min(tileX + int32_t(TileWidth) - 1, colLast)) + 0.5f;
+
+            const float zTile = min(z[0] + zdX * ((zdX > 0.0f ? x1 : x0) - x[0]) + zdY * ((zdY > 0.0f ? y1 : y0) - y[0]), zFar);
+
+            Tile& tile = m_tiles[ty * m_tilesX + tx];
+            if (!(zTile < tile.ZMax[0]))
+                continue;
+
+            __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile.Mask));
+            float zWorking = tile.ZMax[1];
+
+            const bool empty = IsZero(mask);
+            const __m128i merged = _mm_or_si128(mask, coverage);
+
+            if (IsFull(merged))
+            {
+                // Every pixel is now within the farther of the two layers, which becomes the
+                // reference; the nearer one stays as the working layer.
+                const bool keepWorking = !empty && zWorking < zTile;
+
+                if (IsFull(coverage))
+                {
+                    tile.ZMax[0] = zTile;
+                    if (!keepWorking)
+                    {
+                        mask = _mm_setzero_si128();
+                        zWorking = 0.0f;
+                    }
+                }
+                else
+                {
+                    tile.ZMax[0] = max(zWorking, zTile);
+                    if (!keepWorking)
+                    {
+                        mask = coverage;
+                        zWorking = zTile;
+                    }
+                }
+            }
+            else if (empty || zTile <= zWorking)
+            {
+                mask = merged;
+                zWorking = max(zWorking, zTile);
+            }
+            else
+            {
+                // Merging a triangle behind the working layer would drag the working depth back with
+                // it, so it is dropped.
+                continue;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(tile.Mask), mask);
+            tile.ZMax[1] = zWorking;
+        }
+    }
+}
+
+bool OcclusionCuller::IsSphereVisible(FXMVECTOR center, float radius)
+{
+    ++m_stats.TestCount;
+
+    const XMMATRIX viewProj = XMLoadFloat4x4(&m_viewProj);
+
+    // The eight corners of the sphere's box, four per batch: the centre's clip position plus or
+    // minus the radius along each world axis.
+    const XMVECTOR c = XMVector3Transform(center, viewProj);
+    const XMVECTOR a = XMVectorScale(viewProj.r[0], radius);
+    const XMVECTOR b = XMVectorScale(viewProj.r[1], radius);
+    const XMVECTOR d = XMVectorScale(viewProj.r[2], radius);
+
+    XMFLOAT4 cf, af, bf, df;
+    XMStoreFloat4(&cf, c);
+    XMStoreFloat4(&af, a);
+    XMStoreFloat4(&bf, b);
+    XMStoreFloat4(&df, d);
+
+    const __m128 signA = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    const __m128 signB = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+
+    __m128 minX = _mm_set1_ps(c_infinity);
+    __m128 minY = _mm_set1_ps(c_infinity);
+    __m128 minZ = _mm_set1_ps(c_infinity);
+    __m128 maxX = _mm_set1_ps(-c_infinity);
+    __m128 maxY = _mm_set1_ps(-c_infinity);
+    int nearMask = 0;
+
+    for (uint32_t batch = 0; batch < 2; ++batch)
+    {
+        const __m128 signD = _mm_set1_ps(batch ? 1.0f : -1.0f);
+
+        const __m128 x = _mm_add_ps(_mm_add_ps(_mm_set1_ps(cf.x), _mm_mul_ps(signA, _mm_set1_ps(af.x))), _mm_add_ps(_mm_mul_ps(signB, _mm_set1_ps(bf.x)), _mm_mul_ps(signD, _mm_set1_ps(df.x))));
+        const __m128 y = _mm_add_ps(_mm_add_ps(_mm_set1_ps(cf.y), _mm_mul_ps(signA, _mm_set1_ps(af.y))), _mm_add_ps(_mm_mul_ps(signB, _mm_set1_ps(bf.y)), _mm_mul_ps(signD, _mm_set1_ps(df.y))));
+        const __m128 z = _mm_add_ps(_mm_add_ps(_mm_set1_ps(cf.z), _mm_mul_ps(signA, _mm_set1_ps(af.z))), _mm_add_ps(_mm_mul_ps(signB, _mm_set1_ps(bf.z)), _mm_mul_ps(signD, _mm_set1_ps(df.z))));
+        const __m128 w = _mm_add_ps(_mm_add_ps(_mm_set1_ps(cf.w), _mm_mul_ps(signA, _mm_set1_ps(af.w))), _mm_add_ps(_mm_mul_ps(signB, _mm_set1_ps(bf.w)), _mm_mul_ps(signD, _mm_set1_ps(df.w))));
+
+        nearMask |= _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(z, _mm_setzero_ps()), _mm_cmple_ps(w, _mm_setzero_ps())));
+
+        const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), w);
+        const __m128 px = _mm_mul_ps(x, invW);
+        const __m128 py = _mm_mul_ps(y, invW);
+
+        minX = _mm_min_ps(minX, px);
+        maxX = _mm_max_ps(maxX, px);
+        minY = _mm_min_ps(minY, py);
+        maxY = _mm_max_ps(maxY, py);
+        minZ = _mm_min_ps(minZ, _mm_mul_ps(z, invW));
+    }
+
+    if (nearMask != 0)
+        return true;
+
+    // Every pixel the bounds overlap, not only those whose centres they contain, since occluder
+    // coverage is only known at pixel centres.
+    const float left = (HorizontalMin(minX) * 0.5f + 0.5f) * m_width;
+    const float right = (HorizontalMax(maxX) * 0.5f + 0.5f) * m_width;
+    const float top = (0.5f - HorizontalMax(maxY) * 0.5f) * m_height;
+    const float bottom = (0.5f - HorizontalMin(minY) * 0.5f) * m_height;
+    const float zNear = HorizontalMin(minZ);
+
+    if (!(right >= 0.0f && left < m_width && bottom >= 0.0f && top < m_height))
+    {
+        ++m_stats.OccludedCount;
+        return false;
+    }
+
+    const int32_t x0 = static_cast<int32_t>(max(left, 0.0f));
+    const int32_t x1 = static_cast<int32_t>(min(right, m_width - 1.0f));
+    const int32_t y0 = static_cast<int32_t>(max(top, 0.0f));
+    const int32_t y1 = static_cast<int32_t>(min(bottom, m_height - 1.0f));
+
+    for (int32_t ty = y0 / TileHeight; ty <= y1 / TileHeight; ++ty)
+    {
+        const int32_t tileY = ty * TileHeight;
+
+        uint32_t rowMask[TileHeight];
+        for (uint32_t r = 0; r < TileHeight; ++r)
+        {
+            rowMask[r] = (tileY + int32_t(r) >= y0 && tileY + int32_t(r) <= y1) ? ~0u : 0u;
+        }
+        const __m128i rows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowMask));
+
+        for (int32_t tx = x0 / TileWidth; tx <= x1 / TileWidth; ++tx)
+        {
+            const Tile& tile = m_tiles[ty * m_tilesX + tx];
+
+            // Every pixel of the tile is at least as near as the reference depth.
+            if (!(zNear < tile.ZMax[0]))
+                continue;
+
+            // Covered pixels are nearer than the working depth, and the others nearer than the reference.
+            if (zNear < tile.ZMax[1])
+                return true;
+
+            const int32_t tileX = tx * TileWidth;
+            const uint32_t columns = SpanMask(max(x0 - tileX, 0), min(x1 - tileX + 1, int32_t(TileWidth)));
+            const __m128i rect = _mm_and_si128(rows, _mm_set1_epi32(static_cast<int32_t>(columns)));
+            const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile.Mask));
+
+            if (!IsZero(_mm_andnot_si128(mask, rect)))
+                return true;
+        }
+    }
+
+    ++m_stats.OccludedCount;
+    return false;
+}
+
+bool OcclusionCuller::IsMeshVisible(const Mesh& mesh, const MeshletCullParams& params)
+{
+    const XMVECTOR center = XMVector3Transform(XMLoadFloat3(&mesh.BoundingSphere.Center), XMLoadFloat4x4(&params.World));
+    return IsSphereVisible(center, mesh.BoundingSphere.Radius * params.Scale);
+}
+
+HRESULT OcclusionCuller::CullOccludedMeshlets(const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& visible)
+{
+    const size_t meshletCount = mesh.CullingData.size();
+    const uint32_t subsetCount = static_cast<uint32_t>(visible.Subsets.size());
+
+    if (subsetCount != mesh.MeshletSubsets.size())
+    {
+        return E_INVALIDARG;
+    }
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const Subset& subset = visible.Subsets[s];
+        if (size_t(subset.Offset) + subset.Count > visible.Indices.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+        {
+            if (visible.Indices[i] >= meshletCount)
+            {
+                return E_INVALIDARG;
+            }
+        }
+    }
+
+    const XMMATRIX world = XMLoadFloat4x4(&params.World);
+    uint32_t count = 0;
+
+    for (uint32_t s = 0; s < subsetCount; ++s)
+    {
+        const Subset subset = visible.Subsets[s];
+        visible.Subsets[s].Offset = count;
+
+        for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+        {
+            const uint32_t index = visible.Indices[i];
+            const XMFLOAT4& sphere = mesh.CullingData[index].BoundingSphere;
+
+            const XMVECTOR center = XMVector3Transform(XMLoadFloat4(&sphere), world);
+            if (IsSphereVisible(center, sphere.w * params.Scale))
+            {
+                visible.Indices[count++] = index;
+            }
+        }
+
+        visible.Subsets[s].Count = count - visible.Subsets[s].Offset;
+    }
+
+    visible.Indices.resize(count);
+
+    return S_OK;
+}
+
+void OcclusionCuller::GetDepthBuffer(std::vector<float>& depth) const
+{
+    depth.resize(size_t(m_width) * m_height);
+
+    for (uint32_t y = 0; y < m_height; ++y)
+    {
+        for (uint32_t x = 0; x < m_width; ++x)
+        {
+            const Tile& tile = m_tiles[(y / TileHeight) * m_tilesX + x / TileWidth];
+            const bool covered = (tile.Mask[y % TileHeight] >> (x % TileWidth)) & 1;
+
+            depth[size_t(y) * m_width + x] = covered ? tile.ZMax[1] : tile.ZMax[0];
+        }
+    }
+}
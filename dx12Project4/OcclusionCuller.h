@@ -0,0 +1,113 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "MeshletCuller.h"
+
+// Position-only triangles standing in for a mesh when it is drawn as an occluder.
+struct OccluderMesh
+{
+    std::vector<DirectX::XMFLOAT3> Positions;
+    std::vector<uint32_t>          Indices;
+};
+
+// Copies the triangles of every index subset of the mesh into occluder, simplified towards
+// maxTriangles if it has more. Simplification only moves the surface inwards, so the occluder never
+// hides geometry the mesh itself wouldn't; where that stops it short, it keeps more triangles.
+HRESULT BuildOccluderMesh(const Mesh& mesh, uint32_t maxTriangles, OccluderMesh& occluder);
+
+struct OcclusionStats
+{
+    uint32_t OccluderTriangleCount;     // Triangles submitted as occluders
+    uint32_t RasterTriangleCount;       // Left after clipping, back-face culling and trivial rejects
+    uint32_t TestCount;                 // Spheres tested
+    uint32_t OccludedCount;             // Of those, found hidden
+};
+
+// A low-resolution depth buffer for culling on the CPU, after Masked Software Occlusion Culling
+// (Andersson et al.). The target is split into TileWidth x TileHeight tiles. Rather than a depth per
+// pixel, each tile keeps a reference depth that bounds all its pixels, a working depth, and a
+// coverage mask of the pixels that lie in front of the working depth. Occluder triangles are scan
+// converted four rows at a time into coverage masks with SSE, and merged into the tiles they touch;
+// once a tile's mask fills, the farther of its layers becomes the new reference. Partial coverage
+// behind the working depth is dropped rather than allowed to push it back.
+//
+// Depth follows the D3D convention of the rest of the renderer, 0 at the near plane and 1 at the far
+// plane, and as on the GPU clockwise triangles are front-facing and back faces are skipped. Tests are
+// conservative: a sphere is only reported occluded if every pixel its screen bounds touch holds an
+// occluder nearer than the sphere's nearest point.
+class OcclusionCuller
+{
+public:
+    static const uint32_t TileWidth = 32;
+    static const uint32_t TileHeight = 4;
+
+    // Width must be a multiple of TileWidth and height of TileHeight.
+    explicit OcclusionCuller(uint32_t width = 256, uint32_t height = 128);
+
+    // Starts a frame seen through viewProj (row-vector convention): resets every tile to the far
+    // plane and clears the statistics.
+    void Clear(DirectX::FXMMATRIX viewProj);
+
+    // Rasterizes the triangles of every index subset of the mesh, or of an occluder built from one,
+    // transformed by world.
+    void RenderOccluder(const Mesh& mesh, DirectX::FXMMATRIX world);
+    void RenderOccluder(const OccluderMesh& occluder, DirectX::FXMMATRIX world);
+
+    // Rasterizes the listed meshlets of the mesh, transformed by world, as MeshletMS decodes them.
+    // Fails if a meshlet is malformed.
+    HRESULT RenderMeshlets(const Mesh& mesh, DirectX::FXMMATRIX world, const VisibleMeshlets& meshlets);
+
+    // Tests a world-space sphere. Spheres crossing the near plane are always visible.
+    bool IsSphereVisible(DirectX::FXMVECTOR center, float radius);
+
+    // Tests Mesh::BoundingSphere, placed by params.World and params.Scale.
+    bool IsMeshVisible(const Mesh& mesh, const MeshletCullParams& params);
+
+    // Removes the meshlets whose CullData spheres are occluded from visible, typically the output of
+    // CullMeshlets or CullMeshletTree for the same params. The survivors keep their order.
+    // Fails if visible doesn't match the mesh's meshlet subsets or its CullingData.
+    HRESULT CullOccludedMeshlets(const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& visible);
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+    // Totals since the last Clear.
+    const OcclusionStats& GetStats() const { return m_stats; }
+
+    // Writes the conservative depth of each pixel (the working depth where covered, else the
+    // reference depth), top row first, for debugging.
+    void GetDepthBuffer(std::vector<float>& depth) const;
+
+private:
+    struct Tile
+    {
+        uint32_t Mask[TileHeight];      // Bit x of row y covers pixel (x, y) of the tile
+        float    ZMax[2];               // Reference depth, then working depth
+    };
+
+    void RenderTriangles(const uint8_t* positions, uint32_t stride, uint32_t vertexCount, const uint8_t* indices, uint32_t indexSize,
+        uint32_t indexCount, DirectX::FXMMATRIX world);
+    void RasterizeTriangle(const DirectX::XMFLOAT4 (&clip)[3]);
+    void RasterizeProjected(const float (&x)[3], const float (&y)[3], const float (&z)[3]);
+
+    uint32_t            m_width;
+    uint32_t            m_height;
+    uint32_t            m_tilesX;
+    uint32_t            m_tilesY;
+
+    DirectX::XMFLOAT4X4 m_viewProj;
+    std::vector<Tile>   m_tiles;
+
+    std::vector<DirectX::XMFLOAT4> m_clipVertices;  // Scratch: the current occluder's or meshlet's vertices
+
+    OcclusionStats      m_stats;
+};
@@ -0,0 +1,150 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "OcclusionCuller.h"
+#include "TestMeshes.h"
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    const uint32_t c_occluderTriangles = 32;    // Far fewer than the walls have
+
+    // The nearest (largest) z at which a ray along -z through (x, y) meets the triangles, if any.
+    bool CastRay(const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, float x, float y, float& z)
+    {
+        bool hit = false;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const XMFLOAT3& a = positions[indices[i]];
+            const XMFLOAT3& b = positions[indices[i + 1]];
+            const XMFLOAT3& c = positions[indices[i + 2]];
+
+            const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area == 0.0f)
+                continue;
+
+            const float u = ((c.x - b.x) * (y - b.y) - (c.y - b.y) * (x - b.x)) / area;
+            const float v = ((a.x - c.x) * (y - c.y) - (a.y - c.y) * (x - c.x)) / area;
+            const float w = 1.0f - u - v;
+            if (u < 0.0f || v < 0.0f || w < 0.0f)
+                continue;
+
+            const float height = u * a.z + v * b.z + w * c.z;
+            z = hit ? max(z, height) : height;
+            hit = true;
+        }
+        return hit;
+    }
+
+    // A simplified occluder may only shrink: everywhere a ray along the view direction meets the
+    // occluder, it must meet the wall at the same depth or nearer. The ridges give the wall valleys
+    // that an unconstrained collapse would bridge, in front of the original surface.
+    uint32_t CheckOccluderInsideMesh()
+    {
+        PositionMesh wall;
+        OccluderMesh occluder;
+        if (FAILED(BuildWall(0.1f, 3.0f, false, wall)) || FAILED(BuildOccluderMesh(wall.Mesh, c_occluderTriangles, occluder)))
+        {
+            return Check(false, "OcclusionCuller: failed to build the ridged wall's occluder\n");
+        }
+
+        const uint32_t rayCount = 97;
+        uint32_t outside = 0;
+        uint32_t nearer = 0;
+        float worst = 0.0f;
+
+        for (uint32_t j = 0; j < rayCount; ++j)
+        {
+            for (uint32_t i = 0; i < rayCount; ++i)
+            {
+                const float x = -1.0f + (i + 0.37f) * 2.0f / rayCount;
+                const float y = -1.0f + (j + 0.61f) * 2.0f / rayCount;
+
+                float occluderZ = 0.0f;
+                float wallZ = 0.0f;
+                if (!CastRay(occluder.Positions, occluder.Indices, x, y, occluderZ))
+                    continue;
+
+                if (!CastRay(wall.Positions, wall.Indices, x, y, wallZ))
+                {
+                    ++outside;
+                }
+                else if (occluderZ > wallZ + 1e-4f)
+                {
+                    ++nearer;
+                    worst = max(worst, occluderZ - wallZ);
+                }
+            }
+        }
+
+        const uint32_t wallTriangles = static_cast<uint32_t>(wall.Indices.size() / 3);
+        const uint32_t occluderTriangles = static_cast<uint32_t>(occluder.Indices.size() / 3);
+
+        uint32_t errors = Check(occluderTriangles < wallTriangles / 2, "OcclusionCuller: the ridged wall's occluder keeps %u of %u triangles\n",
+            occluderTriangles, wallTriangles);
+        errors += Check(outside == 0, "OcclusionCuller: the ridged wall's occluder covers %u rays the wall misses\n", outside);
+        errors += Check(nearer == 0, "OcclusionCuller: the ridged wall's occluder is in front of the wall at %u rays, by up to %f\n", nearer, worst);
+        return errors;
+    }
+
+    // A sphere seen through a notch in the top of a wall, just behind the notch's edges, must stay
+    // visible whether the wall is drawn exactly or as a simplified occluder, while one behind the
+    // solid part of the wall is hidden by both.
+    uint32_t CheckSilhouette()
+    {
+        PositionMesh wall;
+        OccluderMesh occluder;
+        if (FAILED(BuildWall(0.0f, 0.0f, true, wall)) || FAILED(BuildOccluderMesh(wall.Mesh, c_occluderTriangles, occluder)))
+        {
+            return Check(false, "OcclusionCuller: failed to build the notched wall's occluder\n");
+        }
+
+        OcclusionCuller culler;
+
+        const XMMATRIX view = XMMatrixLookAtRH(XMVectorSet(0, 0, 4, 1), XMVectorZero(), XMVectorSet(0, 1, 0, 0));
+        const XMMATRIX proj = XMMatrixPerspectiveFovRH(XM_PIDIV4, float(culler.GetWidth()) / culler.GetHeight(), 0.1f, 10.0f);
+
+        // Projected onto the wall, the first spans about [-0.05, 0.05] in x and [0.62, 0.72] in y,
+        // inside the notch and less than 0.13 from its edges.
+        const XMVECTOR notchSphere = XMVectorSet(0.0f, 0.75f, -0.5f, 1.0f);
+        const XMVECTOR solidSphere = XMVectorSet(0.5f, -0.5f, -0.5f, 1.0f);
+        const float radius = 0.05f;
+
+        uint32_t errors = 0;
+        for (uint32_t simplified = 0; simplified < 2; ++simplified)
+        {
+            culler.Clear(view * proj);
+            if (simplified)
+            {
+                culler.RenderOccluder(occluder, XMMatrixIdentity());
+            }
+            else
+            {
+                culler.RenderOccluder(wall.Mesh, XMMatrixIdentity());
+            }
+
+            const char* name = simplified ? "simplified" : "exact";
+            errors += Check(culler.IsSphereVisible(notchSphere, radius), "OcclusionCuller: the %s notched wall hides the sphere behind its notch\n", name);
+            errors += Check(!culler.IsSphereVisible(solidSphere, radius), "OcclusionCuller: the %s notched wall doesn't hide the sphere behind it\n", name);
+        }
+        return errors;
+    }
+}
+
+uint32_t Tests::TestOcclusionCuller(const std::wstring&)
+{
+    uint32_t errors = CheckOccluderInsideMesh();
+    errors += CheckSilhouette();
+    return errors;
+}
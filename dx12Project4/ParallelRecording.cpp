@@ -0,0 +1,41 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "ParallelRecording.h"
+
+HRESULT RecordInChunks(ChunkRecordingTarget& target, const uint32_t* itemCosts, uint32_t itemCount, uint64_t minChunkCost, ThreadPool& pool)
+{
+    RecordingChunk chunks[c_maxRecordingChunks];
+    const uint32_t maxChunks = min(target.GetMaxChunkCount(), c_maxRecordingChunks);
+    const uint32_t chunkCount = PlanRecordingChunks(itemCosts, itemCount, maxChunks, minChunkCost, chunks);
+
+    HRESULT hr = target.BeginChunks(chunks, chunkCount);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    HRESULT results[c_maxRecordingChunks];
+    pool.ParallelFor(chunkCount, [&](uint32_t c)
+    {
+        results[c] = target.RecordChunk(c, chunks[c]);
+    });
+
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        if (FAILED(results[c]))
+        {
+            return results[c];
+        }
+    }
+
+    return target.SubmitChunks(chunkCount);
+}
@@ -0,0 +1,41 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "RecordingChunks.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+
+// What RecordInChunks records into: a command list per chunk, each with its own allocator, and a
+// queue to submit them to. The app's frame is the real one; anything else can stand in to measure
+// or check the recording without a GPU.
+class ChunkRecordingTarget
+{
+public:
+    virtual ~ChunkRecordingTarget() { }
+
+    virtual uint32_t GetMaxChunkCount() = 0;
+
+    // Called on the recording thread before any chunk is recorded.
+    virtual HRESULT BeginChunks(const RecordingChunk* chunks, uint32_t chunkCount) = 0;
+
+    // Called on pool threads, for different chunks at once; each chunk is recorded by one thread.
+    virtual HRESULT RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk) = 0;
+
+    // Called on the recording thread once every chunk is recorded: submits them in chunk order, with
+    // a single submission.
+    virtual HRESULT SubmitChunks(uint32_t chunkCount) = 0;
+};
+
+// Plans chunks over the item costs, records them in parallel on pool and submits them in order.
+// Returns the first failure of any step.
+HRESULT RecordInChunks(ChunkRecordingTarget& target, const uint32_t* itemCosts, uint32_t itemCount, uint64_t minChunkCost, ThreadPool& pool);
@@ -0,0 +1,154 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "DrawPackets.h"
+#include "ParallelRecording.h"
+
+#include <random>
+#include <vector>
+
+using namespace Tests;
+
+namespace
+{
+    // Records each mesh's packets into its chunk's stream by content, as DX12Practice records its
+    // root parameters and ExecuteIndirect calls, and joins the streams in chunk order on submit.
+    // RecordChunk fails for FailedChunk, if set.
+    class StreamRecorder : public ChunkRecordingTarget
+    {
+    public:
+        StreamRecorder(const std::vector<MeshletRange>& ranges, const std::vector<uint32_t>& rangeBases, uint32_t maxChunks)
+            : m_ranges(ranges)
+            , m_rangeBases(rangeBases)
+            , m_maxChunks(maxChunks)
+            , FailedChunk(UINT32_MAX)
+            , SubmitCount(0)
+            , SubmittedChunkCount(0)
+        { }
+
+        uint32_t GetMaxChunkCount() override { return m_maxChunks; }
+
+        HRESULT BeginChunks(const RecordingChunk*, uint32_t) override { return S_OK; }
+
+        HRESULT RecordChunk(uint32_t chunkIndex, const RecordingChunk& chunk) override
+        {
+            if (chunkIndex == FailedChunk)
+            {
+                return E_FAIL;
+            }
+
+            std::vector<uint32_t>& stream = m_streams[chunkIndex];
+            stream.clear();
+            for (uint32_t m = chunk.FirstItem; m < chunk.FirstItem + chunk.ItemCount; ++m)
+            {
+                const uint32_t first = m_rangeBases[m];
+                const uint32_t rangeCount = m_rangeBases[m + 1] - first;
+
+                std::vector<DrawPacket> packets(GetMaxDrawPacketCount(m_ranges.data() + first, rangeCount));
+                const uint32_t packetCount = BuildDrawPackets(m_ranges.data() + first, rangeCount, packets.data());
+
+                stream.push_back(m);
+                stream.push_back(packetCount);
+                for (uint32_t i = 0; i < packetCount; ++i)
+                {
+                    stream.push_back(packets[i].MeshletOffset);
+                    stream.push_back(packets[i].ThreadGroupCountX);
+                }
+            }
+            return S_OK;
+        }
+
+        HRESULT SubmitChunks(uint32_t chunkCount) override
+        {
+            Submitted.clear();
+            for (uint32_t c = 0; c < chunkCount; ++c)
+            {
+                Submitted.insert(Submitted.end(), m_streams[c].begin(), m_streams[c].end());
+            }
+            SubmitCount++;
+            SubmittedChunkCount = chunkCount;
+            return S_OK;
+        }
+
+        uint32_t              FailedChunk;
+        uint32_t              SubmitCount;
+        uint32_t              SubmittedChunkCount;
+        std::vector<uint32_t> Submitted;
+
+    private:
+        const std::vector<MeshletRange>& m_ranges;
+        const std::vector<uint32_t>&     m_rangeBases;
+        uint32_t                         m_maxChunks;
+        std::vector<uint32_t>            m_streams[c_maxRecordingChunks];
+    };
+
+    // Records random meshes, laid out and costed as GatherMeshletRanges does, in 1 to 8 chunks on
+    // pools of one, three and eight workers, and checks every recording submits exactly what the
+    // serial one does, in one submission. A failing chunk fails the whole recording, which then
+    // submits nothing.
+    uint32_t CheckChunkedRecording()
+    {
+        const uint32_t meshCount = 300;
+        const uint64_t minChunkCost = 64;
+
+        std::mt19937 rng(25);
+        std::vector<MeshletRange> ranges;
+        std::vector<uint32_t> rangeBases(1, 0);
+        std::vector<uint32_t> costs;
+        for (uint32_t m = 0; m < meshCount; ++m)
+        {
+            // Runs of visible meshlets, with some meshes culled entirely.
+            const uint32_t runCount = rng() % 8 == 0 ? 0 : rng() % 40;
+            uint32_t offset = 0;
+            for (uint32_t r = 0; r < runCount; ++r)
+            {
+                offset += rng() % 3;
+                ranges.push_back(MeshletRange{ m, offset, 1 + static_cast<uint32_t>(rng() % 100) });
+                offset += ranges.back().Count;
+            }
+            rangeBases.push_back(static_cast<uint32_t>(ranges.size()));
+            costs.push_back(1 + runCount);
+        }
+
+        ThreadPool serialPool(1);
+        StreamRecorder serial(ranges, rangeBases, 1);
+        uint32_t errors = Check(SUCCEEDED(RecordInChunks(serial, costs.data(), meshCount, minChunkCost, serialPool)) && serial.SubmittedChunkCount == 1,
+            "ParallelRecording: serial recording failed\n");
+
+        const uint32_t workerCounts[] = { 1, 3, 8 };
+        for (uint32_t workerCount : workerCounts)
+        {
+            ThreadPool pool(workerCount);
+            for (uint32_t chunkCount = 1; chunkCount <= c_maxRecordingChunks; ++chunkCount)
+            {
+                StreamRecorder chunked(ranges, rangeBases, chunkCount);
+                const HRESULT hr = RecordInChunks(chunked, costs.data(), meshCount, minChunkCost, pool);
+                errors += Check(SUCCEEDED(hr) && chunked.SubmitCount == 1 && chunked.SubmittedChunkCount == chunkCount,
+                    "ParallelRecording: %u chunks on %u workers submitted %u chunks in %u submissions\n", chunkCount, workerCount, chunked.SubmittedChunkCount, chunked.SubmitCount);
+                errors += Check(chunked.Submitted == serial.Submitted, "ParallelRecording: %u chunks on %u workers submitted other commands than serial recording\n",
+                    chunkCount, workerCount);
+            }
+
+            StreamRecorder failing(ranges, rangeBases, c_maxRecordingChunks);
+            failing.FailedChunk = 5;
+            errors += Check(RecordInChunks(failing, costs.data(), meshCount, minChunkCost, pool) == E_FAIL && failing.SubmitCount == 0,
+                "ParallelRecording: a failed chunk on %u workers was submitted\n", workerCount);
+        }
+
+        return errors;
+    }
+}
+
+uint32_t Tests::TestParallelRecording(const std::wstring&)
+{
+    return CheckChunkedRecording();
+}
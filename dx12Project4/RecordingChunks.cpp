@@ -0,0 +1,48 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "RecordingChunks.h"
+
+#include <algorithm>
+
+uint32_t PlanRecordingChunks(const uint32_t* itemCosts, uint32_t itemCount, uint32_t maxChunks, uint64_t minChunkCost, RecordingChunk* chunks)
+{
+    uint64_t totalCost = 0;
+    for (uint32_t i = 0; i < itemCount; ++i)
+    {
+        totalCost += itemCosts[i];
+    }
+
+    uint64_t chunkCount = minChunkCost > 0 ? totalCost / minChunkCost : totalCost;
+    chunkCount = std::max(std::min(chunkCount, uint64_t(std::min(maxChunks, itemCount))), uint64_t(1));
+
+    // Chunk c ends at the first item which takes the running cost to (c + 1) / chunkCount of the
+    // total. A single item costing more than a share leaves the chunks after it empty; they are dropped.
+    uint32_t written = 0;
+    uint32_t item = 0;
+    uint64_t cost = 0;
+    for (uint64_t c = 0; c < chunkCount; ++c)
+    {
+        const uint64_t target = totalCost * (c + 1) / chunkCount;
+        const uint32_t first = item;
+
+        while (item < itemCount && (cost < target || c + 1 == chunkCount))
+        {
+            cost += itemCosts[item++];
+        }
+
+        if (item > first || (written == 0 && c + 1 == chunkCount))
+        {
+            chunks[written++] = RecordingChunk{ first, item - first };
+        }
+    }
+
+    return written;
+}
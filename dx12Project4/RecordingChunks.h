@@ -0,0 +1,28 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+// Upper bound on the chunks a frame is recorded in; targets size their per-chunk state by it.
+const uint32_t c_maxRecordingChunks = 8;
+
+// Items [FirstItem, FirstItem + ItemCount), recorded into one command list.
+struct RecordingChunk
+{
+    uint32_t FirstItem;
+    uint32_t ItemCount;
+};
+
+// Splits items [0, itemCount) into at most maxChunks consecutive chunks of about equal total cost,
+// and returns how many were written. A chunk costs at least minChunkCost unless there is only one;
+// there is always at least one, empty if itemCount is zero.
+uint32_t PlanRecordingChunks(const uint32_t* itemCosts, uint32_t itemCount, uint32_t maxChunks, uint64_t minChunkCost, RecordingChunk* chunks);
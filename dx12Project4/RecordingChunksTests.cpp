@@ -0,0 +1,111 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+#include "RecordingChunks.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Tests;
+
+namespace
+{
+    // Checks a chunk plan: consecutive chunks covering every item, none empty unless it is the only
+    // one, at most maxChunks, and none costing more than an even share plus one item.
+    uint32_t CheckRecordingChunks(const std::vector<uint32_t>& costs, uint32_t maxChunks, uint64_t minChunkCost, uint32_t expectedChunkCount = UINT32_MAX)
+    {
+        const uint32_t itemCount = static_cast<uint32_t>(costs.size());
+        RecordingChunk chunks[c_maxRecordingChunks + 1];
+        const uint32_t chunkCount = PlanRecordingChunks(costs.data(), itemCount, maxChunks, minChunkCost, chunks);
+
+        uint32_t errors = chunkCount == 0 || chunkCount > std::max(maxChunks, 1u);
+        errors += expectedChunkCount != UINT32_MAX && chunkCount != expectedChunkCount;
+        if (errors > 0)
+        {
+            return errors;
+        }
+
+        uint64_t totalCost = 0;
+        uint32_t maxItemCost = 0;
+        for (uint32_t cost : costs)
+        {
+            totalCost += cost;
+            maxItemCost = std::max(maxItemCost, cost);
+        }
+
+        uint32_t next = 0;
+        for (uint32_t c = 0; c < chunkCount; ++c)
+        {
+            uint64_t chunkCost = 0;
+            for (uint32_t i = 0; i < chunks[c].ItemCount && chunks[c].FirstItem + i < itemCount; ++i)
+            {
+                chunkCost += costs[chunks[c].FirstItem + i];
+            }
+
+            errors += chunks[c].FirstItem != next || (chunks[c].ItemCount == 0 && chunkCount > 1);
+            errors += chunkCost > totalCost / chunkCount + maxItemCost;
+            next = chunks[c].FirstItem + chunks[c].ItemCount;
+        }
+        return errors + (next != itemCount);
+    }
+
+    uint32_t CheckPlanCases()
+    {
+        struct
+        {
+            const char*           Name;
+            std::vector<uint32_t> Costs;
+            uint32_t              MaxChunks;
+            uint64_t              MinChunkCost;
+            uint32_t              ChunkCount;
+        } const cases[] =
+        {
+            { "no items",           { },                                    8,  1,   1 },
+            { "one item",           { 5 },                                  8,  1,   1 },
+            { "zero costs",         { 0, 0, 0, 0, 0, 0 },                   4,  1,   1 },
+            { "zero min cost",      { 1, 1, 1, 1 },                         8,  0,   4 },
+            { "below min cost",     { 10, 10, 10, 10 },                     8,  64,  1 },
+            { "even",               { 2, 2, 2, 2, 2, 2, 2, 2 },             4,  1,   4 },
+            { "fewer items",        { 3, 3 },                               8,  1,   2 },
+            { "one huge item",      { 1, 1, 1000, 1, 1 },                   4,  1,   UINT32_MAX },
+            { "huge first",         { 1000, 1, 1, 1 },                      4,  1,   UINT32_MAX },
+            { "huge last",          { 1, 1, 1, 1000 },                      4,  1,   UINT32_MAX },
+            { "one chunk",          { 7, 7, 7 },                            1,  1,   1 },
+        };
+
+        uint32_t errors = 0;
+        for (auto& test : cases)
+        {
+            errors += Check(CheckRecordingChunks(test.Costs, test.MaxChunks, test.MinChunkCost, test.ChunkCount) == 0, "RecordingChunks: case '%s' failed\n", test.Name);
+        }
+
+        std::mt19937 rng(25);
+        auto below = [&rng](uint32_t bound) { return static_cast<uint32_t>(rng() % bound); };
+
+        uint32_t failedPlans = 0;
+        for (uint32_t n = 0; n < 2000; ++n)
+        {
+            std::vector<uint32_t> costs(below(200));
+            for (auto& cost : costs)
+            {
+                cost = below(8) == 0 ? below(5000) : below(20);
+            }
+            failedPlans += CheckRecordingChunks(costs, 1 + below(c_maxRecordingChunks), below(3) == 0 ? 0 : below(500)) != 0;
+        }
+        return errors + Check(failedPlans == 0, "RecordingChunks: %u of 2000 random plans failed\n", failedPlans);
+    }
+}
+
+uint32_t Tests::TestRecordingChunks(const std::wstring&)
+{
+    return CheckPlanCases();
+}
@@ -0,0 +1,90 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "RingAllocator.h"
+
+#include "Alignment.h"
+
+#include <algorithm>
+
+RingAllocator::RingAllocator(uint64_t capacity)
+{
+    Reset(capacity);
+}
+
+void RingAllocator::Reset(uint64_t capacity)
+{
+    m_capacity = capacity;
+    m_head = 0;
+    m_tail = 0;
+    m_submittedHead = 0;
+    m_submissions.clear();
+    m_firstSubmission = 0;
+}
+
+bool RingAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+    size = std::max(size, uint64_t(1));
+    if (size > m_capacity)
+    {
+        return false;
+    }
+
+    // A range which would run past the end starts over at the beginning; the gap is freed along
+    // with the range.
+    uint64_t start = AlignUp(m_head, alignment);
+    if (start % m_capacity + size > m_capacity)
+    {
+        // The capacity needn't be a power of two, so the next lap is found by dividing.
+        start = DivRoundUp(m_head, m_capacity) * m_capacity;
+    }
+
+    if (start + size - m_tail > m_capacity)
+    {
+        return false;
+    }
+
+    m_head = start + size;
+    offset = start % m_capacity;
+    return true;
+}
+
+void RingAllocator::Submit(uint64_t fenceValue)
+{
+    if (!HasUnsubmitted())
+    {
+        return;
+    }
+
+    // Drop the retired entries once they are the bulk of the vector, which keeps it from growing
+    // without ever reallocating.
+    if (m_firstSubmission > 0 && m_firstSubmission * 2 >= m_submissions.size())
+    {
+        m_submissions.erase(m_submissions.begin(), m_submissions.begin() + m_firstSubmission);
+        m_firstSubmission = 0;
+    }
+
+    m_submissions.push_back(Submission{ fenceValue, m_head });
+    m_submittedHead = m_head;
+}
+
+void RingAllocator::Retire(uint64_t completedFenceValue)
+{
+    while (m_firstSubmission < m_submissions.size() && m_submissions[m_firstSubmission].FenceValue <= completedFenceValue)
+    {
+        m_tail = m_submissions[m_firstSubmission].End;
+        m_firstSubmission++;
+    }
+}
+
+uint64_t RingAllocator::GetOldestPendingFence() const
+{
+    return m_firstSubmission < m_submissions.size() ? m_submissions[m_firstSubmission].FenceValue : 0;
+}
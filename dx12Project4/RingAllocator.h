@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bookkeeping of a ring buffer whose ranges are freed by fence value, without any D3D objects.
+// Allocations are carved from the head; Submit tags everything allocated since the last Submit with
+// the fence value that will be signalled after the GPU work reading it, and Retire frees the ranges
+// of every completed fence value from the tail. An allocation never straddles the end of the ring.
+//
+// Alignments must be powers of two which divide the capacity.
+class RingAllocator
+{
+public:
+    explicit RingAllocator(uint64_t capacity = 0);
+
+    void Reset(uint64_t capacity);
+
+    // Returns false if the range doesn't fit until more has been retired.
+    bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+
+    // Fence values must increase from one Submit to the next.
+    void Submit(uint64_t fenceValue);
+    void Retire(uint64_t completedFenceValue);
+
+    // The fence value whose completion frees the oldest submitted range, or zero if none is pending.
+    uint64_t GetOldestPendingFence() const;
+    bool HasUnsubmitted() const { return m_head != m_submittedHead; }
+
+    uint64_t GetCapacity() const { return m_capacity; }
+    uint64_t GetUsedSize() const { return m_head - m_tail; }
+
+private:
+    struct Submission
+    {
+        uint64_t FenceValue;
+        uint64_t End;           // Head when submitted
+    };
+
+    // Positions only grow; the offset in the ring is the position modulo the capacity.
+    uint64_t                m_capacity;
+    uint64_t                m_head;
+    uint64_t                m_tail;
+    uint64_t                m_submittedHead;
+
+    std::vector<Submission> m_submissions;      // Pending from m_firstSubmission on, oldest first
+    size_t                  m_firstSubmission;
+};
@@ -0,0 +1,49 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "SceneGeometry.h"
+
+static_assert(sizeof(Meshlet) == c_sceneMeshletBytes && sizeof(PackedTriangle) == c_scenePrimitiveBytes, "The scene streams' element sizes are out of date");
+
+HRESULT AddSceneMesh(SceneGeometryLayout& layout, const Mesh& mesh, uint32_t& meshIndex)
+{
+    // The mesh shader reads the first vertex stream only.
+    if (mesh.Vertices.empty() || mesh.VertexStrides.empty() || (layout.GetMeshCount() > 0 && mesh.VertexStrides[0] != layout.GetVertexStride()))
+    {
+        return E_INVALIDARG;
+    }
+    const uint32_t vertexStride = mesh.VertexStrides[0];
+    if (vertexStride == 0 || mesh.Vertices[0].size() < uint64_t(mesh.VertexCount) * vertexStride)
+    {
+        return E_INVALIDARG;
+    }
+
+    const SceneMeshStreams streams =
+    {
+        mesh.IndexSize,
+        vertexStride,
+        mesh.VertexCount,
+        {
+            mesh.Vertices[0].data(),
+            mesh.Meshlets.data(),
+            mesh.UniqueVertexIndices.data(),
+            mesh.PrimitiveIndices.data(),
+        },
+        {
+            mesh.Vertices[0].size(),
+            mesh.Meshlets.size() * sizeof(mesh.Meshlets[0]),
+            mesh.UniqueVertexIndices.size(),
+            mesh.PrimitiveIndices.size() * sizeof(mesh.PrimitiveIndices[0]),
+        },
+    };
+
+    return layout.AddMesh(streams, meshIndex) ? S_OK : E_OUTOFMEMORY;
+}
@@ -0,0 +1,30 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "Model.h"
+#include "SceneGeometryLayout.h"
+
+#include <cstdint>
+
+// The table entry of a mesh drawn from its own buffers.
+inline MeshGeometryOffsets GetUnpackedOffsets(const Mesh& mesh)
+{
+    return MeshGeometryOffsets{ mesh.IndexSize, 0, 0, 0, 0 };
+}
+
+// Appends a mesh's first vertex stream, meshlets, unique vertex indices and primitive indices to
+// layout, and returns its index in the table. Fails with E_INVALIDARG if its vertex stride differs
+// from the meshes before it or its first stream is too short for its vertices, and E_OUTOFMEMORY if
+// an offset would overflow.
+//
+// The layout references the mesh's own spans; they must outlive the copies.
+HRESULT AddSceneMesh(SceneGeometryLayout& layout, const Mesh& mesh, uint32_t& meshIndex);
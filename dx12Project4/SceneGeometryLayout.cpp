@@ -0,0 +1,98 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "SceneGeometryLayout.h"
+
+#include "Alignment.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    // ByteAddressBuffer loads are 4-byte aligned, and a mesh's 16-bit indices may end halfway.
+    const uint64_t c_uniqueIndexAlignment = 4;
+}
+
+SceneGeometryLayout::SceneGeometryLayout()
+{
+    Reset();
+}
+
+void SceneGeometryLayout::Reset()
+{
+    m_vertexStride = 0;
+    for (auto& size : m_streamSizes)
+    {
+        size = 0;
+    }
+    m_table.clear();
+    m_copies.clear();
+}
+
+bool SceneGeometryLayout::AddMesh(const SceneMeshStreams& mesh, uint32_t& meshIndex)
+{
+    const uint32_t vertexStride = mesh.VertexStride;
+    assert(vertexStride != 0 && (m_vertexStride == 0 || vertexStride == m_vertexStride));
+    assert(mesh.Sizes[SceneStream::Vertices] >= uint64_t(mesh.VertexCount) * vertexStride);
+
+    uint64_t offsets[SceneStream::Count];
+    for (uint32_t s = 0; s < SceneStream::Count; ++s)
+    {
+        offsets[s] = m_streamSizes[s];
+    }
+    offsets[SceneStream::UniqueVertexIndices] = AlignUp(offsets[SceneStream::UniqueVertexIndices], c_uniqueIndexAlignment);
+
+    // Vertices are addressed in whole strides, which needn't be a power of two. A stream padded past
+    // its last vertex is copied whole, so the next mesh starts at the following stride boundary.
+    offsets[SceneStream::Vertices] = DivRoundUp(offsets[SceneStream::Vertices], vertexStride) * vertexStride;
+
+    // Offsets are 32-bit in the shader; unique indices are addressed in bytes, the rest in elements.
+    MeshGeometryOffsets entry;
+    entry.IndexBytes = mesh.IndexBytes;
+
+    const uint64_t vertexOffset = offsets[SceneStream::Vertices] / vertexStride;
+    const uint64_t meshletOffset = offsets[SceneStream::Meshlets] / c_sceneMeshletBytes;
+    const uint64_t uniqueIndexEnd = offsets[SceneStream::UniqueVertexIndices] + mesh.Sizes[SceneStream::UniqueVertexIndices];
+    const uint64_t primitiveOffset = offsets[SceneStream::PrimitiveIndices] / c_scenePrimitiveBytes;
+
+    if (vertexOffset + mesh.VertexCount > UINT32_MAX || meshletOffset + mesh.Sizes[SceneStream::Meshlets] / c_sceneMeshletBytes > UINT32_MAX
+        || uniqueIndexEnd > UINT32_MAX || primitiveOffset + mesh.Sizes[SceneStream::PrimitiveIndices] / c_scenePrimitiveBytes > UINT32_MAX)
+    {
+        return false;
+    }
+
+    entry.VertexOffset = static_cast<uint32_t>(vertexOffset);
+    entry.MeshletOffset = static_cast<uint32_t>(meshletOffset);
+    entry.UniqueIndexOffset = static_cast<uint32_t>(offsets[SceneStream::UniqueVertexIndices]);
+    entry.PrimitiveOffset = static_cast<uint32_t>(primitiveOffset);
+
+    for (uint32_t s = 0; s < SceneStream::Count; ++s)
+    {
+        if (mesh.Sizes[s] > 0)
+        {
+            m_copies.push_back(SceneGeometryCopy{ static_cast<SceneStream::EType>(s), offsets[s], mesh.Data[s], mesh.Sizes[s] });
+        }
+        m_streamSizes[s] = offsets[s] + mesh.Sizes[s];
+    }
+
+    m_vertexStride = vertexStride;
+    meshIndex = static_cast<uint32_t>(m_table.size());
+    m_table.push_back(entry);
+    return true;
+}
+
+void PackSceneGeometry(const SceneGeometryLayout& layout, uint8_t* const streams[SceneStream::Count])
+{
+    for (auto& copy : layout.GetCopies())
+    {
+        std::memcpy(streams[copy.Stream] + copy.DestOffset, copy.Data, copy.Size);
+    }
+}
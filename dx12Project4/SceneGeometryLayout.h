@@ -0,0 +1,100 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Where a mesh's data starts in the buffers bound for it, as MeshOffsets in MeshletMS.hlsl reads it.
+// Offsets count elements of each buffer, except UniqueIndexOffset which counts bytes. They are zero
+// when the mesh's own buffers are bound.
+struct MeshGeometryOffsets
+{
+    uint32_t IndexBytes;
+    uint32_t VertexOffset;
+    uint32_t MeshletOffset;
+    uint32_t UniqueIndexOffset;
+    uint32_t PrimitiveOffset;
+};
+
+// The buffers shared by every mesh of a packed scene, in the order of root SRVs t0-t3.
+struct SceneStream
+{
+    enum EType : uint32_t
+    {
+        Vertices,
+        Meshlets,
+        UniqueVertexIndices,
+        PrimitiveIndices,
+        Count
+    };
+};
+
+// Sizes of a Meshlet and a PackedTriangle, the elements the meshlet and primitive streams are
+// addressed in.
+const uint32_t c_sceneMeshletBytes = 16;
+const uint32_t c_scenePrimitiveBytes = 4;
+
+// A mesh's data in each stream, without the Mesh it comes from; only the first vertex stream is
+// packed, since the mesh shader reads no other.
+struct SceneMeshStreams
+{
+    uint32_t    IndexBytes;
+    uint32_t    VertexStride;
+    uint32_t    VertexCount;
+    const void* Data[SceneStream::Count];
+    uint64_t    Sizes[SceneStream::Count];      // In bytes
+};
+
+// A mesh's data and where it goes in one of the shared buffers.
+struct SceneGeometryCopy
+{
+    SceneStream::EType Stream;
+    uint64_t           DestOffset;     // In bytes
+    const void*        Data;
+    uint64_t           Size;
+};
+
+// Lays out the vertices, meshlets, unique vertex indices and primitive indices of any number of
+// meshes, from any number of models, back to back in one buffer per stream, so a single set of
+// bindings draws them all and each mesh only needs its index into the offset table. Plain CPU work:
+// the copies can be staged to the GPU as they are, or packed into memory with PackSceneGeometry.
+// AddSceneMesh (SceneGeometry.h) adds a Mesh.
+//
+// The copies reference the meshes' own data, which must outlive them.
+class SceneGeometryLayout
+{
+public:
+    SceneGeometryLayout();
+
+    void Reset();
+
+    // Appends a mesh and returns its index in the table. Returns false, adding nothing, if an
+    // offset would overflow. The vertex stride must be that of the meshes before it, and the vertex
+    // stream at least VertexCount strides long.
+    bool AddMesh(const SceneMeshStreams& mesh, uint32_t& meshIndex);
+
+    uint32_t GetMeshCount() const { return static_cast<uint32_t>(m_table.size()); }
+    const std::vector<MeshGeometryOffsets>& GetTable() const { return m_table; }
+    const std::vector<SceneGeometryCopy>& GetCopies() const { return m_copies; }
+
+    uint64_t GetStreamSize(SceneStream::EType stream) const { return m_streamSizes[stream]; }
+    uint32_t GetVertexStride() const { return m_vertexStride; }
+
+private:
+    uint32_t                         m_vertexStride;
+    uint64_t                         m_streamSizes[SceneStream::Count];
+    std::vector<MeshGeometryOffsets> m_table;
+    std::vector<SceneGeometryCopy>   m_copies;
+};
+
+// Copies every mesh's data into streams, one buffer per SceneStream of at least GetStreamSize bytes.
+void PackSceneGeometry(const SceneGeometryLayout& layout, uint8_t* const streams[SceneStream::Count]);
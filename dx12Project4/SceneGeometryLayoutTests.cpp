@@ -0,0 +1,147 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+#include "SceneGeometryLayout.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace Tests;
+
+namespace
+{
+    // Streams of a mesh with made-up contents: each byte is its own index plus seed, so a copy
+    // placed at the wrong offset reads back wrong.
+    struct FakeMesh
+    {
+        std::vector<uint8_t> Bytes[SceneStream::Count];
+        SceneMeshStreams     Streams;
+
+        FakeMesh(uint32_t indexBytes, uint32_t vertexStride, uint32_t vertexCount, uint64_t vertexPadding, uint32_t meshletCount, uint64_t uniqueIndexSize, uint32_t primitiveCount, uint8_t seed)
+        {
+            const uint64_t sizes[SceneStream::Count] =
+            {
+                uint64_t(vertexCount) * vertexStride + vertexPadding,
+                uint64_t(meshletCount) * c_sceneMeshletBytes,
+                uniqueIndexSize,
+                uint64_t(primitiveCount) * c_scenePrimitiveBytes,
+            };
+
+            Streams.IndexBytes = indexBytes;
+            Streams.VertexStride = vertexStride;
+            Streams.VertexCount = vertexCount;
+            for (uint32_t s = 0; s < SceneStream::Count; ++s)
+            {
+                Bytes[s].resize(static_cast<size_t>(sizes[s]));
+                for (size_t i = 0; i < Bytes[s].size(); ++i)
+                {
+                    Bytes[s][i] = static_cast<uint8_t>(i + seed + s);
+                }
+                Streams.Data[s] = Bytes[s].data();
+                Streams.Sizes[s] = sizes[s];
+            }
+        }
+    };
+
+    // Lays out meshes with padded vertex streams and 16-bit unique indices ending halfway through a
+    // word, packs them, and checks every offset lands where MeshletMS.hlsl addresses it: vertices on
+    // a stride boundary, meshlets and primitives on whole elements, unique indices 4-byte aligned.
+    uint32_t CheckOffsets()
+    {
+        const uint32_t stride = 12;
+        const FakeMesh meshes[] =
+        {
+            FakeMesh(2, stride, 5, 4, 3, 6, 7, 1),
+            FakeMesh(4, stride, 9, 0, 1, 8, 2, 2),
+            FakeMesh(2, stride, 1, 11, 0, 2, 0, 3),
+            FakeMesh(2, stride, 7, 0, 2, 10, 5, 4),
+        };
+        const uint32_t meshCount = sizeof(meshes) / sizeof(meshes[0]);
+
+        SceneGeometryLayout layout;
+        uint32_t errors = 0;
+        for (uint32_t i = 0; i < meshCount; ++i)
+        {
+            uint32_t meshIndex;
+            errors += Check(layout.AddMesh(meshes[i].Streams, meshIndex) && meshIndex == i, "SceneGeometryLayout: mesh %u wasn't added as mesh %u\n", i, i);
+        }
+        if (errors > 0 || layout.GetMeshCount() != meshCount || layout.GetVertexStride() != stride)
+        {
+            return errors + 1;
+        }
+
+        std::vector<uint8_t> streams[SceneStream::Count];
+        uint8_t* streamData[SceneStream::Count];
+        for (uint32_t s = 0; s < SceneStream::Count; ++s)
+        {
+            streams[s].resize(static_cast<size_t>(layout.GetStreamSize(static_cast<SceneStream::EType>(s))));
+            streamData[s] = streams[s].data();
+        }
+        PackSceneGeometry(layout, streamData);
+
+        uint64_t vertexEnd = 0;
+        for (uint32_t i = 0; i < meshCount; ++i)
+        {
+            const MeshGeometryOffsets& offsets = layout.GetTable()[i];
+            const uint64_t destOffsets[SceneStream::Count] =
+            {
+                uint64_t(offsets.VertexOffset) * stride,
+                uint64_t(offsets.MeshletOffset) * c_sceneMeshletBytes,
+                offsets.UniqueIndexOffset,
+                uint64_t(offsets.PrimitiveOffset) * c_scenePrimitiveBytes,
+            };
+
+            errors += Check(offsets.IndexBytes == meshes[i].Streams.IndexBytes, "SceneGeometryLayout: mesh %u has %u-byte indices, not %u\n",
+                i, offsets.IndexBytes, meshes[i].Streams.IndexBytes);
+            errors += Check(offsets.UniqueIndexOffset % 4 == 0, "SceneGeometryLayout: mesh %u's unique indices start at byte %u\n", i, offsets.UniqueIndexOffset);
+            errors += Check(destOffsets[SceneStream::Vertices] >= vertexEnd && destOffsets[SceneStream::Vertices] < vertexEnd + stride,
+                "SceneGeometryLayout: mesh %u's vertices start at vertex %u, not the first stride boundary after the mesh before it\n", i, offsets.VertexOffset);
+            vertexEnd = destOffsets[SceneStream::Vertices] + meshes[i].Streams.Sizes[SceneStream::Vertices];
+
+            for (uint32_t s = 0; s < SceneStream::Count; ++s)
+            {
+                const std::vector<uint8_t>& own = meshes[i].Bytes[s];
+                errors += Check(own.empty() || std::memcmp(streamData[s] + destOffsets[s], own.data(), own.size()) == 0,
+                    "SceneGeometryLayout: mesh %u reads back wrong data from stream %u\n", i, s);
+            }
+        }
+
+        return errors;
+    }
+
+    // A mesh whose offsets would pass 32 bits is refused and leaves the layout as it was.
+    uint32_t CheckOverflow()
+    {
+        const uint32_t stride = 4;
+        SceneMeshStreams huge = {};
+        huge.IndexBytes = 4;
+        huge.VertexStride = stride;
+        huge.VertexCount = UINT32_MAX;
+        huge.Sizes[SceneStream::Vertices] = uint64_t(UINT32_MAX) * stride;
+
+        const FakeMesh small(4, stride, 2, 0, 1, 8, 1, 0);
+
+        SceneGeometryLayout layout;
+        uint32_t meshIndex;
+        uint32_t errors = Check(layout.AddMesh(huge, meshIndex), "SceneGeometryLayout: a mesh of 2^32 - 1 vertices was refused\n");
+
+        const uint64_t vertexSize = layout.GetStreamSize(SceneStream::Vertices);
+        errors += Check(!layout.AddMesh(small.Streams, meshIndex), "SceneGeometryLayout: a vertex offset past 32 bits was accepted\n");
+        errors += Check(layout.GetMeshCount() == 1 && layout.GetCopies().size() == 1 && layout.GetStreamSize(SceneStream::Vertices) == vertexSize
+            && layout.GetStreamSize(SceneStream::Meshlets) == 0, "SceneGeometryLayout: a refused mesh changed the layout\n");
+        return errors;
+    }
+}
+
+uint32_t Tests::TestSceneGeometryLayout(const std::wstring&)
+{
+    return CheckOffsets() + CheckOverflow();
+}
@@ -0,0 +1,153 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "SceneGeometry.h"
+
+#include <cstring>
+#include <memory>
+
+using namespace Tests;
+
+namespace
+{
+    // MeshletMS.hlsl's GetVertexIndex over a packed unique index buffer.
+    uint32_t LoadUniqueVertexIndex(const uint8_t* uniqueIndices, const MeshGeometryOffsets& mesh, const Meshlet& meshlet, uint32_t localIndex)
+    {
+        localIndex = meshlet.VertOffset + localIndex;
+
+        uint32_t word;
+        if (mesh.IndexBytes == 4)
+        {
+            std::memcpy(&word, uniqueIndices + mesh.UniqueIndexOffset + localIndex * 4, sizeof(word));
+            return word;
+        }
+
+        std::memcpy(&word, uniqueIndices + mesh.UniqueIndexOffset + (localIndex / 2) * 4, sizeof(word));
+        return (word >> ((localIndex & 1) * 16)) & 0xffff;
+    }
+
+    // Packs every mesh into shared streams, then reads each meshlet's primitives and vertices back
+    // through the offset table the way the mesh shader does, and compares them with the mesh's own
+    // data.
+    uint32_t CheckPackedMeshes(const std::vector<const Mesh*>& meshes)
+    {
+        SceneGeometryLayout layout;
+        uint32_t errors = 0;
+        for (uint32_t i = 0; i < meshes.size(); ++i)
+        {
+            uint32_t meshIndex;
+            errors += Check(SUCCEEDED(AddSceneMesh(layout, *meshes[i], meshIndex)) && meshIndex == i, "SceneGeometry: mesh %u wasn't added as mesh %u\n", i, i);
+        }
+
+        std::vector<uint8_t> streams[SceneStream::Count];
+        uint8_t* streamData[SceneStream::Count];
+        for (uint32_t s = 0; s < SceneStream::Count; ++s)
+        {
+            streams[s].resize(layout.GetStreamSize(static_cast<SceneStream::EType>(s)));
+            streamData[s] = streams[s].data();
+        }
+        PackSceneGeometry(layout, streamData);
+
+        const uint32_t stride = layout.GetVertexStride();
+        const Meshlet* packedMeshlets = reinterpret_cast<const Meshlet*>(streamData[SceneStream::Meshlets]);
+        const uint32_t* packedPrimitives = reinterpret_cast<const uint32_t*>(streamData[SceneStream::PrimitiveIndices]);
+
+        for (uint32_t i = 0; i < meshes.size(); ++i)
+        {
+            const Mesh& mesh = *meshes[i];
+            const MeshGeometryOffsets& offsets = layout.GetTable()[i];
+            const uint32_t* ownPrimitives = reinterpret_cast<const uint32_t*>(mesh.PrimitiveIndices.data());
+
+            uint32_t meshletErrors = 0;
+            uint32_t primitiveErrors = 0;
+            uint32_t vertexErrors = 0;
+            for (uint32_t j = 0; j < mesh.Meshlets.size(); ++j)
+            {
+                const Meshlet& own = mesh.Meshlets[j];
+                const Meshlet& packed = packedMeshlets[offsets.MeshletOffset + j];
+                meshletErrors += std::memcmp(&own, &packed, sizeof(Meshlet)) != 0;
+
+                for (uint32_t p = 0; p < packed.PrimCount; ++p)
+                {
+                    primitiveErrors += packedPrimitives[offsets.PrimitiveOffset + packed.PrimOffset + p] != ownPrimitives[own.PrimOffset + p];
+                }
+
+                for (uint32_t v = 0; v < packed.VertCount; ++v)
+                {
+                    const uint32_t ownIndex = LoadUniqueVertexIndex(mesh.UniqueVertexIndices.data(), GetUnpackedOffsets(mesh), own, v);
+                    const uint32_t packedIndex = offsets.VertexOffset + LoadUniqueVertexIndex(streamData[SceneStream::UniqueVertexIndices], offsets, packed, v);
+
+                    vertexErrors += std::memcmp(mesh.Vertices[0].data() + size_t(ownIndex) * stride, streamData[SceneStream::Vertices] + size_t(packedIndex) * stride, stride) != 0;
+                }
+            }
+
+            errors += Check(meshletErrors + primitiveErrors + vertexErrors == 0, "SceneGeometry: mesh %u reads back %u wrong meshlets, %u wrong primitives and %u wrong vertices\n",
+                i, meshletErrors, primitiveErrors, vertexErrors);
+        }
+
+        return errors;
+    }
+
+    // A vertex stream padded past its last vertex mustn't shift the mesh after it off a stride
+    // boundary, and one too short for its vertices is rejected.
+    uint32_t CheckPaddedVertices(const Mesh& source)
+    {
+        std::vector<uint8_t> vertices(source.Vertices[0].data(), source.Vertices[0].data() + source.Vertices[0].size());
+        vertices.resize(vertices.size() + 4);
+
+        Mesh padded = source;
+        padded.Vertices[0] = MakeSpan(vertices.data(), static_cast<uint32_t>(vertices.size()));
+
+        SceneGeometryLayout layout;
+        uint32_t meshIndex;
+        uint32_t errors = 0;
+        errors += Check(SUCCEEDED(AddSceneMesh(layout, padded, meshIndex)) && SUCCEEDED(AddSceneMesh(layout, source, meshIndex)), "SceneGeometry: adding a padded mesh failed\n");
+
+        const uint32_t stride = layout.GetVertexStride();
+        for (auto& copy : layout.GetCopies())
+        {
+            if (copy.Stream == SceneStream::Vertices && copy.Data == source.Vertices[0].data())
+            {
+                errors += Check(copy.DestOffset == uint64_t(layout.GetTable()[meshIndex].VertexOffset) * stride,
+                    "SceneGeometry: the vertices after a padded stream start at byte %u, not vertex %u\n",
+                    static_cast<uint32_t>(copy.DestOffset), layout.GetTable()[meshIndex].VertexOffset);
+            }
+        }
+
+        padded.Vertices[0] = MakeSpan(vertices.data(), source.VertexCount * stride - 1);
+        errors += Check(AddSceneMesh(layout, padded, meshIndex) == E_INVALIDARG, "SceneGeometry: a vertex stream too short for its vertices was accepted\n");
+        return errors;
+    }
+}
+
+uint32_t Tests::TestSceneGeometry(const std::wstring& assetDirectory)
+{
+    std::vector<std::unique_ptr<Model>> models;
+    std::vector<const Mesh*> meshes;
+    for (auto filename : c_assetFilenames)
+    {
+        const std::wstring path = assetDirectory + filename;
+
+        models.push_back(std::make_unique<Model>());
+        if (FAILED(models.back()->LoadFromFile(path.c_str())))
+        {
+            return Check(false, "Failed to load %ls\n", path.c_str());
+        }
+
+        for (auto& mesh : *models.back())
+        {
+            meshes.push_back(&mesh);
+        }
+    }
+
+    return CheckPackedMeshes(meshes) + CheckPaddedVertices(*meshes[0]);
+}
@@ -0,0 +1,649 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+    const uint32_t c_chunkMeshlets = 32;
+    const uint32_t c_maxMeshletVerts = 256;     // D3D12 mesh shader output limits
+    const uint32_t c_maxMeshletPrims = 256;
+    const uint32_t c_maxChunks = 1 << 16;       // Visibility entries hold a 16-bit chunk and a 16-bit triangle index
+    const uint32_t c_noTriangle = UINT32_MAX;
+
+    const float    c_guardBand = 4.0f;          // Triangles are clipped to [-4w, 4w] in x and y
+    const float    c_subpixelScale = 256.0f;    // Vertices snap to 1/256 pixel, as with D3D's 8 bits of precision
+    const uint32_t c_maxClipVerts = 8;          // A triangle clipped by five planes
+
+    enum ClipPlane : uint32_t
+    {
+        CLIP_NEAR = 1,
+        CLIP_LEFT = 2,
+        CLIP_RIGHT = 4,
+        CLIP_BOTTOM = 8,
+        CLIP_TOP = 16,
+    };
+
+    float PlaneDistance(const XMFLOAT4& p, uint32_t plane)
+    {
+        switch (plane)
+        {
+        case CLIP_NEAR:   return p.z;
+        case CLIP_LEFT:   return p.x + c_guardBand * p.w;
+        case CLIP_RIGHT:  return c_guardBand * p.w - p.x;
+        case CLIP_BOTTOM: return p.y + c_guardBand * p.w;
+        default:          return c_guardBand * p.w - p.y;
+        }
+    }
+
+    uint32_t OutCode(const XMFLOAT4& p)
+    {
+        uint32_t code = 0;
+        for (uint32_t plane = CLIP_NEAR; plane <= CLIP_TOP; plane <<= 1)
+        {
+            code |= PlaneDistance(p, plane) < 0.0f ? plane : 0;
+        }
+        return code;
+    }
+
+    float Snap(float v)
+    {
+        return floorf(v * c_subpixelScale + 0.5f) / c_subpixelScale;
+    }
+
+    XMFLOAT3 Lerp(const XMFLOAT3& a, const XMFLOAT3& b, float t)
+    {
+        XMFLOAT3 result;
+        XMStoreFloat3(&result, XMVectorLerp(XMLoadFloat3(&a), XMLoadFloat3(&b), t));
+        return result;
+    }
+
+    XMVECTOR SafeNormalize(FXMVECTOR v)
+    {
+        const float lengthSq = XMVectorGetX(XMVector3LengthSq(v));
+        return lengthSq > 0.0f ? XMVectorScale(v, 1.0f / sqrtf(lengthSq)) : XMVectorZero();
+    }
+
+    float Saturate(float v)
+    {
+        return min(max(v, 0.0f), 1.0f);
+    }
+
+    uint32_t PackColor(float r, float g, float b, float a)
+    {
+        return uint32_t(Saturate(r) * 255.0f + 0.5f) | (uint32_t(Saturate(g) * 255.0f + 0.5f) << 8) |
+            (uint32_t(Saturate(b) * 255.0f + 0.5f) << 16) | (uint32_t(Saturate(a) * 255.0f + 0.5f) << 24);
+    }
+
+    // MeshletPS.hlsl, given the interpolated attributes.
+    uint32_t ShadePixel(FXMVECTOR normalIn, FXMVECTOR positionVS, uint32_t meshletIndex, bool drawMeshlets)
+    {
+        const float ambientIntensity = 0.1f;
+        const XMVECTOR lightDir = XMVectorNegate(XMVector3Normalize(XMVectorSet(1, -1, 1, 0)));
+
+        XMVECTOR diffuseColor;
+        float shininess;
+        if (drawMeshlets)
+        {
+            diffuseColor = XMVectorSet(float(meshletIndex & 1), float(meshletIndex & 3) / 4, float(meshletIndex & 7) / 8, 0);
+            shininess = 16.0f;
+        }
+        else
+        {
+            diffuseColor = XMVectorReplicate(0.8f);
+            shininess = 64.0f;
+        }
+
+        const XMVECTOR normal = SafeNormalize(normalIn);
+
+        const float cosAngle = Saturate(XMVectorGetX(XMVector3Dot(normal, lightDir)));
+        const XMVECTOR viewDir = XMVectorNegate(SafeNormalize(positionVS));
+        const XMVECTOR halfAngle = SafeNormalize(XMVectorAdd(lightDir, viewDir));
+
+        float blinnTerm = Saturate(XMVectorGetX(XMVector3Dot(normal, halfAngle)));
+        blinnTerm = cosAngle != 0.0f ? blinnTerm : 0.0f;
+        blinnTerm = powf(blinnTerm, shininess);
+
+        XMFLOAT3 color;
+        XMStoreFloat3(&color, XMVectorScale(diffuseColor, cosAngle + blinnTerm + ambientIntensity));
+
+        return PackColor(color.x, color.y, color.z, 1.0f);
+    }
+}
+
+SoftwareRasterizer::SoftwareRasterizer(ThreadPool& pool)
+    : m_pool(pool)
+{
+}
+
+void SoftwareRasterizer::Clear(uint32_t width, uint32_t height, const float clearColor[4])
+{
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + TileSize - 1) / TileSize;
+    m_tilesY = (height + TileSize - 1) / TileSize;
+    m_pitch = m_tilesX * TileSize;
+
+    std::copy(clearColor, clearColor + 4, m_clearColor);
+
+    m_tileDepth.assign(size_t(m_pitch) * m_tilesY * TileSize, 1.0f);
+    m_visibility.assign(m_tileDepth.size(), c_noTriangle);
+
+    m_chunkCount = 0;
+    m_stats = RasterStats();
+}
+
+// Transforms the chunk's meshlets, clips, culls and sets up their triangles, and bins them by tile.
+HRESULT SoftwareRasterizer::SetupChunk(const Mesh& mesh, const RasterConstants& constants, const DrawMeshlet* meshlets, uint32_t count, Chunk& chunk) const
+{
+    const PositionStream positions = mesh.GetPositions();
+    const PositionStream normals = mesh.GetNormals();
+
+    const XMMATRIX world = XMLoadFloat4x4(&constants.World);
+    const XMMATRIX worldView = XMLoadFloat4x4(&constants.WorldView);
+    const XMMATRIX worldViewProj = XMLoadFloat4x4(&constants.WorldViewProj);
+
+    const float width = static_cast<float>(m_width);
+    const float height = static_cast<float>(m_height);
+
+    chunk.Triangles.clear();
+    chunk.Entries.clear();
+    chunk.Stats = RasterStats();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Meshlet& meshlet = mesh.Meshlets[meshlets[i].Meshlet];
+
+        if (meshlet.VertCount > c_maxMeshletVerts || meshlet.PrimCount > c_maxMeshletPrims ||
+            size_t(meshlet.VertOffset) + meshlet.VertCount > mesh.UniqueVertexIndices.size() / mesh.IndexSize ||
+            size_t(meshlet.PrimOffset) + meshlet.PrimCount > mesh.PrimitiveIndices.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        // MeshletMS: one thread per vertex.
+        chunk.Vertices.resize(meshlet.VertCount);
+        for (uint32_t v = 0; v < meshlet.VertCount; ++v)
+        {
+            const uint32_t vertexIndex = mesh.GetVertexIndex(meshlet.VertOffset + v);
+            if (vertexIndex >= mesh.VertexCount)
+            {
+                return E_INVALIDARG;
+            }
+
+            const XMVECTOR position = XMLoadFloat3(&positions[vertexIndex]);
+            const XMVECTOR normal = normals.Data ? XMLoadFloat3(&normals[vertexIndex]) : XMVectorZero();
+
+            ClipVertex& out = chunk.Vertices[v];
+            XMStoreFloat4(&out.Position, XMVector3Transform(position, worldViewProj));
+            XMStoreFloat3(&out.PositionVS, XMVector3Transform(position, worldView));
+            XMStoreFloat3(&out.Normal, XMVector3TransformNormal(normal, world));
+        }
+
+        chunk.Stats.MeshletCount++;
+        chunk.Stats.TriangleCount += meshlet.PrimCount;
+
+        // One thread per primitive.
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            uint32_t i0, i1, i2;
+            mesh.GetPrimitive(meshlet.PrimOffset + p, i0, i1, i2);
+
+            if (i0 >= meshlet.VertCount || i1 >= meshlet.VertCount || i2 >= meshlet.VertCount)
+            {
+                return E_INVALIDARG;
+            }
+
+            ClipVertex polygon[c_maxClipVerts] = { chunk.Vertices[i0], chunk.Vertices[i1], chunk.Vertices[i2] };
+            uint32_t polygonCount = 3;
+
+            const uint32_t codes[3] = { OutCode(polygon[0].Position), OutCode(polygon[1].Position), OutCode(polygon[2].Position) };
+            if (codes[0] & codes[1] & codes[2])
+                continue;
+
+            // Sutherland-Hodgman against each plane the triangle crosses.
+            const uint32_t crossed = codes[0] | codes[1] | codes[2];
+            for (uint32_t plane = CLIP_NEAR; plane <= CLIP_TOP && polygonCount >= 3; plane <<= 1)
+            {
+                if ((crossed & plane) == 0)
+                    continue;
+
+                ClipVertex clipped[c_maxClipVerts];
+                uint32_t clippedCount = 0;
+
+                for (uint32_t k = 0; k < polygonCount; ++k)
+                {
+                    const ClipVertex& a = polygon[k];
+                    const ClipVertex& b = polygon[(k + 1) % polygonCount];
+                    const float da = PlaneDistance(a.Position, plane);
+                    const float db = PlaneDistance(b.Position, plane);
+
+                    if (da >= 0.0f)
+                    {
+                        clipped[clippedCount++] = a;
+                    }
+
+                    if ((da >= 0.0f) != (db >= 0.0f))
+                    {
+                        const float t = da / (da - db);
+
+                        ClipVertex& v = clipped[clippedCount++];
+                        XMStoreFloat4(&v.Position, XMVectorLerp(XMLoadFloat4(&a.Position), XMLoadFloat4(&b.Position), t));
+                        v.PositionVS = Lerp(a.PositionVS, b.PositionVS, t);
+                        v.Normal = Lerp(a.Normal, b.Normal, t);
+                    }
+                }
+
+                std::copy(clipped, clipped + clippedCount, polygon);
+                polygonCount = clippedCount;
+            }
+
+            // Fan the polygon back into triangles and set each up for rasterization.
+            for (uint32_t k = 1; k + 1 < polygonCount; ++k)
+            {
+                const ClipVertex* v[3] = { &polygon[0], &polygon[k], &polygon[k + 1] };
+
+                RasterTriangle tri;
+                float sx[3], sy[3], sz[3];
+
+                for (uint32_t j = 0; j < 3; ++j)
+                {
+                    const XMFLOAT4& clip = v[j]->Position;
+                    tri.InvW[j] = 1.0f / clip.w;
+                    sx[j] = Snap((clip.x * tri.InvW[j] * 0.5f + 0.5f) * width);
+                    sy[j] = Snap((0.5f - clip.y * tri.InvW[j] * 0.5f) * height);
+                    sz[j] = clip.z * tri.InvW[j];
+                    tri.PositionVS[j] = v[j]->PositionVS;
+                    tri.Normal[j] = v[j]->Normal;
+                }
+
+                // Each edge is evaluated from whichever endpoint sorts first, so the two triangles
+                // sharing it compute exactly opposite values and no pixel is drawn twice or missed.
+                tri.TopLeft = 0;
+                for (uint32_t e = 0; e < 3; ++e)
+                {
+                    const uint32_t a = (e + 1) % 3;
+                    const uint32_t b = (e + 2) % 3;
+                    const bool flip = sy[a] > sy[b] || (sy[a] == sy[b] && sx[a] > sx[b]);
+                    const uint32_t first = flip ? b : a;
+                    const uint32_t second = flip ? a : b;
+
+                    const float edgeA = sy[first] - sy[second];
+                    const float edgeB = sx[second] - sx[first];
+
+                    tri.EdgeA[e] = flip ? -edgeA : edgeA;
+                    tri.EdgeB[e] = flip ? -edgeB : edgeB;
+                    tri.EdgeX[e] = sx[first];
+                    tri.EdgeY[e] = sy[first];
+
+                    if (tri.EdgeA[e] > 0.0f || (tri.EdgeA[e] == 0.0f && tri.EdgeB[e] > 0.0f))
+                    {
+                        tri.TopLeft |= 1u << e;
+                    }
+                }
+
+                // Twice the signed area; clockwise on screen is positive.
+                const float area = tri.EdgeA[0] * (sx[0] - tri.EdgeX[0]) + tri.EdgeB[0] * (sy[0] - tri.EdgeY[0]);
+                if (!(area > 0.0f))
+                    continue;
+
+                tri.InvArea = 1.0f / area;
+                tri.X0 = sx[0];
+                tri.Y0 = sy[0];
+                tri.Z0 = sz[0];
+                tri.ZdX = (tri.EdgeA[0] * sz[0] + tri.EdgeA[1] * sz[1] + tri.EdgeA[2] * sz[2]) * tri.InvArea;
+                tri.ZdY = (tri.EdgeB[0] * sz[0] + tri.EdgeB[1] * sz[1] + tri.EdgeB[2] * sz[2]) * tri.InvArea;
+
+                // Pixels whose centres might be covered.
+                tri.MinX = max(int32_t(floorf(min(min(sx[0], sx[1]), sx[2]) - 0.5f)), 0);
+                tri.MinY = max(int32_t(floorf(min(min(sy[0], sy[1]), sy[2]) - 0.5f)), 0);
+                tri.MaxX = min(int32_t(ceilf(max(max(sx[0], sx[1]), sx[2]) - 0.5f)), int32_t(m_width) - 1);
+                tri.MaxY = min(int32_t(ceilf(max(max(sy[0], sy[1]), sy[2]) - 0.5f)), int32_t(m_height) - 1);
+                if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+                    continue;
+
+                tri.MeshletIndex = meshlets[i].MeshletIndex;
+                tri.DrawMeshlets = constants.DrawMeshlets;
+
+                const uint32_t triangleIndex = static_cast<uint32_t>(chunk.Triangles.size());
+                chunk.Triangles.push_back(tri);
+
+                for (int32_t ty = tri.MinY / int32_t(TileSize); ty <= tri.MaxY / int32_t(TileSize); ++ty)
+                {
+                    for (int32_t tx = tri.MinX / int32_t(TileSize); tx <= tri.MaxX / int32_t(TileSize); ++tx)
+                    {
+                        chunk.Entries.push_back((uint64_t(ty * m_tilesX + tx) << 32) | triangleIndex);
+                    }
+                }
+            }
+        }
+    }
+
+    // Group the bin entries by tile; sorting keeps each tile's triangles in draw order.
+    std::sort(chunk.Entries.begin(), chunk.Entries.end());
+
+    const uint32_t tileCount = m_tilesX * m_tilesY;
+    chunk.TileOffsets.assign(tileCount + 1, 0);
+    chunk.TileTriangles.resize(chunk.Entries.size());
+
+    for (size_t e = 0; e < chunk.Entries.size(); ++e)
+    {
+        ++chunk.TileOffsets[(chunk.Entries[e] >> 32) + 1];
+        chunk.TileTriangles[e] = static_cast<uint32_t>(chunk.Entries[e]);
+    }
+    for (uint32_t t = 0; t < tileCount; ++t)
+    {
+        chunk.TileOffsets[t + 1] += chunk.TileOffsets[t];
+    }
+
+    chunk.Stats.RasterTriangleCount = static_cast<uint32_t>(chunk.Triangles.size());
+    chunk.Stats.BinEntryCount = static_cast<uint32_t>(chunk.Entries.size());
+
+    return S_OK;
+}
+
+// Depth-tests the tile's triangles from the given chunks, in order, four pixels at a time.
+void SoftwareRasterizer::RasterizeTile(uint32_t tile, uint32_t firstChunk, uint32_t chunkCount)
+{
+    const int32_t tileX = int32_t(tile % m_tilesX * TileSize);
+    const int32_t tileY = int32_t(tile / m_tilesX * TileSize);
+
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (uint32_t c = firstChunk; c < firstChunk + chunkCount; ++c)
+    {
+        const Chunk& chunk = m_chunks[c];
+
+        for (uint32_t i = chunk.TileOffsets[tile]; i < chunk.TileOffsets[tile + 1]; ++i)
+        {
+            const uint32_t triangleIndex = chunk.TileTriangles[i];
+            const RasterTriangle& tri = chunk.Triangles[triangleIndex];
+            const __m128i id = _mm_set1_epi32(int((c << 16) | triangleIndex));
+
+            const int32_t x0 = max(tri.MinX, tileX) & ~3;
+            const int32_t x1 = min(tri.MaxX, tileX + int32_t(TileSize) - 1);
+            const int32_t y0 = max(tri.MinY, tileY);
+            const int32_t y1 = min(tri.MaxY, tileY + int32_t(TileSize) - 1);
+
+            __m128 edgeA[3], edgeX[3], topLeft[3];
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                edgeA[e] = _mm_set1_ps(tri.EdgeA[e]);
+                edgeX[e] = _mm_set1_ps(tri.EdgeX[e]);
+                topLeft[e] = _mm_castsi128_ps(_mm_set1_epi32((tri.TopLeft >> e) & 1 ? -1 : 0));
+            }
+
+            const __m128 zdX = _mm_set1_ps(tri.ZdX);
+            const __m128 x0Plane = _mm_set1_ps(tri.X0);
+
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                const float py = float(y) + 0.5f;
+
+                __m128 rowEdge[3];
+                for (uint32_t e = 0; e < 3; ++e)
+                {
+                    rowEdge[e] = _mm_set1_ps(tri.EdgeB[e] * (py - tri.EdgeY[e]));
+                }
+                const __m128 rowZ = _mm_set1_ps(tri.Z0 + tri.ZdY * (py - tri.Y0));
+
+                float* depthRow = &m_tileDepth[size_t(y) * m_pitch];
+                uint32_t* visibilityRow = &m_visibility[size_t(y) * m_pitch];
+
+                for (int32_t x = x0; x <= x1; x += 4)
+                {
+                    const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), laneOffsets);
+
+                    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                    for (uint32_t e = 0; e < 3; ++e)
+                    {
+                        const __m128 edge = _mm_add_ps(_mm_mul_ps(edgeA[e], _mm_sub_ps(px, edgeX[e])), rowEdge[e]);
+                        const __m128 onEdge = _mm_and_ps(_mm_cmpeq_ps(edge, zero), topLeft[e]);
+                        inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edge, zero), onEdge));
+                    }
+
+                    if (_mm_movemask_ps(inside) == 0)
+                        continue;
+
+                    const __m128 z = _mm_add_ps(rowZ, _mm_mul_ps(zdX, _mm_sub_ps(px, x0Plane)));
+                    const __m128 depth = _mm_load_ps(depthRow + x);
+                    const __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, depth));
+
+                    const __m128i passMask = _mm_castps_si128(pass);
+                    const __m128i visibility = _mm_load_si128(reinterpret_cast<const __m128i*>(visibilityRow + x));
+
+                    _mm_store_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, depth)));
+                    _mm_store_si128(reinterpret_cast<__m128i*>(visibilityRow + x),
+                        _mm_or_si128(_mm_and_si128(passMask, id), _mm_andnot_si128(passMask, visibility)));
+                }
+            }
+        }
+    }
+}
+
+HRESULT SoftwareRasterizer::Draw(const Mesh& mesh, const RasterConstants& constants, const VisibleMeshlets* visible)
+{
+    if (mesh.IndexSize != 2 && mesh.IndexSize != 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    const Span<const Subset>& meshletSubsets = mesh.MeshletSubsets;
+    if (visible && visible->Subsets.size() != meshletSubsets.size())
+    {
+        return E_INVALIDARG;
+    }
+
+    m_drawList.clear();
+    for (uint32_t s = 0; s < meshletSubsets.size(); ++s)
+    {
+        const Subset& subset = meshletSubsets[s];
+        if (size_t(subset.Offset) + subset.Count > mesh.Meshlets.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        if (visible)
+        {
+            const Subset& range = visible->Subsets[s];
+            for (uint32_t i = range.Offset; i < range.Offset + range.Count; ++i)
+            {
+                const uint32_t meshlet = visible->Indices[i];
+                if (meshlet < subset.Offset || meshlet >= subset.Offset + subset.Count)
+                {
+                    return E_INVALIDARG;
+                }
+
+                DrawMeshlet draw = { meshlet, meshlet - subset.Offset };
+                m_drawList.push_back(draw);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < subset.Count; ++i)
+            {
+                DrawMeshlet draw = { subset.Offset + i, i };
+                m_drawList.push_back(draw);
+            }
+        }
+    }
+
+    const uint32_t drawCount = static_cast<uint32_t>(m_drawList.size());
+    const uint32_t chunkCount = (drawCount + c_chunkMeshlets - 1) / c_chunkMeshlets;
+    const uint32_t firstChunk = m_chunkCount;
+
+    if (size_t(firstChunk) + chunkCount > c_maxChunks)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (m_chunks.size() < firstChunk + chunkCount)
+    {
+        m_chunks.resize(firstChunk + chunkCount);
+    }
+
+    // Set up and bin in parallel, one chunk of meshlets per task.
+    std::vector<HRESULT> results(chunkCount, S_OK);
+
+    m_pool.ParallelFor(chunkCount, [&](uint32_t c)
+    {
+        const uint32_t begin = c * c_chunkMeshlets;
+        const uint32_t count = min(c_chunkMeshlets, drawCount - begin);
+        results[c] = SetupChunk(mesh, constants, &m_drawList[begin], count, m_chunks[firstChunk + c]);
+    });
+
+    for (HRESULT hr : results)
+    {
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    m_chunkCount += chunkCount;
+
+    for (uint32_t c = firstChunk; c < m_chunkCount; ++c)
+    {
+        const RasterStats& stats = m_chunks[c].Stats;
+        m_stats.MeshletCount += stats.MeshletCount;
+        m_stats.TriangleCount += stats.TriangleCount;
+        m_stats.RasterTriangleCount += stats.RasterTriangleCount;
+        m_stats.BinEntryCount += stats.BinEntryCount;
+    }
+
+    // Rasterize in parallel, one tile per task.
+    m_pool.ParallelFor(m_tilesX * m_tilesY, [&](uint32_t tile)
+    {
+        RasterizeTile(tile, firstChunk, chunkCount);
+    });
+
+    return S_OK;
+}
+
+void SoftwareRasterizer::Resolve()
+{
+    m_color.resize(size_t(m_width) * m_height);
+    m_depth.resize(size_t(m_width) * m_height);
+
+    const uint32_t clearColor = PackColor(m_clearColor[0], m_clearColor[1], m_clearColor[2], m_clearColor[3]);
+
+    m_pool.ParallelFor(m_height, [&](uint32_t y)
+    {
+        const float py = float(y) + 0.5f;
+
+        for (uint32_t x = 0; x < m_width; ++x)
+        {
+            const size_t src = size_t(y) * m_pitch + x;
+            const size_t dst = size_t(y) * m_width + x;
+
+            m_depth[dst] = m_tileDepth[src];
+
+            const uint32_t id = m_visibility[src];
+            if (id == c_noTriangle)
+            {
+                m_color[dst] = clearColor;
+                continue;
+            }
+
+            const RasterTriangle& tri = m_chunks[id >> 16].Triangles[id & 0xFFFF];
+            const float px = float(x) + 0.5f;
+
+            // Perspective-correct barycentrics from the edge functions.
+            float weights[3];
+            float weightSum = 0.0f;
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                const float edge = tri.EdgeA[e] * (px - tri.EdgeX[e]) + tri.EdgeB[e] * (py - tri.EdgeY[e]);
+                weights[e] = max(edge * tri.InvArea, 0.0f) * tri.InvW[e];
+                weightSum += weights[e];
+            }
+
+            XMVECTOR normal = XMVectorZero();
+            XMVECTOR positionVS = XMVectorZero();
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                const float weight = weightSum > 0.0f ? weights[e] / weightSum : 1.0f / 3.0f;
+                normal = XMVectorAdd(normal, XMVectorScale(XMLoadFloat3(&tri.Normal[e]), weight));
+                positionVS = XMVectorAdd(positionVS, XMVectorScale(XMLoadFloat3(&tri.PositionVS[e]), weight));
+            }
+
+            m_color[dst] = ShadePixel(normal, positionVS, tri.MeshletIndex, tri.DrawMeshlets != 0);
+        }
+    });
+}
+
+HRESULT SoftwareRasterizer::WriteBitmap(const wchar_t* filename) const
+{
+    if (m_color.size() != size_t(m_width) * m_height)
+    {
+        return E_INVALIDARG;
+    }
+
+    const uint32_t imageSize = m_width * m_height * 4;
+
+#pragma pack(push, 1)
+    struct BitmapHeader
+    {
+        uint16_t Type;
+        uint32_t FileSize;
+        uint32_t Reserved;
+        uint32_t DataOffset;
+        uint32_t InfoSize;
+        int32_t  Width;
+        int32_t  Height;
+        uint16_t Planes;
+        uint16_t BitCount;
+        uint32_t Compression;
+        uint32_t ImageSize;
+        int32_t  PixelsPerMeterX;
+        int32_t  PixelsPerMeterY;
+        uint32_t ColorsUsed;
+        uint32_t ColorsImportant;
+    };
+#pragma pack(pop)
+
+    BitmapHeader header = {};
+    header.Type = 0x4D42; // "BM"
+    header.FileSize = sizeof(header) + imageSize;
+    header.DataOffset = sizeof(header);
+    header.InfoSize = 40;
+    header.Width = int32_t(m_width);
+    header.Height = -int32_t(m_height); // Top-down
+    header.Planes = 1;
+    header.BitCount = 32;
+    header.ImageSize = imageSize;
+
+    // BI_RGB 32-bit pixels are stored as BGRA.
+    std::vector<uint32_t> pixels(m_color.size());
+    for (size_t i = 0; i < m_color.size(); ++i)
+    {
+        const uint32_t c = m_color[i];
+        pixels[i] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+    }
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        return E_INVALIDARG;
+    }
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(pixels.data()), imageSize);
+
+    return stream ? S_OK : E_FAIL;
+}
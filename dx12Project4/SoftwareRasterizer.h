@@ -0,0 +1,144 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "MeshletCuller.h"
+
+// Per-draw constants, matching SceneConstantBuffer before its matrices are transposed for HLSL.
+struct RasterConstants
+{
+    DirectX::XMFLOAT4X4 World;          // Row-vector convention
+    DirectX::XMFLOAT4X4 WorldView;
+    DirectX::XMFLOAT4X4 WorldViewProj;
+    bool                DrawMeshlets;   // Colour by meshlet, as MeshletPS's debug mode does
+};
+
+struct RasterStats
+{
+    uint32_t MeshletCount;
+    uint32_t TriangleCount;         // Triangles decoded from the meshlets
+    uint32_t RasterTriangleCount;   // Left after clipping and back-face culling
+    uint32_t BinEntryCount;         // Triangle and tile pairs rasterized
+};
+
+// CPU stand-in for the MeshletMS/MeshletPS pipeline, for machines without mesh shaders. Draws decode
+// meshlets as MeshletMS.hlsl does, bin the triangles into screen tiles, then rasterize the tiles in
+// parallel with SSE edge functions and a less-than depth test into a visibility buffer. Resolve
+// shades each covered pixel once with MeshletPS's lighting.
+//
+// As in the default rasterizer state, clockwise triangles are front-facing, back faces are culled,
+// and pixel centres on a shared edge belong to exactly one triangle (top-left rule). Every stage
+// writes its results in draw order, so images don't depend on the pool's thread count.
+class SoftwareRasterizer
+{
+public:
+    static const uint32_t TileSize = 64;
+
+    explicit SoftwareRasterizer(ThreadPool& pool = ThreadPool::GetDefault());
+
+    // Starts a frame: sizes the target, clears depth to 1 and colour to clearColor (RGBA), and
+    // discards the previous frame's draws.
+    void Clear(uint32_t width, uint32_t height, const float clearColor[4]);
+
+    // Draws every meshlet of the mesh, or only the visible ones, one dispatch per meshlet subset as
+    // PopulateCommandList issues them; the debug colour therefore counts from the start of each subset.
+    // Fails if a meshlet is malformed or a frame holds more than about two million meshlets.
+    HRESULT Draw(const Mesh& mesh, const RasterConstants& constants, const VisibleMeshlets* visible = nullptr);
+
+    // Shades the frame's visible pixels into the colour buffer and copies out the depth buffer.
+    void Resolve();
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+    // Width * height texels, top row first. Colour is R8G8B8A8_UNORM with red in the low byte, and
+    // depth is the post-projection z of D32_FLOAT. Valid after Resolve.
+    const std::vector<uint32_t>& GetColorBuffer() const { return m_color; }
+    const std::vector<float>& GetDepthBuffer() const { return m_depth; }
+
+    // Totals over the frame's draws.
+    const RasterStats& GetStats() const { return m_stats; }
+
+    // Writes the colour buffer as a 32-bit BMP.
+    HRESULT WriteBitmap(const wchar_t* filename) const;
+
+private:
+    struct ClipVertex
+    {
+        DirectX::XMFLOAT4 Position;     // Clip space
+        DirectX::XMFLOAT3 PositionVS;
+        DirectX::XMFLOAT3 Normal;
+    };
+
+    struct RasterTriangle
+    {
+        float             EdgeA[3];     // Edge i is opposite vertex i: E = A * (x - X) + B * (y - Y),
+        float             EdgeB[3];     // positive inside
+        float             EdgeX[3];
+        float             EdgeY[3];
+        uint32_t          TopLeft;      // Bit i is set if edge i owns pixel centres lying exactly on it
+        float             InvArea;
+        float             Z0;           // Depth plane through the first vertex
+        float             ZdX;
+        float             ZdY;
+        float             X0;
+        float             Y0;
+        float             InvW[3];
+        DirectX::XMFLOAT3 PositionVS[3];
+        DirectX::XMFLOAT3 Normal[3];
+        uint32_t          MeshletIndex;
+        uint32_t          DrawMeshlets;
+        int32_t           MinX;         // Inclusive pixel bounds, clamped to the target
+        int32_t           MinY;
+        int32_t           MaxX;
+        int32_t           MaxY;
+    };
+
+    // A run of consecutive meshlets of one draw, set up and binned by one task.
+    struct Chunk
+    {
+        std::vector<RasterTriangle> Triangles;
+        std::vector<uint32_t>       TileOffsets;    // Ranges of TileTriangles, one per tile plus an end
+        std::vector<uint32_t>       TileTriangles;  // Indices into Triangles, grouped by tile in draw order
+        std::vector<uint64_t>       Entries;        // Scratch: tile << 32 | triangle
+        std::vector<ClipVertex>     Vertices;       // Scratch: the current meshlet's vertices
+        RasterStats                 Stats;
+    };
+
+    struct DrawMeshlet
+    {
+        uint32_t Meshlet;
+        uint32_t MeshletIndex;      // SV_GroupID of the dispatch that draws it
+    };
+
+    HRESULT SetupChunk(const Mesh& mesh, const RasterConstants& constants, const DrawMeshlet* meshlets, uint32_t count, Chunk& chunk) const;
+    void RasterizeTile(uint32_t tile, uint32_t firstChunk, uint32_t chunkCount);
+
+    ThreadPool&              m_pool;
+
+    uint32_t                 m_width = 0;
+    uint32_t                 m_height = 0;
+    uint32_t                 m_tilesX = 0;
+    uint32_t                 m_tilesY = 0;
+    uint32_t                 m_pitch = 0;           // m_tilesX * TileSize
+    float                    m_clearColor[4] = {};
+
+    std::vector<float>       m_tileDepth;           // Padded to whole tiles, m_pitch texels per row
+    std::vector<uint32_t>    m_visibility;          // chunk << 16 | triangle, or UINT32_MAX
+
+    std::vector<Chunk>       m_chunks;              // The first m_chunkCount hold this frame's draws
+    uint32_t                 m_chunkCount = 0;
+    std::vector<DrawMeshlet> m_drawList;
+
+    std::vector<uint32_t>    m_color;
+    std::vector<float>       m_depth;
+    RasterStats              m_stats = {};
+};
@@ -0,0 +1,538 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "BundledAssets.h"
+#include "SoftwareRasterizer.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    // Three tiles across and down, the last ones partial.
+    const uint32_t c_width = 160;
+    const uint32_t c_height = 136;
+    const float c_clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+    // Coverage is only predicted for pixel centres at least this far, in pixels, from every edge;
+    // vertices snap to 1/256 pixel.
+    const double c_edgeMargin = 1.0 / 128;
+
+    // Positions are in clip space with w = 1, so x and y are NDC and z is the depth written. Each
+    // meshlet holds one triangle, so drawing a meshlet draws that triangle alone.
+    HRESULT BuildTriangleMesh(const std::vector<XMFLOAT3>& positions, PositionMesh& out)
+    {
+        out.Positions = positions;
+        out.Indices.resize(positions.size());
+        for (uint32_t i = 0; i < positions.size(); ++i)
+        {
+            out.Indices[i] = i;
+        }
+
+        MeshletGeneratorOptions options;
+        options.MaxVerts = 3;
+        options.MaxPrims = 1;
+        options.Strategy = MeshletStrategy::IndexOrder;
+        return BuildPositionMesh(out, &options);
+    }
+
+    // The clip space position that lands on pixel coordinates (x, y), so that a vertex at (10.5, 3.5)
+    // lies on the centre of pixel (10, 3).
+    XMFLOAT3 ScreenPoint(float x, float y, float z)
+    {
+        return XMFLOAT3(x / c_width * 2.0f - 1.0f, 1.0f - y / c_height * 2.0f, z);
+    }
+
+    RasterConstants MakeIdentityConstants()
+    {
+        RasterConstants constants;
+        XMStoreFloat4x4(&constants.World, XMMatrixIdentity());
+        XMStoreFloat4x4(&constants.WorldView, XMMatrixIdentity());
+        XMStoreFloat4x4(&constants.WorldViewProj, XMMatrixIdentity());
+        constants.DrawMeshlets = true;
+        return constants;
+    }
+
+    // Renders the listed meshlets in the listed order, or every meshlet in mesh order.
+    HRESULT Render(SoftwareRasterizer& rasterizer, const Mesh& mesh, const std::vector<uint32_t>* meshlets = nullptr)
+    {
+        const RasterConstants constants = MakeIdentityConstants();
+        HRESULT hr;
+
+        rasterizer.Clear(c_width, c_height, c_clearColor);
+        if (meshlets)
+        {
+            VisibleMeshlets visible;
+            visible.Indices = *meshlets;
+            visible.Subsets.push_back(Subset{ 0, static_cast<uint32_t>(meshlets->size()) });
+            hr = rasterizer.Draw(mesh, constants, &visible);
+        }
+        else
+        {
+            hr = rasterizer.Draw(mesh, constants);
+        }
+        rasterizer.Resolve();
+        return hr;
+    }
+
+    // 1 if the centre of pixel (x, y) lies inside the clockwise screen triangle, -1 if outside, and 0
+    // if it is too close to an edge to predict.
+    int32_t Classify(const XMFLOAT2 (&triangle)[3], uint32_t x, uint32_t y)
+    {
+        const double px = x + 0.5;
+        const double py = y + 0.5;
+        double nearest = 1e30;
+
+        for (uint32_t e = 0; e < 3; ++e)
+        {
+            const XMFLOAT2& a = triangle[(e + 1) % 3];
+            const XMFLOAT2& b = triangle[(e + 2) % 3];
+            const double edgeA = double(a.y) - b.y;
+            const double edgeB = double(b.x) - a.x;
+            const double distance = (edgeA * (px - a.x) + edgeB * (py - a.y)) / sqrt(edgeA * edgeA + edgeB * edgeB);
+            nearest = min(nearest, distance);
+        }
+        return nearest > c_edgeMargin ? 1 : (nearest < -c_edgeMargin ? -1 : 0);
+    }
+
+    // Counts pixels covered outside the triangle and pixels missed inside it.
+    uint32_t CountCoverageErrors(const SoftwareRasterizer& rasterizer, const XMFLOAT2 (&triangle)[3])
+    {
+        const std::vector<float>& depth = rasterizer.GetDepthBuffer();
+        uint32_t errors = 0;
+
+        for (uint32_t y = 0; y < c_height; ++y)
+        {
+            for (uint32_t x = 0; x < c_width; ++x)
+            {
+                const int32_t side = Classify(triangle, x, y);
+                const bool covered = depth[y * c_width + x] < 1.0f;
+                errors += (side > 0 && !covered) || (side < 0 && covered);
+            }
+        }
+        return errors;
+    }
+
+    // Tessellates a rectangle, whose corners are pixel centres, into a grid of triangles that cross
+    // the tile borders. The inner vertices are moved by whole pixels, so they stay on pixel centres
+    // and many edges pass exactly through pixel centres. Drawing each triangle on its own, every
+    // pixel centre inside the rectangle must be drawn exactly once, and those on its boundary only
+    // on the left and top edges. Drawn together, each pixel must take its one triangle's colour.
+    uint32_t CheckSharedEdges()
+    {
+        const uint32_t columns = 5;
+        const uint32_t rows = 5;
+        const float left = 6.5f;
+        const float top = 5.5f;
+        const float stepX = 29.0f;
+        const float stepY = 25.0f;
+
+        std::vector<XMFLOAT2> grid((columns + 1) * (rows + 1));
+        for (uint32_t j = 0; j <= rows; ++j)
+        {
+            for (uint32_t i = 0; i <= columns; ++i)
+            {
+                const bool inner = i > 0 && i < columns && j > 0 && j < rows;
+                const float jitterX = inner ? float(int32_t((i * 7 + j * 13) % 11) - 5) : 0.0f;
+                const float jitterY = inner ? float(int32_t((i * 5 + j * 3) % 9) - 4) : 0.0f;
+                grid[j * (columns + 1) + i] = XMFLOAT2(left + i * stepX + jitterX, top + j * stepY + jitterY);
+            }
+        }
+
+        // Clockwise on screen, alternating the diagonal.
+        std::vector<XMFLOAT3> positions;
+        for (uint32_t j = 0; j < rows; ++j)
+        {
+            for (uint32_t i = 0; i < columns; ++i)
+            {
+                const XMFLOAT2& p00 = grid[j * (columns + 1) + i];
+                const XMFLOAT2& p10 = grid[j * (columns + 1) + i + 1];
+                const XMFLOAT2& p01 = grid[(j + 1) * (columns + 1) + i];
+                const XMFLOAT2& p11 = grid[(j + 1) * (columns + 1) + i + 1];
+
+                const XMFLOAT2* corners[2][6] =
+                {
+                    { &p00, &p10, &p11, &p00, &p11, &p01 },
+                    { &p00, &p10, &p01, &p10, &p11, &p01 },
+                };
+                for (auto corner : corners[(i + j) & 1])
+                {
+                    positions.push_back(ScreenPoint(corner->x, corner->y, 0.5f));
+                }
+            }
+        }
+
+        PositionMesh triangles;
+        if (FAILED(BuildTriangleMesh(positions, triangles)))
+        {
+            return Check(false, "SoftwareRasterizer: failed to build the shared edge grid\n");
+        }
+
+        const uint32_t triangleCount = static_cast<uint32_t>(triangles.Meshlets.Meshlets.size());
+        const uint32_t pixelCount = c_width * c_height;
+
+        SoftwareRasterizer rasterizer;
+        std::vector<uint32_t> coverage(pixelCount);
+        std::vector<uint32_t> ownerColor(pixelCount);
+        uint32_t failures = 0;
+
+        for (uint32_t t = 0; t < triangleCount; ++t)
+        {
+            const std::vector<uint32_t> meshlet = { t };
+            failures += FAILED(Render(rasterizer, triangles.Mesh, &meshlet));
+
+            const std::vector<float>& depth = rasterizer.GetDepthBuffer();
+            for (uint32_t p = 0; p < pixelCount; ++p)
+            {
+                if (depth[p] < 1.0f)
+                {
+                    coverage[p]++;
+                    ownerColor[p] = rasterizer.GetColorBuffer()[p];
+                }
+            }
+        }
+
+        // Boundary pixel centres on x = 6.5 and y = 5.5 are drawn; those on x = 151.5 and y = 130.5 aren't.
+        uint32_t missed = 0;
+        uint32_t overdrawn = 0;
+        uint32_t outside = 0;
+        for (uint32_t y = 0; y < c_height; ++y)
+        {
+            for (uint32_t x = 0; x < c_width; ++x)
+            {
+                const bool inside = x + 0.5f >= left && x + 0.5f < left + columns * stepX && y + 0.5f >= top && y + 0.5f < top + rows * stepY;
+                const uint32_t count = coverage[y * c_width + x];
+
+                missed += inside && count == 0;
+                overdrawn += count > 1;
+                outside += !inside && count > 0;
+            }
+        }
+
+        failures += FAILED(Render(rasterizer, triangles.Mesh));
+
+        uint32_t combinedMismatches = 0;
+        for (uint32_t p = 0; p < pixelCount; ++p)
+        {
+            const bool covered = rasterizer.GetDepthBuffer()[p] < 1.0f;
+            combinedMismatches += covered != (coverage[p] > 0) || (covered && rasterizer.GetColorBuffer()[p] != ownerColor[p]);
+        }
+
+        uint32_t errors = Check(failures == 0, "SoftwareRasterizer: drawing the shared edge grid failed %u times\n", failures);
+        errors += Check(triangleCount == columns * rows * 2, "SoftwareRasterizer: the shared edge grid has %u meshlets, not %u\n", triangleCount, columns * rows * 2);
+        errors += Check(missed == 0, "SoftwareRasterizer: %u pixels inside the shared edge grid were missed\n", missed);
+        errors += Check(overdrawn == 0, "SoftwareRasterizer: %u pixels on shared edges were drawn more than once\n", overdrawn);
+        errors += Check(outside == 0, "SoftwareRasterizer: %u pixels outside the shared edge grid were drawn\n", outside);
+        errors += Check(combinedMismatches == 0, "SoftwareRasterizer: drawing the grid at once differs from its triangles in %u pixels\n", combinedMismatches);
+        return errors;
+    }
+
+    // Triangles are clipped against the near plane and against the guard band. A triangle reaching
+    // far past the guard band on every side must still cover each pixel once at its own depth, and
+    // one crossing the near plane must be drawn exactly where its depth is positive.
+    uint32_t CheckClipping()
+    {
+        const std::vector<XMFLOAT3> positions =
+        {
+            // Past the guard band on the left, right, top and bottom; depth 0.2 + 0.005 (x + 10) + 0.01 (y + 10)
+            XMFLOAT3(-10.0f, -10.0f, 0.2f), XMFLOAT3(-10.0f, 30.0f, 0.6f), XMFLOAT3(30.0f, -10.0f, 0.4f),
+
+            // Depth -0.6 + 0.01 (x - 10) in pixels, crossing the near plane at x = 70
+            ScreenPoint(10.0f, 10.0f, -0.6f), ScreenPoint(150.0f, 10.0f, 0.8f), ScreenPoint(10.0f, 126.0f, -0.6f),
+
+            // Wholly behind the near plane
+            ScreenPoint(10.0f, 10.0f, -0.5f), ScreenPoint(150.0f, 10.0f, -0.1f), ScreenPoint(10.0f, 126.0f, -0.3f),
+        };
+
+        PositionMesh triangles;
+        if (FAILED(BuildTriangleMesh(positions, triangles)))
+        {
+            return Check(false, "SoftwareRasterizer: failed to build the clipping triangles\n");
+        }
+
+        SoftwareRasterizer rasterizer;
+        uint32_t failures = 0;
+
+        // The guard band triangle.
+        const std::vector<uint32_t> guardBand = { 0 };
+        failures += FAILED(Render(rasterizer, triangles.Mesh, &guardBand));
+
+        uint32_t guardBandErrors = 0;
+        for (uint32_t y = 0; y < c_height; ++y)
+        {
+            for (uint32_t x = 0; x < c_width; ++x)
+            {
+                const double ndcX = (x + 0.5) / c_width * 2.0 - 1.0;
+                const double ndcY = 1.0 - (y + 0.5) / c_height * 2.0;
+                const double expected = 0.2 + 0.005 * (ndcX + 10.0) + 0.01 * (ndcY + 10.0);
+                guardBandErrors += fabs(rasterizer.GetDepthBuffer()[y * c_width + x] - expected) > 1e-4;
+            }
+        }
+
+        // The triangle crossing the near plane.
+        const std::vector<uint32_t> nearPlane = { 1 };
+        failures += FAILED(Render(rasterizer, triangles.Mesh, &nearPlane));
+
+        const XMFLOAT2 nearTriangle[3] = { XMFLOAT2(10.0f, 10.0f), XMFLOAT2(150.0f, 10.0f), XMFLOAT2(10.0f, 126.0f) };
+        uint32_t nearPlaneErrors = 0;
+        for (uint32_t y = 0; y < c_height; ++y)
+        {
+            for (uint32_t x = 0; x < c_width; ++x)
+            {
+                const double expected = -0.6 + 0.01 * (x + 0.5 - 10.0);
+                const int32_t side = Classify(nearTriangle, x, y);
+                const float depth = rasterizer.GetDepthBuffer()[y * c_width + x];
+
+                if (side < 0 || expected < -1e-3)
+                {
+                    nearPlaneErrors += depth < 1.0f;
+                }
+                else if (side > 0 && expected > 1e-3)
+                {
+                    nearPlaneErrors += fabs(depth - expected) > 1e-4;
+                }
+            }
+        }
+
+        // The triangle behind the near plane.
+        const std::vector<uint32_t> behind = { 2 };
+        failures += FAILED(Render(rasterizer, triangles.Mesh, &behind));
+
+        const std::vector<float>& depth = rasterizer.GetDepthBuffer();
+        const uint32_t behindCovered = static_cast<uint32_t>(std::count_if(depth.begin(), depth.end(), [](float d) { return d < 1.0f; }));
+
+        uint32_t errors = Check(failures == 0, "SoftwareRasterizer: drawing the clipping triangles failed %u times\n", failures);
+        errors += Check(guardBandErrors == 0, "SoftwareRasterizer: the triangle past the guard band is wrong in %u pixels\n", guardBandErrors);
+        errors += Check(nearPlaneErrors == 0, "SoftwareRasterizer: the triangle crossing the near plane is wrong in %u pixels\n", nearPlaneErrors);
+        errors += Check(behindCovered == 0 && rasterizer.GetStats().RasterTriangleCount == 0,
+            "SoftwareRasterizer: the triangle behind the near plane drew %u pixels\n", behindCovered);
+        return errors;
+    }
+
+    // A triangle is binned into each tile its pixel bounds overlap, including the partial tiles on the
+    // right and bottom, and is rasterized correctly in each of them.
+    uint32_t CheckTileBinning()
+    {
+        struct BinCase
+        {
+            const char* Name;
+            XMFLOAT2    Triangle[3];
+            uint32_t    BinEntryCount;
+        };
+
+        const BinCase cases[] =
+        {
+            { "inside one tile",          { XMFLOAT2(10.0f, 10.0f),   XMFLOAT2(50.0f, 10.0f),   XMFLOAT2(10.0f, 50.0f)   }, 1 },
+            { "on a four tile corner",    { XMFLOAT2(58.0f, 58.0f),   XMFLOAT2(70.0f, 58.0f),   XMFLOAT2(58.0f, 70.0f)   }, 4 },
+            { "across a tile border",     { XMFLOAT2(40.3f, 30.5f),   XMFLOAT2(90.7f, 35.0f),   XMFLOAT2(50.0f, 60.5f)   }, 2 },
+            { "across the partial tiles", { XMFLOAT2(100.0f, 100.0f), XMFLOAT2(200.0f, 100.0f), XMFLOAT2(100.0f, 200.0f) }, 4 },
+            { "right of the target",      { XMFLOAT2(170.0f, 10.0f),  XMFLOAT2(230.0f, 10.0f),  XMFLOAT2(170.0f, 70.0f)  }, 0 },
+        };
+
+        std::vector<XMFLOAT3> positions;
+        for (auto& c : cases)
+        {
+            for (auto& vertex : c.Triangle)
+            {
+                positions.push_back(ScreenPoint(vertex.x, vertex.y, 0.5f));
+            }
+        }
+
+        PositionMesh triangles;
+        if (FAILED(BuildTriangleMesh(positions, triangles)))
+        {
+            return Check(false, "SoftwareRasterizer: failed to build the binning triangles\n");
+        }
+
+        SoftwareRasterizer rasterizer;
+        uint32_t errors = 0;
+
+        for (uint32_t i = 0; i < _countof(cases); ++i)
+        {
+            const std::vector<uint32_t> meshlet = { i };
+            const HRESULT hr = Render(rasterizer, triangles.Mesh, &meshlet);
+
+            const uint32_t binEntries = rasterizer.GetStats().BinEntryCount;
+            const uint32_t coverageErrors = CountCoverageErrors(rasterizer, cases[i].Triangle);
+
+            errors += Check(SUCCEEDED(hr) && binEntries == cases[i].BinEntryCount, "SoftwareRasterizer: the triangle %s has %u bin entries, not %u\n",
+                cases[i].Name, binEntries, cases[i].BinEntryCount);
+            errors += Check(coverageErrors == 0, "SoftwareRasterizer: the triangle %s is wrong in %u pixels\n", cases[i].Name, coverageErrors);
+        }
+        return errors;
+    }
+
+    // Overlapping and intersecting triangles, two of them coplanar, drawn in several orders. The
+    // visibility buffer must keep, in each pixel, the first triangle drawn at the nearest depth, so
+    // the frame must match folding each triangle's own render in draw order with a less-than test.
+    uint32_t CheckVisibilityBuffer()
+    {
+        const std::vector<XMFLOAT3> positions =
+        {
+            ScreenPoint(20.0f, 20.0f, 0.2f),  ScreenPoint(140.0f, 30.0f, 0.8f), ScreenPoint(30.0f, 120.0f, 0.2f),     // Recedes to the right
+            ScreenPoint(140.0f, 20.0f, 0.2f), ScreenPoint(150.0f, 125.0f, 0.2f), ScreenPoint(15.0f, 60.0f, 0.8f),     // Recedes to the left
+            ScreenPoint(60.0f, 50.0f, 0.1f),  ScreenPoint(100.0f, 55.0f, 0.1f), ScreenPoint(70.0f, 90.0f, 0.1f),      // In front
+            ScreenPoint(5.0f, 5.0f, 0.9f),    ScreenPoint(155.0f, 5.0f, 0.9f),  ScreenPoint(80.0f, 130.0f, 0.9f),     // Behind
+            ScreenPoint(80.0f, 60.0f, 0.1f),  ScreenPoint(120.0f, 70.0f, 0.1f), ScreenPoint(75.0f, 100.0f, 0.1f),     // Level with the front one
+        };
+
+        PositionMesh triangles;
+        if (FAILED(BuildTriangleMesh(positions, triangles)))
+        {
+            return Check(false, "SoftwareRasterizer: failed to build the overlapping triangles\n");
+        }
+
+        const uint32_t triangleCount = static_cast<uint32_t>(triangles.Meshlets.Meshlets.size());
+        const uint32_t pixelCount = c_width * c_height;
+
+        SoftwareRasterizer rasterizer;
+        std::vector<std::vector<uint32_t>> soloColor(triangleCount);
+        std::vector<std::vector<float>> soloDepth(triangleCount);
+        uint32_t failures = 0;
+
+        for (uint32_t t = 0; t < triangleCount; ++t)
+        {
+            const std::vector<uint32_t> meshlet = { t };
+            failures += FAILED(Render(rasterizer, triangles.Mesh, &meshlet));
+            soloColor[t] = rasterizer.GetColorBuffer();
+            soloDepth[t] = rasterizer.GetDepthBuffer();
+        }
+
+        // Each triangle's debug colour must differ from the others' and from the clear colour, or a
+        // frame taking the wrong triangle could still match.
+        std::vector<uint32_t> colors;
+        for (uint32_t t = 0; t < triangleCount; ++t)
+        {
+            for (uint32_t p = 0; p < pixelCount; ++p)
+            {
+                if (soloDepth[t][p] < 1.0f)
+                {
+                    colors.push_back(soloColor[t][p]);
+                    break;
+                }
+            }
+        }
+        colors.push_back(soloColor[0][0]);
+        std::sort(colors.begin(), colors.end());
+        const bool distinct = colors.size() == triangleCount + 1 && std::adjacent_find(colors.begin(), colors.end()) == colors.end();
+
+        const std::vector<uint32_t> orders[] =
+        {
+            { 0, 1, 2, 3, 4 },
+            { 4, 3, 2, 1, 0 },
+            { 2, 4, 0, 3, 1 },
+        };
+
+        uint32_t errors = 0;
+        for (uint32_t o = 0; o <= _countof(orders); ++o)
+        {
+            // The last pass draws the whole mesh without a visible list.
+            const std::vector<uint32_t>* order = o < _countof(orders) ? &orders[o] : nullptr;
+            failures += FAILED(Render(rasterizer, triangles.Mesh, order));
+
+            uint32_t mismatches = 0;
+            for (uint32_t p = 0; p < pixelCount; ++p)
+            {
+                uint32_t expectedColor = soloColor[0][0];
+                float expectedDepth = 1.0f;
+                for (uint32_t i = 0; i < triangleCount; ++i)
+                {
+                    const uint32_t t = order ? (*order)[i] : i;
+                    if (soloDepth[t][p] < expectedDepth)
+                    {
+                        expectedDepth = soloDepth[t][p];
+                        expectedColor = soloColor[t][p];
+                    }
+                }
+
+                mismatches += rasterizer.GetColorBuffer()[p] != expectedColor || rasterizer.GetDepthBuffer()[p] != expectedDepth;
+            }
+            errors += Check(mismatches == 0, "SoftwareRasterizer: draw order %u differs from the depth-tested triangles in %u pixels\n", o, mismatches);
+        }
+
+        errors += Check(failures == 0, "SoftwareRasterizer: drawing the overlapping triangles failed %u times\n", failures);
+        errors += Check(distinct, "SoftwareRasterizer: the overlapping triangles' colours aren't distinct\n");
+        return errors;
+    }
+
+    // Every stage writes in draw order, so a model must render to the same image with one worker as
+    // with several.
+    uint32_t CheckThreadCountInvariance(const std::wstring& assetDirectory)
+    {
+        const std::wstring path = assetDirectory + c_assetFilenames[2];
+
+        Model model;
+        if (FAILED(model.LoadFromFile(path.c_str())))
+        {
+            return Check(false, "Failed to load %ls\n", path.c_str());
+        }
+
+        const uint32_t width = 320;
+        const uint32_t height = 180;
+
+        const BoundingSphere& bounds = model.GetBoundingSphere();
+        const XMVECTOR center = XMLoadFloat3(&bounds.Center);
+        const XMVECTOR eye = XMVectorAdd(center, XMVectorScale(XMVectorSet(0.6f, 0.3f, 0.8f, 0), 2.0f * bounds.Radius));
+        const XMMATRIX view = XMMatrixLookAtRH(eye, center, XMVectorSet(0, 1, 0, 0));
+        const XMMATRIX proj = XMMatrixPerspectiveFovRH(XM_PI / 3.0f, float(width) / height, bounds.Radius * 0.01f, bounds.Radius * 10.0f);
+
+        RasterConstants constants;
+        XMStoreFloat4x4(&constants.World, XMMatrixIdentity());
+        XMStoreFloat4x4(&constants.WorldView, view);
+        XMStoreFloat4x4(&constants.WorldViewProj, view * proj);
+        constants.DrawMeshlets = true;
+
+        ThreadPool serialPool(1);
+        ThreadPool pool(4);
+        ThreadPool* pools[] = { &serialPool, &pool };
+
+        std::vector<uint32_t> color[2];
+        std::vector<float> depth[2];
+        uint32_t failures = 0;
+
+        for (uint32_t p = 0; p < _countof(pools); ++p)
+        {
+            SoftwareRasterizer rasterizer(*pools[p]);
+            rasterizer.Clear(width, height, c_clearColor);
+            for (auto& mesh : model)
+            {
+                failures += FAILED(rasterizer.Draw(mesh, constants));
+            }
+            rasterizer.Resolve();
+
+            color[p] = rasterizer.GetColorBuffer();
+            depth[p] = rasterizer.GetDepthBuffer();
+        }
+
+        const uint32_t covered = static_cast<uint32_t>(std::count_if(depth[0].begin(), depth[0].end(), [](float d) { return d < 1.0f; }));
+
+        uint32_t errors = Check(failures == 0, "SoftwareRasterizer: drawing %ls failed %u times\n", c_assetFilenames[2], failures);
+        errors += Check(covered > 0, "SoftwareRasterizer: %ls covers no pixels\n", c_assetFilenames[2]);
+        errors += Check(color[0] == color[1] && depth[0] == depth[1], "SoftwareRasterizer: %ls renders differently with 1 and %u workers\n",
+            c_assetFilenames[2], pool.GetThreadCount());
+        return errors;
+    }
+}
+
+uint32_t Tests::TestSoftwareRasterizer(const std::wstring& assetDirectory)
+{
+    uint32_t errors = CheckSharedEdges();
+    errors += CheckClipping();
+    errors += CheckTileBinning();
+    errors += CheckVisibilityBuffer();
+    errors += CheckThreadCountInvariance(assetDirectory);
+    return errors;
+}
@@ -26,6 +26,13 @@ public:
         , m_count(count)
     { }
 
+    // A Span<const T> views the same elements as a Span<T>.
+    template <typename U>
+    Span(const Span<U>& other)
+        : m_data(other.data())
+        , m_count(static_cast<uint32_t>(other.size()))
+    { }
+
     // std library container interface
     T* data() { return m_data; }
     const T* data() const { return m_data; }
@@ -38,6 +45,8 @@ public:
     // Iterator interface
     T* begin() { return m_data; }
     T* end() { return m_data + m_count; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_count; }
 
     T& operator[](uint32_t i) { return *(m_data + i); }
     const T& operator[](uint32_t i) const { return *(m_data + i); }
@@ -0,0 +1,233 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "TemporalOcclusionCuller.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    bool TestBit(const std::vector<uint32_t>& bits, uint32_t index)
+    {
+        return (bits[index >> 5] >> (index & 31)) & 1;
+    }
+
+    void SetBit(std::vector<uint32_t>& bits, uint32_t index)
+    {
+        bits[index >> 5] |= 1u << (index & 31);
+    }
+}
+
+TemporalOcclusionCuller::TemporalOcclusionCuller(uint32_t width, uint32_t height, uint32_t occluderTriangleBudget)
+    : m_culler(width, height)
+    , m_frame(0)
+    , m_stats()
+    , m_occluderTriangleBudget(occluderTriangleBudget)
+    , m_occludersRendered(false)
+{ }
+
+void TemporalOcclusionCuller::BeginFrame(FXMMATRIX viewProj)
+{
+    m_culler.Clear(viewProj);
+    m_frame++;
+    m_stats = TemporalCullStats();
+
+    XMStoreFloat4x4(&m_viewProj, viewProj);
+    m_occludersRendered = false;
+    m_candidates.clear();
+}
+
+HRESULT TemporalOcclusionCuller::CullPhaseOne(uint32_t instance, const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& previous)
+{
+    if (instance >= m_instances.size())
+    {
+        m_instances.resize(instance + 1, Instance());
+    }
+
+    Instance& state = m_instances[instance];
+
+    const uint32_t meshletCount = static_cast<uint32_t>(mesh.CullingData.size());
+    if (state.MeshletCount != meshletCount || state.Visible.empty())
+    {
+        state.MeshletCount = meshletCount;
+        state.Visible.assign((meshletCount + 31) / 32 + 1, 0);
+    }
+
+    HRESULT hr = CullMeshlets(mesh, params, state.Frustum);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const VisibleMeshlets& frustum = state.Frustum;
+
+    previous.Indices.clear();
+    previous.Subsets.resize(frustum.Subsets.size());
+
+    for (uint32_t s = 0; s < frustum.Subsets.size(); ++s)
+    {
+        const Subset& subset = frustum.Subsets[s];
+        previous.Subsets[s].Offset = static_cast<uint32_t>(previous.Indices.size());
+
+        for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+        {
+            if (TestBit(state.Visible, frustum.Indices[i]))
+            {
+                previous.Indices.push_back(frustum.Indices[i]);
+            }
+        }
+
+        previous.Subsets[s].Count = static_cast<uint32_t>(previous.Indices.size()) - previous.Subsets[s].Offset;
+    }
+
+    // What phase one draws is this frame's geometry too; rank it by distance as occluders.
+    const XMMATRIX worldViewProj = XMMatrixMultiply(XMLoadFloat4x4(&params.World), XMLoadFloat4x4(&m_viewProj));
+    for (uint32_t index : previous.Indices)
+    {
+        const XMFLOAT4& sphere = mesh.CullingData[index].BoundingSphere;
+        const float w = XMVectorGetW(XMVector3Transform(XMVectorSet(sphere.x, sphere.y, sphere.z, 1.0f), worldViewProj));
+        m_candidates.push_back(OccluderCandidate{ w - sphere.w * params.Scale, instance, index });
+    }
+
+    state.Frame = m_frame;
+    state.SourceMesh = &mesh;
+    state.World = params.World;
+
+    m_stats.InstanceCount++;
+    m_stats.FrustumCount += static_cast<uint32_t>(frustum.Indices.size());
+    m_stats.PreviousCount += static_cast<uint32_t>(previous.Indices.size());
+
+    return S_OK;
+}
+
+HRESULT TemporalOcclusionCuller::CullPhaseTwo(uint32_t instance, const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& revealed)
+{
+    if (instance >= m_instances.size() || m_instances[instance].Frame != m_frame || m_instances[instance].MeshletCount != mesh.CullingData.size())
+    {
+        return E_INVALIDARG;
+    }
+
+    if (!m_occludersRendered)
+    {
+        const HRESULT hr = RenderOccluders();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    Instance& state = m_instances[instance];
+    VisibleMeshlets& survivors = state.Frustum;
+
+    if (m_culler.IsMeshVisible(mesh, params))
+    {
+        const HRESULT hr = m_culler.CullOccludedMeshlets(mesh, params, survivors);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+    else
+    {
+        survivors.Indices.clear();
+        std::fill(survivors.Subsets.begin(), survivors.Subsets.end(), Subset());
+    }
+
+    revealed.Indices.clear();
+    revealed.Subsets.resize(survivors.Subsets.size());
+
+    for (uint32_t s = 0; s < survivors.Subsets.size(); ++s)
+    {
+        const Subset& subset = survivors.Subsets[s];
+        revealed.Subsets[s].Offset = static_cast<uint32_t>(revealed.Indices.size());
+
+        for (uint32_t i = subset.Offset; i < subset.Offset + subset.Count; ++i)
+        {
+            if (!TestBit(state.Visible, survivors.Indices[i]))
+            {
+                revealed.Indices.push_back(survivors.Indices[i]);
+            }
+        }
+
+        revealed.Subsets[s].Count = static_cast<uint32_t>(revealed.Indices.size()) - revealed.Subsets[s].Offset;
+    }
+
+    // Meshlets outside the frustum or hidden this frame drop out of the visible set.
+    std::fill(state.Visible.begin(), state.Visible.end(), 0u);
+    for (uint32_t index : survivors.Indices)
+    {
+        SetBit(state.Visible, index);
+    }
+
+    m_stats.KeptCount += static_cast<uint32_t>(survivors.Indices.size() - revealed.Indices.size());
+    m_stats.RevealedCount += static_cast<uint32_t>(revealed.Indices.size());
+
+    return S_OK;
+}
+
+HRESULT TemporalOcclusionCuller::RenderOccluders()
+{
+    m_occludersRendered = true;
+
+    // The nearest candidates first, skipping any that would overrun the budget. Taking whole nearby
+    // surfaces leaves the depth buffer without the gaps that scattered large meshlets would, and
+    // partial occluders with gaps hide next to nothing.
+    std::sort(m_candidates.begin(), m_candidates.end(), [](const OccluderCandidate& a, const OccluderCandidate& b) { return a.Depth < b.Depth; });
+
+    uint32_t chosenCount = 0;
+    uint32_t triangleCount = 0;
+    for (auto& candidate : m_candidates)
+    {
+        const uint32_t primCount = m_instances[candidate.Instance].SourceMesh->Meshlets[candidate.Meshlet].PrimCount;
+        if (triangleCount + primCount <= m_occluderTriangleBudget)
+        {
+            triangleCount += primCount;
+            m_candidates[chosenCount++] = candidate;
+        }
+    }
+
+    // One RenderMeshlets call per instance.
+    std::sort(m_candidates.begin(), m_candidates.begin() + chosenCount, [](const OccluderCandidate& a, const OccluderCandidate& b)
+    {
+        return a.Instance < b.Instance || (a.Instance == b.Instance && a.Meshlet < b.Meshlet);
+    });
+
+    for (uint32_t i = 0; i < chosenCount; )
+    {
+        const Instance& state = m_instances[m_candidates[i].Instance];
+
+        m_occluders.Indices.clear();
+        for (const uint32_t instance = m_candidates[i].Instance; i < chosenCount && m_candidates[i].Instance == instance; ++i)
+        {
+            m_occluders.Indices.push_back(m_candidates[i].Meshlet);
+        }
+
+        const HRESULT hr = m_culler.RenderMeshlets(*state.SourceMesh, XMLoadFloat4x4(&state.World), m_occluders);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    m_stats.OccluderCount = chosenCount;
+    m_stats.OccluderTriangleCount = triangleCount;
+    return S_OK;
+}
+
+void TemporalOcclusionCuller::Reset()
+{
+    for (auto& state : m_instances)
+    {
+        std::fill(state.Visible.begin(), state.Visible.end(), 0u);
+    }
+}
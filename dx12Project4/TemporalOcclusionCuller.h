@@ -0,0 +1,97 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "OcclusionCuller.h"
+
+// Totals over the instances of the current frame.
+struct TemporalCullStats
+{
+    uint32_t InstanceCount;
+    uint32_t FrustumCount;      // Meshlets passing the frustum and normal cone tests
+    uint32_t PreviousCount;     // Of those, visible last frame: drawn in phase one untested
+    uint32_t OccluderCount;     // Of those, rasterized into the depth buffer
+    uint32_t OccluderTriangleCount;
+    uint32_t KeptCount;         // Phase one meshlets still visible against this frame's depth
+    uint32_t RevealedCount;     // Meshlets hidden or outside the frustum last frame, drawn in phase two
+};
+
+// Two-phase occlusion culling that uses last frame's visibility as this frame's occluders, so no
+// occluder geometry needs to be chosen. Each instance, a mesh under a transform identified by an
+// index the caller picks, keeps a bitset of the meshlets that were visible in its last frame.
+//
+// A frame calls BeginFrame, then CullPhaseOne for every instance, then CullPhaseTwo for every
+// instance; the meshes must stay alive in between. Phase one frustum culls an instance and returns
+// the meshlets that were also visible last frame, to be drawn straight away. Before the first phase
+// two test, the nearest of those, across every instance, are rasterized into the depth buffer until
+// occluderTriangleBudget triangles have been drawn. Phase two tests all of the
+// instance's meshlets in the frustum against that depth, returns the ones phase one didn't draw, and
+// records the survivors as the instance's visibility for the next frame.
+//
+// The occluders are real geometry of this frame, so phase two is as conservative as OcclusionCuller
+// with exact occluders, and a camera that barely moves reveals few meshlets. Leaving the distant
+// meshlets out of the depth buffer only loses what hides behind them, and bounds the cost by the
+// budget instead of by everything on screen.
+class TemporalOcclusionCuller
+{
+public:
+    explicit TemporalOcclusionCuller(uint32_t width = 256, uint32_t height = 128, uint32_t occluderTriangleBudget = 16384);
+
+    // Starts a frame seen through viewProj (row-vector convention).
+    void BeginFrame(DirectX::FXMMATRIX viewProj);
+
+    // Instances are created on first use. An instance whose mesh changes meshlet count starts over
+    // with no history. Fails as CullMeshlets does.
+    HRESULT CullPhaseOne(uint32_t instance, const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& previous);
+
+    // Fails if CullPhaseOne hasn't been called for the instance this frame with the same mesh, or
+    // as OcclusionCuller::RenderMeshlets does for the occluders.
+    HRESULT CullPhaseTwo(uint32_t instance, const Mesh& mesh, const MeshletCullParams& params, VisibleMeshlets& revealed);
+
+    // Forgets every instance's history, as after a camera cut; the next frame draws all of its
+    // meshlets in phase two.
+    void Reset();
+
+    const TemporalCullStats& GetStats() const { return m_stats; }
+    const OcclusionCuller& GetOcclusionCuller() const { return m_culler; }
+
+private:
+    struct Instance
+    {
+        std::vector<uint32_t> Visible;      // Bit i is set if meshlet i was visible last frame
+        uint32_t              MeshletCount;
+        uint32_t              Frame;        // Frame of the last CullPhaseOne
+        VisibleMeshlets       Frustum;      // Scratch: phase one's frustum survivors
+        const Mesh*           SourceMesh;   // As of the last CullPhaseOne
+        DirectX::XMFLOAT4X4   World;
+    };
+
+    // A meshlet phase one draws, which may go into the depth buffer.
+    struct OccluderCandidate
+    {
+        float    Depth;                     // Clip w of the nearest point of its bounding sphere
+        uint32_t Instance;
+        uint32_t Meshlet;
+    };
+
+    HRESULT RenderOccluders();
+
+    OcclusionCuller                m_culler;
+    std::vector<Instance>          m_instances;
+    uint32_t                       m_frame;
+    TemporalCullStats              m_stats;
+
+    uint32_t                       m_occluderTriangleBudget;
+    DirectX::XMFLOAT4X4            m_viewProj;
+    bool                           m_occludersRendered;
+    std::vector<OccluderCandidate> m_candidates;
+    VisibleMeshlets                m_occluders;         // Scratch: one instance's chosen occluders
+};
@@ -0,0 +1,177 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "TemporalOcclusionCuller.h"
+#include "TestMeshes.h"
+
+using namespace DirectX;
+using namespace Tests;
+
+namespace
+{
+    // Copies of one mesh, each scaled and then moved.
+    struct Placement
+    {
+        float    Scale;
+        XMFLOAT3 Offset;
+    };
+
+    // What each phase returned for each instance in one frame.
+    struct FrameResult
+    {
+        std::vector<VisibleMeshlets> Previous;
+        std::vector<VisibleMeshlets> Revealed;
+        std::vector<VisibleMeshlets> Frustum;   // CullMeshlets alone, for reference
+    };
+
+    bool SameMeshlets(const VisibleMeshlets& a, const VisibleMeshlets& b)
+    {
+        bool same = a.Indices == b.Indices && a.Subsets.size() == b.Subsets.size();
+        for (uint32_t s = 0; same && s < a.Subsets.size(); ++s)
+        {
+            same = a.Subsets[s].Offset == b.Subsets[s].Offset && a.Subsets[s].Count == b.Subsets[s].Count;
+        }
+        return same;
+    }
+
+    // Runs both phases of one frame over every placement, seen from eye towards the origin.
+    HRESULT CullFrame(TemporalOcclusionCuller& culler, const Mesh& mesh, const std::vector<Placement>& placements, FXMVECTOR eye, FrameResult& result)
+    {
+        const XMMATRIX view = XMMatrixLookAtRH(eye, XMVectorZero(), XMVectorSet(0, 1, 0, 0));
+        const XMMATRIX proj = XMMatrixPerspectiveFovRH(XM_PIDIV4, 2.0f, 0.1f, 20.0f);
+        const XMMATRIX viewProj = view * proj;
+
+        const uint32_t instanceCount = static_cast<uint32_t>(placements.size());
+        std::vector<MeshletCullParams> params(instanceCount);
+        for (uint32_t i = 0; i < instanceCount; ++i)
+        {
+            const Placement& p = placements[i];
+            XMStoreFloat4x4(&params[i].World, XMMatrixScaling(p.Scale, p.Scale, p.Scale) * XMMatrixTranslation(p.Offset.x, p.Offset.y, p.Offset.z));
+            params[i].Scale = p.Scale;
+            ComputeFrustumPlanes(viewProj, params[i].Planes);
+            XMStoreFloat3(&params[i].ViewPosition, eye);
+        }
+
+        result.Previous.resize(instanceCount);
+        result.Revealed.resize(instanceCount);
+        result.Frustum.resize(instanceCount);
+
+        culler.BeginFrame(viewProj);
+
+        HRESULT hr = S_OK;
+        for (uint32_t i = 0; i < instanceCount && SUCCEEDED(hr); ++i)
+        {
+            hr = culler.CullPhaseOne(i, mesh, params[i], result.Previous[i]);
+        }
+        for (uint32_t i = 0; i < instanceCount && SUCCEEDED(hr); ++i)
+        {
+            hr = culler.CullPhaseTwo(i, mesh, params[i], result.Revealed[i]);
+        }
+        for (uint32_t i = 0; i < instanceCount && SUCCEEDED(hr); ++i)
+        {
+            hr = CullMeshlets(mesh, params[i], result.Frustum[i]);
+        }
+        return hr;
+    }
+
+    uint32_t CountMeshlets(const std::vector<VisibleMeshlets>& sets, uint32_t first, uint32_t end)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = first; i < end; ++i)
+        {
+            count += static_cast<uint32_t>(sets[i].Indices.size());
+        }
+        return count;
+    }
+}
+
+// Four small walls stand behind a large one. Once they have been hidden for a frame, phase one
+// skips them. When the large wall then leaves the frustum, phase two must re-test them against a
+// depth buffer without it and draw every meshlet each has in the frustum; the frame after, phase
+// one draws them instead.
+uint32_t Tests::TestTemporalOcclusionCuller(const std::wstring&)
+{
+    PositionMesh wall;
+    MeshletGeneratorOptions meshletOptions;
+    if (FAILED(BuildWall(0.0f, 0.0f, false, wall, &meshletOptions)))
+    {
+        return Check(false, "TemporalOcclusionCuller: failed to build the wall\n");
+    }
+
+    const XMVECTOR eye = XMVectorSet(0, 0, 4, 1);
+    const uint32_t hiddenFirst = 1;
+
+    std::vector<Placement> placements =
+    {
+        { 1.0f, XMFLOAT3(0.0f, 0.0f, 0.0f) },
+        { 0.2f, XMFLOAT3(-0.4f, -0.4f, -1.0f) },
+        { 0.2f, XMFLOAT3(0.4f, -0.4f, -1.0f) },
+        { 0.2f, XMFLOAT3(-0.4f, 0.4f, -1.0f) },
+        { 0.2f, XMFLOAT3(0.4f, 0.4f, -1.0f) },
+    };
+    const uint32_t instanceCount = static_cast<uint32_t>(placements.size());
+
+    TemporalOcclusionCuller culler;
+    FrameResult result;
+    uint32_t failures = 0;
+    uint32_t errors = 0;
+
+    // With no history, phase two draws everything in the frustum.
+    failures += FAILED(CullFrame(culler, wall.Mesh, placements, eye, result));
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < instanceCount; ++i)
+    {
+        mismatches += !result.Previous[i].Indices.empty() || !SameMeshlets(result.Revealed[i], result.Frustum[i]);
+    }
+    errors += Check(mismatches == 0, "TemporalOcclusionCuller: %u instances weren't drawn whole in phase two of the first frame\n", mismatches);
+
+    // The large wall hides the small ones from the second frame on, so by the third neither phase draws them.
+    for (uint32_t frame = 1; frame < 3; ++frame)
+    {
+        failures += FAILED(CullFrame(culler, wall.Mesh, placements, eye, result));
+    }
+
+    const uint32_t hiddenDrawn = CountMeshlets(result.Previous, hiddenFirst, instanceCount) + CountMeshlets(result.Revealed, hiddenFirst, instanceCount);
+    errors += Check(hiddenDrawn == 0, "TemporalOcclusionCuller: %u meshlets behind the wall are still drawn\n", hiddenDrawn);
+    errors += Check(!result.Previous[0].Indices.empty(), "TemporalOcclusionCuller: phase one doesn't draw the wall\n");
+
+    // Move the large wall out of the frustum.
+    placements[0].Offset = XMFLOAT3(0.0f, -4.0f, 0.0f);
+    failures += FAILED(CullFrame(culler, wall.Mesh, placements, eye, result));
+
+    mismatches = 0;
+    for (uint32_t i = hiddenFirst; i < instanceCount; ++i)
+    {
+        mismatches += !result.Previous[i].Indices.empty() || result.Frustum[i].Indices.empty() || !SameMeshlets(result.Revealed[i], result.Frustum[i]);
+    }
+    const uint32_t revealedCount = CountMeshlets(result.Revealed, 0, instanceCount);
+    const uint32_t expectedCount = CountMeshlets(result.Frustum, hiddenFirst, instanceCount);
+
+    errors += Check(result.Frustum[0].Indices.empty(), "TemporalOcclusionCuller: the wall is still in the frustum\n");
+    errors += Check(mismatches == 0, "TemporalOcclusionCuller: %u uncovered instances weren't drawn whole in phase two\n", mismatches);
+    errors += Check(culler.GetStats().RevealedCount == expectedCount && revealedCount == expectedCount,
+        "TemporalOcclusionCuller: %u meshlets revealed (%u counted), not %u\n", revealedCount, culler.GetStats().RevealedCount, expectedCount);
+
+    // Now visible last frame, they move to phase one.
+    failures += FAILED(CullFrame(culler, wall.Mesh, placements, eye, result));
+
+    mismatches = 0;
+    for (uint32_t i = hiddenFirst; i < instanceCount; ++i)
+    {
+        mismatches += !result.Revealed[i].Indices.empty() || !SameMeshlets(result.Previous[i], result.Frustum[i]);
+    }
+    errors += Check(mismatches == 0, "TemporalOcclusionCuller: %u uncovered instances weren't drawn whole in phase one the frame after\n", mismatches);
+
+    errors += Check(failures == 0, "TemporalOcclusionCuller: culling failed in %u frames\n", failures);
+    return errors;
+}
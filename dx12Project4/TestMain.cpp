@@ -0,0 +1,124 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+    struct TestCase
+    {
+        const char* Name;
+        uint32_t (*Run)(const std::wstring& assetDirectory);
+    };
+
+    const TestCase c_tests[] =
+    {
+        { "ThreadPool",              Tests::TestThreadPool },
+        { "LinearArena",             Tests::TestLinearArena },
+        { "UploadRing",              Tests::TestUploadRing },
+        { "GeometryHeap",            Tests::TestGeometryHeap },
+        { "SceneGeometryLayout",     Tests::TestSceneGeometryLayout },
+        { "DrawPackets",             Tests::TestDrawPackets },
+        { "RecordingChunks",         Tests::TestRecordingChunks },
+#if defined(_WIN32)
+        { "DispatchRuns",            Tests::TestDispatchRuns },
+        { "UploadBatch",             Tests::TestUploadBatch },
+        { "SceneGeometry",           Tests::TestSceneGeometry },
+        { "ParallelRecording",       Tests::TestParallelRecording },
+        { "Compression",             Tests::TestCompression },
+        { "Model",                   Tests::TestModel },
+        { "MeshletGenerator",        Tests::TestMeshletGenerator },
+        { "MeshletCuller",           Tests::TestMeshletCuller },
+        { "MeshSimplifier",          Tests::TestMeshSimplifier },
+        { "ClusterLod",              Tests::TestClusterLod },
+        { "SoftwareRasterizer",      Tests::TestSoftwareRasterizer },
+        { "OcclusionCuller",         Tests::TestOcclusionCuller },
+        { "TemporalOcclusionCuller", Tests::TestTemporalOcclusionCuller },
+        { "InstanceCuller",          Tests::TestInstanceCuller },
+#endif
+    };
+
+    void LogV(const char* format, va_list args)
+    {
+        char buffer[512];
+        vsnprintf(buffer, sizeof(buffer), format, args);
+
+#if defined(_WIN32)
+        OutputDebugStringA(buffer);
+#endif
+        fputs(buffer, stdout);
+    }
+}
+
+void Tests::Log(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    LogV(format, args);
+    va_end(args);
+}
+
+uint32_t Tests::Check(bool condition, const char* format, ...)
+{
+    if (condition)
+    {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, format);
+    LogV(format, args);
+    va_end(args);
+
+    return 1;
+}
+
+namespace
+{
+    int RunTests(const std::wstring& assetDirectory)
+    {
+        uint32_t failures = 0;
+        for (auto& test : c_tests)
+        {
+            const uint32_t testFailures = test.Run(assetDirectory);
+            Tests::Log("%-24s %s (%u failures)\n", test.Name, testFailures == 0 ? "passed" : "FAILED", testFailures);
+            failures += testFailures;
+        }
+
+        Tests::Log("%u failures\n", failures);
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+// Runs every test and returns 1 if any check failed. The asset directory defaults to the one next
+// to the executable, as for "-benchmark".
+#if defined(_WIN32)
+int wmain(int argc, wchar_t** argv)
+{
+    return RunTests(argc > 1 ? std::wstring(argv[1]) + L"\\" : L"Assets\\");
+}
+#else
+int main(int argc, char** argv)
+{
+    // Asset paths are ASCII, so widening each char is enough.
+    return RunTests(argc > 1 ? std::wstring(argv[1], argv[1] + strlen(argv[1])) + L"/" : L"Assets/");
+}
+#endif
@@ -0,0 +1,191 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "MeshletGenerator.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// A position-only mesh with 32-bit indices, for tests that build their geometry by hand. The
+// mesh's spans point into the other members, so it is neither copied nor moved.
+struct PositionMesh
+{
+    PositionMesh() = default;
+    PositionMesh(const PositionMesh&) = delete;
+    PositionMesh& operator=(const PositionMesh&) = delete;
+
+    std::vector<DirectX::XMFLOAT3> Positions;
+    std::vector<uint32_t>          Indices;
+    Subset                         IndexSubset = {};
+    MeshletData                    Meshlets;
+    Mesh                           Mesh;
+};
+
+// Points out.Mesh at out.Positions and out.Indices as a single index subset and computes its bounds,
+// and with meshletOptions generates and attaches meshlets too.
+inline HRESULT BuildPositionMesh(PositionMesh& out, const MeshletGeneratorOptions* meshletOptions = nullptr)
+{
+    out.IndexSubset = Subset{ 0, static_cast<uint32_t>(out.Indices.size()) };
+
+    Mesh& mesh = out.Mesh;
+    mesh.LayoutElems[0] = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+    mesh.LayoutDesc.pInputElementDescs = mesh.LayoutElems;
+    mesh.LayoutDesc.NumElements = 1;
+    mesh.Vertices.assign(1, MakeSpan(reinterpret_cast<const uint8_t*>(out.Positions.data()), static_cast<uint32_t>(out.Positions.size() * sizeof(DirectX::XMFLOAT3))));
+    mesh.VertexStrides.assign(1, sizeof(DirectX::XMFLOAT3));
+    mesh.VertexCount = static_cast<uint32_t>(out.Positions.size());
+    mesh.IndexSize = sizeof(uint32_t);
+    mesh.Indices = MakeSpan(reinterpret_cast<const uint8_t*>(out.Indices.data()), static_cast<uint32_t>(out.Indices.size() * sizeof(uint32_t)));
+    mesh.IndexCount = static_cast<uint32_t>(out.Indices.size());
+    mesh.IndexSubsets = MakeSpan(&out.IndexSubset, 1);
+
+    DirectX::BoundingSphere::CreateFromPoints(mesh.BoundingSphere, mesh.VertexCount, out.Positions.data(), sizeof(DirectX::XMFLOAT3));
+    DirectX::BoundingBox::CreateFromPoints(mesh.BoundingBox, mesh.VertexCount, out.Positions.data(), sizeof(DirectX::XMFLOAT3));
+
+    if (meshletOptions == nullptr)
+    {
+        return S_OK;
+    }
+
+    const HRESULT hr = GenerateMeshlets(mesh, out.Meshlets, *meshletOptions);
+    if (SUCCEEDED(hr))
+    {
+        out.Meshlets.AttachTo(mesh);
+    }
+    return hr;
+}
+
+// Whether any triangle of the meshlet faces the object-space position by more than rounding can
+// account for. Front faces are clockwise.
+inline bool MeshletFacesPosition(const Mesh& mesh, uint32_t meshletIndex, const DirectX::XMFLOAT3& position)
+{
+    using namespace DirectX;
+
+    const PositionStream positions = mesh.GetPositions();
+    const Meshlet& meshlet = mesh.Meshlets[meshletIndex];
+    const XMVECTOR eye = XMLoadFloat3(&position);
+
+    for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+    {
+        uint32_t i0, i1, i2;
+        mesh.GetPrimitive(meshlet.PrimOffset + p, i0, i1, i2);
+
+        const XMVECTOR a = XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + i0)]);
+        const XMVECTOR b = XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + i1)]);
+        const XMVECTOR c = XMLoadFloat3(&positions[mesh.GetVertexIndex(meshlet.VertOffset + i2)]);
+
+        const XMVECTOR normal = XMVector3Cross(XMVectorSubtract(c, a), XMVectorSubtract(b, a));
+        const XMVECTOR toEye = XMVectorSubtract(eye, a);
+
+        const float facing = XMVectorGetX(XMVector3Dot(normal, toEye));
+        if (facing > 1e-4f * XMVectorGetX(XMVector3Length(normal)) * XMVectorGetX(XMVector3Length(toEye)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Byte comparisons of meshes and their parts.
+inline bool SameBytes(const void* a, const void* b, size_t size)
+{
+    return size == 0 || std::memcmp(a, b, size) == 0;
+}
+
+template <typename T>
+inline bool SameSpan(const Span<T>& a, const Span<T>& b)
+{
+    return a.size() == b.size() && SameBytes(a.data(), b.data(), a.size() * sizeof(T));
+}
+
+inline bool SameLayout(const Mesh& a, const Mesh& b)
+{
+    bool same = a.LayoutDesc.NumElements == b.LayoutDesc.NumElements;
+    for (uint32_t i = 0; same && i < a.LayoutDesc.NumElements; ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& x = a.LayoutElems[i];
+        const D3D12_INPUT_ELEMENT_DESC& y = b.LayoutElems[i];
+        same = std::strcmp(x.SemanticName, y.SemanticName) == 0 && x.SemanticIndex == y.SemanticIndex && x.Format == y.Format
+            && x.InputSlot == y.InputSlot && x.AlignedByteOffset == y.AlignedByteOffset;
+    }
+    return same;
+}
+
+inline bool SameBounds(const Mesh& a, const Mesh& b)
+{
+    return SameBytes(&a.BoundingSphere, &b.BoundingSphere, sizeof(DirectX::BoundingSphere)) && SameBytes(&a.BoundingBox, &b.BoundingBox, sizeof(DirectX::BoundingBox))
+        && a.SubsetBoundingSpheres.size() == b.SubsetBoundingSpheres.size() && a.SubsetBoundingBoxes.size() == b.SubsetBoundingBoxes.size()
+        && SameBytes(a.SubsetBoundingSpheres.data(), b.SubsetBoundingSpheres.data(), a.SubsetBoundingSpheres.size() * sizeof(DirectX::BoundingSphere))
+        && SameBytes(a.SubsetBoundingBoxes.data(), b.SubsetBoundingBoxes.data(), a.SubsetBoundingBoxes.size() * sizeof(DirectX::BoundingBox));
+}
+
+// Whether two meshes hold the same bytes in every span, the same layout and the same bounds,
+// wherever their storage lives.
+inline bool SameMesh(const Mesh& a, const Mesh& b)
+{
+    bool same = a.Vertices.size() == b.Vertices.size() && a.VertexStrides == b.VertexStrides && a.VertexCount == b.VertexCount
+        && a.IndexSize == b.IndexSize && a.IndexCount == b.IndexCount && SameLayout(a, b) && SameBounds(a, b);
+    for (uint32_t i = 0; same && i < a.Vertices.size(); ++i)
+    {
+        same = SameSpan(a.Vertices[i], b.Vertices[i]);
+    }
+
+    return same && SameSpan(a.IndexSubsets, b.IndexSubsets) && SameSpan(a.Indices, b.Indices)
+        && SameSpan(a.MeshletSubsets, b.MeshletSubsets) && SameSpan(a.Meshlets, b.Meshlets)
+        && SameSpan(a.UniqueVertexIndices, b.UniqueVertexIndices) && SameSpan(a.PrimitiveIndices, b.PrimitiveIndices)
+        && SameSpan(a.CullingData, b.CullingData);
+}
+
+// Quads per side of the walls BuildWall makes.
+const uint32_t c_wallQuads = 32;
+
+// A wall of c_wallQuads x c_wallQuads quads over [-1, 1] in x and y, facing +z, with its surface at
+// z = depth * sin(ridges * pi * x). With notch, the quads above y = 0.5 within 0.125 of x = 0 are
+// left out, cutting a notch into the top of its silhouette.
+inline HRESULT BuildWall(float depth, float ridges, bool notch, PositionMesh& wall, const MeshletGeneratorOptions* meshletOptions = nullptr)
+{
+    const float step = 2.0f / c_wallQuads;
+
+    wall.Positions.clear();
+    for (uint32_t j = 0; j <= c_wallQuads; ++j)
+    {
+        for (uint32_t i = 0; i <= c_wallQuads; ++i)
+        {
+            const float x = -1.0f + i * step;
+            wall.Positions.push_back(DirectX::XMFLOAT3(x, -1.0f + j * step, depth * sinf(ridges * DirectX::XM_PI * x)));
+        }
+    }
+
+    // Clockwise seen from +z.
+    wall.Indices.clear();
+    for (uint32_t j = 0; j < c_wallQuads; ++j)
+    {
+        for (uint32_t i = 0; i < c_wallQuads; ++i)
+        {
+            const float centerX = -1.0f + (i + 0.5f) * step;
+            const float centerY = -1.0f + (j + 0.5f) * step;
+            if (notch && fabsf(centerX) < 0.125f && centerY > 0.5f)
+                continue;
+
+            const uint32_t v00 = j * (c_wallQuads + 1) + i;
+            const uint32_t v10 = v00 + 1;
+            const uint32_t v01 = v00 + c_wallQuads + 1;
+            const uint32_t v11 = v01 + 1;
+
+            const uint32_t quad[] = { v01, v11, v10, v01, v10, v00 };
+            wall.Indices.insert(wall.Indices.end(), quad, quad + 6);
+        }
+    }
+
+    return BuildPositionMesh(wall, meshletOptions);
+}
@@ -0,0 +1,56 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "BundledAssets.h"
+
+#include <cstdint>
+#include <string>
+
+// Behavioural checks of the sample's CPU code, built into the DX12PracticeTests console app (see
+// dx12Project4Tests.vcxproj) and run as "DX12PracticeTests [assetDirectory]". Each test drives the
+// production code itself, without a window or device, and returns how many of its checks failed;
+// the timings stay in Benchmarks.cpp.
+//
+// Tests of code which doesn't include stdafx.h also build without the Windows SDK, through
+// CMakeLists.txt; the rest are only registered on Windows.
+namespace Tests
+{
+    // Writes to stdout and the debugger output window.
+    void Log(const char* format, ...);
+
+    // Returns 0 if condition holds; otherwise logs the formatted message, as Log does, and returns 1.
+    uint32_t Check(bool condition, const char* format, ...);
+
+    uint32_t TestThreadPool(const std::wstring& assetDirectory);
+    uint32_t TestLinearArena(const std::wstring& assetDirectory);
+    uint32_t TestUploadRing(const std::wstring& assetDirectory);
+    uint32_t TestGeometryHeap(const std::wstring& assetDirectory);
+    uint32_t TestSceneGeometryLayout(const std::wstring& assetDirectory);
+    uint32_t TestDrawPackets(const std::wstring& assetDirectory);
+    uint32_t TestRecordingChunks(const std::wstring& assetDirectory);
+
+    // Windows only
+    uint32_t TestDispatchRuns(const std::wstring& assetDirectory);
+    uint32_t TestUploadBatch(const std::wstring& assetDirectory);
+    uint32_t TestSceneGeometry(const std::wstring& assetDirectory);
+    uint32_t TestParallelRecording(const std::wstring& assetDirectory);
+    uint32_t TestCompression(const std::wstring& assetDirectory);
+    uint32_t TestModel(const std::wstring& assetDirectory);
+    uint32_t TestMeshletGenerator(const std::wstring& assetDirectory);
+    uint32_t TestMeshletCuller(const std::wstring& assetDirectory);
+    uint32_t TestMeshSimplifier(const std::wstring& assetDirectory);
+    uint32_t TestClusterLod(const std::wstring& assetDirectory);
+    uint32_t TestSoftwareRasterizer(const std::wstring& assetDirectory);
+    uint32_t TestOcclusionCuller(const std::wstring& assetDirectory);
+    uint32_t TestTemporalOcclusionCuller(const std::wstring& assetDirectory);
+    uint32_t TestInstanceCuller(const std::wstring& assetDirectory);
+}
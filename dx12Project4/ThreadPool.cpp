@@ -0,0 +1,432 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    // The pool and deque of the worker running on this thread, if any.
+    struct WorkerContext
+    {
+        const ThreadPool* Pool;
+        uint32_t          Index;
+    };
+
+    thread_local WorkerContext t_worker = { nullptr, 0 };
+}
+
+// Shared between the caller of ParallelFor and the helpers it queued, and returned to the pool by
+// whichever lets go last: a helper may only start after every index has been claimed and the caller
+// has returned.
+struct ThreadPool::ParallelForState
+{
+    IndexFunction           Func;
+    const void*             Context;
+    uint32_t                Count;
+    std::atomic<uint32_t>   NextIndex;
+    std::atomic<uint32_t>   Completed;
+    std::atomic<uint32_t>   References;
+    std::mutex              Mutex;
+    std::condition_variable Done;
+
+    void Run()
+    {
+        for (uint32_t i = NextIndex++; i < Count; i = NextIndex++)
+        {
+            Func(Context, i);
+
+            if (++Completed == Count)
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Done.notify_all();
+            }
+        }
+    }
+};
+
+struct ThreadPool::Task
+{
+    std::function<void()>   Func;
+    std::atomic<uint32_t>   Pending;        // Unfinished dependencies, plus one until Schedule has seen them all
+    std::atomic<bool>       Done;
+
+    std::mutex              Mutex;          // Guards Finished and Continuations
+    bool                    Finished;
+    std::vector<TaskHandle> Continuations;  // Tasks waiting on this one
+};
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_nextWorker(0)
+    , m_queuedCount(0)
+    , m_waiterCount(0)
+    , m_exit(false)
+    , m_queuedHelpers(0)
+{
+    if (threadCount == 0)
+    {
+        const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    // Every deque exists before any worker starts looking for work to steal.
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    // Outside nested loops, ParallelFor states are held by their callers, by queued helpers (no more
+    // than there are workers) and by running ones (one per worker). Creating that many now means how
+    // late the workers run never decides whether a ParallelFor from one thread touches the heap.
+    const uint32_t stateCount = 2 * threadCount + 1;
+    m_parallelForStates.reserve(stateCount);
+    m_freeParallelForStates.reserve(stateCount);
+    for (uint32_t i = 0; i < stateCount; ++i)
+    {
+        m_parallelForStates.push_back(std::make_unique<ParallelForState>());
+        m_freeParallelForStates.push_back(m_parallelForStates.back().get());
+    }
+
+    m_threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::WorkerMain, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    Push(std::move(task));
+}
+
+ThreadPool::TaskHandle ThreadPool::Schedule(std::function<void()> func, std::initializer_list<TaskHandle> dependencies)
+{
+    return Schedule(std::move(func), dependencies.begin(), dependencies.end());
+}
+
+ThreadPool::TaskHandle ThreadPool::Schedule(std::function<void()> func, const std::vector<TaskHandle>& dependencies)
+{
+    return Schedule(std::move(func), dependencies.begin(), dependencies.end());
+}
+
+template <typename Iterator>
+ThreadPool::TaskHandle ThreadPool::Schedule(std::function<void()> func, Iterator first, Iterator last)
+{
+    auto task = std::make_shared<Task>();
+    task->Func = std::move(func);
+    task->Pending = 1;
+    task->Done = false;
+    task->Finished = false;
+
+    for (Iterator it = first; it != last; ++it)
+    {
+        const TaskHandle& dependency = *it;
+        if (!dependency)
+        {
+            continue;
+        }
+
+        // Count the dependency before it can finish and release it.
+        std::lock_guard<std::mutex> lock(dependency->Mutex);
+        if (!dependency->Finished)
+        {
+            dependency->Continuations.push_back(task);
+            task->Pending++;
+        }
+    }
+
+    Release(task);
+    return task;
+}
+
+void ThreadPool::Wait(const TaskHandle& task)
+{
+    while (!task->Done.load())
+    {
+        if (RunOne())
+        {
+            continue;
+        }
+
+        // Nothing to help with: sleep until a task is queued or this one finishes. Run announces
+        // completion to sleeping waiters, so raising the count before the check can't miss it.
+        m_waiterCount++;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, &task]() { return task->Done.load() || m_queuedCount.load() > 0; });
+        }
+        m_waiterCount--;
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, IndexFunction func, const void* context)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // One helper per worker (or per remaining item), less the helpers of earlier calls still waiting
+    // for a worker; the calling thread takes the rest.
+    const uint32_t threadCount = GetThreadCount();
+    const uint32_t helperCount = std::min(threadCount - std::min(m_queuedHelpers.load(), threadCount), count - 1);
+
+    if (helperCount == 0)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            func(context, i);
+        }
+        return;
+    }
+
+    ParallelForState* state = AcquireParallelForState();
+    state->Func = func;
+    state->Context = context;
+    state->Count = count;
+    state->NextIndex = 0;
+    state->Completed = 0;
+    state->References = helperCount + 1;
+
+    m_queuedHelpers += helperCount;
+    for (uint32_t i = 0; i < helperCount; ++i)
+    {
+        Submit([this, state]()
+        {
+            m_queuedHelpers--;
+            state->Run();
+            ReleaseParallelForState(state);
+        });
+    }
+
+    state->Run();
+
+    // Only indices other threads have claimed, and are running, are left to wait for. Running other
+    // tasks here instead could block on one further down this thread's stack.
+    if (state->Completed.load() != count)
+    {
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->Done.wait(lock, [state, count]() { return state->Completed.load() == count; });
+    }
+
+    ReleaseParallelForState(state);
+}
+
+ThreadPool::ParallelForState* ThreadPool::AcquireParallelForState()
+{
+    std::lock_guard<std::mutex> lock(m_parallelForMutex);
+
+    if (m_freeParallelForStates.empty())
+    {
+        m_parallelForStates.push_back(std::make_unique<ParallelForState>());
+        m_freeParallelForStates.reserve(m_parallelForStates.size());
+        return m_parallelForStates.back().get();
+    }
+
+    ParallelForState* state = m_freeParallelForStates.back();
+    m_freeParallelForStates.pop_back();
+    return state;
+}
+
+void ThreadPool::ReleaseParallelForState(ParallelForState* state)
+{
+    if (--state->References == 0)
+    {
+        // Room for every state was reserved when it was created.
+        std::lock_guard<std::mutex> lock(m_parallelForMutex);
+        m_freeParallelForStates.push_back(state);
+    }
+}
+
+ThreadPool& ThreadPool::GetDefault()
+{
+    static ThreadPool s_pool;
+    return s_pool;
+}
+
+void ThreadPool::WorkerMain(uint32_t index)
+{
+    t_worker.Pool = this;
+    t_worker.Index = index;
+
+    for (;;)
+    {
+        if (RunOne())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_exit || m_queuedCount.load() > 0; });
+
+        if (m_exit && m_queuedCount.load() <= 0)
+        {
+            return; // Exit requested and the deques have drained.
+        }
+    }
+}
+
+uint32_t ThreadPool::GetCurrentWorker() const
+{
+    return t_worker.Pool == this ? t_worker.Index : UINT32_MAX;
+}
+
+void ThreadPool::Push(std::function<void()> task)
+{
+    uint32_t index = GetCurrentWorker();
+    if (index == UINT32_MAX)
+    {
+        index = m_nextWorker++ % GetThreadCount();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->Mutex);
+        m_workers[index]->PushBack(std::move(task));
+    }
+    m_queuedCount++;
+
+    // Sleepers check the count under m_mutex, so taking it here means none can miss the task.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_wake.notify_one();
+}
+
+// Runs one task: the newest from this thread's own deque, else the oldest from another's.
+bool ThreadPool::RunOne()
+{
+    const uint32_t workerCount = GetThreadCount();
+    const uint32_t self = GetCurrentWorker();
+
+    std::function<void()> task;
+
+    if (self != UINT32_MAX)
+    {
+        Worker& worker = *m_workers[self];
+        std::lock_guard<std::mutex> lock(worker.Mutex);
+
+        worker.PopBack(task);
+    }
+
+    const uint32_t start = self != UINT32_MAX ? self + 1 : 0;
+    for (uint32_t i = 0; !task && i < workerCount; ++i)
+    {
+        Worker& victim = *m_workers[(start + i) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.Mutex);
+
+        victim.PopFront(task);
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+
+    m_queuedCount--;
+    task();
+    return true;
+}
+
+void ThreadPool::Release(const TaskHandle& task)
+{
+    if (--task->Pending == 0)
+    {
+        Push([this, task]() { Run(task); });
+    }
+}
+
+void ThreadPool::Run(const TaskHandle& task)
+{
+    task->Func();
+    task->Func = nullptr;
+
+    std::vector<TaskHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(task->Mutex);
+        task->Finished = true;
+        continuations.swap(task->Continuations);
+    }
+
+    task->Done = true;
+    if (m_waiterCount.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_wake.notify_all();
+    }
+
+    for (auto& continuation : continuations)
+    {
+        Release(continuation);
+    }
+}
+
+void ThreadPool::Worker::PushBack(std::function<void()> task)
+{
+    if (Count == Tasks.size())
+    {
+        // Unroll the ring into a buffer twice the size.
+        std::vector<std::function<void()>> grown(std::max(Tasks.size() * 2, size_t(16)));
+        for (size_t i = 0; i < Count; ++i)
+        {
+            grown[i] = std::move(Tasks[(Front + i) & (Tasks.size() - 1)]);
+        }
+
+        Tasks.swap(grown);
+        Front = 0;
+    }
+
+    Tasks[(Front + Count) & (Tasks.size() - 1)] = std::move(task);
+    Count++;
+}
+
+bool ThreadPool::Worker::PopBack(std::function<void()>& task)
+{
+    if (Count == 0)
+    {
+        return false;
+    }
+
+    Count--;
+    task = std::move(Tasks[(Front + Count) & (Tasks.size() - 1)]);
+    Tasks[(Front + Count) & (Tasks.size() - 1)] = nullptr;
+    return true;
+}
+
+bool ThreadPool::Worker::PopFront(std::function<void()>& task)
+{
+    if (Count == 0)
+    {
+        return false;
+    }
+
+    task = std::move(Tasks[Front]);
+    Tasks[Front] = nullptr;
+    Front = (Front + 1) & (Tasks.size() - 1);
+    Count--;
+    return true;
+}
@@ -0,0 +1,123 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own deque of tasks. A worker pushes the tasks it
+// submits onto its own deque and pops them newest first, so nested work stays on the thread whose
+// caches hold its data; a worker that runs dry steals the oldest task of another. Tasks submitted
+// from other threads are dealt out round robin.
+class ThreadPool
+{
+public:
+    struct Task;
+    using TaskHandle = std::shared_ptr<Task>;
+
+    // A thread count of zero uses one worker per hardware thread (minus the calling thread).
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    // Queues a task to run on a worker thread.
+    void Submit(std::function<void()> task);
+
+    // Queues func to run once every task in dependencies has finished, and returns a handle that
+    // later tasks can depend on. A continuation is a task scheduled on its predecessor; it is queued
+    // by the thread that finishes the last of its dependencies, on that thread's deque. Null
+    // dependencies are ignored.
+    TaskHandle Schedule(std::function<void()> func, std::initializer_list<TaskHandle> dependencies = {});
+    TaskHandle Schedule(std::function<void()> func, const std::vector<TaskHandle>& dependencies);
+
+    // Runs queued tasks on the calling thread until task has finished, so this is safe to call from
+    // inside a pool task.
+    void Wait(const TaskHandle& task);
+
+    // Invokes func(i) for every i in [0, count) and returns once all calls have completed.
+    // The calling thread participates, so this is safe to call from inside a pool task. Once the
+    // deques have grown to the load, this doesn't touch the heap.
+    template <typename Func>
+    void ParallelFor(uint32_t count, const Func& func)
+    {
+        ParallelFor(count, &InvokeIndex<Func>, &func);
+    }
+
+    // Process-wide pool shared by the loaders.
+    static ThreadPool& GetDefault();
+
+private:
+    using IndexFunction = void (*)(const void* context, uint32_t index);
+
+    template <typename Func>
+    static void InvokeIndex(const void* context, uint32_t index)
+    {
+        (*static_cast<const Func*>(context))(index);
+    }
+
+    // Ring buffer of tasks: the owner pushes and pops at the back, thieves take from the front. Its
+    // capacity is a power of two and only grows.
+    struct Worker
+    {
+        std::vector<std::function<void()>> Tasks;
+        size_t                             Front = 0;
+        size_t                             Count = 0;
+        std::mutex                         Mutex;
+
+        void PushBack(std::function<void()> task);
+        bool PopBack(std::function<void()>& task);
+        bool PopFront(std::function<void()>& task);
+    };
+
+    struct ParallelForState;
+
+    void ParallelFor(uint32_t count, IndexFunction func, const void* context);
+    ParallelForState* AcquireParallelForState();
+    void ReleaseParallelForState(ParallelForState* state);
+
+    template <typename Iterator>
+    TaskHandle Schedule(std::function<void()> func, Iterator first, Iterator last);
+
+    void WorkerMain(uint32_t index);
+    uint32_t GetCurrentWorker() const;
+    void Push(std::function<void()> task);
+    bool RunOne();
+    void Release(const TaskHandle& task);
+    void Run(const TaskHandle& task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread>             m_threads;
+    std::atomic<uint32_t>                m_nextWorker;      // Round robin for tasks from other threads
+    std::atomic<int32_t>                 m_queuedCount;     // May dip below zero while a push completes
+    std::atomic<uint32_t>                m_waiterCount;     // Threads asleep in Wait
+    std::mutex                           m_mutex;
+    std::condition_variable              m_wake;
+    bool                                 m_exit;
+
+    // ParallelFor states are recycled, and those un-nested loops need are created up front, so a pool
+    // that has seen its deepest nesting stops allocating them.
+    std::vector<std::unique_ptr<ParallelForState>> m_parallelForStates;
+    std::vector<ParallelForState*>                 m_freeParallelForStates;
+    std::mutex                                     m_parallelForMutex;
+    std::atomic<uint32_t>                          m_queuedHelpers;     // ParallelFor helpers not yet started
+};
@@ -0,0 +1,144 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cmath>
+
+using namespace Tests;
+
+namespace
+{
+    // Sums a tree of tasks: leafCount leaves each sum a slice of values, and every inner node adds
+    // its two children once both have finished. The additions happen in the same order whichever
+    // threads run them, so every pool gets the same bits.
+    double SumTaskTree(ThreadPool& pool, const std::vector<float>& values, uint32_t leafCount)
+    {
+        std::vector<double> sums(2 * leafCount);
+        std::vector<ThreadPool::TaskHandle> tasks(2 * leafCount);
+
+        const size_t sliceSize = values.size() / leafCount;
+        for (uint32_t i = 0; i < leafCount; ++i)
+        {
+            tasks[leafCount + i] = pool.Schedule([&, i]()
+            {
+                double sum = 0.0;
+                for (size_t k = i * sliceSize; k < (i + 1) * sliceSize; ++k)
+                {
+                    sum += sqrt(values[k]);
+                }
+                sums[leafCount + i] = sum;
+            });
+        }
+
+        for (uint32_t i = leafCount - 1; i > 0; --i)
+        {
+            tasks[i] = pool.Schedule([&sums, i]() { sums[i] = sums[2 * i] + sums[2 * i + 1]; }, { tasks[2 * i], tasks[2 * i + 1] });
+        }
+
+        pool.Wait(tasks[1]);
+        return sums[1];
+    }
+
+    uint32_t CheckParallelFor(ThreadPool& pool)
+    {
+        const uint32_t c_count = 1000;
+
+        std::vector<std::atomic<uint32_t>> calls(c_count);
+        for (auto& count : calls)
+        {
+            count = 0;
+        }
+        pool.ParallelFor(c_count, [&calls](uint32_t i) { calls[i]++; });
+
+        uint32_t errors = 0;
+        for (uint32_t i = 0; i < c_count; ++i)
+        {
+            errors += Check(calls[i] == 1, "ParallelFor: index %u ran %u times\n", i, calls[i].load());
+        }
+
+        // Nested loops run on the caller too, so they can't deadlock however few workers there are.
+        std::atomic<uint32_t> nested(0);
+        pool.ParallelFor(16, [&pool, &nested](uint32_t) { pool.ParallelFor(16, [&nested](uint32_t) { nested++; }); });
+        errors += Check(nested == 256, "ParallelFor: nested loops ran %u of 256 calls\n", nested.load());
+
+        pool.ParallelFor(0, [&errors](uint32_t) { errors++; });
+        return errors;
+    }
+
+    uint32_t CheckDependencies(ThreadPool& pool)
+    {
+        const uint32_t c_dependencyCount = 64;
+
+        std::atomic<uint32_t> finished(0);
+        std::vector<ThreadPool::TaskHandle> dependencies;
+        for (uint32_t i = 0; i < c_dependencyCount; ++i)
+        {
+            dependencies.push_back(pool.Schedule([&finished]() { finished++; }));
+        }
+        dependencies.push_back(nullptr);
+
+        uint32_t seen = 0;
+        ThreadPool::TaskHandle continuation = pool.Schedule([&finished, &seen]() { seen = finished; }, dependencies);
+        pool.Wait(continuation);
+
+        uint32_t errors = Check(seen == c_dependencyCount, "Schedule: continuation ran after %u of %u dependencies\n", seen, c_dependencyCount);
+
+        // A task which waits for another runs queued tasks meanwhile, so it can't starve the pool.
+        uint32_t waited = 0;
+        ThreadPool::TaskHandle inner = pool.Schedule([]() { });
+        ThreadPool::TaskHandle outer = pool.Schedule([&pool, &inner, &waited]()
+        {
+            ThreadPool::TaskHandle late = pool.Schedule([&waited]() { waited = 1; }, { inner });
+            pool.Wait(late);
+        });
+        pool.Wait(outer);
+
+        errors += Check(waited == 1, "Wait: a task waiting inside a task returned early\n");
+        return errors;
+    }
+}
+
+uint32_t Tests::TestThreadPool(const std::wstring&)
+{
+    const uint32_t c_leafCount = 1024;
+    const uint32_t c_workerCounts[] = { 1, 3, 8 };
+
+    std::vector<float> values(c_leafCount * 64);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = float(i % 1000);
+    }
+
+    uint32_t errors = 0;
+    double expectedSum = 0.0;
+
+    for (uint32_t workerCount : c_workerCounts)
+    {
+        ThreadPool pool(workerCount);
+
+        errors += CheckParallelFor(pool);
+        errors += CheckDependencies(pool);
+
+        for (uint32_t n = 0; n < 10; ++n)
+        {
+            const double sum = SumTaskTree(pool, values, c_leafCount);
+            if (workerCount == c_workerCounts[0] && n == 0)
+            {
+                expectedSum = sum;
+            }
+            errors += Check(sum == expectedSum, "Schedule: task tree summed %.17g on %u workers, %.17g on one\n", sum, workerCount, expectedSum);
+        }
+    }
+
+    return errors;
+}
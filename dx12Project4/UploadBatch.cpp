@@ -0,0 +1,203 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "UploadBatch.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    const uint64_t c_stagingAlignment = 16;
+}
+
+UploadBatch::UploadBatch(UploadQueue& queue)
+    : m_queue(queue)
+    , m_recording(false)
+    , m_lastToken(0)
+    , m_stagedCount(0)
+{ }
+
+UploadBatch::~UploadBatch()
+{
+    // Whatever was staged but never submitted would leave the list open.
+    assert(!m_recording);
+}
+
+HRESULT UploadBatch::Stage(ID3D12Resource* dest, const void* data, uint64_t size, D3D12_RESOURCE_STATES stateAfter)
+{
+    return Stage(dest, 0, data, size, stateAfter);
+}
+
+HRESULT UploadBatch::Stage(ID3D12Resource* dest, uint64_t destOffset, const void* data, uint64_t size, D3D12_RESOURCE_STATES stateAfter)
+{
+    if (!m_recording)
+    {
+        HRESULT hr = m_queue.Begin();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        m_recording = true;
+    }
+
+    // Pieces of up to a quarter of the staging keep a buffer larger than it streaming through.
+    const uint64_t maxChunk = max(m_queue.GetStagingCapacity() / 4, c_stagingAlignment);
+
+    for (uint64_t offset = 0; offset < size; )
+    {
+        const uint64_t chunk = min(size - offset, maxChunk);
+
+        UploadAllocation allocation;
+        HRESULT hr = m_queue.AllocateStaging(chunk, c_stagingAlignment, allocation);
+        if (hr == E_PENDING)
+        {
+            // The staging is full of this batch's copies: execute them to free it.
+            m_recording = false;
+            hr = m_queue.Execute(m_lastToken);
+            if (SUCCEEDED(hr))
+            {
+                hr = m_queue.Begin();
+                m_recording = SUCCEEDED(hr);
+            }
+            if (SUCCEEDED(hr))
+            {
+                hr = m_queue.AllocateStaging(chunk, c_stagingAlignment, allocation);
+            }
+        }
+        if (FAILED(hr))
+        {
+            Abandon();
+            return hr;
+        }
+
+        std::memcpy(allocation.CpuAddress, static_cast<const uint8_t*>(data) + offset, chunk);
+        m_queue.CopyBufferRegion(dest, destOffset + offset, allocation, chunk);
+        offset += chunk;
+    }
+
+    if (stateAfter != D3D12_RESOURCE_STATE_COMMON)
+    {
+        m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(dest, D3D12_RESOURCE_STATE_COPY_DEST, stateAfter));
+    }
+    m_stagedCount++;
+    return S_OK;
+}
+
+HRESULT UploadBatch::Submit(UploadToken& token)
+{
+    if (!m_recording)
+    {
+        token = m_lastToken;
+        return S_OK;
+    }
+
+    if (!m_barriers.empty())
+    {
+        m_queue.ResourceBarrier(static_cast<uint32_t>(m_barriers.size()), m_barriers.data());
+        m_barriers.clear();
+    }
+
+    m_recording = false;
+    m_stagedCount = 0;
+
+    HRESULT hr = m_queue.Execute(m_lastToken);
+    token = m_lastToken;
+    return hr;
+}
+
+void UploadBatch::Abandon()
+{
+    if (m_recording)
+    {
+        m_queue.Abandon();
+        m_recording = false;
+    }
+
+    m_barriers.clear();
+    m_stagedCount = 0;
+}
+
+HRESULT UploadBatch::SubmitAndWait()
+{
+    UploadToken token;
+    HRESULT hr = Submit(token);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return m_queue.Wait(token);
+}
+
+D3D12UploadQueue::D3D12UploadQueue(ID3D12CommandQueue* cmdQueue, ID3D12CommandAllocator* cmdAlloc, ID3D12GraphicsCommandList* cmdList, UploadRing& uploadRing)
+    : m_cmdQueue(cmdQueue)
+    , m_cmdAlloc(cmdAlloc)
+    , m_cmdList(cmdList)
+    , m_uploadRing(uploadRing)
+{ }
+
+uint64_t D3D12UploadQueue::GetStagingCapacity()
+{
+    return m_uploadRing.GetCapacity();
+}
+
+HRESULT D3D12UploadQueue::AllocateStaging(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+{
+    return m_uploadRing.Allocate(size, alignment, allocation);
+}
+
+HRESULT D3D12UploadQueue::Begin()
+{
+    return m_cmdList->Reset(m_cmdAlloc, nullptr);
+}
+
+void D3D12UploadQueue::CopyBufferRegion(ID3D12Resource* dest, uint64_t destOffset, const UploadAllocation& source, uint64_t size)
+{
+    m_cmdList->CopyBufferRegion(dest, destOffset, source.Resource, source.Offset, size);
+}
+
+void D3D12UploadQueue::ResourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers)
+{
+    m_cmdList->ResourceBarrier(count, barriers);
+}
+
+HRESULT D3D12UploadQueue::Execute(UploadToken& token)
+{
+    HRESULT hr = m_cmdList->Close();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ID3D12CommandList* ppCommandLists[] = { m_cmdList };
+    m_cmdQueue->ExecuteCommandLists(1, ppCommandLists);
+
+    hr = m_uploadRing.Submit(m_cmdQueue);
+    token = m_uploadRing.GetSubmittedFence();
+    return hr;
+}
+
+void D3D12UploadQueue::Abandon()
+{
+    // The next Begin resets the list; its staging is retired with the ring's next submit.
+    m_cmdList->Close();
+}
+
+bool D3D12UploadQueue::IsComplete(UploadToken token)
+{
+    return m_uploadRing.IsComplete(token);
+}
+
+HRESULT D3D12UploadQueue::Wait(UploadToken token)
+{
+    return m_uploadRing.Wait(token);
+}
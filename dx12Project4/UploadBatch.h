@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "UploadRing.h"
+
+#include <cstdint>
+#include <vector>
+
+// Fence value signalled once a submitted batch has run.
+using UploadToken = uint64_t;
+
+// What an UploadBatch needs from the GPU: staging memory, a command list to record copies and
+// barriers into, and a fence. D3D12UploadQueue is the real one; anything else can stand in to
+// count or check what a batch does.
+class UploadQueue
+{
+public:
+    virtual ~UploadQueue() { }
+
+    virtual uint64_t GetStagingCapacity() = 0;
+
+    // Returns E_PENDING if only staging not yet executed is in the way.
+    virtual HRESULT AllocateStaging(uint64_t size, uint64_t alignment, UploadAllocation& allocation) = 0;
+
+    virtual HRESULT Begin() = 0;
+    virtual void CopyBufferRegion(ID3D12Resource* dest, uint64_t destOffset, const UploadAllocation& source, uint64_t size) = 0;
+    virtual void ResourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers) = 0;
+
+    // Closes and executes what was recorded since Begin, and returns the fence value signalled after it.
+    // The list is closed whether or not this succeeds.
+    virtual HRESULT Execute(UploadToken& token) = 0;
+
+    // Closes what was recorded since Begin without executing it.
+    virtual void Abandon() = 0;
+
+    virtual bool IsComplete(UploadToken token) = 0;
+    virtual HRESULT Wait(UploadToken token) = 0;
+};
+
+// Records buffer uploads, from any number of meshes or models, for a single submission: every
+// copy goes into one command list and the transitions out of COPY_DEST into one ResourceBarrier
+// call at the end. The list is only executed early if staging runs out; the barriers still wait
+// for the final submit.
+//
+// Each destination range must be staged once per batch. Destinations transitioned to stateAfter
+// must be in COPY_DEST; stateAfter COMMON leaves a buffer to implicit promotion and decay instead, as
+// GeometryHeap's pages are, and records no barrier.
+//
+// If Stage fails, the batch abandons its open list and drops everything staged since the last
+// submit, and can be used again straight away. Copies that already went out because staging ran
+// out have run, but their destinations get no barrier and their contents must be staged again.
+class UploadBatch
+{
+public:
+    explicit UploadBatch(UploadQueue& queue);
+    ~UploadBatch();
+
+    UploadBatch(const UploadBatch&) = delete;
+    UploadBatch& operator=(const UploadBatch&) = delete;
+
+    HRESULT Stage(ID3D12Resource* dest, const void* data, uint64_t size, D3D12_RESOURCE_STATES stateAfter);
+    HRESULT Stage(ID3D12Resource* dest, uint64_t destOffset, const void* data, uint64_t size, D3D12_RESOURCE_STATES stateAfter);
+
+    // Submits the batch without waiting; token tells when it has run. An empty batch returns the
+    // token of the last submit.
+    HRESULT Submit(UploadToken& token);
+    HRESULT SubmitAndWait();
+
+    bool IsComplete(UploadToken token) { return m_queue.IsComplete(token); }
+    HRESULT Wait(UploadToken token) { return m_queue.Wait(token); }
+
+    uint32_t GetStagedCount() const { return m_stagedCount; }
+
+private:
+    void Abandon();
+
+    UploadQueue&                        m_queue;
+    bool                                m_recording;
+    UploadToken                         m_lastToken;
+    uint32_t                            m_stagedCount;      // Since the last submit
+    std::vector<D3D12_RESOURCE_BARRIER> m_barriers;
+};
+
+// UploadQueue over a D3D command queue, staging through an UploadRing. The allocator must be idle
+// when the first copy is staged, and stay unreset until the batch has run.
+class D3D12UploadQueue : public UploadQueue
+{
+public:
+    D3D12UploadQueue(ID3D12CommandQueue* cmdQueue, ID3D12CommandAllocator* cmdAlloc, ID3D12GraphicsCommandList* cmdList, UploadRing& uploadRing);
+
+    uint64_t GetStagingCapacity() override;
+    HRESULT AllocateStaging(uint64_t size, uint64_t alignment, UploadAllocation& allocation) override;
+
+    HRESULT Begin() override;
+    void CopyBufferRegion(ID3D12Resource* dest, uint64_t destOffset, const UploadAllocation& source, uint64_t size) override;
+    void ResourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers) override;
+    HRESULT Execute(UploadToken& token) override;
+    void Abandon() override;
+
+    bool IsComplete(UploadToken token) override;
+    HRESULT Wait(UploadToken token) override;
+
+private:
+    ID3D12CommandQueue*        m_cmdQueue;
+    ID3D12CommandAllocator*    m_cmdAlloc;
+    ID3D12GraphicsCommandList* m_cmdList;
+    UploadRing&                m_uploadRing;
+};
@@ -0,0 +1,327 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "Tests.h"
+#include "UploadBatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <random>
+
+using namespace Tests;
+
+namespace
+{
+    // Stand-in for the GPU behind an UploadBatch. Staging is a RingAllocator over CPU memory, and
+    // executed copies only land in their (fake) destinations when their fence completes, so staging
+    // reused too early shows up as corrupt contents. Counts the submits, waits and barrier calls,
+    // and flags copies into a destination that was already transitioned out of COPY_DEST.
+    class RecordingUploadQueue : public UploadQueue
+    {
+    public:
+        explicit RecordingUploadQueue(uint64_t stagingCapacity)
+            : m_staging(stagingCapacity)
+            , m_ring(stagingCapacity)
+            , m_submitted(0)
+            , m_completed(0)
+            , m_open(false)
+            , SubmitCount(0)
+            , WaitCount(0)
+            , BarrierCallCount(0)
+            , ErrorCount(0)
+            , AllocationsBeforeFailure(UINT32_MAX)
+        { }
+
+        uint64_t GetStagingCapacity() override { return m_ring.GetCapacity(); }
+
+        HRESULT AllocateStaging(uint64_t size, uint64_t alignment, UploadAllocation& allocation) override
+        {
+            if (AllocationsBeforeFailure == 0)
+            {
+                return E_OUTOFMEMORY;
+            }
+            AllocationsBeforeFailure--;
+
+            uint64_t offset = 0;
+            while (!m_ring.Allocate(size, alignment, offset))
+            {
+                if (m_ring.GetOldestPendingFence() == 0)
+                {
+                    return E_PENDING;
+                }
+                Wait(m_ring.GetOldestPendingFence());
+            }
+
+            allocation.CpuAddress = m_staging.data() + offset;
+            allocation.GpuAddress = offset;
+            allocation.Resource = nullptr;
+            allocation.Offset = offset;
+            return S_OK;
+        }
+
+        HRESULT Begin() override
+        {
+            ErrorCount += m_open;
+            m_open = true;
+            m_recorded.clear();
+            return S_OK;
+        }
+
+        void CopyBufferRegion(ID3D12Resource* dest, uint64_t destOffset, const UploadAllocation& source, uint64_t size) override
+        {
+            ErrorCount += !m_open + m_transitioned.count(dest);
+            m_recorded.push_back(Copy{ dest, destOffset, source.Offset, size, 0 });
+        }
+
+        void ResourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers) override
+        {
+            ErrorCount += !m_open;
+            BarrierCallCount++;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                m_transitioned[barriers[i].Transition.pResource] = true;
+            }
+        }
+
+        HRESULT Execute(UploadToken& token) override
+        {
+            ErrorCount += !m_open;
+            m_open = false;
+
+            token = ++m_submitted;
+            for (auto& copy : m_recorded)
+            {
+                copy.FenceValue = token;
+                m_executed.push_back(copy);
+            }
+            m_recorded.clear();
+
+            m_ring.Submit(token);
+            SubmitCount++;
+            return S_OK;
+        }
+
+        void Abandon() override
+        {
+            ErrorCount += !m_open;
+            m_open = false;
+            m_recorded.clear();
+        }
+
+        bool IsOpen() const { return m_open; }
+        bool IsTransitioned(ID3D12Resource* dest) const { return m_transitioned.count(dest) != 0; }
+
+        bool IsComplete(UploadToken token) override { return m_completed >= token; }
+
+        HRESULT Wait(UploadToken token) override
+        {
+            if (m_completed >= token)
+            {
+                return S_OK;
+            }
+
+            WaitCount++;
+            for (auto& copy : m_executed)
+            {
+                if (copy.FenceValue > m_completed && copy.FenceValue <= token)
+                {
+                    auto& contents = Contents[copy.Dest];
+                    contents.resize(max<size_t>(contents.size(), copy.DestOffset + copy.Size));
+                    std::memcpy(contents.data() + copy.DestOffset, m_staging.data() + copy.StagingOffset, copy.Size);
+                }
+            }
+
+            m_completed = token;
+            m_ring.Retire(m_completed);
+            return S_OK;
+        }
+
+        std::map<ID3D12Resource*, std::vector<uint8_t>> Contents;
+        uint32_t SubmitCount;
+        uint32_t WaitCount;
+        uint32_t BarrierCallCount;
+        uint32_t ErrorCount;                    // Copies after a barrier on their destination, and calls out of order
+        uint32_t AllocationsBeforeFailure;      // AllocateStaging fails once this many have succeeded
+
+    private:
+        struct Copy
+        {
+            ID3D12Resource* Dest;
+            uint64_t        DestOffset;
+            uint64_t        StagingOffset;
+            uint64_t        Size;
+            UploadToken     FenceValue;
+        };
+
+        std::vector<uint8_t>                m_staging;
+        RingAllocator                       m_ring;
+        uint64_t                            m_submitted;
+        uint64_t                            m_completed;
+        bool                                m_open;             // Between Begin and Execute or Abandon
+        std::vector<Copy>                   m_recorded;
+        std::vector<Copy>                   m_executed;
+        std::map<ID3D12Resource*, bool>     m_transitioned;
+    };
+
+    ID3D12Resource* MakeDest(size_t index)
+    {
+        return reinterpret_cast<ID3D12Resource*>(index + 1);
+    }
+
+    // Stages made-up meshes of seven buffers each, from a few bytes to more than the smaller staging,
+    // with a submit and a wait per mesh, a submit per mesh, or one submit for all of them, and checks
+    // every destination against its source and the submits, waits and barrier calls each way costs.
+    uint32_t CheckBatchedUploads()
+    {
+        enum Mode { PerMeshWait, PerMesh, Batched, ModeCount };
+        const char* modeNames[] = { "per mesh+wait", "per mesh", "one batch" };
+        const uint64_t stagingSizes[] = { 32 * 1024 * 1024, 256 * 1024 };
+        const uint32_t meshCount = 40;
+        const uint32_t buffersPerMesh = 7;
+
+        std::mt19937 rng(5);
+        std::vector<std::vector<uint8_t>> buffers(meshCount * buffersPerMesh);
+        for (auto& buffer : buffers)
+        {
+            // Mostly small, with one in eight up to 1 MB.
+            const uint32_t size = rng() % 8 == 0 ? 1 + rng() % (1024 * 1024) : 1 + rng() % 4096;
+            buffer.resize(size);
+            for (auto& byte : buffer)
+            {
+                byte = static_cast<uint8_t>(rng());
+            }
+        }
+
+        uint32_t errors = 0;
+        for (uint64_t stagingSize : stagingSizes)
+        {
+            for (uint32_t mode = 0; mode < ModeCount; ++mode)
+            {
+                RecordingUploadQueue queue(stagingSize);
+                UploadToken token = 0;
+                {
+                    UploadBatch batch(queue);
+                    for (uint32_t m = 0; m < meshCount; ++m)
+                    {
+                        for (uint32_t b = m * buffersPerMesh; b < (m + 1) * buffersPerMesh; ++b)
+                        {
+                            errors += Check(SUCCEEDED(batch.Stage(MakeDest(b), buffers[b].data(), buffers[b].size(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)),
+                                "UploadBatch (%s): staging buffer %u failed\n", modeNames[mode], b);
+                        }
+
+                        if (mode == PerMeshWait)
+                        {
+                            batch.SubmitAndWait();
+                        }
+                        else if (mode == PerMesh)
+                        {
+                            batch.Submit(token);
+                        }
+                    }
+
+                    batch.Submit(token);
+                    batch.Wait(token);
+                }
+
+                uint32_t mismatches = 0;
+                for (size_t b = 0; b < buffers.size(); ++b)
+                {
+                    mismatches += queue.Contents[MakeDest(b)] != buffers[b] || !queue.IsTransitioned(MakeDest(b));
+                }
+                errors += Check(mismatches == 0, "UploadBatch (%s, %u KB staging): %u destinations don't match their source\n",
+                    modeNames[mode], static_cast<uint32_t>(stagingSize >> 10), mismatches);
+                errors += Check(queue.ErrorCount == 0, "UploadBatch (%s, %u KB staging): %u copies after their barrier or calls out of order\n",
+                    modeNames[mode], static_cast<uint32_t>(stagingSize >> 10), queue.ErrorCount);
+                errors += Check(!queue.IsOpen(), "UploadBatch (%s): the list was left open\n", modeNames[mode]);
+
+                // However often staging runs out, the barriers only go out with a submit.
+                const uint32_t barrierCalls = mode == Batched ? 1 : meshCount;
+                errors += Check(queue.BarrierCallCount == barrierCalls, "UploadBatch (%s, %u KB staging): %u barrier calls, not %u\n",
+                    modeNames[mode], static_cast<uint32_t>(stagingSize >> 10), queue.BarrierCallCount, barrierCalls);
+
+                if (stagingSize == stagingSizes[0])
+                {
+                    // With room for everything, nothing goes out early.
+                    const uint32_t submits = mode == Batched ? 1 : meshCount;
+                    const uint32_t waits = mode == PerMeshWait ? meshCount : 1;
+                    errors += Check(queue.SubmitCount == submits && queue.WaitCount == waits, "UploadBatch (%s): %u submits and %u waits, not %u and %u\n",
+                        modeNames[mode], queue.SubmitCount, queue.WaitCount, submits, waits);
+                }
+            }
+        }
+
+        return errors;
+    }
+
+    // A destination left in COMMON gets no barrier, and an empty submit executes nothing and hands
+    // back the last token.
+    uint32_t CheckCommonAndEmpty()
+    {
+        const std::vector<uint8_t> data(1000, 0x3c);
+        RecordingUploadQueue queue(64 * 1024);
+
+        uint32_t errors = 0;
+        UploadToken token = 0;
+        UploadToken emptyToken = 0;
+        {
+            UploadBatch batch(queue);
+            errors += Check(SUCCEEDED(batch.Stage(MakeDest(0), 24, data.data(), data.size(), D3D12_RESOURCE_STATE_COMMON)), "UploadBatch: staging into COMMON failed\n");
+            errors += Check(batch.GetStagedCount() == 1, "UploadBatch: %u buffers staged, not 1\n", batch.GetStagedCount());
+            batch.Submit(token);
+            errors += Check(batch.GetStagedCount() == 0, "UploadBatch: the staged count wasn't reset by a submit\n");
+
+            batch.Submit(emptyToken);
+            batch.Wait(token);
+        }
+
+        const auto& contents = queue.Contents[MakeDest(0)];
+        errors += Check(contents.size() == 24 + data.size() && std::equal(data.begin(), data.end(), contents.begin() + 24), "UploadBatch: a copy at an offset landed in the wrong place\n");
+        errors += Check(queue.BarrierCallCount == 0, "UploadBatch: %u barrier calls for a destination left in COMMON\n", queue.BarrierCallCount);
+        errors += Check(queue.SubmitCount == 1 && emptyToken == token, "UploadBatch: an empty submit executed or changed the token\n");
+        return errors + queue.ErrorCount;
+    }
+
+    // Fails a buffer's staging after part of it has gone out early, then checks the batch abandoned
+    // its list and can stage and submit another buffer.
+    uint32_t CheckFailedStage()
+    {
+        const std::vector<uint8_t> data(1024 * 1024, 0x5a);
+        ID3D12Resource* const failed = MakeDest(0);
+        ID3D12Resource* const retried = MakeDest(1);
+
+        // Pieces of 64 KB: the fifth waits for the first four to execute, and the sixth fails.
+        RecordingUploadQueue queue(256 * 1024);
+        queue.AllocationsBeforeFailure = 5;
+
+        uint32_t errors = 0;
+        {
+            UploadBatch batch(queue);
+            errors += Check(batch.Stage(failed, data.data(), data.size(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == E_OUTOFMEMORY,
+                "UploadBatch: a failed allocation didn't fail the stage\n");
+            errors += Check(batch.GetStagedCount() == 0 && !queue.IsOpen(), "UploadBatch: a failed stage left the batch recording\n");
+
+            queue.AllocationsBeforeFailure = UINT32_MAX;
+            errors += Check(SUCCEEDED(batch.Stage(retried, data.data(), data.size(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)), "UploadBatch: staging after a failure failed\n");
+            errors += Check(SUCCEEDED(batch.SubmitAndWait()), "UploadBatch: submitting after a failure failed\n");
+        }
+
+        errors += Check(queue.Contents[retried] == data, "UploadBatch: the buffer staged after a failure doesn't match its source\n");
+        errors += Check(!queue.IsOpen() && queue.BarrierCallCount == 1, "UploadBatch: %u barrier calls after a failure, not 1\n", queue.BarrierCallCount);
+        errors += Check(!queue.IsTransitioned(failed), "UploadBatch: the failed destination got a barrier\n");
+        return errors + Check(queue.ErrorCount == 0, "UploadBatch: %u calls out of order around a failure\n", queue.ErrorCount);
+    }
+}
+
+uint32_t Tests::TestUploadBatch(const std::wstring&)
+{
+    return CheckBatchedUploads() + CheckCommonAndEmpty() + CheckFailedStage();
+}
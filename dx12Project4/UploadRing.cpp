@@ -0,0 +1,134 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "UploadRing.h"
+
+#include "DXBaiseHelper.h"
+
+UploadRing::UploadRing()
+    : m_cpuBase(nullptr)
+    , m_gpuBase(0)
+    , m_fenceValue(0)
+    , m_fenceEvent(nullptr)
+{ }
+
+UploadRing::~UploadRing()
+{
+    if (m_fenceEvent != nullptr)
+    {
+        CloseHandle(m_fenceEvent);
+    }
+}
+
+HRESULT UploadRing::Create(ID3D12Device* device, uint64_t capacity)
+{
+    // Buffers are 64 KB aligned, so any alignment up to that divides a multiple of it.
+    capacity = AlignUp(capacity, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    const CD3DX12_HEAP_PROPERTIES uploadHeap(D3D12_HEAP_TYPE_UPLOAD);
+    const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+
+    HRESULT hr = device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_resource));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // Kept mapped for the ring's lifetime; the CPU never reads it back.
+    CD3DX12_RANGE readRange(0, 0);
+    hr = m_resource->Map(0, &readRange, reinterpret_cast<void**>(&m_cpuBase));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    m_gpuBase = m_resource->GetGPUVirtualAddress();
+
+    hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    m_fenceValue = 0;
+
+    m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_fenceEvent == nullptr)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_ring.Reset(capacity);
+    return S_OK;
+}
+
+HRESULT UploadRing::Allocate(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+{
+    if (size > m_ring.GetCapacity())
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    uint64_t offset = 0;
+    for (;;)
+    {
+        m_ring.Retire(m_fence->GetCompletedValue());
+        if (m_ring.Allocate(size, alignment, offset))
+        {
+            break;
+        }
+
+        const uint64_t fenceValue = m_ring.GetOldestPendingFence();
+        if (fenceValue == 0)
+        {
+            return E_PENDING;
+        }
+
+        HRESULT hr = Wait(fenceValue);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    allocation.CpuAddress = m_cpuBase + offset;
+    allocation.GpuAddress = m_gpuBase + offset;
+    allocation.Resource = m_resource.Get();
+    allocation.Offset = offset;
+    return S_OK;
+}
+
+HRESULT UploadRing::Submit(ID3D12CommandQueue* queue)
+{
+    HRESULT hr = queue->Signal(m_fence.Get(), m_fenceValue + 1);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    m_ring.Submit(++m_fenceValue);
+    return S_OK;
+}
+
+HRESULT UploadRing::Wait(uint64_t fenceValue)
+{
+    if (IsComplete(fenceValue))
+    {
+        return S_OK;
+    }
+
+    HRESULT hr = m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+    return S_OK;
+}
@@ -0,0 +1,64 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include "RingAllocator.h"
+
+#include <cstdint>
+
+struct UploadAllocation
+{
+    uint8_t*                  CpuAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS GpuAddress;
+    ID3D12Resource*           Resource;
+    uint64_t                  Offset;           // Within Resource
+};
+
+// A persistently mapped UPLOAD buffer shared by everything that stages data for the GPU: model
+// uploads copy out of it, and per-frame constants are read from it in place. Ranges are recycled
+// once the ring's own fence, signalled by Submit after the work that reads them, has passed.
+class UploadRing
+{
+public:
+    UploadRing();
+    ~UploadRing();
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    HRESULT Create(ID3D12Device* device, uint64_t capacity);
+
+    // Waits for the GPU if the ring is full of submitted ranges. Returns E_PENDING if only ranges not
+    // yet submitted are in the way, and E_OUTOFMEMORY if size exceeds the capacity.
+    HRESULT Allocate(uint64_t size, uint64_t alignment, UploadAllocation& allocation);
+
+    // Call after queueing the work which reads the ranges allocated since the last Submit. Signals
+    // the ring's fence even if nothing was allocated, so the value also marks the work itself.
+    HRESULT Submit(ID3D12CommandQueue* queue);
+
+    uint64_t GetSubmittedFence() const { return m_fenceValue; }
+    bool IsComplete(uint64_t fenceValue) const { return m_fence->GetCompletedValue() >= fenceValue; }
+    HRESULT Wait(uint64_t fenceValue);
+
+    uint64_t GetCapacity() const { return m_ring.GetCapacity(); }
+    uint64_t GetUsedSize() const { return m_ring.GetUsedSize(); }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_resource;
+    uint8_t*                               m_cpuBase;
+    D3D12_GPU_VIRTUAL_ADDRESS              m_gpuBase;
+
+    Microsoft::WRL::ComPtr<ID3D12Fence>    m_fence;
+    uint64_t                               m_fenceValue;    // Last value signalled
+    HANDLE                                 m_fenceEvent;
+
+    RingAllocator                          m_ring;
+};
@@ -0,0 +1,149 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "Tests.h"
+#include "RingAllocator.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace Tests;
+
+namespace
+{
+    // The edges of the ring, step by step: what doesn't fit is refused without changing anything,
+    // a range never straddles the end, and retiring frees in submission order.
+    uint32_t CheckRingEdges()
+    {
+        RingAllocator ring(1024);
+        uint64_t offset = 0;
+
+        uint32_t errors = 0;
+        errors += Check(!ring.Allocate(2048, 16, offset) && ring.GetUsedSize() == 0, "RingAllocator: a range larger than the ring was allocated\n");
+        errors += Check(ring.GetOldestPendingFence() == 0 && !ring.HasUnsubmitted(), "RingAllocator: an empty ring has pending work\n");
+
+        errors += Check(ring.Allocate(600, 16, offset) && offset == 0, "RingAllocator: the first range isn't at the start\n");
+        errors += Check(ring.HasUnsubmitted(), "RingAllocator: an allocation isn't unsubmitted\n");
+        ring.Submit(1);
+
+        errors += Check(ring.Allocate(200, 256, offset) && offset == 768, "RingAllocator: an aligned range is at %u, not 768\n", static_cast<uint32_t>(offset));
+        ring.Submit(2);
+
+        // 512 bytes don't fit before the end, or at the start until fence 1 has completed.
+        errors += Check(!ring.Allocate(512, 16, offset), "RingAllocator: a range overlapped one still in flight\n");
+        errors += Check(ring.GetOldestPendingFence() == 1, "RingAllocator: oldest pending fence is %u, not 1\n", static_cast<uint32_t>(ring.GetOldestPendingFence()));
+
+        ring.Retire(1);
+        errors += Check(ring.Allocate(512, 16, offset) && offset == 0, "RingAllocator: a range didn't start over at the beginning\n");
+        ring.Submit(3);
+
+        ring.Retire(3);
+        errors += Check(ring.GetUsedSize() == 0 && ring.GetOldestPendingFence() == 0, "RingAllocator: %u bytes used once every fence completed\n", static_cast<uint32_t>(ring.GetUsedSize()));
+
+        // Submitting with nothing allocated leaves nothing to wait for.
+        ring.Submit(4);
+        errors += Check(ring.GetOldestPendingFence() == 0, "RingAllocator: an empty submission is pending\n");
+        return errors;
+    }
+
+    // Drives the ring the way DX12Practice drives its UploadRing, against a fake fence which trails
+    // the submissions by up to two frames: a 256-byte constant buffer per frame and mesh uploads of up
+    // to an eighth of the ring. When an allocation doesn't fit, unsubmitted ranges are submitted, as
+    // Model::UploadGpuResources does, or the fake GPU is stepped to the oldest pending fence, as
+    // UploadRing::Allocate waits for it. A range which overlaps one the fake GPU may still read, or
+    // isn't aligned, is a violation.
+    uint32_t CheckFakeFrames(uint64_t capacity)
+    {
+        const uint32_t c_frameCount = 5000;
+        const uint32_t c_maxFrameLag = 2;
+
+        struct LiveRange
+        {
+            uint64_t Offset;
+            uint64_t Size;
+            uint64_t FenceValue;    // UINT64_MAX until submitted
+        };
+
+        RingAllocator ring(capacity);
+        std::vector<LiveRange> live;
+        std::mt19937 random(1);
+
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint32_t violations = 0;
+
+        auto retire = [&](uint64_t fenceValue)
+        {
+            completed = std::max(completed, fenceValue);
+            ring.Retire(completed);
+            live.erase(std::remove_if(live.begin(), live.end(), [&](const LiveRange& range) { return range.FenceValue <= completed; }), live.end());
+        };
+
+        auto submit = [&]()
+        {
+            ring.Submit(++submitted);
+            for (auto& range : live)
+            {
+                range.FenceValue = std::min(range.FenceValue, submitted);
+            }
+        };
+
+        for (uint32_t f = 0; f < c_frameCount; ++f)
+        {
+            retire(submitted - std::min<uint64_t>(submitted, random() % (c_maxFrameLag + 1)));
+
+            // The constants come last, after the uploads of the frame were submitted.
+            const uint32_t uploadCount = random() % 4 == 0 ? random() % 16 : 0;
+            for (uint32_t u = 0; u <= uploadCount; ++u)
+            {
+                const bool constants = u == uploadCount;
+                const uint64_t size = constants ? 256 : 1 + random() % (capacity / 8);
+                const uint64_t alignment = constants ? 256 : 16;
+
+                uint64_t offset = 0;
+                while (!ring.Allocate(size, alignment, offset))
+                {
+                    if (ring.GetOldestPendingFence() == 0)
+                    {
+                        submit();
+                    }
+                    else
+                    {
+                        retire(ring.GetOldestPendingFence());
+                    }
+                }
+
+                bool valid = offset % alignment == 0 && offset + size <= capacity;
+                for (auto& range : live)
+                {
+                    valid = valid && (offset + size <= range.Offset || range.Offset + range.Size <= offset);
+                }
+                violations += !valid;
+
+                live.push_back(LiveRange{ offset, size, UINT64_MAX });
+
+                if (!constants && u + 1 == uploadCount)
+                {
+                    submit();
+                }
+            }
+
+            submit();
+        }
+
+        return Check(violations == 0, "RingAllocator: %u violations over %u frames of a %u KB ring\n", violations, c_frameCount, static_cast<uint32_t>(capacity / 1024));
+    }
+}
+
+// The second ring's capacity isn't a power of two.
+uint32_t Tests::TestUploadRing(const std::wstring&)
+{
+    return CheckRingEdges() + CheckFakeFrames(1024 * 1024) + CheckFakeFrames(768 * 1024);
+}